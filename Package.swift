@@ -24,5 +24,15 @@ let package = Package(
         .testTarget(
             name: "CrasheeTests",
             dependencies: ["Crashee"]),
+        // Tests and benchmarks for the C recording core, which needs its
+        // internal headers: swift run -c release CrasheeCTests [--bench]
+        .target(
+            name: "CrasheeCTests",
+            dependencies: ["CrasheeObjc"],
+            path: "Tests/CrasheeCTests",
+            cSettings: [
+                .headerSearchPath("../../Sources/CrasheeObjc/Recording"),
+                .headerSearchPath("../../Sources/CrasheeObjc/Recording/Tools"),
+            ]),
     ]
 )
@@ -51,7 +51,7 @@ final class CrashReporter {
             completion(.success([]))
             return 
         }
-        send(reports: allReports(), completion: completion)
+        send(reports: reports, completion: completion)
     }
     
     internal func deleteAllReports(with completion: DeleteReportsCompletion) {
@@ -67,13 +67,22 @@ final class CrashReporter {
     internal func install() {
         monitoring = crasheecrash_install(NSString(string: bundleName).utf8String, NSString(string: basePath).utf8String)
         didLoad()
+        fixupPendingReports()
     }
     
     // MARK: - Private implementation
     
     private func allReports() -> [CrashReport] {
-        reportIDs().compactMap({ reportWith(id: $0) })
-        
+        let reportIDs = self.reportIDs().map({ Int64($0) })
+        guard !reportIDs.isEmpty else { return [] }
+        let collector = ReportDataCollector()
+        // Reads all reports in one go on a few threads; they arrive in any order
+        _ = crasheecrash_readReports(reportIDs, Int32(reportIDs.count), { reportId, report, length, userData in
+            guard let report = report, let userData = userData else { return }
+            let collector = Unmanaged<ReportDataCollector>.fromOpaque(userData).takeUnretainedValue()
+            collector.reports[reportId] = Data(bytesNoCopy: report, count: Int(length), deallocator: .free)
+        }, Unmanaged.passUnretained(collector).toOpaque())
+        return reportIDs.compactMap({ collector.reports[$0] }).compactMap({ report(from: $0) })
     }
     private func reportIDs() -> [Int] {
         let reportsCount = crasheecrash_getReportCount()
@@ -82,8 +91,7 @@ final class CrashReporter {
         return reportIDs.compactMap({ Int($0) })
     }
     
-    private func reportWith(id reportId: Int) -> CrashReport? {
-        guard let data = reportDataWith(id: reportId) else { return nil }
+    private func report(from data: Data) -> CrashReport? {
         do {
             var report = try jsonDecoder.decode(CrashReport.self, from: data)
             return report.diagnosed(with: crashDoctor)
@@ -93,9 +101,11 @@ final class CrashReporter {
         }
     }
     
-    private func reportDataWith(id: Int) -> Data? {
-        guard let report = crasheecrash_readReport(Int64(id)) else { return nil }
-        return Data(bytesNoCopy: report, count: strlen(report), deallocator: .free)
+    /// Fixes up reports left by previous launches once, so reading them later is a plain copy
+    private func fixupPendingReports() {
+        DispatchQueue.global(qos: .utility).async {
+            _ = crasheecrash_fixupAllReports(0)
+        }
     }
     
     private func send(reports: [CrashReport], completion: @escaping ReportsCompletion) {
@@ -138,3 +148,8 @@ final class CrashReporter {
     }
     
 }
+
+/// Gathers reports handed over by `crasheecrash_readReports`, which never calls back concurrently
+private final class ReportDataCollector {
+    var reports: [Int64: Data] = [:]
+}
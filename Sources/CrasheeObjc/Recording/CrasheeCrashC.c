@@ -44,9 +44,11 @@
 #include "Tools/CrasheeLogger.h"
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 typedef enum
 {
@@ -58,6 +60,9 @@ typedef enum
     CrasheeApplicationStateWillTerminate
 } CrasheeApplicationState;
 
+/** The most threads that crasheecrash_fixupAllReports() will use. */
+#define MAX_FIXUP_THREADS 4
+
 // ============================================================================
 #pragma mark - Globals -
 // ============================================================================
@@ -70,6 +75,9 @@ static bool g_shouldPrintPreviousLog = false;
 static char g_consoleLogPath[CrasheeFU_MAX_PATH_LENGTH];
 static CrasheeCrashMonitorType g_monitoring = CrasheeCrashMonitorTypeProductionSafeMinimal;
 static char g_lastCrashReportFilePath[CrasheeFU_MAX_PATH_LENGTH];
+static int64_t g_lastCrashReportID;
+/** True once the last crash report has been published under its real path. */
+static volatile bool g_isLastCrashReportPublished;
 static CrasheeReportWrittenCallback g_reportWrittenCallback;
 static CrasheeApplicationState g_lastApplicationState = CrasheeApplicationStateNone;
 
@@ -79,13 +87,13 @@ static CrasheeApplicationState g_lastApplicationState = CrasheeApplicationStateN
 
 static void printPreviousLog(const char* filePath)
 {
-    char* data;
-    int length;
-    if(crasheefu_readEntireFile(filePath, &data, &length, 0))
+    CrasheeFileView log;
+    if(crasheefu_mapFile(filePath, &log, 0))
     {
         printf("\nvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv Previous Log vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv\n\n");
-        printf("%s\n", data);
-        free(data);
+        fwrite(log.data, 1, (size_t)log.length, stdout);
+        printf("\n");
+        crasheefu_unmapFile(&log);
         printf("^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^\n\n");
         fflush(stdout);
     }
@@ -129,14 +137,34 @@ static void onCrash(struct CrasheeCrash_MonitorContext* monitorContext)
 
     if(monitorContext->crashedDuringCrashHandling)
     {
+        if(!g_isLastCrashReportPublished && access(g_lastCrashReportFilePath, F_OK) != 0)
+        {
+            // Crashed while the report was being published, after it was moved.
+            crasheecrs_getCrashReportPath(g_lastCrashReportID, g_lastCrashReportFilePath);
+            g_isLastCrashReportPublished = true;
+        }
         crasheecrashreport_writeRecrashReport(monitorContext, g_lastCrashReportFilePath);
+        if(g_isLastCrashReportPublished)
+        {
+            crasheecrs_notifyReportRewritten(g_lastCrashReportID);
+        }
+        else
+        {
+            crasheecrs_notifyReportWritten(g_lastCrashReportID);
+        }
     }
     else
     {
         char crashReportFilePath[CrasheeFU_MAX_PATH_LENGTH];
         int64_t reportID = crasheecrs_getNextCrashReport(crashReportFilePath);
         strncpy(g_lastCrashReportFilePath, crashReportFilePath, sizeof(g_lastCrashReportFilePath));
+        g_lastCrashReportID = reportID;
+        g_isLastCrashReportPublished = false;
         crasheecrashreport_writeStandardReport(monitorContext, crashReportFilePath);
+        crasheecrs_notifyReportWritten(reportID);
+        // A crash from here on rewrites the published report.
+        crasheecrs_getCrashReportPath(reportID, g_lastCrashReportFilePath);
+        g_isLastCrashReportPublished = true;
 
         if(g_reportWrittenCallback)
         {
@@ -248,6 +276,51 @@ void crasheecrash_setMaxReportCount(int maxReportCount)
     crasheecrs_setMaxReportCount(maxReportCount);
 }
 
+void crasheecrash_setMaxReportBytes(int64_t maxReportBytes)
+{
+    crasheecrs_setMaxReportBytes(maxReportBytes);
+}
+
+void crasheecrash_setMaxReportAge(int64_t maxReportAge)
+{
+    crasheecrs_setMaxReportAge(maxReportAge);
+}
+
+void crasheecrash_setMaxReportCountOfKind(CrasheeReportKind kind, int maxReportCount)
+{
+    crasheecrs_setMaxReportCountOfKind(kind, maxReportCount);
+}
+
+void crasheecrash_setReportDurability(CrasheeReportDurability durability)
+{
+    crasheecrs_setReportDurability(durability);
+}
+
+void crasheecrash_setFullCrashReportInterval(int interval)
+{
+    crasheecrs_setFullCrashReportInterval(interval);
+}
+
+void crasheecrash_setUserReportStorage(CrasheeUserReportStorage storage)
+{
+    crasheecrs_setUserReportStorage(storage);
+}
+
+void crasheecrash_setReportSlotSize(int64_t reportSlotSize)
+{
+    crasheecrs_setReportSlotSize(reportSlotSize);
+}
+
+void crasheecrash_setReportFormat(CrasheeCrashReportFormat format)
+{
+    crasheecrashreport_setReportFormat(format);
+}
+
+void crasheecrash_setCompressReports(bool compressReports)
+{
+    crasheecrashreport_setCompressReports(compressReports);
+}
+
 void crasheecrash_reportUserException(const char* name,
                                  const char* reason,
                                  const char* language,
@@ -320,7 +393,45 @@ int crasheecrash_getReportIDs(int64_t* reportIDs, int count)
     return crasheecrs_getReportIDs(reportIDs, count);
 }
 
+bool crasheecrash_getReportOccurrences(int64_t reportID, CrasheeReportOccurrences* occurrences)
+{
+    return crasheecrs_getReportOccurrences(reportID, occurrences);
+}
+
 char* crasheecrash_readReport(int64_t reportID)
+{
+    return crasheecrash_readReportWithLength(reportID, NULL);
+}
+
+/** Make a fixed up, null terminated copy of a report. */
+static char* copyFixedUpReport(const int64_t reportID, const CrasheeFileView* const rawReport, const bool isFixedUp, int* const length)
+{
+    char* fixedReport;
+    if(isFixedUp)
+    {
+        fixedReport = malloc((size_t)rawReport->length + 1);
+        if(fixedReport != NULL)
+        {
+            memcpy(fixedReport, rawReport->data, (size_t)rawReport->length);
+            fixedReport[rawReport->length] = '\0';
+            if(length != NULL)
+            {
+                *length = rawReport->length;
+            }
+        }
+    }
+    else
+    {
+        fixedReport = crasheecrf_fixupCrashReportData(rawReport->data, rawReport->length, length);
+    }
+    if(fixedReport == NULL)
+    {
+        CrasheeLOG_ERROR("Failed to fixup report ID %" PRIx64, reportID);
+    }
+    return fixedReport;
+}
+
+char* crasheecrash_readReportWithLength(int64_t reportID, int* length)
 {
     if(reportID <= 0)
     {
@@ -328,21 +439,190 @@ char* crasheecrash_readReport(int64_t reportID)
         return NULL;
     }
 
-    char* rawReport = crasheecrs_readReport(reportID);
-    if(rawReport == NULL)
+    CrasheeFileView rawReport;
+    bool isFixedUp = false;
+    if(!crasheecrs_mapReport(reportID, &rawReport, &isFixedUp))
     {
         CrasheeLOG_ERROR("Failed to load report ID %" PRIx64, reportID);
         return NULL;
     }
 
-    char* fixedReport = crasheecrf_fixupCrashReport(rawReport);
-    if(fixedReport == NULL)
+    char* fixedReport = copyFixedUpReport(reportID, &rawReport, isFixedUp, length);
+    crasheecrs_unmapReport(&rawReport);
+    return fixedReport;
+}
+
+typedef struct
+{
+    CrasheeReportReadCallback callback;
+    CrasheeReportBatchCallback completion;
+    void* userData;
+    pthread_mutex_t callbackMutex;
+    _Atomic(int) readCount;
+} ReadReportsContext;
+
+static void onReportRead(int64_t reportID, const CrasheeFileView* rawReport, bool isFixedUp, void* userData)
+{
+    ReadReportsContext* context = (ReadReportsContext*)userData;
+    int length = 0;
+    char* report = copyFixedUpReport(reportID, rawReport, isFixedUp, &length);
+    if(report != NULL)
     {
-        CrasheeLOG_ERROR("Failed to fixup report ID %" PRIx64, reportID);
+        pthread_mutex_lock(&context->callbackMutex);
+        context->callback(reportID, report, length, context->userData);
+        pthread_mutex_unlock(&context->callbackMutex);
+        context->readCount++;
     }
+}
 
-    free(rawReport);
-    return fixedReport;
+int crasheecrash_readReports(const int64_t* reportIDs, int count, CrasheeReportReadCallback callback, void* userData)
+{
+    ReadReportsContext context =
+    {
+        .callback = callback,
+        .userData = userData,
+        .callbackMutex = PTHREAD_MUTEX_INITIALIZER,
+        .readCount = 0,
+    };
+    crasheecrs_readReports(reportIDs, count, 0, onReportRead, &context);
+    pthread_mutex_destroy(&context.callbackMutex);
+    return context.readCount;
+}
+
+static void onReportsRead(const int64_t* reportIDs, int count, __unused int completedCount, void* userData)
+{
+    ReadReportsContext* context = (ReadReportsContext*)userData;
+    if(context->completion != NULL)
+    {
+        // Count the reports that could also be fixed up, not just read.
+        context->completion(reportIDs, count, context->readCount, context->userData);
+    }
+    pthread_mutex_destroy(&context->callbackMutex);
+    free(context);
+}
+
+bool crasheecrash_readReportsAsync(const int64_t* reportIDs,
+                                   int count,
+                                   CrasheeReportReadCallback callback,
+                                   CrasheeReportBatchCallback completion,
+                                   void* userData)
+{
+    ReadReportsContext* context = malloc(sizeof(*context));
+    if(context == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate a read context");
+        return false;
+    }
+    *context = (ReadReportsContext)
+    {
+        .callback = callback,
+        .completion = completion,
+        .userData = userData,
+        .callbackMutex = PTHREAD_MUTEX_INITIALIZER,
+        .readCount = 0,
+    };
+    if(!crasheecrs_readReportsAsync(reportIDs, count, onReportRead, onReportsRead, context))
+    {
+        pthread_mutex_destroy(&context->callbackMutex);
+        free(context);
+        return false;
+    }
+    return true;
+}
+
+static bool writeFixedUpReport(int fd, void* userData)
+{
+    const CrasheeFileView* rawReport = (const CrasheeFileView*)userData;
+    return crasheecrf_fixupCrashReportToFD(rawReport->data, rawReport->length, fd);
+}
+
+typedef struct
+{
+    const int64_t* reportIDs;
+    int reportCount;
+    _Atomic(int) nextIndex;
+    _Atomic(int) fixedUpCount;
+} FixupBatch;
+
+static void* fixupReportsThread(void* userData)
+{
+    FixupBatch* batch = (FixupBatch*)userData;
+    for(int i = batch->nextIndex++; i < batch->reportCount; i = batch->nextIndex++)
+    {
+        const int64_t reportID = batch->reportIDs[i];
+        CrasheeFileView rawReport;
+        bool isFixedUp = false;
+        if(!crasheecrs_mapReport(reportID, &rawReport, &isFixedUp))
+        {
+            continue;
+        }
+        if(!isFixedUp)
+        {
+            if(crasheecrs_replaceWithFixedUpReport(reportID, writeFixedUpReport, &rawReport))
+            {
+                batch->fixedUpCount++;
+            }
+            else
+            {
+                CrasheeLOG_ERROR("Failed to fixup report ID %" PRIx64, reportID);
+            }
+        }
+        crasheecrs_unmapReport(&rawReport);
+    }
+    return NULL;
+}
+
+int crasheecrash_fixupAllReports(int maxThreadCount)
+{
+    int reportCount = crasheecrs_getReportCount();
+    if(reportCount <= 0)
+    {
+        return 0;
+    }
+    int64_t* reportIDs = malloc(sizeof(*reportIDs) * (size_t)reportCount);
+    if(reportIDs == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d report IDs", reportCount);
+        return 0;
+    }
+    reportCount = crasheecrs_getReportIDs(reportIDs, reportCount);
+
+    FixupBatch batch =
+    {
+        .reportIDs = reportIDs,
+        .reportCount = reportCount,
+        .nextIndex = 0,
+        .fixedUpCount = 0,
+    };
+    if(maxThreadCount <= 0)
+    {
+        maxThreadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(maxThreadCount > MAX_FIXUP_THREADS)
+    {
+        maxThreadCount = MAX_FIXUP_THREADS;
+    }
+    if(maxThreadCount > reportCount)
+    {
+        maxThreadCount = reportCount;
+    }
+
+    // The calling thread does its share too.
+    pthread_t threads[MAX_FIXUP_THREADS];
+    int threadCount = 0;
+    while(threadCount < maxThreadCount - 1 &&
+          pthread_create(&threads[threadCount], NULL, fixupReportsThread, &batch) == 0)
+    {
+        threadCount++;
+    }
+    fixupReportsThread(&batch);
+    for(int i = 0; i < threadCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(reportIDs);
+    return batch.fixedUpCount;
 }
 
 int64_t crasheecrash_addUserReport(const char* report, int reportLength)
@@ -350,6 +630,15 @@ int64_t crasheecrash_addUserReport(const char* report, int reportLength)
     return crasheecrs_addUserReport(report, reportLength);
 }
 
+bool crasheecrash_addUserReportsAsync(const char* const* reports,
+                                      const int* reportLengths,
+                                      int count,
+                                      CrasheeReportBatchCallback completion,
+                                      void* userData)
+{
+    return crasheecrs_addUserReportsAsync(reports, reportLengths, count, completion, userData);
+}
+
 void crasheecrash_deleteAllReports()
 {
     crasheecrs_deleteAllReports();
@@ -359,3 +648,11 @@ void crasheecrash_deleteReportWithID(int64_t reportID)
 {
     crasheecrs_deleteReportWithID(reportID);
 }
+
+bool crasheecrash_deleteReportsAsync(const int64_t* reportIDs,
+                                     int count,
+                                     CrasheeReportBatchCallback completion,
+                                     void* userData)
+{
+    return crasheecrs_deleteReportsAsync(reportIDs, count, completion, userData);
+}
@@ -39,6 +39,7 @@ extern "C" {
 
 #include "Monitors/CrasheeCrashMonitorType.h"
 #include "CrasheeCrashReportWriter.h"
+#include "CrasheeCrashReportStore.h"
 
 #include <stdbool.h>
 
@@ -161,6 +162,81 @@ void crasheecrash_setPrintPreviousLog(bool shouldPrintPreviousLog);
  */
 void crasheecrash_setMaxReportCount(int maxReportCount);
 
+/** Set the most disk space reports may take up before old ones get deleted.
+ * Limits are checked as reports are added, and old reports are deleted on a
+ * background thread.
+ *
+ * @param maxReportBytes The total size in bytes, or 0 for no limit.
+ */
+void crasheecrash_setMaxReportBytes(int64_t maxReportBytes);
+
+/** Set how long reports are kept before they get deleted.
+ *
+ * @param maxReportAge The age in seconds, or 0 for no limit.
+ */
+void crasheecrash_setMaxReportAge(int64_t maxReportAge);
+
+/** Set the maximum number of crash or user reports allowed on disk before old
+ * ones of the same kind get deleted.
+ *
+ * @param kind CrasheeReportKindCrash or CrasheeReportKindUser.
+ *
+ * @param maxReportCount The maximum number of reports, or 0 for no limit.
+ */
+void crasheecrash_setMaxReportCountOfKind(CrasheeReportKind kind, int maxReportCount);
+
+/** Set how hard to try to get reports onto permanent storage, trading write
+ * throughput for surviving power loss. Reports are always published whole,
+ * whatever the policy.
+ * Default: CrasheeReportDurabilityNone
+ *
+ * @param durability The durability policy.
+ */
+void crasheecrash_setReportDurability(CrasheeReportDurability durability);
+
+/** Set how often a crash that repeats one already on disk is kept as a full
+ * report. The other repeats are deleted, and only counted in the report they
+ * repeat, so that a hot bug doesn't push the rare crashes out.
+ * Default: 0
+ *
+ * @param interval Keep every interval'th occurrence, 0 to keep only the
+ *                 first, or 1 to keep them all.
+ */
+void crasheecrash_setFullCrashReportInterval(int interval);
+
+/** Set where new user reports are kept. Packing them into segment files
+ * avoids creating a file per report, which is much cheaper when many small
+ * reports are added.
+ * Default: CrasheeUserReportStorageFiles
+ *
+ * @param storage The storage to use.
+ */
+void crasheecrash_setUserReportStorage(CrasheeUserReportStorage storage);
+
+/** Set how much disk space to reserve ahead of time for the next crash report,
+ * so that writing it at crash time doesn't have to create a file or allocate
+ * space, and still works when the disk is nearly full.
+ *
+ * @param reportSlotSize The size in bytes, or 0 to create reports as they are written.
+ */
+void crasheecrash_setReportSlotSize(int64_t reportSlotSize);
+
+/** Set the encoding to use when writing crash reports.
+ * Binary reports are smaller and cheaper to write, and are converted back to
+ * JSON when read from the report store.
+ *
+ * Default: CrasheeCrashReportFormatJSON
+ */
+void crasheecrash_setReportFormat(CrasheeCrashReportFormat format);
+
+/** Set whether crash reports are compressed on disk.
+ * Compressed reports are smaller and involve less I/O at crash time. They are
+ * decompressed transparently when read from the report store.
+ *
+ * Default: false
+ */
+void crasheecrash_setCompressReports(bool compressReports);
+
 /** Report a custom, user defined exception.
  * This can be useful when dealing with scripting languages.
  *
@@ -235,6 +311,16 @@ int crasheecrash_getReportCount(void);
  */
 int crasheecrash_getReportIDs(int64_t* reportIDs, int count);
 
+/** Get how many crashes a report stands for, once repeats of it have been
+ * coalesced into it.
+ *
+ * @param reportID The report's ID.
+ * @param occurrences Receives the occurrences.
+ *
+ * @return false if there is no such report.
+ */
+bool crasheecrash_getReportOccurrences(int64_t reportID, CrasheeReportOccurrences* occurrences);
+
 /** Read a report.
  *
  * @param reportID The report's ID.
@@ -244,6 +330,77 @@ int crasheecrash_getReportIDs(int64_t* reportIDs, int count);
  */
 char* crasheecrash_readReport(int64_t reportID);
 
+/** Read a report, and get its length.
+ * The raw report is mapped from disk rather than copied, so the only buffer
+ * allocated is the fixed up report that is returned.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param length Receives the length of the report in bytes (can be NULL).
+ *
+ * @return The NULL terminated report, or NULL if not found.
+ *         MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
+ */
+char* crasheecrash_readReportWithLength(int64_t reportID, int* length);
+
+typedef void (*CrasheeReportReadCallback)(int64_t reportID, char* report, int length, void* userData);
+
+/** Read several reports at once, handing each to the callback as soon as it
+ * is ready, so that the first reports can be used while later ones are
+ * still being read. Reports arrive in no particular order, and reports that
+ * can't be read are skipped.
+ * The callback may be called from other threads, but never concurrently.
+ * Blocks until all reports have been read.
+ *
+ * @param reportIDs The IDs of the reports to read.
+ *
+ * @param count The number of report IDs.
+ *
+ * @param callback Called with each NULL terminated report and its length.
+ *                 MEMORY MANAGEMENT WARNING: The callback is responsible for calling free() on the report.
+ *
+ * @param userData Any data you would like passed to the callback.
+ *
+ * @return The number of reports passed to the callback.
+ */
+int crasheecrash_readReports(const int64_t* reportIDs, int count, CrasheeReportReadCallback callback, void* userData);
+
+/** Like crasheecrash_readReports(), but returns right away and reads the
+ * reports on the store's I/O thread. Batches submitted with this and the
+ * other asynchronous functions run one at a time, in submission order.
+ *
+ * @param reportIDs The IDs of the reports to read. They are copied.
+ *
+ * @param count The number of report IDs.
+ *
+ * @param callback Called with each NULL terminated report and its length.
+ *                 MEMORY MANAGEMENT WARNING: The callback is responsible for calling free() on the report.
+ *
+ * @param completion Called with the number of reports passed to the callback,
+ *                   once all have been read (can be NULL).
+ *
+ * @param userData Any data you would like passed to the callbacks.
+ *
+ * @return true if the batch was queued.
+ */
+bool crasheecrash_readReportsAsync(const int64_t* reportIDs,
+                                   int count,
+                                   CrasheeReportReadCallback callback,
+                                   CrasheeReportBatchCallback completion,
+                                   void* userData);
+
+/** Fix up every report that hasn't been fixed up yet, and store the results.
+ * Reading a fixed up report is then a plain copy, so each report is only
+ * fixed up once. Reports can be read while this runs.
+ * Blocks until done, so call it from a background thread.
+ *
+ * @param maxThreadCount The most threads to fix up reports on, including
+ *                       the calling thread (0 = one per CPU core, up to 4).
+ *
+ * @return The number of reports that were fixed up.
+ */
+int crasheecrash_fixupAllReports(int maxThreadCount);
+
 /** Add a custom report to the store.
  *
  * @param report The report's contents (must be JSON encoded).
@@ -253,6 +410,22 @@ char* crasheecrash_readReport(int64_t reportID);
  */
 int64_t crasheecrash_addUserReport(const char* report, int reportLength);
 
+/** Add several custom reports to the store in the background.
+ *
+ * @param reports The reports' contents (must be JSON encoded). They are copied.
+ * @param reportLengths The length of each report in bytes.
+ * @param count The number of reports.
+ * @param completion Called with the new reports' IDs, 0 for any that couldn't be added (can be NULL).
+ * @param userData Any data you would like passed to the completion.
+ *
+ * @return true if the batch was queued.
+ */
+bool crasheecrash_addUserReportsAsync(const char* const* reports,
+                                      const int* reportLengths,
+                                      int count,
+                                      CrasheeReportBatchCallback completion,
+                                      void* userData);
+
 /** Delete all reports on disk.
  */
 void crasheecrash_deleteAllReports(void);
@@ -263,6 +436,20 @@ void crasheecrash_deleteAllReports(void);
  */
 void crasheecrash_deleteReportWithID(int64_t reportID);
 
+/** Delete several reports in the background.
+ *
+ * @param reportIDs The IDs of the reports to delete. They are copied.
+ * @param count The number of report IDs.
+ * @param completion Called once the reports have been deleted (can be NULL).
+ * @param userData Any data you would like passed to the completion.
+ *
+ * @return true if the batch was queued.
+ */
+bool crasheecrash_deleteReportsAsync(const int64_t* reportIDs,
+                                     int count,
+                                     CrasheeReportBatchCallback completion,
+                                     void* userData);
+
 
 #ifdef __cplusplus
 }
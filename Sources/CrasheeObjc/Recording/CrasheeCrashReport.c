@@ -31,7 +31,10 @@
 #include "CrasheeCrashReportWriter.h"
 #include "Tools/CrasheeDynamicLinker.h"
 #include "Tools/CrasheeFileUtils.h"
+#include "Tools/CrasheeFormat.h"
 #include "Tools/CrasheeJSONCodec.h"
+#include "Tools/CrasheeCBORCodec.h"
+#include "Tools/CrasheeLZ.h"
 #include "Tools/CrasheeCPU.h"
 #include "Tools/CrasheeMemory.h"
 #include "Tools/CrasheeMach.h"
@@ -76,19 +79,23 @@
 /** The minimum length for a valid string. */
 #define kMinStringLength 4
 
+/** Size of the write buffer used for uncompressed reports. */
+#define kReportWriteBufferLength 16384
+
 
 // ============================================================================
 #pragma mark - JSON Encoding -
 // ============================================================================
 
 #define getJsonContext(REPORT_WRITER) ((CrasheeJSONEncodeContext*)((REPORT_WRITER)->context))
+#define getCborContext(REPORT_WRITER) ((CrasheeCBOREncodeContext*)((REPORT_WRITER)->context))
 
-/** Used for writing hex string values. */
-static const char g_hexNybbles[] =
+/** Storage for whichever encoder the report is being written with. */
+typedef union
 {
-    '0', '1', '2', '3', '4', '5', '6', '7',
-    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
-};
+    CrasheeJSONEncodeContext json;
+    CrasheeCBOREncodeContext cbor;
+} ReportEncodeContext;
 
 // ============================================================================
 #pragma mark - Runtime Config -
@@ -113,6 +120,14 @@ typedef struct
 static const char* g_userInfoJSON;
 static CrasheeCrash_IntrospectionRules g_introspectionRules;
 static CrasheeReportWriteCallback g_userSectionWriteCallback;
+static CrasheeCrashReportFormat g_reportFormat = CrasheeCrashReportFormatJSON;
+static bool g_compressReports = false;
+
+/** Compression buffers. Too big for the signal stack, and only one report is written at a time. */
+static CrasheeLZWorkspace g_compressionWorkspace;
+
+/** Uncompressed report write buffer, kept off the signal stack for the same reason. */
+static char g_reportWriteBuffer[kReportWriteBufferLength];
 
 
 #pragma mark Callbaccrashee
@@ -202,47 +217,42 @@ static void addUUIDElement(const CrasheeCrashReportWriter* const writer, const c
 {
     if(value == NULL)
     {
-        crasheejson_addNullElement(getJsonContext(writer), key);
+        writer->addStringElement(writer, key, NULL);
     }
     else
     {
-        char uuidBuffer[37];
-        const unsigned char* src = value;
-        char* dst = uuidBuffer;
-        for(int i = 0; i < 4; i++)
-        {
-            *dst++ = g_hexNybbles[(*src>>4)&15];
-            *dst++ = g_hexNybbles[(*src++)&15];
-        }
-        *dst++ = '-';
-        for(int i = 0; i < 2; i++)
-        {
-            *dst++ = g_hexNybbles[(*src>>4)&15];
-            *dst++ = g_hexNybbles[(*src++)&15];
-        }
-        *dst++ = '-';
-        for(int i = 0; i < 2; i++)
-        {
-            *dst++ = g_hexNybbles[(*src>>4)&15];
-            *dst++ = g_hexNybbles[(*src++)&15];
-        }
-        *dst++ = '-';
-        for(int i = 0; i < 2; i++)
-        {
-            *dst++ = g_hexNybbles[(*src>>4)&15];
-            *dst++ = g_hexNybbles[(*src++)&15];
-        }
-        *dst++ = '-';
-        for(int i = 0; i < 6; i++)
-        {
-            *dst++ = g_hexNybbles[(*src>>4)&15];
-            *dst++ = g_hexNybbles[(*src++)&15];
-        }
-
-        crasheejson_addStringElement(getJsonContext(writer), key, uuidBuffer, (int)(dst - uuidBuffer));
+        char uuidBuffer[CrasheeFMT_UUID_BUFFER_LENGTH];
+        crasheefmt_uuid(uuidBuffer, value);
+        writer->addStringElement(writer, key, uuidBuffer);
     }
 }
 
+/** Write an object describing a preformatted JSON element that could not be added.
+ *
+ * @param writer The writer.
+ *
+ * @param key The object key.
+ *
+ * @param jsonElement The invalid JSON data.
+ *
+ * @param jsonResult The error from the JSON decoder.
+ */
+static void writeInvalidJSONElement(const CrasheeCrashReportWriter* const writer,
+                                    const char* const key,
+                                    const char* const jsonElement,
+                                    const int jsonResult)
+{
+    char errorBuff[100];
+    crasheefmt_format(errorBuff,
+                      sizeof(errorBuff),
+                      "Invalid JSON data: %s",
+                      crasheejson_stringForError(jsonResult));
+    writer->beginObject(writer, key);
+    writer->addStringElement(writer, CrasheeCrashField_Error, errorBuff);
+    writer->addStringElement(writer, CrasheeCrashField_JSONData, jsonElement);
+    writer->endContainer(writer);
+}
+
 static void addJSONElement(const CrasheeCrashReportWriter* const writer,
                            const char* const key,
                            const char* const jsonElement,
@@ -255,21 +265,7 @@ static void addJSONElement(const CrasheeCrashReportWriter* const writer,
                                            closeLastContainer);
     if(jsonResult != CrasheeJSON_OK)
     {
-        char errorBuff[100];
-        snprintf(errorBuff,
-                 sizeof(errorBuff),
-                 "Invalid JSON data: %s",
-                 crasheejson_stringForError(jsonResult));
-        crasheejson_beginObject(getJsonContext(writer), key);
-        crasheejson_addStringElement(getJsonContext(writer),
-                                CrasheeCrashField_Error,
-                                errorBuff,
-                                CrasheeJSON_SIZE_AUTOMATIC);
-        crasheejson_addStringElement(getJsonContext(writer),
-                                CrasheeCrashField_JSONData,
-                                jsonElement,
-                                CrasheeJSON_SIZE_AUTOMATIC);
-        crasheejson_endContainer(getJsonContext(writer));
+        writeInvalidJSONElement(writer, key, jsonElement, jsonResult);
     }
 }
 
@@ -317,7 +313,7 @@ static void addTextLinesFromFile(const CrasheeCrashReportWriter* const writer, c
                 break;
             }
             buffer[length - 1] = '\0';
-            crasheejson_addStringElement(getJsonContext(writer), NULL, buffer, CrasheeJSON_SIZE_AUTOMATIC);
+            writer->addStringElement(writer, NULL, buffer);
         }
     }
     endContainer(writer);
@@ -332,6 +328,130 @@ static int addJSONData(const char* restrict const data, const int length, void*
 }
 
 
+#pragma mark Binary Callbaccrashee
+
+static void cbor_addBooleanElement(const CrasheeCrashReportWriter* const writer, const char* const key, const bool value)
+{
+    crasheecbor_addBooleanElement(getCborContext(writer), key, value);
+}
+
+static void cbor_addFloatingPointElement(const CrasheeCrashReportWriter* const writer, const char* const key, const double value)
+{
+    crasheecbor_addFloatingPointElement(getCborContext(writer), key, value);
+}
+
+static void cbor_addIntegerElement(const CrasheeCrashReportWriter* const writer, const char* const key, const int64_t value)
+{
+    crasheecbor_addIntegerElement(getCborContext(writer), key, value);
+}
+
+static void cbor_addUIntegerElement(const CrasheeCrashReportWriter* const writer, const char* const key, const uint64_t value)
+{
+    crasheecbor_addUIntegerElement(getCborContext(writer), key, value);
+}
+
+static void cbor_addStringElement(const CrasheeCrashReportWriter* const writer, const char* const key, const char* const value)
+{
+    crasheecbor_addStringElement(getCborContext(writer), key, value, CrasheeCBOR_SIZE_AUTOMATIC);
+}
+
+static void cbor_addTextFileElement(const CrasheeCrashReportWriter* const writer, const char* const key, const char* const filePath)
+{
+    const int fd = open(filePath, O_RDONLY);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", filePath, strerror(errno));
+        return;
+    }
+
+    if(crasheecbor_beginStringElement(getCborContext(writer), key) != CrasheeJSON_OK)
+    {
+        CrasheeLOG_ERROR("Could not start string element");
+        goto done;
+    }
+
+    char buffer[512];
+    int bytesRead;
+    for(bytesRead = (int)read(fd, buffer, sizeof(buffer));
+        bytesRead > 0;
+        bytesRead = (int)read(fd, buffer, sizeof(buffer)))
+    {
+        if(crasheecbor_appendStringElement(getCborContext(writer), buffer, bytesRead) != CrasheeJSON_OK)
+        {
+            CrasheeLOG_ERROR("Could not append string element");
+            goto done;
+        }
+    }
+
+done:
+    crasheecbor_endStringElement(getCborContext(writer));
+    close(fd);
+}
+
+static void cbor_addDataElement(const CrasheeCrashReportWriter* const writer,
+                                const char* const key,
+                                const char* const value,
+                                const int length)
+{
+    crasheecbor_addDataElement(getCborContext(writer), key, value, length);
+}
+
+static void cbor_beginDataElement(const CrasheeCrashReportWriter* const writer, const char* const key)
+{
+    crasheecbor_beginDataElement(getCborContext(writer), key);
+}
+
+static void cbor_appendDataElement(const CrasheeCrashReportWriter* const writer, const char* const value, const int length)
+{
+    crasheecbor_appendDataElement(getCborContext(writer), value, length);
+}
+
+static void cbor_endDataElement(const CrasheeCrashReportWriter* const writer)
+{
+    crasheecbor_endDataElement(getCborContext(writer));
+}
+
+static void cbor_addJSONElement(const CrasheeCrashReportWriter* const writer,
+                                const char* const key,
+                                const char* const jsonElement,
+                                bool closeLastContainer)
+{
+    int jsonResult = crasheecbor_addJSONElement(getCborContext(writer),
+                                                key,
+                                                jsonElement,
+                                                (int)strlen(jsonElement),
+                                                closeLastContainer);
+    if(jsonResult != CrasheeJSON_OK)
+    {
+        writeInvalidJSONElement(writer, key, jsonElement, jsonResult);
+    }
+}
+
+static void cbor_addJSONElementFromFile(const CrasheeCrashReportWriter* const writer,
+                                        const char* const key,
+                                        const char* const filePath,
+                                        __unused bool closeLastContainer)
+{
+    // Only used to embed an earlier report, which is already CBOR.
+    crasheecbor_addCBORFromFile(getCborContext(writer), key, filePath);
+}
+
+static void cbor_beginObject(const CrasheeCrashReportWriter* const writer, const char* const key)
+{
+    crasheecbor_beginObject(getCborContext(writer), key);
+}
+
+static void cbor_beginArray(const CrasheeCrashReportWriter* const writer, const char* const key)
+{
+    crasheecbor_beginArray(getCborContext(writer), key);
+}
+
+static void cbor_endContainer(const CrasheeCrashReportWriter* const writer)
+{
+    crasheecbor_endContainer(getCborContext(writer));
+}
+
+
 // ============================================================================
 #pragma mark - Utility -
 // ============================================================================
@@ -984,12 +1104,13 @@ static void writeNotableStackContents(const CrasheeCrashReportWriter* const writ
         highAddress = tmp;
     }
     uintptr_t contentsAsPointer;
-    char nameBuffer[40];
+    char nameBuffer[40] = "stack@0x";
+    char* const addressBuffer = nameBuffer + strlen(nameBuffer);
     for(uintptr_t address = lowAddress; address < highAddress; address += sizeof(address))
     {
         if(crasheemem_copySafely((void*)address, &contentsAsPointer, sizeof(contentsAsPointer)))
         {
-            sprintf(nameBuffer, "stack@%p", (void*)address);
+            crasheefmt_hex64(addressBuffer, address, 1, false);
             writeMemoryContentsIfNotable(writer, nameBuffer, contentsAsPointer);
         }
     }
@@ -1020,7 +1141,8 @@ static void writeBasicRegisters(const CrasheeCrashReportWriter* const writer,
             registerName = crasheecpu_registerName(reg);
             if(registerName == NULL)
             {
-                snprintf(registerNameBuff, sizeof(registerNameBuff), "r%d", reg);
+                registerNameBuff[0] = 'r';
+                crasheefmt_int64(registerNameBuff + 1, reg);
                 registerName = registerNameBuff;
             }
             writer->addUIntegerElement(writer, registerName,
@@ -1052,7 +1174,8 @@ static void writeExceptionRegisters(const CrasheeCrashReportWriter* const writer
             registerName = crasheecpu_exceptionRegisterName(reg);
             if(registerName == NULL)
             {
-                snprintf(registerNameBuff, sizeof(registerNameBuff), "r%d", reg);
+                registerNameBuff[0] = 'r';
+                crasheefmt_int64(registerNameBuff + 1, reg);
                 registerName = registerNameBuff;
             }
             writer->addUIntegerElement(writer,registerName,
@@ -1102,7 +1225,8 @@ static void writeNotableRegisters(const CrasheeCrashReportWriter* const writer,
         registerName = crasheecpu_registerName(reg);
         if(registerName == NULL)
         {
-            snprintf(registerNameBuff, sizeof(registerNameBuff), "r%d", reg);
+            registerNameBuff[0] = 'r';
+            crasheefmt_int64(registerNameBuff + 1, reg);
             registerName = registerNameBuff;
         }
         writeMemoryContentsIfNotable(writer,
@@ -1561,6 +1685,128 @@ static void prepareReportWriter(CrasheeCrashReportWriter* const writer, CrasheeJ
     writer->context = context;
 }
 
+/** Prepare a report writer for binary (CBOR) output.
+ *
+ * @oaram writer The writer to prepare.
+ *
+ * @param context CBOR writer contextual information.
+ */
+static void prepareCBORReportWriter(CrasheeCrashReportWriter* const writer, CrasheeCBOREncodeContext* const context)
+{
+    writer->addBooleanElement = cbor_addBooleanElement;
+    writer->addFloatingPointElement = cbor_addFloatingPointElement;
+    writer->addIntegerElement = cbor_addIntegerElement;
+    writer->addUIntegerElement = cbor_addUIntegerElement;
+    writer->addStringElement = cbor_addStringElement;
+    writer->addTextFileElement = cbor_addTextFileElement;
+    writer->addTextFileLinesElement = addTextLinesFromFile;
+    writer->addJSONFileElement = cbor_addJSONElementFromFile;
+    writer->addDataElement = cbor_addDataElement;
+    writer->beginDataElement = cbor_beginDataElement;
+    writer->appendDataElement = cbor_appendDataElement;
+    writer->endDataElement = cbor_endDataElement;
+    writer->addUUIDElement = addUUIDElement;
+    writer->addJSONElement = cbor_addJSONElement;
+    writer->beginObject = cbor_beginObject;
+    writer->beginArray = cbor_beginArray;
+    writer->endContainer = cbor_endContainer;
+    writer->context = context;
+}
+
+/** Open a report file for writing.
+ *
+ * Uncompressed reports are written with vectored I/O so that large values
+ * go out without being copied.
+ *
+ * @param bufferedWriter The writer to open.
+ *
+ * @param path The report path.
+ *
+ * @param compress If true, compress the report.
+ *
+ * @param isReportSlot If true, the path may be a report slot that the store
+ *                     has already moved there.
+ *
+ * @return true if the file was opened.
+ */
+static bool openReportFile(CrasheeBufferedWriter* const bufferedWriter,
+                           const char* const path,
+                           const bool compress,
+                           const bool isReportSlot)
+{
+    if(compress)
+    {
+        return crasheefu_openCompressedBufferedWriter(bufferedWriter, path, &g_compressionWorkspace, isReportSlot);
+    }
+    return crasheefu_openVectoredBufferedWriter(bufferedWriter, path, g_reportWriteBuffer, sizeof(g_reportWriteBuffer), isReportSlot);
+}
+
+/** Decompress a report in place so that it can be embedded in another report.
+ *
+ * @param path The report to decompress.
+ */
+static void decompressReportFile(const char* const path)
+{
+    static char decompressedPath[CrasheeFU_MAX_PATH_LENGTH];
+    crasheefmt_format(decompressedPath, sizeof(decompressedPath), "%s.raw", path);
+    if(!crasheelz_decompressFile(path, decompressedPath, &g_compressionWorkspace))
+    {
+        CrasheeLOG_ERROR("Could not decompress %s", path);
+        remove(decompressedPath);
+        return;
+    }
+    if(rename(decompressedPath, path) < 0)
+    {
+        CrasheeLOG_ERROR("Could not rename %s to %s: %s", decompressedPath, path, strerror(errno));
+    }
+}
+
+/** Prepare a report writer and start encoding in the requested format.
+ *
+ * @param writer The writer to prepare.
+ *
+ * @param context Storage for the encoder context.
+ *
+ * @param format The report format.
+ *
+ * @param bufferedWriter Where the encoded data goes.
+ */
+static void beginReportEncode(CrasheeCrashReportWriter* const writer,
+                              ReportEncodeContext* const context,
+                              const CrasheeCrashReportFormat format,
+                              CrasheeBufferedWriter* const bufferedWriter)
+{
+    if(format == CrasheeCrashReportFormatCBOR)
+    {
+        prepareCBORReportWriter(writer, &context->cbor);
+        crasheecbor_beginEncode(getCborContext(writer), addJSONData, bufferedWriter);
+    }
+    else
+    {
+        prepareReportWriter(writer, &context->json);
+        crasheejson_beginEncode(getJsonContext(writer), true, addJSONData, bufferedWriter);
+        crasheejson_setInternedNames(getJsonContext(writer), g_crasheeCrashFieldNames, CrasheeCrashFieldCount);
+    }
+}
+
+/** Finish encoding, closing any open containers.
+ *
+ * @param writer The writer.
+ *
+ * @param format The format passed to beginReportEncode().
+ */
+static void endReportEncode(const CrasheeCrashReportWriter* const writer, const CrasheeCrashReportFormat format)
+{
+    if(format == CrasheeCrashReportFormatCBOR)
+    {
+        crasheecbor_endEncode(getCborContext(writer));
+    }
+    else
+    {
+        crasheejson_endEncode(getJsonContext(writer));
+    }
+}
+
 
 // ============================================================================
 #pragma mark - Main API -
@@ -1568,7 +1814,6 @@ static void prepareReportWriter(CrasheeCrashReportWriter* const writer, CrasheeJ
 
 void crasheecrashreport_writeRecrashReport(const CrasheeCrash_MonitorContext* const monitorContext, const char* const path)
 {
-    char writeBuffer[1024];
     CrasheeBufferedWriter bufferedWriter;
     static char tempPath[CrasheeFU_MAX_PATH_LENGTH];
     strncpy(tempPath, path, sizeof(tempPath) - 10);
@@ -1579,20 +1824,25 @@ void crasheecrashreport_writeRecrashReport(const CrasheeCrash_MonitorContext* co
     {
         CrasheeLOG_ERROR("Could not rename %s to %s: %s", path, tempPath, strerror(errno));
     }
-    if(!crasheefu_openBufferedWriter(&bufferedWriter, path, writeBuffer, sizeof(writeBuffer)))
+    const bool compress = g_compressReports;
+    if(compress)
+    {
+        // Must happen before the workspace is reused for writing.
+        decompressReportFile(tempPath);
+    }
+    // The original report has been moved aside, so nothing should be here.
+    if(!openReportFile(&bufferedWriter, path, compress, false))
     {
         return;
     }
 
     crasheeccd_freeze();
 
-    CrasheeJSONEncodeContext jsonContext;
-    jsonContext.userData = &bufferedWriter;
+    const CrasheeCrashReportFormat format = g_reportFormat;
+    ReportEncodeContext encodeContext;
     CrasheeCrashReportWriter concreteWriter;
     CrasheeCrashReportWriter* writer = &concreteWriter;
-    prepareReportWriter(writer, &jsonContext);
-
-    crasheejson_beginEncode(getJsonContext(writer), true, addJSONData, &bufferedWriter);
+    beginReportEncode(writer, &encodeContext, format, &bufferedWriter);
 
     writer->beginObject(writer, CrasheeCrashField_Report);
     {
@@ -1627,7 +1877,7 @@ void crasheecrashreport_writeRecrashReport(const CrasheeCrash_MonitorContext* co
     }
     writer->endContainer(writer);
 
-    crasheejson_endEncode(getJsonContext(writer));
+    endReportEncode(writer, format);
     crasheefu_closeBufferedWriter(&bufferedWriter);
     crasheeccd_unfreeze();
 }
@@ -1692,23 +1942,20 @@ static void writeDebugInfo(const CrasheeCrashReportWriter* const writer,
 void crasheecrashreport_writeStandardReport(const CrasheeCrash_MonitorContext* const monitorContext, const char* const path)
 {
     CrasheeLOG_INFO("Writing crash report to %s", path);
-    char writeBuffer[1024];
     CrasheeBufferedWriter bufferedWriter;
 
-    if(!crasheefu_openBufferedWriter(&bufferedWriter, path, writeBuffer, sizeof(writeBuffer)))
+    if(!openReportFile(&bufferedWriter, path, g_compressReports, true))
     {
         return;
     }
 
     crasheeccd_freeze();
     
-    CrasheeJSONEncodeContext jsonContext;
-    jsonContext.userData = &bufferedWriter;
+    const CrasheeCrashReportFormat format = g_reportFormat;
+    ReportEncodeContext encodeContext;
     CrasheeCrashReportWriter concreteWriter;
     CrasheeCrashReportWriter* writer = &concreteWriter;
-    prepareReportWriter(writer, &jsonContext);
-
-    crasheejson_beginEncode(getJsonContext(writer), true, addJSONData, &bufferedWriter);
+    beginReportEncode(writer, &encodeContext, format, &bufferedWriter);
 
     writer->beginObject(writer, CrasheeCrashField_Report);
     {
@@ -1763,7 +2010,7 @@ void crasheecrashreport_writeStandardReport(const CrasheeCrash_MonitorContext* c
     }
     writer->endContainer(writer);
     
-    crasheejson_endEncode(getJsonContext(writer));
+    endReportEncode(writer, format);
     crasheefu_closeBufferedWriter(&bufferedWriter);
     crasheeccd_unfreeze();
 }
@@ -1837,3 +2084,15 @@ void crasheecrashreport_setUserSectionWriteCallback(const CrasheeReportWriteCall
     CrasheeLOG_TRACE("Set userSectionWriteCallback to %p", userSectionWriteCallback);
     g_userSectionWriteCallback = userSectionWriteCallback;
 }
+
+void crasheecrashreport_setReportFormat(CrasheeCrashReportFormat format)
+{
+    CrasheeLOG_TRACE("Set report format to %d", format);
+    g_reportFormat = format;
+}
+
+void crasheecrashreport_setCompressReports(bool compressReports)
+{
+    CrasheeLOG_TRACE("Set compressReports to %d", compressReports);
+    g_compressReports = compressReports;
+}
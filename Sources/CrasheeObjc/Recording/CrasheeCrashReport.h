@@ -74,6 +74,18 @@ void crasheecrashreport_setDoNotIntrospectClasses(const char** doNotIntrospectCl
  */
 void crasheecrashreport_setUserSectionWriteCallback(const CrasheeReportWriteCallback userSectionWriteCallback);
 
+/** Set the encoding to use for reports written from now on.
+ *
+ * @param format The report format. Default: CrasheeCrashReportFormatJSON
+ */
+void crasheecrashreport_setReportFormat(CrasheeCrashReportFormat format);
+
+/** Set whether reports written from now on are compressed.
+ *
+ * @param compressReports If true, compress reports. Default: false
+ */
+void crasheecrashreport_setCompressReports(bool compressReports);
+
 
 // ============================================================================
 #pragma mark - Main API -
@@ -84,7 +96,8 @@ void crasheecrashreport_setUserSectionWriteCallback(const CrasheeReportWriteCall
  * @param monitorContext Contextual information about the crash and environment.
  *                       The caller must fill this out before passing it in.
  *
- * @param path The file to write to.
+ * @param path The file to write to, as returned by crasheecrs_getNextCrashReport().
+ *             If it's a report slot, the report is written into it.
  */
 void crasheecrashreport_writeStandardReport(const struct CrasheeCrash_MonitorContext* const monitorContext,
                                        const char* path);
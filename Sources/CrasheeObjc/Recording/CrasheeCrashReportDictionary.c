@@ -0,0 +1,327 @@
+//
+//  CrasheeCrashReportDictionary.c
+//
+//  Copyright (c) 2012 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "CrasheeCrashReportDictionary.h"
+
+#include <stddef.h>
+
+
+/** Dictionary 1, built from the fields and structures of report version 3.3.0.
+ * Least common content comes first: when the same text appears twice, the
+ * match finder remembers the later one.
+ */
+static const char g_dictionary1[] =
+    "{\"report\":{\"version\":\"3.3.0\",\"id\":\"\",\"process_name\":\"\",\"timestamp\":17,"
+    "\"type\":\"standard\"},\"process\":{},"
+    "\"system\":{\"system_name\":\"iOS\",\"system_version\":\"17.5.1\","
+    "\"machine\":\"iPhone15,2\",\"model\":\"D73AP\","
+    "\"kernel_version\":\"Darwin Kernel Version 23.5.0: Wed May  1 20:35:22 PDT 2024; root:xnu-10063.122.3~3/RELEASE_ARM64_T8120\","
+    "\"os_version\":\"21F90\",\"jailbroken\":false,"
+    "\"boot_time\":\"2024-06-01T08:00:00Z\","
+    "\"app_start_time\":\"2024-06-01T08:00:00Z\","
+    "\"CFBundleExecutablePath\":\"/private/var/containers/Bundle/Application/\","
+    "\"CFBundleExecutable\":\"\",\"CFBundleIdentifier\":\"com.\",\"CFBundleName\":\"\","
+    "\"CFBundleVersion\":\"1\",\"CFBundleShortVersionString\":\"1.0.0\","
+    "\"app_uuid\":\"\",\"cpu_arch\":\"arm64e\",\"cpu_type\":16777228,\"cpu_subtype\":2,"
+    "\"binary_cpu_type\":16777228,\"binary_cpu_subtype\":0,\"time_zone\":\"GMT+2\","
+    "\"process_name\":\"\",\"process_id\":,\"parent_process_id\":1,"
+    "\"device_app_hash\":\"\",\"build_type\":\"app store\",\"storage\":,"
+    "\"memory\":{\"size\":,\"usable\":,\"free\":},"
+    "\"application_stats\":{\"application_active\":false,"
+    "\"application_in_foreground\":true,\"launches_since_last_crash\":1,"
+    "\"sessions_since_last_crash\":1,\"active_time_since_last_crash\":0,"
+    "\"background_time_since_last_crash\":0,\"sessions_since_launch\":1,"
+    "\"active_time_since_launch\":0,\"background_time_since_launch\":0}},"
+    "\"crash\":{\"error\":{\"mach\":{\"exception\":1,"
+    "\"exception_name\":\"EXC_BAD_ACCESS\",\"code\":1,"
+    "\"code_name\":\"KERN_INVALID_ADDRESS\",\"subcode\":0},\"signal\":{\"signal\":11,"
+    "\"name\":\"SIGSEGV\",\"code\":0,\"code_name\":\"SEGV_MAPERR\"},\"address\":0,"
+    "\"type\":\"mach\"},"
+    "\"error\":{\"mach\":{\"exception\":10,\"exception_name\":\"EXC_CRASH\",\"code\":0,"
+    "\"subcode\":0},\"signal\":{\"signal\":6,\"name\":\"SIGABRT\",\"code\":0},"
+    "\"reason\":\"\",\"type\":\"nsexception\","
+    "\"nsexception\":{\"name\":\"NSInvalidArgumentException\",\"userInfo\":\"\","
+    "\"referenced_object\":{\"address\":,\"type\":\"objc_object\",\"class\":\"\"}}},"
+    "\"type\":\"cpp_exception\",\"cpp_exception\":{\"name\":\"std::runtime_error\"}},"
+    "\"type\":\"signal\",\"signal\":{\"signal\":5,\"name\":\"SIGTRAP\",\"code\":0},"
+    "\"mach\":{\"exception\":6,\"exception_name\":\"EXC_BREAKPOINT\",\"code\":1,"
+    "\"subcode\":\"type\":\"user\",\"user_reported\":{\"name\":\"\",\"language\":\"\","
+    "\"line_of_code\":\"\",\"backtrace\":[]}},"
+    "\"stack\":{\"grow_direction\":\"-\",\"dump_start\":,\"dump_end\":,"
+    "\"stack_pointer\":,\"overflow\":false,\"contents\":\"\"},"
+    "\"notable_addresses\":{\"x0\":{\"address\":,\"type\":\"string\",\"value\":\"\"},"
+    "\"type\":\"objc_class\",\"type\":\"null_pointer\",\"type\":\"unknown\"}"
+    "\"registers\":{\"basic\":{\"x0\":,\"x1\":,\"x2\":,\"x3\":,\"x4\":,\"x5\":,\"x6\":,\"x7\":,"
+    "\"x8\":,\"x9\":,\"x10\":,\"x11\":,\"x12\":,\"x13\":,\"x14\":,\"x15\":,\"x16\":,\"x17\":,"
+    "\"x18\":0,\"x19\":,\"x20\":,\"x21\":,\"x22\":,\"x23\":,\"x24\":,\"x25\":,\"x26\":,"
+    "\"x27\":,\"x28\":,\"fp\":,\"lr\":,\"sp\":,\"pc\":,\"cpsr\":1610616832},"
+    "\"exception\":{\"exception\":0,\"esr\":1442840704,\"far\":}},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,\"name\":\"/usr/lib/dyld\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/libobjc.A.dylib\",\"uuid\":\"\",\"cpu_type\":16777228,"
+    "\"cpu_subtype\":2,\"major_version\":0,\"minor_version\":0,"
+    "\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/libc++abi.dylib\",\"uuid\":\"\",\"cpu_type\":16777228,"
+    "\"cpu_subtype\":2,\"major_version\":0,\"minor_version\":0,"
+    "\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/libc++.1.dylib\",\"uuid\":\"\",\"cpu_type\":16777228,"
+    "\"cpu_subtype\":2,\"major_version\":0,\"minor_version\":0,"
+    "\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/swift/libswiftCore.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/swift/libswift_Concurrency.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/swift/libswiftFoundation.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/libsystem_c.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/libsystem_malloc.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/libsystem_platform.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/libdyld.dylib\",\"uuid\":\"\",\"cpu_type\":16777228,"
+    "\"cpu_subtype\":2,\"major_version\":0,\"minor_version\":0,"
+    "\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/CFNetwork.framework/CFNetwork\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/QuartzCore.framework/QuartzCore\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/Security.framework/Security\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/CoreGraphics.framework/CoreGraphics\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/SwiftUI.framework/SwiftUI\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/Combine.framework/Combine\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/PrivateFrameworks/GraphicsServices.framework/GraphicsServices\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/PrivateFrameworks/UIKitCore.framework/UIKitCore\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/Foundation.framework/Foundation\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/System/Library/Frameworks/CoreFoundation.framework/CoreFoundation\","
+    "\"uuid\":\"\",\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/libdispatch.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/libsystem_pthread.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "{\"image_addr\":,\"image_vmaddr\":,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/libsystem_kernel.dylib\",\"uuid\":\"\","
+    "\"cpu_type\":16777228,\"cpu_subtype\":2,\"major_version\":0,"
+    "\"minor_version\":0,\"revision_version\":0},"
+    "\"binary_images\":[{\"image_addr\":,\"image_vmaddr\":0,\"image_size\":,"
+    "\"name\":\"/usr/lib/system/lib\",\"uuid\":\"\",\"cpu_type\":16777228,"
+    "\"cpu_subtype\":0,\"major_version\":1,\"minor_version\":0,"
+    "\"revision_version\":0},"
+    "\"name\":\"/System/Library/PrivateFrameworks/.framework/\","
+    "\"name\":\"/System/Library/Frameworks/.framework/\","
+    "{\"object_name\":\"dyld\",\"object_addr\":,\"symbol_name\":\"start\","
+    "\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_c.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"abort\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libc++abi.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"abort_message\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libc++abi.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"demangling_terminate_handler()\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libobjc.A.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_objc_terminate()\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libc++abi.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"std::__terminate(void (*)())\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libc++abi.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"__cxa_rethrow\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libobjc.A.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"objc_exception_throw\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"CoreFoundation\",\"object_addr\":,"
+    "\"symbol_name\":\"__exceptionPreprocess\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libobjc.A.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"objc_msgSend\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libswiftCore.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_assertionFailure(_:_:file:line:flags:)\","
+    "\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"UIKitCore\",\"object_addr\":,"
+    "\"symbol_name\":\"UIApplicationMain\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"UIKitCore\",\"object_addr\":,"
+    "\"symbol_name\":\"-[UIApplication _run]\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"GraphicsServices\",\"object_addr\":,"
+    "\"symbol_name\":\"GSEventRunModal\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"CoreFoundation\",\"object_addr\":,"
+    "\"symbol_name\":\"CFRunLoopRunSpecific\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"CoreFoundation\",\"object_addr\":,"
+    "\"symbol_name\":\"__CFRunLoopRun\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"CoreFoundation\",\"object_addr\":,"
+    "\"symbol_name\":\"__CFRunLoopServiceMachPort\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"CoreFoundation\",\"object_addr\":,"
+    "\"symbol_name\":\"__CFRUNLOOP_IS_SERVICING_THE_MAIN_DISPATCH_QUEUE__\","
+    "\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"CoreFoundation\",\"object_addr\":,"
+    "\"symbol_name\":\"__CFRUNLOOP_IS_CALLING_OUT_TO_A_SOURCE0_PERFORM_FUNCTION__\","
+    "\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"Foundation\",\"object_addr\":,"
+    "\"symbol_name\":\"-[NSThread main]\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"Foundation\",\"object_addr\":,"
+    "\"symbol_name\":\"__NSThread__start__\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"CFNetwork\",\"object_addr\":,\"symbol_name\":\"__CFNetwork\","
+    "\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_main_queue_drain\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_main_queue_callback_4CF\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_client_callout\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_call_block_and_release\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_lane_serial_drain\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_lane_invoke\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_workloop_worker_thread\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libdispatch.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_dispatch_root_queue_drain\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_pthread.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_pthread_start\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_pthread.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"thread_start\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_pthread.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"_pthread_wqthread\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_pthread.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"start_wqthread\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_pthread.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"pthread_kill\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"__psynch_cvwait\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"__pthread_kill\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"semaphore_wait_trap\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"__workq_kernreturn\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"mach_msg\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"mach_msg_overwrite\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"mach_msg2_internal\",\"symbol_addr\":,"
+    "\"instruction_addr\":},"
+    "{\"object_name\":\"libsystem_kernel.dylib\",\"object_addr\":,"
+    "\"symbol_name\":\"mach_msg2_trap\",\"symbol_addr\":,\"instruction_addr\":},"
+    "\"threads\":[{\"backtrace\":{\"contents\":[{\"object_name\":\"\",\"object_addr\":,"
+    "\"symbol_name\":\"\",\"symbol_addr\":,\"instruction_addr\":},"
+    "{\"object_name\":\"\",\"object_addr\":,\"instruction_addr\":}],\"skipped\":0},"
+    "\"index\":0,\"name\":\"\",\"dispatch_queue\":\"com.apple.main-thread\","
+    "\"crashed\":true,\"current_thread\":false},{\"backtrace\":{\"contents\":[],"
+    "\"skipped\":0},\"index\":,\"dispatch_queue\":\"com.apple.root.default-qos\","
+    "\"crashed\":false,\"current_thread\":false},"
+    "\"name\":\"com.apple.uikit.eventfetch-thread\","
+    "\"name\":\"com.apple.NSURLConnectionLoader\",\"crashed\":false,"
+    "\"current_thread\":false},\"crashed_thread\":{},\"diagnosis\":\"\",\"user\":{},"
+    "\"debug\":{\"console_log\":[]},\"incomplete\":true,\"recrash_report\":{}}";
+
+/** All dictionaries ever shipped, oldest first. The last one is current. */
+static const CrasheeLZDictionary g_dictionaries[] =
+{
+    {.id = 1, .data = g_dictionary1, .length = sizeof(g_dictionary1) - 1},
+};
+static const int g_dictionariesCount = sizeof(g_dictionaries) / sizeof(*g_dictionaries);
+
+
+const CrasheeLZDictionary* crasheecrd_getCurrentDictionary(void)
+{
+    return &g_dictionaries[g_dictionariesCount - 1];
+}
+
+const CrasheeLZDictionary* crasheecrd_getDictionary(const uint32_t dictionaryID)
+{
+    for(int i = 0; i < g_dictionariesCount; i++)
+    {
+        if(g_dictionaries[i].id == dictionaryID)
+        {
+            return &g_dictionaries[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,71 @@
+//
+//  CrasheeCrashReportDictionary.h
+//
+//  Copyright (c) 2012 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/* Dictionaries for compressing crash reports at rest (see CrasheeLZ.h).
+ *
+ * A dictionary holds the minified JSON that reports from this library are
+ * made of: field names in the order the writer emits them, the error,
+ * thread, register and binary image structures, and the system images and
+ * symbols that turn up in nearly every backtrace.
+ *
+ * Each compressed report records the ID of the dictionary it was compressed
+ * with, so a dictionary must never change once it has shipped. To improve
+ * one, add a new dictionary with the next ID and keep the old ones, so that
+ * reports already on disk can still be read.
+ */
+
+#ifndef HDR_CrasheeCrashReportDictionary_h
+#define HDR_CrasheeCrashReportDictionary_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "Tools/CrasheeLZ.h"
+
+#include <stdint.h>
+
+
+/** Get the dictionary that reports should be compressed with now.
+ *
+ * @return The newest dictionary.
+ */
+const CrasheeLZDictionary* crasheecrd_getCurrentDictionary(void);
+
+/** Get the dictionary that a report was compressed with.
+ *
+ * @param dictionaryID The ID recorded in the compressed report.
+ *
+ * @return The dictionary, or NULL if it is unknown.
+ */
+const CrasheeLZDictionary* crasheecrd_getDictionary(uint32_t dictionaryID);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeCrashReportDictionary_h
@@ -28,6 +28,8 @@
 #ifndef HDR_CrasheeCrashReportFields_h
 #define HDR_CrasheeCrashReportFields_h
 
+#include "Tools/CrasheeJSONCodec.h"
+
 
 #pragma mark - Report Types -
 
@@ -56,172 +58,320 @@
 #define CrasheeCrashExcType_User                "user"
 
 
+/** Every field name. Each CrasheeCrashField_* below refers to its entry in
+ * g_crasheeCrashFieldNames, which also holds the name pre-quoted for JSON so
+ * that the encoder can write it without escaping.
+ *
+ * Names must not need JSON escaping.
+ */
+#define CrasheeCRASH_FIELD_NAMES(FIELD) \
+    /* Common */ \
+    FIELD(Address,                  "address") \
+    FIELD(Contents,                 "contents") \
+    FIELD(Exception,                "exception") \
+    FIELD(FirstObject,              "first_object") \
+    FIELD(Index,                    "index") \
+    FIELD(Ivars,                    "ivars") \
+    FIELD(Language,                 "language") \
+    FIELD(Name,                     "name") \
+    FIELD(UserInfo,                 "userInfo") \
+    FIELD(ReferencedObject,         "referenced_object") \
+    FIELD(Type,                     "type") \
+    FIELD(UUID,                     "uuid") \
+    FIELD(Value,                    "value") \
+    FIELD(Error,                    "error") \
+    FIELD(JSONData,                 "json_data") \
+    /* Notable Address */ \
+    FIELD(Class,                    "class") \
+    FIELD(LastDeallocObject,        "last_deallocated_obj") \
+    /* Backtrace */ \
+    FIELD(InstructionAddr,          "instruction_addr") \
+    FIELD(LineOfCode,               "line_of_code") \
+    FIELD(ObjectAddr,               "object_addr") \
+    FIELD(ObjectName,               "object_name") \
+    FIELD(SymbolAddr,               "symbol_addr") \
+    FIELD(SymbolName,               "symbol_name") \
+    /* Stack Dump */ \
+    FIELD(DumpEnd,                  "dump_end") \
+    FIELD(DumpStart,                "dump_start") \
+    FIELD(GrowDirection,            "grow_direction") \
+    FIELD(Overflow,                 "overflow") \
+    FIELD(StackPtr,                 "stack_pointer") \
+    /* Thread Dump */ \
+    FIELD(Backtrace,                "backtrace") \
+    FIELD(Basic,                    "basic") \
+    FIELD(Crashed,                  "crashed") \
+    FIELD(CurrentThread,            "current_thread") \
+    FIELD(DispatchQueue,            "dispatch_queue") \
+    FIELD(NotableAddresses,         "notable_addresses") \
+    FIELD(Registers,                "registers") \
+    FIELD(Skipped,                  "skipped") \
+    FIELD(Stack,                    "stack") \
+    /* Binary Image */ \
+    FIELD(CPUSubType,               "cpu_subtype") \
+    FIELD(CPUType,                  "cpu_type") \
+    FIELD(ImageAddress,             "image_addr") \
+    FIELD(ImageVmAddress,           "image_vmaddr") \
+    FIELD(ImageSize,                "image_size") \
+    FIELD(ImageMajorVersion,        "major_version") \
+    FIELD(ImageMinorVersion,        "minor_version") \
+    FIELD(ImageRevisionVersion,     "revision_version") \
+    /* Memory */ \
+    FIELD(Free,                     "free") \
+    FIELD(Usable,                   "usable") \
+    /* Error */ \
+    FIELD(Code,                     "code") \
+    FIELD(CodeName,                 "code_name") \
+    FIELD(CPPException,             "cpp_exception") \
+    FIELD(ExceptionName,            "exception_name") \
+    FIELD(Mach,                     "mach") \
+    FIELD(NSException,              "nsexception") \
+    FIELD(Reason,                   "reason") \
+    FIELD(Signal,                   "signal") \
+    FIELD(Subcode,                  "subcode") \
+    FIELD(UserReported,             "user_reported") \
+    /* Process State */ \
+    FIELD(LastDeallocedNSException, "last_dealloced_nsexception") \
+    FIELD(ProcessState,             "process") \
+    /* App Stats */ \
+    FIELD(ActiveTimeSinceCrash,     "active_time_since_last_crash") \
+    FIELD(ActiveTimeSinceLaunch,    "active_time_since_launch") \
+    FIELD(AppActive,                "application_active") \
+    FIELD(AppInFG,                  "application_in_foreground") \
+    FIELD(BGTimeSinceCrash,         "background_time_since_last_crash") \
+    FIELD(BGTimeSinceLaunch,        "background_time_since_launch") \
+    FIELD(LaunchesSinceCrash,       "launches_since_last_crash") \
+    FIELD(SessionsSinceCrash,       "sessions_since_last_crash") \
+    FIELD(SessionsSinceLaunch,      "sessions_since_launch") \
+    /* Report */ \
+    FIELD(Crash,                    "crash") \
+    FIELD(Debug,                    "debug") \
+    FIELD(Diagnosis,                "diagnosis") \
+    FIELD(ID,                       "id") \
+    FIELD(ProcessName,              "process_name") \
+    FIELD(Report,                   "report") \
+    FIELD(Timestamp,                "timestamp") \
+    FIELD(Version,                  "version") \
+    /* Minimal */ \
+    FIELD(CrashedThread,            "crashed_thread") \
+    /* Standard */ \
+    FIELD(AppStats,                 "application_stats") \
+    FIELD(BinaryImages,             "binary_images") \
+    FIELD(System,                   "system") \
+    FIELD(Memory,                   "memory") \
+    FIELD(Threads,                  "threads") \
+    FIELD(User,                     "user") \
+    FIELD(ConsoleLog,               "console_log") \
+    /* Incomplete */ \
+    FIELD(Incomplete,               "incomplete") \
+    FIELD(RecrashReport,            "recrash_report") \
+    /* System */ \
+    FIELD(AppStartTime,             "app_start_time") \
+    FIELD(AppUUID,                  "app_uuid") \
+    FIELD(BootTime,                 "boot_time") \
+    FIELD(BundleID,                 "CFBundleIdentifier") \
+    FIELD(BundleName,               "CFBundleName") \
+    FIELD(BundleShortVersion,       "CFBundleShortVersionString") \
+    FIELD(BundleVersion,            "CFBundleVersion") \
+    FIELD(CPUArch,                  "cpu_arch") \
+    FIELD(BinaryCPUType,            "binary_cpu_type") \
+    FIELD(BinaryCPUSubType,         "binary_cpu_subtype") \
+    FIELD(DeviceAppHash,            "device_app_hash") \
+    FIELD(Executable,               "CFBundleExecutable") \
+    FIELD(ExecutablePath,           "CFBundleExecutablePath") \
+    FIELD(Jailbroken,               "jailbroken") \
+    FIELD(KernelVersion,            "kernel_version") \
+    FIELD(Machine,                  "machine") \
+    FIELD(Model,                    "model") \
+    FIELD(OSVersion,                "os_version") \
+    FIELD(ParentProcessID,          "parent_process_id") \
+    FIELD(ProcessID,                "process_id") \
+    FIELD(Size,                     "size") \
+    FIELD(Storage,                  "storage") \
+    FIELD(SystemName,               "system_name") \
+    FIELD(SystemVersion,            "system_version") \
+    FIELD(TimeZone,                 "time_zone") \
+    FIELD(BuildType,                "build_type")
+
+typedef enum
+{
+#define CrasheeCRASH_FIELD_INDEX(ID, NAME) CrasheeCrashFieldIndex_##ID,
+    CrasheeCRASH_FIELD_NAMES(CrasheeCRASH_FIELD_INDEX)
+#undef CrasheeCRASH_FIELD_INDEX
+    CrasheeCrashFieldCount
+} CrasheeCrashFieldIndex;
+
+extern const CrasheeJSONInternedName g_crasheeCrashFieldNames[CrasheeCrashFieldCount];
+
+#define CrasheeCrashField(ID) (g_crasheeCrashFieldNames[CrasheeCrashFieldIndex_##ID].name)
+
+
 #pragma mark - Common -
 
-#define CrasheeCrashField_Address               "address"
-#define CrasheeCrashField_Contents              "contents"
-#define CrasheeCrashField_Exception             "exception"
-#define CrasheeCrashField_FirstObject           "first_object"
-#define CrasheeCrashField_Index                 "index"
-#define CrasheeCrashField_Ivars                 "ivars"
-#define CrasheeCrashField_Language              "language"
-#define CrasheeCrashField_Name                  "name"
-#define CrasheeCrashField_UserInfo              "userInfo"
-#define CrasheeCrashField_ReferencedObject      "referenced_object"
-#define CrasheeCrashField_Type                  "type"
-#define CrasheeCrashField_UUID                  "uuid"
-#define CrasheeCrashField_Value                 "value"
+#define CrasheeCrashField_Address               CrasheeCrashField(Address)
+#define CrasheeCrashField_Contents              CrasheeCrashField(Contents)
+#define CrasheeCrashField_Exception             CrasheeCrashField(Exception)
+#define CrasheeCrashField_FirstObject           CrasheeCrashField(FirstObject)
+#define CrasheeCrashField_Index                 CrasheeCrashField(Index)
+#define CrasheeCrashField_Ivars                 CrasheeCrashField(Ivars)
+#define CrasheeCrashField_Language              CrasheeCrashField(Language)
+#define CrasheeCrashField_Name                  CrasheeCrashField(Name)
+#define CrasheeCrashField_UserInfo              CrasheeCrashField(UserInfo)
+#define CrasheeCrashField_ReferencedObject      CrasheeCrashField(ReferencedObject)
+#define CrasheeCrashField_Type                  CrasheeCrashField(Type)
+#define CrasheeCrashField_UUID                  CrasheeCrashField(UUID)
+#define CrasheeCrashField_Value                 CrasheeCrashField(Value)
 
-#define CrasheeCrashField_Error                 "error"
-#define CrasheeCrashField_JSONData              "json_data"
+#define CrasheeCrashField_Error                 CrasheeCrashField(Error)
+#define CrasheeCrashField_JSONData              CrasheeCrashField(JSONData)
 
 
 #pragma mark - Notable Address -
 
-#define CrasheeCrashField_Class                 "class"
-#define CrasheeCrashField_LastDeallocObject     "last_deallocated_obj"
+#define CrasheeCrashField_Class                 CrasheeCrashField(Class)
+#define CrasheeCrashField_LastDeallocObject     CrasheeCrashField(LastDeallocObject)
 
 
 #pragma mark - Backtrace -
 
-#define CrasheeCrashField_InstructionAddr       "instruction_addr"
-#define CrasheeCrashField_LineOfCode            "line_of_code"
-#define CrasheeCrashField_ObjectAddr            "object_addr"
-#define CrasheeCrashField_ObjectName            "object_name"
-#define CrasheeCrashField_SymbolAddr            "symbol_addr"
-#define CrasheeCrashField_SymbolName            "symbol_name"
+#define CrasheeCrashField_InstructionAddr       CrasheeCrashField(InstructionAddr)
+#define CrasheeCrashField_LineOfCode            CrasheeCrashField(LineOfCode)
+#define CrasheeCrashField_ObjectAddr            CrasheeCrashField(ObjectAddr)
+#define CrasheeCrashField_ObjectName            CrasheeCrashField(ObjectName)
+#define CrasheeCrashField_SymbolAddr            CrasheeCrashField(SymbolAddr)
+#define CrasheeCrashField_SymbolName            CrasheeCrashField(SymbolName)
 
 
 #pragma mark - Stack Dump -
 
-#define CrasheeCrashField_DumpEnd               "dump_end"
-#define CrasheeCrashField_DumpStart             "dump_start"
-#define CrasheeCrashField_GrowDirection         "grow_direction"
-#define CrasheeCrashField_Overflow              "overflow"
-#define CrasheeCrashField_StackPtr              "stack_pointer"
+#define CrasheeCrashField_DumpEnd               CrasheeCrashField(DumpEnd)
+#define CrasheeCrashField_DumpStart             CrasheeCrashField(DumpStart)
+#define CrasheeCrashField_GrowDirection         CrasheeCrashField(GrowDirection)
+#define CrasheeCrashField_Overflow              CrasheeCrashField(Overflow)
+#define CrasheeCrashField_StackPtr              CrasheeCrashField(StackPtr)
 
 
 #pragma mark - Thread Dump -
 
-#define CrasheeCrashField_Backtrace             "backtrace"
-#define CrasheeCrashField_Basic                 "basic"
-#define CrasheeCrashField_Crashed               "crashed"
-#define CrasheeCrashField_CurrentThread         "current_thread"
-#define CrasheeCrashField_DispatchQueue         "dispatch_queue"
-#define CrasheeCrashField_NotableAddresses      "notable_addresses"
-#define CrasheeCrashField_Registers             "registers"
-#define CrasheeCrashField_Skipped               "skipped"
-#define CrasheeCrashField_Stack                 "stack"
+#define CrasheeCrashField_Backtrace             CrasheeCrashField(Backtrace)
+#define CrasheeCrashField_Basic                 CrasheeCrashField(Basic)
+#define CrasheeCrashField_Crashed               CrasheeCrashField(Crashed)
+#define CrasheeCrashField_CurrentThread         CrasheeCrashField(CurrentThread)
+#define CrasheeCrashField_DispatchQueue         CrasheeCrashField(DispatchQueue)
+#define CrasheeCrashField_NotableAddresses      CrasheeCrashField(NotableAddresses)
+#define CrasheeCrashField_Registers             CrasheeCrashField(Registers)
+#define CrasheeCrashField_Skipped               CrasheeCrashField(Skipped)
+#define CrasheeCrashField_Stack                 CrasheeCrashField(Stack)
 
 
 #pragma mark - Binary Image -
 
-#define CrasheeCrashField_CPUSubType            "cpu_subtype"
-#define CrasheeCrashField_CPUType               "cpu_type"
-#define CrasheeCrashField_ImageAddress          "image_addr"
-#define CrasheeCrashField_ImageVmAddress        "image_vmaddr"
-#define CrasheeCrashField_ImageSize             "image_size"
-#define CrasheeCrashField_ImageMajorVersion     "major_version"
-#define CrasheeCrashField_ImageMinorVersion     "minor_version"
-#define CrasheeCrashField_ImageRevisionVersion  "revision_version"
+#define CrasheeCrashField_CPUSubType            CrasheeCrashField(CPUSubType)
+#define CrasheeCrashField_CPUType               CrasheeCrashField(CPUType)
+#define CrasheeCrashField_ImageAddress          CrasheeCrashField(ImageAddress)
+#define CrasheeCrashField_ImageVmAddress        CrasheeCrashField(ImageVmAddress)
+#define CrasheeCrashField_ImageSize             CrasheeCrashField(ImageSize)
+#define CrasheeCrashField_ImageMajorVersion     CrasheeCrashField(ImageMajorVersion)
+#define CrasheeCrashField_ImageMinorVersion     CrasheeCrashField(ImageMinorVersion)
+#define CrasheeCrashField_ImageRevisionVersion  CrasheeCrashField(ImageRevisionVersion)
 
 
 #pragma mark - Memory -
 
-#define CrasheeCrashField_Free                  "free"
-#define CrasheeCrashField_Usable                "usable"
+#define CrasheeCrashField_Free                  CrasheeCrashField(Free)
+#define CrasheeCrashField_Usable                CrasheeCrashField(Usable)
 
 
 #pragma mark - Error -
 
-#define CrasheeCrashField_Backtrace             "backtrace"
-#define CrasheeCrashField_Code                  "code"
-#define CrasheeCrashField_CodeName              "code_name"
-#define CrasheeCrashField_CPPException          "cpp_exception"
-#define CrasheeCrashField_ExceptionName         "exception_name"
-#define CrasheeCrashField_Mach                  "mach"
-#define CrasheeCrashField_NSException           "nsexception"
-#define CrasheeCrashField_Reason                "reason"
-#define CrasheeCrashField_Signal                "signal"
-#define CrasheeCrashField_Subcode               "subcode"
-#define CrasheeCrashField_UserReported          "user_reported"
+#define CrasheeCrashField_Backtrace             CrasheeCrashField(Backtrace)
+#define CrasheeCrashField_Code                  CrasheeCrashField(Code)
+#define CrasheeCrashField_CodeName              CrasheeCrashField(CodeName)
+#define CrasheeCrashField_CPPException          CrasheeCrashField(CPPException)
+#define CrasheeCrashField_ExceptionName         CrasheeCrashField(ExceptionName)
+#define CrasheeCrashField_Mach                  CrasheeCrashField(Mach)
+#define CrasheeCrashField_NSException           CrasheeCrashField(NSException)
+#define CrasheeCrashField_Reason                CrasheeCrashField(Reason)
+#define CrasheeCrashField_Signal                CrasheeCrashField(Signal)
+#define CrasheeCrashField_Subcode               CrasheeCrashField(Subcode)
+#define CrasheeCrashField_UserReported          CrasheeCrashField(UserReported)
 
 
 #pragma mark - Process State -
 
-#define CrasheeCrashField_LastDeallocedNSException "last_dealloced_nsexception"
-#define CrasheeCrashField_ProcessState             "process"
+#define CrasheeCrashField_LastDeallocedNSException CrasheeCrashField(LastDeallocedNSException)
+#define CrasheeCrashField_ProcessState             CrasheeCrashField(ProcessState)
 
 
 #pragma mark - App Stats -
 
-#define CrasheeCrashField_ActiveTimeSinceCrash  "active_time_since_last_crash"
-#define CrasheeCrashField_ActiveTimeSinceLaunch "active_time_since_launch"
-#define CrasheeCrashField_AppActive             "application_active"
-#define CrasheeCrashField_AppInFG               "application_in_foreground"
-#define CrasheeCrashField_BGTimeSinceCrash      "background_time_since_last_crash"
-#define CrasheeCrashField_BGTimeSinceLaunch     "background_time_since_launch"
-#define CrasheeCrashField_LaunchesSinceCrash    "launches_since_last_crash"
-#define CrasheeCrashField_SessionsSinceCrash    "sessions_since_last_crash"
-#define CrasheeCrashField_SessionsSinceLaunch   "sessions_since_launch"
+#define CrasheeCrashField_ActiveTimeSinceCrash  CrasheeCrashField(ActiveTimeSinceCrash)
+#define CrasheeCrashField_ActiveTimeSinceLaunch CrasheeCrashField(ActiveTimeSinceLaunch)
+#define CrasheeCrashField_AppActive             CrasheeCrashField(AppActive)
+#define CrasheeCrashField_AppInFG               CrasheeCrashField(AppInFG)
+#define CrasheeCrashField_BGTimeSinceCrash      CrasheeCrashField(BGTimeSinceCrash)
+#define CrasheeCrashField_BGTimeSinceLaunch     CrasheeCrashField(BGTimeSinceLaunch)
+#define CrasheeCrashField_LaunchesSinceCrash    CrasheeCrashField(LaunchesSinceCrash)
+#define CrasheeCrashField_SessionsSinceCrash    CrasheeCrashField(SessionsSinceCrash)
+#define CrasheeCrashField_SessionsSinceLaunch   CrasheeCrashField(SessionsSinceLaunch)
 
 
 #pragma mark - Report -
 
-#define CrasheeCrashField_Crash                 "crash"
-#define CrasheeCrashField_Debug                 "debug"
-#define CrasheeCrashField_Diagnosis             "diagnosis"
-#define CrasheeCrashField_ID                    "id"
-#define CrasheeCrashField_ProcessName           "process_name"
-#define CrasheeCrashField_Report                "report"
-#define CrasheeCrashField_Timestamp             "timestamp"
-#define CrasheeCrashField_Version               "version"
+#define CrasheeCrashField_Crash                 CrasheeCrashField(Crash)
+#define CrasheeCrashField_Debug                 CrasheeCrashField(Debug)
+#define CrasheeCrashField_Diagnosis             CrasheeCrashField(Diagnosis)
+#define CrasheeCrashField_ID                    CrasheeCrashField(ID)
+#define CrasheeCrashField_ProcessName           CrasheeCrashField(ProcessName)
+#define CrasheeCrashField_Report                CrasheeCrashField(Report)
+#define CrasheeCrashField_Timestamp             CrasheeCrashField(Timestamp)
+#define CrasheeCrashField_Version               CrasheeCrashField(Version)
 
 #pragma mark Minimal
-#define CrasheeCrashField_CrashedThread         "crashed_thread"
+#define CrasheeCrashField_CrashedThread         CrasheeCrashField(CrashedThread)
 
 #pragma mark Standard
-#define CrasheeCrashField_AppStats              "application_stats"
-#define CrasheeCrashField_BinaryImages          "binary_images"
-#define CrasheeCrashField_System                "system"
-#define CrasheeCrashField_Memory                "memory"
-#define CrasheeCrashField_Threads               "threads"
-#define CrasheeCrashField_User                  "user"
-#define CrasheeCrashField_ConsoleLog            "console_log"
+#define CrasheeCrashField_AppStats              CrasheeCrashField(AppStats)
+#define CrasheeCrashField_BinaryImages          CrasheeCrashField(BinaryImages)
+#define CrasheeCrashField_System                CrasheeCrashField(System)
+#define CrasheeCrashField_Memory                CrasheeCrashField(Memory)
+#define CrasheeCrashField_Threads               CrasheeCrashField(Threads)
+#define CrasheeCrashField_User                  CrasheeCrashField(User)
+#define CrasheeCrashField_ConsoleLog            CrasheeCrashField(ConsoleLog)
 
 #pragma mark Incomplete
-#define CrasheeCrashField_Incomplete            "incomplete"
-#define CrasheeCrashField_RecrashReport         "recrash_report"
+#define CrasheeCrashField_Incomplete            CrasheeCrashField(Incomplete)
+#define CrasheeCrashField_RecrashReport         CrasheeCrashField(RecrashReport)
 
 #pragma mark System
-#define CrasheeCrashField_AppStartTime          "app_start_time"
-#define CrasheeCrashField_AppUUID               "app_uuid"
-#define CrasheeCrashField_BootTime              "boot_time"
-#define CrasheeCrashField_BundleID              "CFBundleIdentifier"
-#define CrasheeCrashField_BundleName            "CFBundleName"
-#define CrasheeCrashField_BundleShortVersion    "CFBundleShortVersionString"
-#define CrasheeCrashField_BundleVersion         "CFBundleVersion"
-#define CrasheeCrashField_CPUArch               "cpu_arch"
-#define CrasheeCrashField_CPUType               "cpu_type"
-#define CrasheeCrashField_CPUSubType            "cpu_subtype"
-#define CrasheeCrashField_BinaryCPUType         "binary_cpu_type"
-#define CrasheeCrashField_BinaryCPUSubType      "binary_cpu_subtype"
-#define CrasheeCrashField_DeviceAppHash         "device_app_hash"
-#define CrasheeCrashField_Executable            "CFBundleExecutable"
-#define CrasheeCrashField_ExecutablePath        "CFBundleExecutablePath"
-#define CrasheeCrashField_Jailbroken            "jailbroken"
-#define CrasheeCrashField_KernelVersion         "kernel_version"
-#define CrasheeCrashField_Machine               "machine"
-#define CrasheeCrashField_Model                 "model"
-#define CrasheeCrashField_OSVersion             "os_version"
-#define CrasheeCrashField_ParentProcessID       "parent_process_id"
-#define CrasheeCrashField_ProcessID             "process_id"
-#define CrasheeCrashField_ProcessName           "process_name"
-#define CrasheeCrashField_Size                  "size"
-#define CrasheeCrashField_Storage               "storage"
-#define CrasheeCrashField_SystemName            "system_name"
-#define CrasheeCrashField_SystemVersion         "system_version"
-#define CrasheeCrashField_TimeZone              "time_zone"
-#define CrasheeCrashField_BuildType             "build_type"
+#define CrasheeCrashField_AppStartTime          CrasheeCrashField(AppStartTime)
+#define CrasheeCrashField_AppUUID               CrasheeCrashField(AppUUID)
+#define CrasheeCrashField_BootTime              CrasheeCrashField(BootTime)
+#define CrasheeCrashField_BundleID              CrasheeCrashField(BundleID)
+#define CrasheeCrashField_BundleName            CrasheeCrashField(BundleName)
+#define CrasheeCrashField_BundleShortVersion    CrasheeCrashField(BundleShortVersion)
+#define CrasheeCrashField_BundleVersion         CrasheeCrashField(BundleVersion)
+#define CrasheeCrashField_CPUArch               CrasheeCrashField(CPUArch)
+#define CrasheeCrashField_CPUType               CrasheeCrashField(CPUType)
+#define CrasheeCrashField_CPUSubType            CrasheeCrashField(CPUSubType)
+#define CrasheeCrashField_BinaryCPUType         CrasheeCrashField(BinaryCPUType)
+#define CrasheeCrashField_BinaryCPUSubType      CrasheeCrashField(BinaryCPUSubType)
+#define CrasheeCrashField_DeviceAppHash         CrasheeCrashField(DeviceAppHash)
+#define CrasheeCrashField_Executable            CrasheeCrashField(Executable)
+#define CrasheeCrashField_ExecutablePath        CrasheeCrashField(ExecutablePath)
+#define CrasheeCrashField_Jailbroken            CrasheeCrashField(Jailbroken)
+#define CrasheeCrashField_KernelVersion         CrasheeCrashField(KernelVersion)
+#define CrasheeCrashField_Machine               CrasheeCrashField(Machine)
+#define CrasheeCrashField_Model                 CrasheeCrashField(Model)
+#define CrasheeCrashField_OSVersion             CrasheeCrashField(OSVersion)
+#define CrasheeCrashField_ParentProcessID       CrasheeCrashField(ParentProcessID)
+#define CrasheeCrashField_ProcessID             CrasheeCrashField(ProcessID)
+#define CrasheeCrashField_ProcessName           CrasheeCrashField(ProcessName)
+#define CrasheeCrashField_Size                  CrasheeCrashField(Size)
+#define CrasheeCrashField_Storage               CrasheeCrashField(Storage)
+#define CrasheeCrashField_SystemName            CrasheeCrashField(SystemName)
+#define CrasheeCrashField_SystemVersion         CrasheeCrashField(SystemVersion)
+#define CrasheeCrashField_TimeZone              CrasheeCrashField(TimeZone)
+#define CrasheeCrashField_BuildType             CrasheeCrashField(BuildType)
 
 #endif
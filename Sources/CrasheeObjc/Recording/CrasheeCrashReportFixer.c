@@ -24,190 +24,387 @@
 // THE SOFTWARE.
 //
 
+#include "CrasheeCrashReportFixer.h"
 #include "CrasheeCrashReportFields.h"
 #include "CrasheeSystemCapabilities.h"
 #include "Tools/CrasheeJSONCodec.h"
 #include "Tools/CrasheeDate.h"
+#include "Tools/CrasheeFileUtils.h"
 #include "Tools/CrasheeLogger.h"
 
+#include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+/** The size of the buffers that streaming fixups read and write through.
+ * Both live on the stack.
+ */
+#ifndef CrasheeCRF_StreamBufferSize
+    #define CrasheeCRF_StreamBufferSize 16384
+#endif
+
+/** The size of the (heap) buffer that crasheecrf_fixupCrashReportFromFD()
+ * decodes names and strings into. This is the longest string a streamed
+ * report can contain. 1/4 of it is used for names.
+ */
+#ifndef CrasheeCRF_StreamStringBufferSize
+    #define CrasheeCRF_StreamStringBufferSize 65536
+#endif
 
 #define MAX_DEPTH 100
-#define MAX_NAME_LENGTH 100
+#define MAX_PATH_NODES 32
+#define INITIAL_NAME_BUFFER_LENGTH 256
+#define INITIAL_STRING_BUFFER_LENGTH 1024
 #define REPORT_VERSION_COMPONENTS_COUNT 3
 
-static char* datePaths[][MAX_DEPTH] =
+static const char* datePaths[][MAX_DEPTH] =
 {
     {"", CrasheeCrashField_Report, CrasheeCrashField_Version},
     {"", CrasheeCrashField_RecrashReport, CrasheeCrashField_Report, CrasheeCrashField_Version},
 };
 static int datePathsCount = sizeof(datePaths) / sizeof(*datePaths);
 
+
+// ============================================================================
+#pragma mark - Path Trie -
+// ============================================================================
+
+/** A node in the trie of paths that need fixing.
+ * Node 0 is the root, which sits above the top level container. Since it's
+ * never anyone's child, 0 also means "no node".
+ */
+typedef struct
+{
+    const char* name;
+    int firstChild;
+    int nextSibling;
+    /** Integer elements at this path are timestamps to convert to date strings. */
+    bool isDate;
+} PathNode;
+
+static PathNode g_pathNodes[MAX_PATH_NODES];
+static int g_pathNodeCount = 1;
+static pthread_once_t g_pathTrieOnce = PTHREAD_ONCE_INIT;
+
+static int findChildNode(const int node, const char* name)
+{
+    if(name == NULL)
+    {
+        name = "";
+    }
+    for(int child = g_pathNodes[node].firstChild; child != 0; child = g_pathNodes[child].nextSibling)
+    {
+        if(strcmp(g_pathNodes[child].name, name) == 0)
+        {
+            return child;
+        }
+    }
+    return 0;
+}
+
+static int addChildNode(const int node, const char* const name)
+{
+    int child = findChildNode(node, name);
+    if(child != 0)
+    {
+        return child;
+    }
+    if(g_pathNodeCount >= MAX_PATH_NODES)
+    {
+        CrasheeLOG_ERROR("Too many fixup paths. Increase MAX_PATH_NODES");
+        return 0;
+    }
+    child = g_pathNodeCount++;
+    g_pathNodes[child] = (PathNode){ .name = name, .nextSibling = g_pathNodes[node].firstChild };
+    g_pathNodes[node].firstChild = child;
+    return child;
+}
+
+static void addPaths(const char* paths[][MAX_DEPTH], const int pathsCount)
+{
+    for(int i = 0; i < pathsCount; i++)
+    {
+        int node = 0;
+        for(int depth = 0; depth < MAX_DEPTH && paths[i][depth] != NULL; depth++)
+        {
+            node = addChildNode(node, paths[i][depth]);
+            if(node == 0)
+            {
+                return;
+            }
+        }
+        g_pathNodes[node].isDate = true;
+    }
+}
+
+static void buildPathTrie(void)
+{
+    addPaths(datePaths, datePathsCount);
+}
+
+
+// ============================================================================
+#pragma mark - Fixup -
+// ============================================================================
+
 typedef struct
 {
     CrasheeJSONEncodeContext* encodeContext;
     int reportVersionComponents[REPORT_VERSION_COMPONENTS_COUNT];
-    char objectPath[MAX_DEPTH][MAX_NAME_LENGTH];
-    int currentDepth;
+    /** The trie node of the current container. Only valid if unmatchedDepth is 0. */
+    int pathNode;
+    /** The trie nodes of the enclosing containers. */
+    int pathNodeStack[MAX_DEPTH];
+    int pathDepth;
+    /** How many containers deep we are below the last one that is on a path.
+     * Nothing in there needs fixing, so there's nothing to look up.
+     */
+    int unmatchedDepth;
+    /** The start of the output buffer. */
+    char* outputBuffer;
     char* outputPtr;
     int outputBytesLeft;
+    /** When streaming, the file that the output buffer is flushed to. */
+    int outputFD;
+    /** Holds the current element's name. Grown as needed. */
+    char* nameBuffer;
+    int nameBufferLength;
+    /** Holds the current string value if it had to be unescaped. Grown as needed. */
+    char* stringBuffer;
+    int stringBufferLength;
 } FixupContext;
 
-static bool increaseDepth(FixupContext* context, const char* name)
+static int unescapeSlice(const CrasheeJSONSlice* const slice, char** const buffer, int* const bufferLength)
 {
-    if(context->currentDepth >= MAX_DEPTH)
+    if(slice->length >= *bufferLength)
     {
-        return false;
-    }
-    if(name == NULL)
-    {
-        *context->objectPath[context->currentDepth] = '\0';
+        int newLength = *bufferLength * 2;
+        if(newLength <= slice->length)
+        {
+            newLength = slice->length + 1;
+        }
+        char* newBuffer = realloc(*buffer, (unsigned)newLength);
+        if(newBuffer == NULL)
+        {
+            CrasheeLOG_ERROR("Failed to allocate string buffer of size %d", newLength);
+            return CrasheeJSON_ERROR_DATA_TOO_LONG;
+        }
+        *buffer = newBuffer;
+        *bufferLength = newLength;
     }
-    else
+    return crasheejson_unescapeSlice(slice, *buffer, *bufferLength);
+}
+
+/** Get the element name to encode from a decoded name slice (NULL for none). */
+static int getName(FixupContext* context, const CrasheeJSONSlice* const nameSlice, const char** const name)
+{
+    if(nameSlice == NULL)
     {
-        strncpy(context->objectPath[context->currentDepth], name, sizeof(context->objectPath[context->currentDepth]));
+        *name = NULL;
+        return CrasheeJSON_OK;
     }
-    context->currentDepth++;
-    return true;
+    *name = context->nameBuffer;
+    return unescapeSlice(nameSlice, &context->nameBuffer, &context->nameBufferLength);
 }
 
-static bool decreaseDepth(FixupContext* context)
+static void increaseDepth(FixupContext* context, const char* name)
 {
-    if(context->currentDepth <= 0)
+    if(context->unmatchedDepth > 0)
     {
-        return false;
+        context->unmatchedDepth++;
+        return;
     }
-    context->currentDepth--;
-    return true;
+    const int node = findChildNode(context->pathNode, name);
+    if(node == 0 || context->pathDepth >= MAX_DEPTH)
+    {
+        context->unmatchedDepth = 1;
+        return;
+    }
+    context->pathNodeStack[context->pathDepth++] = context->pathNode;
+    context->pathNode = node;
 }
 
-static bool matchesPath(FixupContext* context, char** path, const char* finalName)
+static void decreaseDepth(FixupContext* context)
 {
-    if(finalName == NULL)
+    if(context->unmatchedDepth > 0)
     {
-        finalName = "";
+        context->unmatchedDepth--;
     }
-
-    for(int i = 0;i < context->currentDepth; i++)
+    else if(context->pathDepth > 0)
     {
-        if(strncmp(context->objectPath[i], path[i], MAX_NAME_LENGTH) != 0)
-        {
-            return false;
-        }
+        context->pathNode = context->pathNodeStack[--context->pathDepth];
     }
-    if(strncmp(finalName, path[context->currentDepth], MAX_NAME_LENGTH) != 0)
+}
+
+static bool shouldFixDate(FixupContext* context, const char* name)
+{
+    if(context->unmatchedDepth > 0)
     {
         return false;
     }
-    return true;
+    const int node = findChildNode(context->pathNode, name);
+    return node != 0 && g_pathNodes[node].isDate;
 }
 
-static bool matchesAPath(FixupContext* context, const char* name, char* paths[][MAX_DEPTH], int pathsCount)
+static int addIntegerElement(FixupContext* context, const char* const name, const int64_t value)
 {
-    for(int i = 0; i < pathsCount; i++)
+    if(shouldFixDate(context, name))
     {
-        if(matchesPath(context, paths[i], name))
-        {
-            return true;
-        }
+        char buffer[28];
+        crasheedate_utcStringFromTimestamp((time_t)value, buffer);
+
+        return crasheejson_addStringElement(context->encodeContext, name, buffer, (int)strlen(buffer));
     }
-    return false;
+    return crasheejson_addIntegerElement(context->encodeContext, name, value);
 }
 
-static bool shouldFixDate(FixupContext* context, const char* name)
+static int beginContainer(FixupContext* context, const char* const name, const bool isObject)
 {
-    return matchesAPath(context, name, datePaths, datePathsCount);
+    int result = isObject ? crasheejson_beginObject(context->encodeContext, name)
+                          : crasheejson_beginArray(context->encodeContext, name);
+    increaseDepth(context, name);
+    return result;
 }
 
-static int onBooleanElement(const char* const name,
+static int endContainer(FixupContext* context)
+{
+    int result = crasheejson_endContainer(context->encodeContext);
+    decreaseDepth(context);
+    return result;
+}
+
+
+// ============================================================================
+#pragma mark - Slice Callbaccrashee -
+// ============================================================================
+
+static int onBooleanElement(const CrasheeJSONSlice* const nameSlice,
                             const bool value,
                             void* const userData)
 {
     FixupContext* context = (FixupContext*)userData;
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
     return crasheejson_addBooleanElement(context->encodeContext, name, value);
 }
 
-static int onFloatingPointElement(const char* const name,
+static int onFloatingPointElement(const CrasheeJSONSlice* const nameSlice,
                                   const double value,
                                   void* const userData)
 {
     FixupContext* context = (FixupContext*)userData;
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
     return crasheejson_addFloatingPointElement(context->encodeContext, name, value);
 }
 
-static int onIntegerElement(const char* const name,
+static int onIntegerElement(const CrasheeJSONSlice* const nameSlice,
                             const int64_t value,
                             void* const userData)
 {
     FixupContext* context = (FixupContext*)userData;
-    int result = CrasheeJSON_OK;
-    if(shouldFixDate(context, name))
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
     {
-        char buffer[28];
-        crasheedate_utcStringFromTimestamp((time_t)value, buffer);
-
-        result = crasheejson_addStringElement(context->encodeContext, name, buffer, (int)strlen(buffer));
+        return result;
     }
-    else
+    return addIntegerElement(context, name, value);
+}
+
+static int onUnsignedIntegerElement(const CrasheeJSONSlice* const nameSlice,
+                                    const uint64_t value,
+                                    void* const userData)
+{
+    FixupContext* context = (FixupContext*)userData;
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
     {
-        result = crasheejson_addIntegerElement(context->encodeContext, name, value);
+        return result;
     }
-    return result;
+    return crasheejson_addUIntegerElement(context->encodeContext, name, value);
 }
 
-static int onNullElement(const char* const name,
+static int onNullElement(const CrasheeJSONSlice* const nameSlice,
                          void* const userData)
 {
     FixupContext* context = (FixupContext*)userData;
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
     return crasheejson_addNullElement(context->encodeContext, name);
 }
 
-static int onStringElement(const char* const name,
-                           const char* const value,
+static int onStringElement(const CrasheeJSONSlice* const nameSlice,
+                           const CrasheeJSONSlice* const value,
                            void* const userData)
 {
     FixupContext* context = (FixupContext*)userData;
-    const char* stringValue = value;
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
 
-    int result = crasheejson_addStringElement(context->encodeContext, name, stringValue, (int)strlen(stringValue));
+    // Most strings can be re-encoded straight from the source report.
+    if(!value->hasEscapes)
+    {
+        return crasheejson_addStringElement(context->encodeContext, name, value->string, value->length);
+    }
 
-    return result;
+    result = unescapeSlice(value, &context->stringBuffer, &context->stringBufferLength);
+    if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    const char* stringValue = context->stringBuffer;
+    return crasheejson_addStringElement(context->encodeContext, name, stringValue, (int)strlen(stringValue));
 }
 
-static int onBeginObject(const char* const name,
+static int onBeginObject(const CrasheeJSONSlice* const nameSlice,
                          void* const userData)
 {
     FixupContext* context = (FixupContext*)userData;
-    int result = crasheejson_beginObject(context->encodeContext, name);
-    if(!increaseDepth(context, name))
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
     {
-        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+        return result;
     }
-    return result;
+    return beginContainer(context, name, true);
 }
 
-static int onBeginArray(const char* const name,
+static int onBeginArray(const CrasheeJSONSlice* const nameSlice,
                         void* const userData)
 {
     FixupContext* context = (FixupContext*)userData;
-    int result = crasheejson_beginArray(context->encodeContext, name);
-    if(!increaseDepth(context, name))
+    const char* name;
+    int result = getName(context, nameSlice, &name);
+    if(result != CrasheeJSON_OK)
     {
-        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+        return result;
     }
-    return result;
+    return beginContainer(context, name, false);
 }
 
 static int onEndContainer(void* const userData)
 {
-    FixupContext* context = (FixupContext*)userData;
-    int result = crasheejson_endContainer(context->encodeContext);
-    if(!decreaseDepth(context))
-    {
-        // Do something;
-    }
-    return result;
+    return endContainer((FixupContext*)userData);
 }
 
 static int onEndData(__unused void* const userData)
@@ -216,6 +413,91 @@ static int onEndData(__unused void* const userData)
     return crasheejson_endEncode(context->encodeContext);
 }
 
+static CrasheeJSONSliceDecodeCallbaccrashee g_sliceCallbaccrashee =
+{
+    .onBeginArray = onBeginArray,
+    .onBeginObject = onBeginObject,
+    .onBooleanElement = onBooleanElement,
+    .onEndContainer = onEndContainer,
+    .onEndData = onEndData,
+    .onFloatingPointElement = onFloatingPointElement,
+    .onIntegerElement = onIntegerElement,
+    .onUnsignedIntegerElement = onUnsignedIntegerElement,
+    .onNullElement = onNullElement,
+    .onStringElement = onStringElement,
+};
+
+
+// ============================================================================
+#pragma mark - Stream Callbaccrashee -
+// ============================================================================
+
+// The push decoder has already unescaped names and strings into its own buffer.
+
+static int onStreamBooleanElement(const char* const name, const bool value, void* const userData)
+{
+    FixupContext* context = (FixupContext*)userData;
+    return crasheejson_addBooleanElement(context->encodeContext, name, value);
+}
+
+static int onStreamFloatingPointElement(const char* const name, const double value, void* const userData)
+{
+    FixupContext* context = (FixupContext*)userData;
+    return crasheejson_addFloatingPointElement(context->encodeContext, name, value);
+}
+
+static int onStreamIntegerElement(const char* const name, const int64_t value, void* const userData)
+{
+    return addIntegerElement((FixupContext*)userData, name, value);
+}
+
+static int onStreamUnsignedIntegerElement(const char* const name, const uint64_t value, void* const userData)
+{
+    FixupContext* context = (FixupContext*)userData;
+    return crasheejson_addUIntegerElement(context->encodeContext, name, value);
+}
+
+static int onStreamNullElement(const char* const name, void* const userData)
+{
+    FixupContext* context = (FixupContext*)userData;
+    return crasheejson_addNullElement(context->encodeContext, name);
+}
+
+static int onStreamStringElement(const char* const name, const char* const value, void* const userData)
+{
+    FixupContext* context = (FixupContext*)userData;
+    return crasheejson_addStringElement(context->encodeContext, name, value, (int)strlen(value));
+}
+
+static int onStreamBeginObject(const char* const name, void* const userData)
+{
+    return beginContainer((FixupContext*)userData, name, true);
+}
+
+static int onStreamBeginArray(const char* const name, void* const userData)
+{
+    return beginContainer((FixupContext*)userData, name, false);
+}
+
+static CrasheeJSONDecodeCallbaccrashee g_streamCallbaccrashee =
+{
+    .onBeginArray = onStreamBeginArray,
+    .onBeginObject = onStreamBeginObject,
+    .onBooleanElement = onStreamBooleanElement,
+    .onEndContainer = onEndContainer,
+    .onEndData = onEndData,
+    .onFloatingPointElement = onStreamFloatingPointElement,
+    .onIntegerElement = onStreamIntegerElement,
+    .onUnsignedIntegerElement = onStreamUnsignedIntegerElement,
+    .onNullElement = onStreamNullElement,
+    .onStringElement = onStreamStringElement,
+};
+
+
+// ============================================================================
+#pragma mark - Output -
+// ============================================================================
+
 static int addJSONData(const char* data, int length, void* userData)
 {
     FixupContext* context = (FixupContext*)userData;
@@ -230,62 +512,226 @@ static int addJSONData(const char* data, int length, void* userData)
     return CrasheeJSON_OK;
 }
 
-char* crasheecrf_fixupCrashReport(const char* crashReport)
+static bool flushOutput(FixupContext* context)
 {
-    if(crashReport == NULL)
+    const int length = (int)(context->outputPtr - context->outputBuffer);
+    context->outputPtr = context->outputBuffer;
+    context->outputBytesLeft += length;
+    return crasheefu_writeBytesToFD(context->outputFD, context->outputBuffer, length);
+}
+
+static int addJSONDataToFD(const char* data, int length, void* userData)
+{
+    FixupContext* context = (FixupContext*)userData;
+    if(length > context->outputBytesLeft)
     {
-        return NULL;
+        if(!flushOutput(context))
+        {
+            return CrasheeJSON_ERROR_CANNOT_ADD_DATA;
+        }
+        if(length > context->outputBytesLeft)
+        {
+            return crasheefu_writeBytesToFD(context->outputFD, data, length) ? CrasheeJSON_OK : CrasheeJSON_ERROR_CANNOT_ADD_DATA;
+        }
     }
+    return addJSONData(data, length, userData);
+}
 
-    CrasheeJSONDecodeCallbaccrashee callbaccrashee =
+/** Set up a fixup context, with buffers for unescaping slices if needed.
+ *
+ * @return true if successful.
+ */
+static bool initFixupContext(FixupContext* context,
+                             CrasheeJSONEncodeContext* encodeContext,
+                             bool needsSliceBuffers,
+                             char* outputBuffer,
+                             int outputBufferLength,
+                             int outputFD)
+{
+    pthread_once(&g_pathTrieOnce, buildPathTrie);
+    *context = (FixupContext)
     {
-        .onBeginArray = onBeginArray,
-        .onBeginObject = onBeginObject,
-        .onBooleanElement = onBooleanElement,
-        .onEndContainer = onEndContainer,
-        .onEndData = onEndData,
-        .onFloatingPointElement = onFloatingPointElement,
-        .onIntegerElement = onIntegerElement,
-        .onNullElement = onNullElement,
-        .onStringElement = onStringElement,
+        .encodeContext = encodeContext,
+        .outputBuffer = outputBuffer,
+        .outputPtr = outputBuffer,
+        .outputBytesLeft = outputBufferLength,
+        .outputFD = outputFD,
     };
-    int stringBufferLength = 10000;
-    char* stringBuffer = malloc((unsigned)stringBufferLength);
-    if(stringBuffer == NULL)
+    if(needsSliceBuffers)
     {
-        CrasheeLOG_ERROR("Failed to allocate string buffer of size %ul", stringBufferLength);
-        return NULL;
+        context->nameBuffer = malloc(INITIAL_NAME_BUFFER_LENGTH);
+        context->nameBufferLength = INITIAL_NAME_BUFFER_LENGTH;
+        context->stringBuffer = malloc(INITIAL_STRING_BUFFER_LENGTH);
+        context->stringBufferLength = INITIAL_STRING_BUFFER_LENGTH;
+        if(context->nameBuffer == NULL || context->stringBuffer == NULL)
+        {
+            free(context->nameBuffer);
+            free(context->stringBuffer);
+            CrasheeLOG_ERROR("Failed to allocate string buffers");
+            return false;
+        }
     }
-    int crashReportLength = (int)strlen(crashReport);
+    return true;
+}
+
+static void freeFixupContext(FixupContext* context)
+{
+    free(context->nameBuffer);
+    free(context->stringBuffer);
+    context->nameBuffer = NULL;
+    context->stringBuffer = NULL;
+}
+
+
+/** Fix up a report into newly allocated memory.
+ *
+ * @param prettyPrint If false, the report is re-encoded without whitespace.
+ */
+static char* fixupToBuffer(const char* crashReport, int crashReportLength, bool prettyPrint, int* fixedLength)
+{
     int fixedReportLength = (int)(crashReportLength * 1.5);
-    char* fixedReport = malloc((unsigned)fixedReportLength);
+    // Leave room for the null terminator.
+    char* fixedReport = malloc((unsigned)fixedReportLength + 1);
     if(fixedReport == NULL)
     {
-        free(stringBuffer);
         CrasheeLOG_ERROR("Failed to allocate fixed report buffer of size %ld", fixedReportLength);
         return NULL;
     }
     CrasheeJSONEncodeContext encodeContext;
-    FixupContext fixupContext =
+    FixupContext fixupContext;
+    if(!initFixupContext(&fixupContext, &encodeContext, true, fixedReport, fixedReportLength, -1))
     {
-        .encodeContext = &encodeContext,
-        .reportVersionComponents = {0},
-        .currentDepth = 0,
-        .outputPtr = fixedReport,
-        .outputBytesLeft = fixedReportLength,
-    };
+        free(fixedReport);
+        return NULL;
+    }
 
-    crasheejson_beginEncode(&encodeContext, true, addJSONData, &fixupContext);
+    crasheejson_beginEncode(&encodeContext, prettyPrint, addJSONData, &fixupContext);
 
     int errorOffset = 0;
-    int result = crasheejson_decode(crashReport, (int)strlen(crashReport), stringBuffer, stringBufferLength, &callbaccrashee, &fixupContext, &errorOffset);
+    int result = crasheejson_decodeSlices(crashReport, crashReportLength, &g_sliceCallbaccrashee, &fixupContext, &errorOffset);
     *fixupContext.outputPtr = '\0';
-    free(stringBuffer);
+    freeFixupContext(&fixupContext);
     if(result != CrasheeJSON_OK)
     {
         CrasheeLOG_ERROR("Could not decode report: %s", crasheejson_stringForError(result));
         free(fixedReport);
         return NULL;
     }
+    if(fixedLength != NULL)
+    {
+        *fixedLength = (int)(fixupContext.outputPtr - fixedReport);
+    }
     return fixedReport;
 }
+
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+char* crasheecrf_fixupCrashReport(const char* crashReport)
+{
+    if(crashReport == NULL)
+    {
+        return NULL;
+    }
+    return crasheecrf_fixupCrashReportData(crashReport, (int)strlen(crashReport), NULL);
+}
+
+char* crasheecrf_fixupCrashReportData(const char* crashReport, int crashReportLength, int* fixedLength)
+{
+    if(crashReport == NULL)
+    {
+        return NULL;
+    }
+    return fixupToBuffer(crashReport, crashReportLength, true, fixedLength);
+}
+
+char* crasheecrf_minifyCrashReport(const char* crashReport, int crashReportLength, int* minifiedLength)
+{
+    if(crashReport == NULL)
+    {
+        return NULL;
+    }
+    return fixupToBuffer(crashReport, crashReportLength, false, minifiedLength);
+}
+
+bool crasheecrf_fixupCrashReportToFD(const char* crashReport, int crashReportLength, int outputFD)
+{
+    if(crashReport == NULL)
+    {
+        return false;
+    }
+
+    char outputBuffer[CrasheeCRF_StreamBufferSize];
+    CrasheeJSONEncodeContext encodeContext;
+    FixupContext fixupContext;
+    if(!initFixupContext(&fixupContext, &encodeContext, true, outputBuffer, sizeof(outputBuffer), outputFD))
+    {
+        return false;
+    }
+
+    crasheejson_beginEncode(&encodeContext, true, addJSONDataToFD, &fixupContext);
+
+    int errorOffset = 0;
+    int result = crasheejson_decodeSlices(crashReport, crashReportLength, &g_sliceCallbaccrashee, &fixupContext, &errorOffset);
+    freeFixupContext(&fixupContext);
+    if(result != CrasheeJSON_OK)
+    {
+        CrasheeLOG_ERROR("Could not decode report: %s", crasheejson_stringForError(result));
+        return false;
+    }
+    return flushOutput(&fixupContext);
+}
+
+bool crasheecrf_fixupCrashReportFromFD(int inputFD, int outputFD)
+{
+    char* stringBuffer = malloc(CrasheeCRF_StreamStringBufferSize);
+    if(stringBuffer == NULL)
+    {
+        CrasheeLOG_ERROR("Failed to allocate string buffer of size %d", CrasheeCRF_StreamStringBufferSize);
+        return false;
+    }
+    char readBuffer[CrasheeCRF_StreamBufferSize];
+    char outputBuffer[CrasheeCRF_StreamBufferSize];
+    CrasheeJSONEncodeContext encodeContext;
+    FixupContext fixupContext;
+    initFixupContext(&fixupContext, &encodeContext, false, outputBuffer, sizeof(outputBuffer), outputFD);
+
+    crasheejson_beginEncode(&encodeContext, true, addJSONDataToFD, &fixupContext);
+    CrasheeJSONPushDecoder decoder;
+    crasheejson_beginPushDecode(&decoder, stringBuffer, CrasheeCRF_StreamStringBufferSize, &g_streamCallbaccrashee, &fixupContext);
+
+    int result = CrasheeJSON_OK;
+    for(;;)
+    {
+        const ssize_t bytesRead = read(inputFD, readBuffer, sizeof(readBuffer));
+        if(bytesRead < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            CrasheeLOG_ERROR("Error reading report: %s", strerror(errno));
+            result = CrasheeJSON_ERROR_INCOMPLETE;
+            break;
+        }
+        if(bytesRead == 0)
+        {
+            result = crasheejson_endPushDecode(&decoder);
+            break;
+        }
+        result = crasheejson_feedPushDecoder(&decoder, readBuffer, (int)bytesRead);
+        if(result != CrasheeJSON_OK)
+        {
+            break;
+        }
+    }
+    free(stringBuffer);
+    if(result != CrasheeJSON_OK)
+    {
+        CrasheeLOG_ERROR("Could not decode report at offset %d: %s", decoder.offset, crasheejson_stringForError(result));
+        return false;
+    }
+    return flushOutput(&fixupContext);
+}
@@ -32,6 +32,9 @@ extern "C" {
 #endif
 
 
+#include <stdbool.h>
+
+
 /** Fixes up fields in a crash report that could not be fixed up at crash time.
  * Some fields, such a mangled fields and dates, cannot be fixed up at crash time
  * because the function calls needed to do it are not async-safe.
@@ -43,6 +46,59 @@ extern "C" {
  */
 char* crasheecrf_fixupCrashReport(const char* crashReport);
 
+/** Fix up a crash report that isn't null terminated, such as one mapped
+ * with crasheecrs_mapReport().
+ *
+ * @param crashReport A raw report loaded from disk.
+ *
+ * @param crashReportLength The length of the report.
+ *
+ * @param fixedLength Receives the length of the fixed up report (can be NULL).
+ *
+ * @return A null terminated, fixed up crash report.
+ *         MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
+ */
+char* crasheecrf_fixupCrashReportData(const char* crashReport, int crashReportLength, int* fixedLength);
+
+/** Re-encode a crash report without any whitespace, fixing it up on the way
+ * if it isn't already. This is how reports are kept at rest.
+ *
+ * @param crashReport A raw or fixed up report, which doesn't need to be null terminated.
+ *
+ * @param crashReportLength The length of the report.
+ *
+ * @param minifiedLength Receives the length of the minified report (can be NULL).
+ *
+ * @return A null terminated, minified crash report.
+ *         MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
+ */
+char* crasheecrf_minifyCrashReport(const char* crashReport, int crashReportLength, int* minifiedLength);
+
+/** Fix up a crash report, writing the result to a file as it goes instead of
+ * building it in memory. Only a small, fixed size output buffer is used.
+ *
+ * @param crashReport A raw report loaded (or mapped) from disk.
+ *
+ * @param crashReportLength The length of the report.
+ *
+ * @param outputFD The file to write the fixed up report to.
+ *
+ * @return true if the whole report was fixed up and written.
+ */
+bool crasheecrf_fixupCrashReportToFD(const char* crashReport, int crashReportLength, int outputFD);
+
+/** Fix up a crash report as it is read from a file, writing the result to
+ * another file. Memory use is bounded regardless of the size of the report,
+ * but no string in it can be longer than CrasheeCRF_StreamStringBufferSize * 3/4.
+ *
+ * @param inputFD The file to read the raw JSON report from.
+ *
+ * @param outputFD The file to write the fixed up report to.
+ *
+ * @return true if the whole report was fixed up and written.
+ */
+bool crasheecrf_fixupCrashReportFromFD(int inputFD, int outputFD);
+
 
 #ifdef __cplusplus
 }
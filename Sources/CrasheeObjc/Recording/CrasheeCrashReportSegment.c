@@ -0,0 +1,172 @@
+//
+//  CrasheeCrashReportSegment.c
+//
+//  Copyright (c) 2012 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "CrasheeCrashReportSegment.h"
+#include "Tools/CrasheeCRC32.h"
+#include "Tools/CrasheeLogger.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define SEGMENT_VERSION 1
+
+static const char g_segmentMagic[4] = {(char)0x89, 'C', 'R', 'S'};
+
+typedef struct
+{
+    uint32_t length;
+    uint32_t checksum;
+    int64_t reportID;
+} FrameHeader;
+
+_Static_assert(sizeof(FrameHeader) == CrasheeCRSG_FRAME_HEADER_LENGTH, "Frame headers must be packed");
+
+static uint32_t getChecksum(const int64_t reportID, const char* const report, const int length)
+{
+    const uint32_t crc = crasheecrc_update(0, &reportID, sizeof(reportID));
+    return crasheecrc_update(crc, report, (size_t)length);
+}
+
+bool crasheecrsg_writeHeader(const int fd)
+{
+    char header[CrasheeCRSG_HEADER_LENGTH];
+    const uint32_t version = SEGMENT_VERSION;
+    memcpy(header, g_segmentMagic, sizeof(g_segmentMagic));
+    memcpy(header + sizeof(g_segmentMagic), &version, sizeof(version));
+    return crasheefu_writeBytesToFD(fd, header, sizeof(header));
+}
+
+bool crasheecrsg_appendReport(const int fd, const int64_t reportID, const char* const report, const int length)
+{
+    FrameHeader frame =
+    {
+        .length = (uint32_t)length,
+        .checksum = getChecksum(reportID, report, length),
+        .reportID = reportID,
+    };
+    struct iovec iov[2] =
+    {
+        { .iov_base = &frame, .iov_len = sizeof(frame) },
+        { .iov_base = (void*)report, .iov_len = (size_t)length },
+    };
+    ssize_t bytesWritten;
+    while((bytesWritten = writev(fd, iov, 2)) < 0 && errno == EINTR)
+    {
+    }
+    if(bytesWritten != (ssize_t)(sizeof(frame) + (size_t)length))
+    {
+        CrasheeLOG_ERROR("Could not append report %llx: %s", reportID, bytesWritten < 0 ? strerror(errno) : "Short write");
+        return false;
+    }
+    return true;
+}
+
+bool crasheecrsg_readReport(const int fd,
+                            const int64_t offset,
+                            const int64_t reportID,
+                            const int length,
+                            CrasheeFileView* const view)
+{
+    memset(view, 0, sizeof(*view));
+    // The frame and the report in one read.
+    const size_t frameLength = sizeof(FrameHeader) + (size_t)length;
+    char* buffer = malloc(frameLength);
+    if(buffer == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %zu bytes", frameLength);
+        return false;
+    }
+    const ssize_t bytesRead = pread(fd, buffer, frameLength, offset);
+    FrameHeader frame;
+    memcpy(&frame, buffer, sizeof(frame));
+    if(bytesRead != (ssize_t)frameLength ||
+       frame.length != (uint32_t)length ||
+       frame.reportID != reportID ||
+       frame.checksum != getChecksum(reportID, buffer + sizeof(frame), length))
+    {
+        CrasheeLOG_ERROR("Report %llx is damaged or missing from its segment", reportID);
+        free(buffer);
+        return false;
+    }
+    view->data = buffer + sizeof(frame);
+    view->length = length;
+    view->memory = buffer;
+    view->memoryLength = frameLength;
+    view->isMapped = false;
+    return true;
+}
+
+int crasheecrsg_scan(const int fd, const CrasheeSegmentScanCallback callback, void* const userData)
+{
+    char header[CrasheeCRSG_HEADER_LENGTH];
+    if(pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+       memcmp(header, g_segmentMagic, sizeof(g_segmentMagic)) != 0)
+    {
+        return -1;
+    }
+    uint32_t version;
+    memcpy(&version, header + sizeof(g_segmentMagic), sizeof(version));
+    if(version != SEGMENT_VERSION)
+    {
+        return -1;
+    }
+
+    char* buffer = NULL;
+    size_t capacity = 0;
+    int64_t offset = CrasheeCRSG_HEADER_LENGTH;
+    int count = 0;
+    for(;;)
+    {
+        FrameHeader frame;
+        if(pread(fd, &frame, sizeof(frame), offset) != (ssize_t)sizeof(frame) || frame.length > INT32_MAX)
+        {
+            break;
+        }
+        if(frame.length >= capacity)
+        {
+            char* newBuffer = realloc(buffer, (size_t)frame.length + 1);
+            if(newBuffer == NULL)
+            {
+                CrasheeLOG_ERROR("Could not allocate %u bytes", frame.length + 1);
+                break;
+            }
+            buffer = newBuffer;
+            capacity = (size_t)frame.length + 1;
+        }
+        const int length = (int)frame.length;
+        if(pread(fd, buffer, (size_t)length, offset + (int64_t)sizeof(frame)) != (ssize_t)length ||
+           frame.checksum != getChecksum(frame.reportID, buffer, length))
+        {
+            break;
+        }
+        callback(frame.reportID, offset, buffer, length, userData);
+        count++;
+        offset += (int64_t)sizeof(frame) + length;
+    }
+    free(buffer);
+    return count;
+}
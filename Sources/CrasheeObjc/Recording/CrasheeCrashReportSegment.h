@@ -0,0 +1,135 @@
+//
+//  CrasheeCrashReportSegment.h
+//
+//  Copyright (c) 2012 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Segments pack many small reports into one append-only file, so that adding
+ * a report doesn't cost a file of its own. A segment is a header followed by
+ * frames, one per report:
+ *
+ *     [4 bytes] report length.
+ *     [4 bytes] CRC-32 of the report ID and the report.
+ *     [8 bytes] report ID.
+ *     [report length bytes] the report.
+ *
+ * Frames are never changed once written. A frame that was only partly
+ * written, or was damaged afterwards, fails its CRC.
+ */
+
+#ifndef HDR_CrasheeCrashReportSegment_h
+#define HDR_CrasheeCrashReportSegment_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "Tools/CrasheeFileUtils.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/** Length of the header at the start of a segment. */
+#define CrasheeCRSG_HEADER_LENGTH 8
+
+/** Length of the frame in front of each report. */
+#define CrasheeCRSG_FRAME_HEADER_LENGTH 16
+
+
+/** Write the header of a new, empty segment.
+ *
+ * @param fd The segment file.
+ *
+ * @return true if the header was written.
+ */
+bool crasheecrsg_writeHeader(int fd);
+
+/** Append a report to a segment, in a single write.
+ *
+ * @param fd The segment file, opened with O_APPEND.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param report The report.
+ *
+ * @param length The length of the report.
+ *
+ * @return true if the whole frame was written. If not, part of it may have been.
+ */
+bool crasheecrsg_appendReport(int fd, int64_t reportID, const char* report, int length);
+
+/** Read a report from a segment, and check that it's intact.
+ *
+ * @param fd The segment file.
+ *
+ * @param offset Where the report's frame starts.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param length The report's length.
+ *
+ * @param view Filled in with a view of the report in a heap buffer.
+ *             Release it with crasheefu_unmapFile().
+ *
+ * @return true if the report was read.
+ */
+bool crasheecrsg_readReport(int fd, int64_t offset, int64_t reportID, int length, CrasheeFileView* view);
+
+/** Called with each intact report found by crasheecrsg_scan().
+ *
+ * @param reportID The report's ID.
+ *
+ * @param offset Where the report's frame starts.
+ *
+ * @param report The report. It is only valid during the call.
+ *
+ * @param length The length of the report.
+ *
+ * @param userData The user data passed to crasheecrsg_scan().
+ */
+typedef void (*CrasheeSegmentScanCallback)(int64_t reportID,
+                                           int64_t offset,
+                                           const char* report,
+                                           int length,
+                                           void* userData);
+
+/** Go through all reports in a segment, in the order they were appended.
+ * Stops at the first frame that isn't intact, as nothing after it can be
+ * found reliably.
+ *
+ * @param fd The segment file.
+ *
+ * @param callback Called with each report.
+ *
+ * @param userData Any data you would like passed to the callback.
+ *
+ * @return The number of reports found, or -1 if this isn't a segment.
+ */
+int crasheecrsg_scan(int fd, CrasheeSegmentScanCallback callback, void* userData);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeCrashReportSegment_h
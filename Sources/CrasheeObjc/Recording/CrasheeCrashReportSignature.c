@@ -0,0 +1,389 @@
+//
+//  CrasheeCrashReportSignature.c
+//
+//  Copyright (c) 2012 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "CrasheeCrashReportSignature.h"
+#include "CrasheeCrashReportFields.h"
+#include "Tools/CrasheeJSONCodec.h"
+#include "Tools/CrasheeLogger.h"
+
+#include <string.h>
+
+/** How many containers deep to keep track of. Nothing of interest is deeper. */
+#define MAX_DEPTH 8
+/** How many frames of each thread to look through for ones in the executable. */
+#define MAX_THREAD_FRAMES 64
+
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+/** The containers that hold something that goes into a signature. */
+typedef enum
+{
+    Container_Other,
+    Container_Root,
+    Container_Report,
+    Container_Crash,
+    Container_Error,
+    /** An error's details, like "signal" or "nsexception". */
+    Container_ErrorDetail,
+    Container_Threads,
+    Container_Thread,
+    Container_Backtrace,
+    Container_Frames,
+    Container_Frame,
+} Container;
+
+typedef struct
+{
+    /** Hash of the name of the image the frame is in, or 0 if it has none. */
+    uint64_t imageHash;
+    /** The instruction's offset into the image. */
+    uint64_t offset;
+} Frame;
+
+typedef struct
+{
+    Container containers[MAX_DEPTH];
+    /** How deep we are. Containers beyond MAX_DEPTH are all Container_Other. */
+    int depth;
+
+    uint64_t errorHash;
+    bool hasError;
+    uint64_t executableHash;
+    bool hasExecutable;
+
+    uint64_t objectAddr;
+    uint64_t instructionAddr;
+    uint64_t objectHash;
+    bool hasInstructionAddr;
+
+    Frame threadFrames[MAX_THREAD_FRAMES];
+    int threadFrameCount;
+    bool isThreadCrashed;
+
+    Frame crashedFrames[MAX_THREAD_FRAMES];
+    int crashedFrameCount;
+    bool hasCrashedThread;
+} SignatureContext;
+
+
+// ============================================================================
+#pragma mark - Utility -
+// ============================================================================
+
+/** Add bytes to an FNV-1a hash. */
+static uint64_t addToHash(uint64_t hash, const void* const data, const size_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/** Add a string to a hash. Strings are hashed as encoded, which is fine as
+ * every report encodes the same string the same way.
+ */
+static uint64_t addSliceToHash(const uint64_t hash, const CrasheeJSONSlice* const slice)
+{
+    // Keeps "ab" + "c" apart from "a" + "bc".
+    const uint8_t separator = 0;
+    return addToHash(addToHash(hash, slice->string, (size_t)slice->length), &separator, 1);
+}
+
+static bool isName(const CrasheeJSONSlice* const slice, const char* const name)
+{
+    // Field names never need escaping.
+    return slice != NULL &&
+           !slice->hasEscapes &&
+           (size_t)slice->length == strlen(name) &&
+           memcmp(slice->string, name, (size_t)slice->length) == 0;
+}
+
+static Container getCurrentContainer(const SignatureContext* const context)
+{
+    if(context->depth == 0 || context->depth > MAX_DEPTH)
+    {
+        return Container_Other;
+    }
+    return context->containers[context->depth - 1];
+}
+
+static Container getChildContainer(const SignatureContext* const context, const CrasheeJSONSlice* const name)
+{
+    if(context->depth == 0)
+    {
+        return Container_Root;
+    }
+    switch(getCurrentContainer(context))
+    {
+        case Container_Root:
+            return isName(name, CrasheeCrashField_Report) ? Container_Report :
+                   isName(name, CrasheeCrashField_Crash) ? Container_Crash :
+                   Container_Other;
+        case Container_Crash:
+            return isName(name, CrasheeCrashField_Error) ? Container_Error :
+                   isName(name, CrasheeCrashField_Threads) ? Container_Threads :
+                   Container_Other;
+        case Container_Error:
+            return isName(name, CrasheeCrashField_NSException) ||
+                   isName(name, CrasheeCrashField_CPPException) ||
+                   isName(name, CrasheeCrashField_UserReported) ||
+                   isName(name, CrasheeCrashField_Mach) ||
+                   isName(name, CrasheeCrashField_Signal) ? Container_ErrorDetail : Container_Other;
+        case Container_Threads:
+            return Container_Thread;
+        case Container_Thread:
+            return isName(name, CrasheeCrashField_Backtrace) ? Container_Backtrace : Container_Other;
+        case Container_Backtrace:
+            return isName(name, CrasheeCrashField_Contents) ? Container_Frames : Container_Other;
+        case Container_Frames:
+            return Container_Frame;
+        default:
+            return Container_Other;
+    }
+}
+
+static void addAddress(SignatureContext* const context, const CrasheeJSONSlice* const name, const uint64_t value)
+{
+    if(getCurrentContainer(context) != Container_Frame)
+    {
+        return;
+    }
+    if(isName(name, CrasheeCrashField_ObjectAddr))
+    {
+        context->objectAddr = value;
+    }
+    else if(isName(name, CrasheeCrashField_InstructionAddr))
+    {
+        context->instructionAddr = value;
+        context->hasInstructionAddr = true;
+    }
+}
+
+/** Hash the frames that identify the crash: the top ones in the executable,
+ * or failing that, the top ones.
+ */
+static uint64_t addFramesToHash(uint64_t hash, const SignatureContext* const context)
+{
+    int inAppCount = 0;
+    for(int i = 0; i < context->crashedFrameCount && inAppCount < CrasheeCRSIG_FRAME_COUNT; i++)
+    {
+        const Frame* const frame = &context->crashedFrames[i];
+        if(context->hasExecutable && frame->imageHash == context->executableHash)
+        {
+            hash = addToHash(hash, &frame->offset, sizeof(frame->offset));
+            inAppCount++;
+        }
+    }
+    if(inAppCount > 0)
+    {
+        return hash;
+    }
+    for(int i = 0; i < context->crashedFrameCount && i < CrasheeCRSIG_FRAME_COUNT; i++)
+    {
+        const Frame* const frame = &context->crashedFrames[i];
+        hash = addToHash(hash, &frame->imageHash, sizeof(frame->imageHash));
+        hash = addToHash(hash, &frame->offset, sizeof(frame->offset));
+    }
+    return hash;
+}
+
+
+// ============================================================================
+#pragma mark - Callbaccrashee -
+// ============================================================================
+
+static int onBooleanElement(const CrasheeJSONSlice* const name, const bool value, void* const userData)
+{
+    SignatureContext* context = (SignatureContext*)userData;
+    if(getCurrentContainer(context) == Container_Thread && isName(name, CrasheeCrashField_Crashed))
+    {
+        context->isThreadCrashed = value;
+    }
+    return CrasheeJSON_OK;
+}
+
+static int onFloatingPointElement(__unused const CrasheeJSONSlice* const name,
+                                  __unused const double value,
+                                  __unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static int onIntegerElement(const CrasheeJSONSlice* const name, const int64_t value, void* const userData)
+{
+    addAddress((SignatureContext*)userData, name, (uint64_t)value);
+    return CrasheeJSON_OK;
+}
+
+static int onUnsignedIntegerElement(const CrasheeJSONSlice* const name, const uint64_t value, void* const userData)
+{
+    addAddress((SignatureContext*)userData, name, value);
+    return CrasheeJSON_OK;
+}
+
+static int onNullElement(__unused const CrasheeJSONSlice* const name, __unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static int onStringElement(const CrasheeJSONSlice* const name,
+                           const CrasheeJSONSlice* const value,
+                           void* const userData)
+{
+    SignatureContext* context = (SignatureContext*)userData;
+    switch(getCurrentContainer(context))
+    {
+        case Container_Report:
+            if(isName(name, CrasheeCrashField_ProcessName))
+            {
+                context->executableHash = addSliceToHash(FNV_OFFSET_BASIS, value);
+                context->hasExecutable = true;
+            }
+            break;
+        case Container_Error:
+            if(isName(name, CrasheeCrashField_Type))
+            {
+                context->errorHash = addSliceToHash(context->errorHash, value);
+                context->hasError = true;
+            }
+            break;
+        case Container_ErrorDetail:
+            if(isName(name, CrasheeCrashField_Name) || isName(name, CrasheeCrashField_ExceptionName))
+            {
+                context->errorHash = addSliceToHash(context->errorHash, value);
+                context->hasError = true;
+            }
+            break;
+        case Container_Frame:
+            if(isName(name, CrasheeCrashField_ObjectName))
+            {
+                context->objectHash = addSliceToHash(FNV_OFFSET_BASIS, value);
+            }
+            break;
+        default:
+            break;
+    }
+    return CrasheeJSON_OK;
+}
+
+static int beginContainer(const CrasheeJSONSlice* const name, void* const userData)
+{
+    SignatureContext* context = (SignatureContext*)userData;
+    const Container container = getChildContainer(context, name);
+    if(container == Container_Thread)
+    {
+        context->threadFrameCount = 0;
+        context->isThreadCrashed = false;
+    }
+    else if(container == Container_Frame)
+    {
+        context->objectAddr = 0;
+        context->objectHash = 0;
+        context->hasInstructionAddr = false;
+    }
+    if(context->depth < MAX_DEPTH)
+    {
+        context->containers[context->depth] = container;
+    }
+    context->depth++;
+    return CrasheeJSON_OK;
+}
+
+static int onEndContainer(void* const userData)
+{
+    SignatureContext* context = (SignatureContext*)userData;
+    const Container container = getCurrentContainer(context);
+    context->depth--;
+    if(container == Container_Frame)
+    {
+        if(context->hasInstructionAddr && context->threadFrameCount < MAX_THREAD_FRAMES)
+        {
+            context->threadFrames[context->threadFrameCount++] = (Frame)
+            {
+                .imageHash = context->objectHash,
+                .offset = context->instructionAddr - context->objectAddr,
+            };
+        }
+    }
+    else if(container == Container_Thread)
+    {
+        if(context->isThreadCrashed && !context->hasCrashedThread)
+        {
+            memcpy(context->crashedFrames, context->threadFrames, sizeof(Frame) * (size_t)context->threadFrameCount);
+            context->crashedFrameCount = context->threadFrameCount;
+            context->hasCrashedThread = true;
+        }
+    }
+    return CrasheeJSON_OK;
+}
+
+static int onEndData(__unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static CrasheeJSONSliceDecodeCallbaccrashee g_callbaccrashee =
+{
+    .onBeginArray = beginContainer,
+    .onBeginObject = beginContainer,
+    .onBooleanElement = onBooleanElement,
+    .onEndContainer = onEndContainer,
+    .onEndData = onEndData,
+    .onFloatingPointElement = onFloatingPointElement,
+    .onIntegerElement = onIntegerElement,
+    .onUnsignedIntegerElement = onUnsignedIntegerElement,
+    .onNullElement = onNullElement,
+    .onStringElement = onStringElement,
+};
+
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+bool crasheecrsig_getSignature(const char* report, int reportLength, uint64_t* signature)
+{
+    SignatureContext context =
+    {
+        .errorHash = FNV_OFFSET_BASIS,
+    };
+    int errorOffset = 0;
+    const int result = crasheejson_decodeSlices(report, reportLength, &g_callbaccrashee, &context, &errorOffset);
+    if(result != CrasheeJSON_OK)
+    {
+        CrasheeLOG_ERROR("Could not decode report at offset %d: %s", errorOffset, crasheejson_stringForError(result));
+        return false;
+    }
+    if(!context.hasError && !context.hasCrashedThread)
+    {
+        return false;
+    }
+    const uint64_t hash = addFramesToHash(context.errorHash, &context);
+    // 0 means "no signature" to whoever stores these.
+    *signature = hash != 0 ? hash : 1;
+    return true;
+}
@@ -0,0 +1,73 @@
+//
+//  CrasheeCrashReportSignature.h
+//
+//  Copyright (c) 2012 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* A crash signature is a hash of what makes a crash the same bug wherever and
+ * whenever it happens:
+ *
+ *     The error type ("signal", "nsexception", ...).
+ *     The exception, signal and mach exception names.
+ *     The top frames of the crashed thread that are in the app's own
+ *     executable, as offsets into it, so that they don't change with ASLR.
+ *
+ * If none of the crashed thread's frames are in the executable, its top
+ * frames in any image are used instead.
+ */
+
+#ifndef HDR_CrasheeCrashReportSignature_h
+#define HDR_CrasheeCrashReportSignature_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/** How many frames of the crashed thread go into a signature. */
+#ifndef CrasheeCRSIG_FRAME_COUNT
+    #define CrasheeCRSIG_FRAME_COUNT 5
+#endif
+
+
+/** Get the signature of a JSON crash report.
+ *
+ * @param report The report, which doesn't need to be null terminated.
+ *
+ * @param reportLength The length of the report.
+ *
+ * @param signature Receives the signature, which is never 0.
+ *
+ * @return false if the report couldn't be decoded, or has no crashed thread
+ *         or error to take a signature of.
+ */
+bool crasheecrsig_getSignature(const char* report, int reportLength, uint64_t* signature);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeCrashReportSignature_h
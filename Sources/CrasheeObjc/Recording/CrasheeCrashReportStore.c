@@ -25,150 +25,2528 @@
 //
 
 #include "CrasheeCrashReportStore.h"
+#include "CrasheeCrashReportDictionary.h"
+#include "CrasheeCrashReportFixer.h"
+#include "CrasheeCrashReportSegment.h"
+#include "CrasheeCrashReportSignature.h"
 #include "Tools/CrasheeLogger.h"
 #include "Tools/CrasheeFileUtils.h"
+#include "Tools/CrasheeFormat.h"
+#include "Tools/CrasheeLZ.h"
+#include "Tools/CrasheeCBORCodec.h"
+#include "Tools/CrasheeJSONCodec.h"
 
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 
 static int g_maxReportCount = 5;
-// Have to use max 32-bit atomics because of MIPS.
-static _Atomic(uint32_t) g_nextUniqueIDLow;
-static int64_t g_nextUniqueIDHigh;
+/** 0 if there is no limit. */
+static int64_t g_maxReportBytes;
+/** In seconds, 0 if there is no limit. */
+static int64_t g_maxReportAge;
+/** Per CrasheeReportKind, 0 if there is no limit. */
+static int g_maxReportCountByKind[CrasheeReportKindUser + 1];
+static _Atomic(int64_t) g_nextUniqueID;
 static const char* g_appName;
 static const char* g_reportsPath;
 static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static int compareInt64(const void* a, const void* b)
+#define MAX_READ_THREADS 4
+/** How many reports ahead of the ones being decoded to start reading from disk. */
+#define READ_AHEAD_COUNT 4
+
+#define FIXED_UP_MAGIC_LENGTH 4
+/** Marks a report that has already been fixed up. Like the LZ magic, this
+ * can't start a JSON or CBOR document.
+ */
+static const char g_fixedUpMagic[FIXED_UP_MAGIC_LENGTH] = {(char)0x89, 'C', 'F', 'X'};
+
+
+// ============================================================================
+#pragma mark - Segments -
+// ============================================================================
+
+/* User reports can be packed into segments (see CrasheeCrashReportSegment.h)
+ * instead of each getting a file. Reports are appended to the active segment,
+ * which is sealed once it reaches CrasheeCRS_SEGMENT_SIZE, and a new one is
+ * started at each launch. The manifest records which segment and offset each
+ * report is at. Deleted reports leave holes, so sealed segments that are
+ * mostly holes are compacted by copying what's left into the active segment.
+ */
+
+#define SEGMENT_FILENAME_FORMAT "segment-%08x.log"
+#define SEGMENT_FILENAME_SCAN_FORMAT "segment-%8" SCNx32 ".log%n"
+
+typedef struct
+{
+    uint32_t number;
+    /** How many reports in the index are in the segment, and the bytes they take up there. */
+    int reportCount;
+    int64_t reportBytes;
+} SegmentInfo;
+
+static _Atomic(CrasheeUserReportStorage) g_userReportStorage = CrasheeUserReportStorageFiles;
+/** All segments that reports in the index are in, or were in. */
+static SegmentInfo* g_segments;
+static int g_segmentCount;
+static int g_segmentCapacity;
+static uint32_t g_nextSegmentNumber = 1;
+
+static void getSegmentPath(const uint32_t segment, char* pathBuffer)
+{
+    crasheefmt_format(pathBuffer, CrasheeCRS_MAX_PATH_LENGTH, "%s/" SEGMENT_FILENAME_FORMAT, g_reportsPath, segment);
+}
+
+/** There are only ever a few segments, so they're just kept in a list. */
+static SegmentInfo* getSegment(const uint32_t segment)
+{
+    for(int i = 0; i < g_segmentCount; i++)
+    {
+        if(g_segments[i].number == segment)
+        {
+            return &g_segments[i];
+        }
+    }
+    if(g_segmentCount >= g_segmentCapacity)
+    {
+        const int newCapacity = g_segmentCapacity == 0 ? 8 : g_segmentCapacity * 2;
+        SegmentInfo* newSegments = realloc(g_segments, sizeof(*g_segments) * (size_t)newCapacity);
+        if(newSegments == NULL)
+        {
+            CrasheeLOG_ERROR("Could not allocate %d segments", newCapacity);
+            return NULL;
+        }
+        g_segments = newSegments;
+        g_segmentCapacity = newCapacity;
+    }
+    if(segment >= g_nextSegmentNumber)
+    {
+        g_nextSegmentNumber = segment + 1;
+    }
+    g_segments[g_segmentCount] = (SegmentInfo){ .number = segment };
+    return &g_segments[g_segmentCount++];
+}
+
+static void removeSegment(const SegmentInfo* const segment)
+{
+    const int index = (int)(segment - g_segments);
+    g_segmentCount--;
+    memmove(g_segments + index, g_segments + index + 1, sizeof(*g_segments) * (size_t)(g_segmentCount - index));
+}
+
+
+// ============================================================================
+#pragma mark - Manifest -
+// ============================================================================
+
+/* The manifest is an append-only log of fixed size records, one per change
+ * to the store. It's replayed into g_reports, a sorted in-memory index that
+ * answers all queries, so the reports directory is only ever scanned to
+ * rebuild a manifest that is missing or damaged.
+ *
+ * Records are appended with a single write() to an O_APPEND descriptor, so
+ * crash handlers can add them too. The index catches up with records it
+ * didn't write itself the next time it is used.
+ */
+
+#define MANIFEST_FILENAME "manifest.bin"
+#define MANIFEST_VERSION 3
+/** Compact the manifest at startup once it has this many more records than reports. */
+#define MANIFEST_SLACK_RECORDS 256
+
+typedef enum
+{
+    ManifestOperation_Set = 1,
+    ManifestOperation_Remove = 2,
+} ManifestOperation;
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+} ManifestHeader;
+
+typedef struct
+{
+    int64_t reportID;
+    int64_t size;
+    int64_t createdAt;
+    uint32_t segment;
+    uint32_t offset;
+    uint8_t operation;
+    uint8_t type;
+    uint8_t state;
+    uint8_t kind;
+    /** Checksum of everything above, so that a torn or damaged record is noticed. */
+    uint32_t checksum;
+} ManifestRecord;
+
+_Static_assert(sizeof(ManifestRecord) == 40, "Manifest records must be packed");
+
+typedef struct
+{
+    CrasheeReportInfo info;
+    /** The segment the report is packed into, or 0 if it has a file of its own. */
+    uint32_t segment;
+    /** Where the report's frame starts in its segment. */
+    uint32_t offset;
+} IndexEntry;
+
+static const char g_manifestMagic[4] = {(char)0x89, 'C', 'R', 'M'};
+
+static int g_manifestFD = -1;
+/** How much of the manifest has been replayed into the index. */
+static off_t g_manifestReplayedLength;
+static int g_manifestRecordCount;
+
+/** All reports, sorted by ID. */
+static IndexEntry* g_reports;
+static int g_reportCount;
+static int g_reportCapacity;
+/** How many reports in the index are still being written. These aren't listed. */
+static int g_writingReportCount;
+/** Totals for the reports that are listed, kept up to date for the retention limits. */
+static int64_t g_totalReportBytes;
+static int g_reportCountByKind[CrasheeReportKindUser + 1];
+
+static uint32_t getChecksum(const void* const data, const size_t length)
+{
+    // FNV-1a
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t getRecordChecksum(const ManifestRecord* const record)
+{
+    return getChecksum(record, offsetof(ManifestRecord, checksum));
+}
+
+static void getManifestPath(char* pathBuffer)
+{
+    crasheefmt_format(pathBuffer, CrasheeCRS_MAX_PATH_LENGTH, "%s/" MANIFEST_FILENAME, g_reportsPath);
+}
+
+static ManifestRecord makeRecord(const ManifestOperation operation, const IndexEntry* const entry)
+{
+    const CrasheeReportInfo* const info = &entry->info;
+    ManifestRecord record =
+    {
+        .reportID = info->reportID,
+        .size = info->size,
+        .createdAt = info->createdAt,
+        .segment = entry->segment,
+        .offset = entry->offset,
+        .operation = (uint8_t)operation,
+        .type = (uint8_t)info->type,
+        .state = (uint8_t)info->state,
+        .kind = (uint8_t)info->kind,
+    };
+    record.checksum = getRecordChecksum(&record);
+    return record;
+}
+
+/** Append a record to the manifest.
+ * This function is async-safe, but the index doesn't see the record until
+ * it is next refreshed.
+ */
+static bool appendEntryRecord(const ManifestOperation operation, const IndexEntry* const entry)
+{
+    const ManifestRecord record = makeRecord(operation, entry);
+    return g_manifestFD >= 0 && write(g_manifestFD, &record, sizeof(record)) == (ssize_t)sizeof(record);
+}
+
+/** Append several records to the manifest with a single write.
+ * The index doesn't see them until it is next refreshed.
+ */
+static bool appendRecords(const ManifestRecord* const records, const int count)
+{
+    const ssize_t length = (ssize_t)(sizeof(*records) * (size_t)count);
+    return g_manifestFD >= 0 && (count == 0 || write(g_manifestFD, records, (size_t)length) == length);
+}
+
+/** Append a record for a report that has a file of its own. */
+static bool appendRecord(const ManifestOperation operation, const CrasheeReportInfo* const info)
+{
+    const IndexEntry entry = { .info = *info };
+    return appendEntryRecord(operation, &entry);
+}
+
+/** Find a report in the index.
+ *
+ * @return The report's index, or -(insertion point + 1) if it isn't there.
+ */
+static int findReport(const int64_t reportID)
+{
+    int low = 0;
+    int high = g_reportCount - 1;
+    while(low <= high)
+    {
+        const int mid = (low + high) / 2;
+        if(g_reports[mid].info.reportID < reportID)
+        {
+            low = mid + 1;
+        }
+        else if(g_reports[mid].info.reportID > reportID)
+        {
+            high = mid - 1;
+        }
+        else
+        {
+            return mid;
+        }
+    }
+    return -(low + 1);
+}
+
+/** Make room in the index for one more report. */
+static bool growIndex()
+{
+    if(g_reportCount < g_reportCapacity)
+    {
+        return true;
+    }
+    const int newCapacity = g_reportCapacity == 0 ? 64 : g_reportCapacity * 2;
+    IndexEntry* newReports = realloc(g_reports, sizeof(*g_reports) * (size_t)newCapacity);
+    if(newReports == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate index of %d reports", newCapacity);
+        return false;
+    }
+    g_reports = newReports;
+    g_reportCapacity = newCapacity;
+    return true;
+}
+
+/** Add a report to, or with a negative sign take it off, the index's totals. */
+static void countIndexEntry(const IndexEntry* const entry, const int sign)
+{
+    const CrasheeReportInfo* const info = &entry->info;
+    if(entry->segment != 0)
+    {
+        SegmentInfo* const segment = getSegment(entry->segment);
+        if(segment != NULL)
+        {
+            segment->reportCount += sign;
+            segment->reportBytes += sign * (CrasheeCRSG_FRAME_HEADER_LENGTH + info->size);
+        }
+    }
+    if(info->state == CrasheeReportStateWriting)
+    {
+        g_writingReportCount += sign;
+    }
+    else
+    {
+        g_totalReportBytes += sign * info->size;
+        g_reportCountByKind[info->kind] += sign;
+    }
+}
+
+static bool setIndexEntry(const IndexEntry* const entry)
+{
+    int index = findReport(entry->info.reportID);
+    if(index >= 0)
+    {
+        countIndexEntry(&g_reports[index], -1);
+    }
+    else
+    {
+        if(!growIndex())
+        {
+            return false;
+        }
+        // IDs only go up, so this is almost always an append.
+        index = -(index + 1);
+        memmove(g_reports + index + 1, g_reports + index, sizeof(*g_reports) * (size_t)(g_reportCount - index));
+        g_reportCount++;
+    }
+    g_reports[index] = *entry;
+    countIndexEntry(entry, 1);
+    return true;
+}
+
+static void removeIndexEntry(const int64_t reportID)
+{
+    const int index = findReport(reportID);
+    if(index >= 0)
+    {
+        countIndexEntry(&g_reports[index], -1);
+        g_reportCount--;
+        memmove(g_reports + index, g_reports + index + 1, sizeof(*g_reports) * (size_t)(g_reportCount - index));
+    }
+}
+
+/** Replay any records that the index hasn't seen yet.
+ *
+ * @return false if the manifest is damaged.
+ */
+static bool refreshIndex()
+{
+    if(g_manifestFD < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if(fstat(g_manifestFD, &st) != 0)
+    {
+        CrasheeLOG_ERROR("Could not stat manifest: %s", strerror(errno));
+        return false;
+    }
+
+    ManifestRecord records[128];
+    while(st.st_size - g_manifestReplayedLength >= (off_t)sizeof(ManifestRecord))
+    {
+        // A partial record at the end is still being written.
+        off_t length = (st.st_size - g_manifestReplayedLength) / (off_t)sizeof(ManifestRecord) * (off_t)sizeof(ManifestRecord);
+        if(length > (off_t)sizeof(records))
+        {
+            length = sizeof(records);
+        }
+        const ssize_t bytesRead = pread(g_manifestFD, records, (size_t)length, g_manifestReplayedLength);
+        if(bytesRead != (ssize_t)length)
+        {
+            CrasheeLOG_ERROR("Could not read manifest: %s", strerror(errno));
+            return false;
+        }
+        const int recordCount = (int)(length / (off_t)sizeof(ManifestRecord));
+        for(int i = 0; i < recordCount; i++)
+        {
+            const ManifestRecord* const record = &records[i];
+            if(record->checksum != getRecordChecksum(record))
+            {
+                CrasheeLOG_ERROR("Manifest record %d is damaged", g_manifestRecordCount);
+                return false;
+            }
+            if(record->operation == ManifestOperation_Remove)
+            {
+                removeIndexEntry(record->reportID);
+            }
+            else if(record->operation == ManifestOperation_Set)
+            {
+                const IndexEntry entry =
+                {
+                    .info =
+                    {
+                        .reportID = record->reportID,
+                        .size = record->size,
+                        .createdAt = record->createdAt,
+                        .type = (CrasheeReportType)record->type,
+                        .state = (CrasheeReportState)record->state,
+                        .kind = record->kind <= CrasheeReportKindUser ? (CrasheeReportKind)record->kind : CrasheeReportKindUnknown,
+                    },
+                    .segment = record->segment,
+                    .offset = record->offset,
+                };
+                if(!setIndexEntry(&entry))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                CrasheeLOG_ERROR("Unknown manifest operation %d", record->operation);
+                return false;
+            }
+            g_manifestRecordCount++;
+        }
+        g_manifestReplayedLength += length;
+    }
+    return true;
+}
+
+static void closeManifest()
+{
+    if(g_manifestFD >= 0)
+    {
+        close(g_manifestFD);
+        g_manifestFD = -1;
+    }
+    g_manifestReplayedLength = 0;
+    g_manifestRecordCount = 0;
+}
+
+static void clearIndex()
+{
+    g_reportCount = 0;
+    g_writingReportCount = 0;
+    g_totalReportBytes = 0;
+    memset(g_reportCountByKind, 0, sizeof(g_reportCountByKind));
+    g_segmentCount = 0;
+}
+
+/** Open the manifest and load it into the index.
+ *
+ * @return false if it is missing or damaged.
+ */
+static bool openManifest()
+{
+    closeManifest();
+    clearIndex();
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    getManifestPath(path);
+    g_manifestFD = open(path, O_RDWR | O_APPEND);
+    if(g_manifestFD < 0)
+    {
+        return false;
+    }
+    ManifestHeader header;
+    if(read(g_manifestFD, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+       memcmp(header.magic, g_manifestMagic, sizeof(g_manifestMagic)) != 0 ||
+       header.version != MANIFEST_VERSION)
+    {
+        CrasheeLOG_ERROR("Manifest %s is damaged", path);
+        closeManifest();
+        return false;
+    }
+    g_manifestReplayedLength = sizeof(header);
+    if(!refreshIndex())
+    {
+        closeManifest();
+        return false;
+    }
+    return true;
+}
+
+/** Replace the manifest with one that has a single record per report in the index. */
+static bool writeManifest()
+{
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    char tempPath[CrasheeCRS_MAX_PATH_LENGTH];
+    getManifestPath(path);
+    crasheefmt_format(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", tempPath, strerror(errno));
+        return false;
+    }
+    ManifestHeader header = { .version = MANIFEST_VERSION };
+    memcpy(header.magic, g_manifestMagic, sizeof(header.magic));
+    bool isWritten = crasheefu_writeBytesToFD(fd, (const char*)&header, sizeof(header));
+    ManifestRecord records[128];
+    for(int i = 0; isWritten && i < g_reportCount; i += 128)
+    {
+        const int count = g_reportCount - i < 128 ? g_reportCount - i : 128;
+        for(int j = 0; j < count; j++)
+        {
+            records[j] = makeRecord(ManifestOperation_Set, &g_reports[i + j]);
+        }
+        isWritten = crasheefu_writeBytesToFD(fd, (const char*)records, (int)(sizeof(*records) * (size_t)count));
+    }
+    close(fd);
+    if(!isWritten || rename(tempPath, path) != 0)
+    {
+        CrasheeLOG_ERROR("Could not write manifest %s: %s", path, strerror(errno));
+        unlink(tempPath);
+        return false;
+    }
+
+    // The index already matches the new manifest, so skip replaying it.
+    const int reportCount = g_reportCount;
+    closeManifest();
+    g_manifestFD = open(path, O_RDWR | O_APPEND);
+    g_manifestReplayedLength = (off_t)(sizeof(header) + sizeof(ManifestRecord) * (size_t)reportCount);
+    g_manifestRecordCount = reportCount;
+    return g_manifestFD >= 0;
+}
+
+
+// ============================================================================
+#pragma mark - Reports -
+// ============================================================================
+
+static int compareIndexEntries(const void* a, const void* b)
+{
+    const int64_t idA = ((const IndexEntry*)a)->info.reportID;
+    const int64_t idB = ((const IndexEntry*)b)->info.reportID;
+    return idA < idB ? -1 : idA > idB ? 1 : 0;
+}
+
+static inline int64_t getNextUniqueID()
+{
+    return atomic_fetch_add_explicit(&g_nextUniqueID, 1, memory_order_relaxed);
+}
+
+static void getCrashReportPathByID(int64_t id, char* pathBuffer)
+{
+    crasheefmt_format(pathBuffer, CrasheeCRS_MAX_PATH_LENGTH, "%s/%s-report-%016llx.json", g_reportsPath, g_appName, id);
+}
+
+/** Where a report is written before it's published under its real path. */
+static void getInProgressPathByID(int64_t id, char* pathBuffer)
+{
+    crasheefmt_format(pathBuffer, CrasheeCRS_MAX_PATH_LENGTH, "%s/writing-%s-report-%016llx.json", g_reportsPath, g_appName, id);
+}
+
+/** Where a report's data is: its own file, or the segment it's packed into.
+ * Must be called with g_mutex held.
+ */
+static void getReportDataPath(const int64_t reportID, char* pathBuffer)
+{
+    const int index = findReport(reportID);
+    if(index >= 0 && g_reports[index].segment != 0)
+    {
+        getSegmentPath(g_reports[index].segment, pathBuffer);
+    }
+    else
+    {
+        getCrashReportPathByID(reportID, pathBuffer);
+    }
+}
+
+static int64_t getReportIDFromFilename(const char* filename)
+{
+    char scanFormat[100];
+    sprintf(scanFormat, "%s-report-%%" PRIx64 ".json%%n", g_appName);
+
+    int64_t reportID = 0;
+    int length = 0;
+    sscanf(filename, scanFormat, &reportID, &length);
+    // Anything else that starts like a report name isn't one.
+    if(length == 0 || filename[length] != '\0')
+    {
+        return 0;
+    }
+    return reportID;
+}
+
+/** Look at a report file to find out its size and type. Its kind can't be
+ * told from the file, and is left unknown.
+ * This function is async-safe.
+ *
+ * @return false if the report doesn't exist.
+ */
+static bool getReportInfoFromFile(const int64_t reportID, CrasheeReportInfo* const info)
+{
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    getCrashReportPathByID(reportID, path);
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    // Long enough for the dictionary ID, too.
+    char magic[CrasheeLZ_DICTIONARY_HEADER_LENGTH] = {0};
+    const bool isStatted = fstat(fd, &st) == 0;
+    const int magicLength = (int)read(fd, magic, sizeof(magic));
+    close(fd);
+    if(!isStatted)
+    {
+        return false;
+    }
+
+    *info = (CrasheeReportInfo)
+    {
+        .reportID = reportID,
+        .size = (int64_t)st.st_size,
+        .createdAt = (int64_t)st.st_mtime,
+        .type = CrasheeReportTypeJSON,
+        .state = CrasheeReportStatePending,
+        .kind = CrasheeReportKindUnknown,
+    };
+    if(magicLength >= FIXED_UP_MAGIC_LENGTH && memcmp(magic, g_fixedUpMagic, FIXED_UP_MAGIC_LENGTH) == 0)
+    {
+        info->state = CrasheeReportStateFixedUp;
+    }
+    else if(crasheelz_isDictionaryCompressed(magic, magicLength))
+    {
+        // Only fixed up reports are compressed at rest.
+        info->type = CrasheeReportTypeCompressed;
+        info->state = CrasheeReportStateFixedUp;
+    }
+    else if(crasheelz_isCompressed(magic, magicLength))
+    {
+        info->type = CrasheeReportTypeCompressed;
+    }
+    else if(crasheecbor_isCBOR(magic, magicLength))
+    {
+        info->type = CrasheeReportTypeCBOR;
+    }
+    return true;
+}
+
+
+// ============================================================================
+#pragma mark - Durability -
+// ============================================================================
+
+/* Reports are written under an in-progress name and renamed into place once
+ * complete, so readers never see half of one. How hard we then try to get
+ * them onto permanent storage is up to g_durability.
+ */
+
+/** Atomic because user reports are published without holding g_mutex. */
+static _Atomic(CrasheeReportDurability) g_durability = CrasheeReportDurabilityNone;
+/** Reports published since the last group commit. */
+static int64_t* g_uncommittedReportIDs;
+static int g_uncommittedReportCount;
+static int g_uncommittedReportCapacity;
+static pthread_cond_t g_groupCommitCondition = PTHREAD_COND_INITIALIZER;
+static bool g_isGroupCommitThreadRunning;
+
+/** This function is async-safe. */
+static bool syncPath(const char* const path)
+{
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+    const bool isSynced = crasheefu_syncFD(fd);
+    close(fd);
+    if(!isSynced)
+    {
+        CrasheeLOG_ERROR("Could not sync %s: %s", path, strerror(errno));
+    }
+    return isSynced;
+}
+
+/** Move a finished report from where it was written to its real path.
+ * This function is async-safe.
+ *
+ * @param writtenPath Where the report was written.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param shouldSync If true, the report is on permanent storage by the time it's published.
+ */
+static bool publishReportFile(const char* const writtenPath, const int64_t reportID, const bool shouldSync)
+{
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    getCrashReportPathByID(reportID, path);
+    if(shouldSync)
+    {
+        syncPath(writtenPath);
+    }
+    if(rename(writtenPath, path) != 0)
+    {
+        CrasheeLOG_ERROR("Could not rename %s to %s: %s", writtenPath, path, strerror(errno));
+        return false;
+    }
+    if(shouldSync)
+    {
+        // Makes the new name durable too.
+        syncPath(g_reportsPath);
+    }
+    return true;
+}
+
+static void* groupCommitThread(__unused void* userData)
+{
+    pthread_mutex_lock(&g_mutex);
+    for(;;)
+    {
+        while(g_uncommittedReportCount == 0)
+        {
+            pthread_cond_wait(&g_groupCommitCondition, &g_mutex);
+        }
+        // Let reports published around the same time join this commit.
+        pthread_mutex_unlock(&g_mutex);
+        usleep(CrasheeCRS_GROUP_COMMIT_INTERVAL_MS * 1000);
+        pthread_mutex_lock(&g_mutex);
+
+        // Take the whole list, however long it got. Reports published
+        // while it's being synced start a new one.
+        const int reportCount = g_uncommittedReportCount;
+        int64_t* const reportIDs = g_uncommittedReportIDs;
+        g_uncommittedReportIDs = NULL;
+        g_uncommittedReportCount = 0;
+        g_uncommittedReportCapacity = 0;
+        pthread_mutex_unlock(&g_mutex);
+
+        char lastPath[CrasheeCRS_MAX_PATH_LENGTH] = "";
+        for(int i = 0; i < reportCount; i++)
+        {
+            char path[CrasheeCRS_MAX_PATH_LENGTH];
+            pthread_mutex_lock(&g_mutex);
+            getReportDataPath(reportIDs[i], path);
+            pthread_mutex_unlock(&g_mutex);
+            // Reports deleted in the meantime have nothing to sync, and
+            // reports packed into the same segment are synced together.
+            if(strcmp(path, lastPath) != 0)
+            {
+                syncPath(path);
+                strcpy(lastPath, path);
+            }
+        }
+        syncPath(g_reportsPath);
+        free(reportIDs);
+
+        pthread_mutex_lock(&g_mutex);
+    }
+    return NULL;
+}
+
+/** Make a report that was just published durable, as g_durability asks for.
+ * Must be called with g_mutex held.
+ */
+static void commitReport(const int64_t reportID)
+{
+    if(g_durability != CrasheeReportDurabilityGroupCommit)
+    {
+        return;
+    }
+    if(g_uncommittedReportCount >= g_uncommittedReportCapacity)
+    {
+        const int newCapacity = g_uncommittedReportCapacity == 0 ? 16 : g_uncommittedReportCapacity * 2;
+        int64_t* newReportIDs = realloc(g_uncommittedReportIDs, sizeof(*newReportIDs) * (size_t)newCapacity);
+        if(newReportIDs == NULL)
+        {
+            CrasheeLOG_ERROR("Could not allocate %d report IDs", newCapacity);
+            char path[CrasheeCRS_MAX_PATH_LENGTH];
+            getCrashReportPathByID(reportID, path);
+            syncPath(path);
+            return;
+        }
+        g_uncommittedReportIDs = newReportIDs;
+        g_uncommittedReportCapacity = newCapacity;
+    }
+    g_uncommittedReportIDs[g_uncommittedReportCount++] = reportID;
+
+    if(!g_isGroupCommitThreadRunning)
+    {
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        int error = pthread_create(&thread, &attr, groupCommitThread, NULL);
+        if(error != 0)
+        {
+            CrasheeLOG_ERROR("pthread_create: %s", strerror(error));
+        }
+        g_isGroupCommitThreadRunning = error == 0;
+        pthread_attr_destroy(&attr);
+    }
+    pthread_cond_signal(&g_groupCommitCondition);
+}
+
+
+// ============================================================================
+#pragma mark - Segment Writing -
+// ============================================================================
+
+/** The segment that user reports are appended to, or 0 if none was started yet. */
+static uint32_t g_activeSegment;
+static int g_activeSegmentFD = -1;
+static int64_t g_activeSegmentLength;
+/** Set when a sealed segment may be mostly holes. */
+static _Atomic(bool) g_isCompactionNeeded;
+
+static bool isSegmentSparse(const SegmentInfo* const segment)
+{
+    return segment->number != g_activeSegment && segment->reportBytes < CrasheeCRS_SEGMENT_SIZE / 2;
+}
+
+/** Note that reports were removed from a segment. Must be called with g_mutex held. */
+static void noteSegmentShrunk(const uint32_t segmentNumber)
+{
+    const SegmentInfo* const segment = getSegment(segmentNumber);
+    if(segment != NULL && isSegmentSparse(segment))
+    {
+        g_isCompactionNeeded = true;
+    }
+}
+
+static void closeActiveSegment()
+{
+    if(g_activeSegmentFD >= 0)
+    {
+        close(g_activeSegmentFD);
+        g_activeSegmentFD = -1;
+    }
+    g_activeSegment = 0;
+}
+
+/** Stop appending to the active segment. Must be called with g_mutex held. */
+static void sealActiveSegment()
+{
+    if(g_activeSegmentFD >= 0 && g_durability != CrasheeReportDurabilityNone)
+    {
+        crasheefu_syncFD(g_activeSegmentFD);
+    }
+    const uint32_t segment = g_activeSegment;
+    closeActiveSegment();
+    if(segment != 0)
+    {
+        noteSegmentShrunk(segment);
+    }
+}
+
+/** Must be called with g_mutex held. */
+static bool startActiveSegment()
+{
+    const uint32_t segment = g_nextSegmentNumber++;
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    getSegmentPath(segment, path);
+    // A file left by a segment that never got any reports is reused.
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", path, strerror(errno));
+        return false;
+    }
+    if(!crasheecrsg_writeHeader(fd))
+    {
+        close(fd);
+        unlink(path);
+        return false;
+    }
+    if(g_durability != CrasheeReportDurabilityNone)
+    {
+        syncPath(g_reportsPath);
+    }
+    g_activeSegment = segment;
+    g_activeSegmentFD = fd;
+    g_activeSegmentLength = CrasheeCRSG_HEADER_LENGTH;
+    return true;
+}
+
+/** Append a report to the active segment, starting a new one if needed.
+ * Must be called with g_mutex held.
+ *
+ * @param entry The report's index entry. Its location is filled in.
+ */
+static bool appendToSegment(IndexEntry* const entry, const char* const report, const int length)
+{
+    if(g_activeSegmentFD >= 0 && g_activeSegmentLength >= CrasheeCRS_SEGMENT_SIZE)
+    {
+        sealActiveSegment();
+    }
+    if(g_activeSegmentFD < 0 && !startActiveSegment())
+    {
+        return false;
+    }
+    if(!crasheecrsg_appendReport(g_activeSegmentFD, entry->info.reportID, report, length))
+    {
+        // Whatever part of the frame made it to disk is in the way of the next one.
+        sealActiveSegment();
+        return false;
+    }
+    entry->segment = g_activeSegment;
+    entry->offset = (uint32_t)g_activeSegmentLength;
+    g_activeSegmentLength += CrasheeCRSG_FRAME_HEADER_LENGTH + length;
+    if(g_durability == CrasheeReportDurabilitySync)
+    {
+        crasheefu_syncFD(g_activeSegmentFD);
+    }
+    return true;
+}
+
+/** Read a report that is packed into a segment. Must be called with g_mutex held. */
+static bool readSegmentReport(const IndexEntry* const entry, CrasheeFileView* const report)
+{
+    int fd = g_activeSegmentFD;
+    if(entry->segment != g_activeSegment)
+    {
+        char path[CrasheeCRS_MAX_PATH_LENGTH];
+        getSegmentPath(entry->segment, path);
+        fd = open(path, O_RDONLY);
+        if(fd < 0)
+        {
+            CrasheeLOG_ERROR("Could not open file %s: %s", path, strerror(errno));
+            return false;
+        }
+    }
+    const bool isRead = crasheecrsg_readReport(fd, entry->offset, entry->info.reportID, (int)entry->info.size, report);
+    if(fd != g_activeSegmentFD)
+    {
+        close(fd);
+    }
+    return isRead;
+}
+
+/** Replace a report in a segment by appending a new version of it.
+ * Must be called with g_mutex held.
+ *
+ * @param entry The report's index entry.
+ *
+ * @param path A file holding the new version.
+ */
+static bool replaceSegmentReport(const IndexEntry* const entry, const char* const path)
+{
+    CrasheeFileView report;
+    if(!crasheefu_mapFile(path, &report, 0))
+    {
+        return false;
+    }
+    const uint32_t oldSegment = entry->segment;
+    IndexEntry newEntry = *entry;
+    newEntry.info.size = report.length;
+    newEntry.info.state = CrasheeReportStateFixedUp;
+    const bool isAppended = appendToSegment(&newEntry, report.data, report.length);
+    crasheefu_unmapFile(&report);
+    if(isAppended)
+    {
+        appendEntryRecord(ManifestOperation_Set, &newEntry);
+        refreshIndex();
+        noteSegmentShrunk(oldSegment);
+    }
+    return isAppended;
+}
+
+/** Delete segments that no longer hold any reports, other than the active one.
+ * Must be called with g_mutex held, and the index up to date.
+ */
+static void deleteEmptySegments()
+{
+    for(int i = g_segmentCount - 1; i >= 0; i--)
+    {
+        if(g_segments[i].reportCount == 0 && g_segments[i].number != g_activeSegment)
+        {
+            char path[CrasheeCRS_MAX_PATH_LENGTH];
+            getSegmentPath(g_segments[i].number, path);
+            unlink(path);
+            removeSegment(&g_segments[i]);
+        }
+    }
+}
+
+
+// ============================================================================
+#pragma mark - Maintenance -
+// ============================================================================
+
+typedef struct
+{
+    uint32_t segment;
+    int64_t createdAt;
+} SegmentScan;
+
+static void addScannedReport(const int64_t reportID,
+                             const int64_t offset,
+                             const char* const report,
+                             const int length,
+                             void* const userData)
+{
+    const SegmentScan* const scan = (const SegmentScan*)userData;
+    const bool isFixedUp = length >= FIXED_UP_MAGIC_LENGTH && memcmp(report, g_fixedUpMagic, FIXED_UP_MAGIC_LENGTH) == 0;
+    const IndexEntry entry =
+    {
+        .info =
+        {
+            .reportID = reportID,
+            .size = length,
+            .createdAt = scan->createdAt,
+            .type = CrasheeReportTypeJSON,
+            .state = isFixedUp ? CrasheeReportStateFixedUp : CrasheeReportStatePending,
+            .kind = CrasheeReportKindUser,
+        },
+        .segment = scan->segment,
+        .offset = (uint32_t)offset,
+    };
+    // Compaction copies reports forward, so later copies win.
+    setIndexEntry(&entry);
+}
+
+static int compareSegmentNumbers(const void* a, const void* b)
+{
+    const uint32_t numberA = *(const uint32_t*)a;
+    const uint32_t numberB = *(const uint32_t*)b;
+    return numberA < numberB ? -1 : numberA > numberB ? 1 : 0;
+}
+
+/** Add the reports in segments to the index, oldest segment first.
+ * Reports deleted from a segment that wasn't compacted yet come back.
+ */
+static void scanSegments(uint32_t* const segments, const int segmentCount)
+{
+    if(segmentCount > 1)
+    {
+        qsort(segments, (size_t)segmentCount, sizeof(*segments), compareSegmentNumbers);
+    }
+    for(int i = 0; i < segmentCount; i++)
+    {
+        char path[CrasheeCRS_MAX_PATH_LENGTH];
+        getSegmentPath(segments[i], path);
+        int fd = open(path, O_RDONLY);
+        if(fd < 0)
+        {
+            continue;
+        }
+        struct stat st;
+        SegmentScan scan = { .segment = segments[i] };
+        if(fstat(fd, &st) == 0)
+        {
+            scan.createdAt = (int64_t)st.st_mtime;
+        }
+        const int reportCount = crasheecrsg_scan(fd, addScannedReport, &scan);
+        close(fd);
+        if(reportCount <= 0 && segments[i] != g_activeSegment)
+        {
+            unlink(path);
+        }
+        if(segments[i] >= g_nextSegmentNumber)
+        {
+            g_nextSegmentNumber = segments[i] + 1;
+        }
+    }
+}
+
+/** Rebuild the index from the reports directory, and write a new manifest. */
+static void rebuildManifest()
+{
+    CrasheeLOG_INFO("Rebuilding report manifest in %s", g_reportsPath);
+    closeManifest();
+    clearIndex();
+    DIR* dir = opendir(g_reportsPath);
+    if(dir == NULL)
+    {
+        CrasheeLOG_ERROR("Could not open directory %s", g_reportsPath);
+        return;
+    }
+    uint32_t* segments = NULL;
+    int segmentCount = 0;
+    struct dirent* ent;
+    while((ent = readdir(dir)) != NULL)
+    {
+        uint32_t segment = 0;
+        int length = 0;
+        sscanf(ent->d_name, SEGMENT_FILENAME_SCAN_FORMAT, &segment, &length);
+        if(length > 0 && ent->d_name[length] == '\0' && segment > 0)
+        {
+            uint32_t* newSegments = realloc(segments, sizeof(*segments) * (size_t)(segmentCount + 1));
+            if(newSegments != NULL)
+            {
+                segments = newSegments;
+                segments[segmentCount++] = segment;
+            }
+            continue;
+        }
+        int64_t reportID = getReportIDFromFilename(ent->d_name);
+        CrasheeReportInfo info;
+        if(reportID > 0 && getReportInfoFromFile(reportID, &info))
+        {
+            if(!growIndex())
+            {
+                break;
+            }
+            // Sorted all at once below.
+            g_reports[g_reportCount] = (IndexEntry){ .info = info };
+            countIndexEntry(&g_reports[g_reportCount++], 1);
+        }
+    }
+    closedir(dir);
+    if(g_reportCount > 1)
+    {
+        qsort(g_reports, (size_t)g_reportCount, sizeof(*g_reports), compareIndexEntries);
+    }
+    scanSegments(segments, segmentCount);
+    free(segments);
+    writeManifest();
+}
+
+/** Fill in reports that a crash handler started but may not have finished. */
+static void resolveWritingReports()
+{
+    for(int i = g_reportCount - 1; i >= 0; i--)
+    {
+        if(g_reports[i].info.state == CrasheeReportStateWriting)
+        {
+            const CrasheeReportInfo writingInfo = g_reports[i].info;
+            CrasheeReportInfo info = writingInfo;
+            // Keep what the crash handler managed to write.
+            char inProgressPath[CrasheeCRS_MAX_PATH_LENGTH];
+            getInProgressPathByID(info.reportID, inProgressPath);
+            if(access(inProgressPath, F_OK) == 0)
+            {
+                publishReportFile(inProgressPath, info.reportID, g_durability != CrasheeReportDurabilityNone);
+            }
+            if(getReportInfoFromFile(info.reportID, &info) && info.size > 0)
+            {
+                info.createdAt = writingInfo.createdAt;
+                info.kind = writingInfo.kind;
+                appendRecord(ManifestOperation_Set, &info);
+            }
+            else
+            {
+                // A report slot that was claimed but never written to is left empty.
+                char path[CrasheeCRS_MAX_PATH_LENGTH];
+                getCrashReportPathByID(info.reportID, path);
+                crasheefu_removeFile(path, false);
+                appendRecord(ManifestOperation_Remove, &info);
+            }
+        }
+    }
+    refreshIndex();
+}
+
+/** Make sure the index is up to date, rebuilding it if the manifest is damaged. */
+static void updateIndex()
+{
+    if(!refreshIndex())
+    {
+        rebuildManifest();
+    }
+}
+
+static void deleteReportWithID(int64_t reportID)
+{
+    const int index = findReport(reportID);
+    const uint32_t segment = index >= 0 ? g_reports[index].segment : 0;
+    if(segment == 0)
+    {
+        char path[CrasheeCRS_MAX_PATH_LENGTH];
+        getCrashReportPathByID(reportID, path);
+        crasheefu_removeFile(path, true);
+    }
+    const CrasheeReportInfo info = { .reportID = reportID };
+    appendRecord(ManifestOperation_Remove, &info);
+    refreshIndex();
+    if(segment != 0)
+    {
+        // The report stays in its segment until that is compacted.
+        noteSegmentShrunk(segment);
+    }
+}
+
+static bool isKindOverLimit(const CrasheeReportKind kind)
+{
+    return kind != CrasheeReportKindUnknown &&
+           g_maxReportCountByKind[kind] > 0 &&
+           g_reportCountByKind[kind] > g_maxReportCountByKind[kind];
+}
+
+static bool isOverTotalLimits()
+{
+    return g_reportCount - g_writingReportCount > g_maxReportCount ||
+           (g_maxReportBytes > 0 && g_totalReportBytes > g_maxReportBytes);
+}
+
+/** Whether any limit other than age is exceeded. */
+static bool isOverSizeLimits()
+{
+    return isOverTotalLimits() ||
+           isKindOverLimit(CrasheeReportKindCrash) ||
+           isKindOverLimit(CrasheeReportKindUser);
+}
+
+static int64_t getOldestAllowedCreationTime()
+{
+    return g_maxReportAge > 0 ? (int64_t)time(NULL) - g_maxReportAge : INT64_MIN;
+}
+
+/** Check the index's totals to see whether any reports should be deleted.
+ * Must be called with g_mutex held.
+ */
+static bool isRetentionNeeded()
+{
+    // The oldest report is always first.
+    return isOverSizeLimits() || (g_reportCount > 0 && g_reports[0].info.createdAt < getOldestAllowedCreationTime());
+}
+
+/** Delete the oldest reports until the store is within all of its limits.
+ * Must be called with g_mutex held.
+ */
+static void enforceRetention()
+{
+    updateIndex();
+    const int64_t oldestAllowedCreationTime = getOldestAllowedCreationTime();
+    int i = 0;
+    while(i < g_reportCount)
+    {
+        const CrasheeReportInfo* const info = &g_reports[i].info;
+        const bool isTooOld = info->createdAt < oldestAllowedCreationTime;
+        if(!isTooOld && !isOverSizeLimits())
+        {
+            // The rest are newer still.
+            break;
+        }
+        const bool shouldDelete = info->state != CrasheeReportStateWriting &&
+                                  (isTooOld || isOverTotalLimits() || isKindOverLimit(info->kind));
+        if(!shouldDelete)
+        {
+            i++;
+            continue;
+        }
+        const int64_t reportID = info->reportID;
+        deleteReportWithID(reportID);
+        // Deleting shifts the index down, unless the report couldn't be removed from it.
+        if(i < g_reportCount && g_reports[i].info.reportID == reportID)
+        {
+            i++;
+        }
+    }
+}
+
+/** Copy the reports left in sealed segments that are mostly holes into the
+ * active segment, and delete the sealed ones.
+ * Must be called with g_mutex held.
+ */
+static void compactSegments()
+{
+    updateIndex();
+    uint32_t sparseSegments[g_segmentCount + 1];
+    int sparseCount = 0;
+    for(int i = 0; i < g_segmentCount; i++)
+    {
+        if(isSegmentSparse(&g_segments[i]) && g_segments[i].reportCount > 0)
+        {
+            sparseSegments[sparseCount++] = g_segments[i].number;
+        }
+    }
+    for(int s = 0; s < sparseCount; s++)
+    {
+        for(int i = 0; i < g_reportCount; i++)
+        {
+            if(g_reports[i].segment != sparseSegments[s])
+            {
+                continue;
+            }
+            IndexEntry entry = g_reports[i];
+            CrasheeFileView report;
+            if(!readSegmentReport(&entry, &report))
+            {
+                // Not worth keeping a segment around for.
+                appendEntryRecord(ManifestOperation_Remove, &entry);
+                refreshIndex();
+                if(i >= g_reportCount || g_reports[i].info.reportID != entry.info.reportID)
+                {
+                    // Removing it shifted the index down.
+                    i--;
+                }
+                continue;
+            }
+            const bool isAppended = appendToSegment(&entry, report.data, report.length);
+            crasheefu_unmapFile(&report);
+            if(!isAppended)
+            {
+                // Probably out of space. Try again some other time.
+                goto done;
+            }
+            // Replaces the entry in place.
+            appendEntryRecord(ManifestOperation_Set, &entry);
+            refreshIndex();
+        }
+    }
+
+done:
+    if(g_activeSegmentFD >= 0 && g_durability != CrasheeReportDurabilityNone)
+    {
+        // The copies must be safe before the originals go.
+        crasheefu_syncFD(g_activeSegmentFD);
+    }
+    deleteEmptySegments();
+}
+
+static void initializeIDs()
+{
+    time_t rawTime;
+    time(&rawTime);
+    struct tm time;
+    gmtime_r(&rawTime, &time);
+    int64_t baseID = (int64_t)time.tm_sec
+                   + (int64_t)time.tm_min * 61
+                   + (int64_t)time.tm_hour * 61 * 60
+                   + (int64_t)time.tm_yday * 61 * 60 * 24
+                   + (int64_t)time.tm_year * 61 * 60 * 24 * 366;
+    baseID <<= 23;
+
+    g_nextUniqueID = baseID;
+}
+
+
+// ============================================================================
+#pragma mark - Report Decoding -
+// ============================================================================
+
+typedef struct
+{
+    char* buffer;
+    int length;
+    int capacity;
+} JSONOutputBuffer;
+
+static int addJSONDataToBuffer(const char* const data, const int length, void* const userData)
+{
+    JSONOutputBuffer* output = (JSONOutputBuffer*)userData;
+    if(output->length + length + 1 > output->capacity)
+    {
+        int newCapacity = output->capacity * 2;
+        while(output->length + length + 1 > newCapacity)
+        {
+            newCapacity *= 2;
+        }
+        char* newBuffer = realloc(output->buffer, (size_t)newCapacity);
+        if(newBuffer == NULL)
+        {
+            return CrasheeJSON_ERROR_CANNOT_ADD_DATA;
+        }
+        output->buffer = newBuffer;
+        output->capacity = newCapacity;
+    }
+    memcpy(output->buffer + output->length, data, (size_t)length);
+    output->length += length;
+    output->buffer[output->length] = '\0';
+    return CrasheeJSON_OK;
+}
+
+/** Convert a binary report to JSON text.
+ *
+ * @param report The CBOR report data.
+ *
+ * @param length The length of the report data.
+ *
+ * @param jsonLength Receives the length of the JSON string.
+ *
+ * @return A newly allocated JSON string, or NULL on failure.
+ */
+static char* convertReportToJSON(const char* const report, const int length, int* const jsonLength)
+{
+    JSONOutputBuffer output =
+    {
+        .buffer = malloc((size_t)length * 2 + 1),
+        .length = 0,
+        .capacity = length * 2 + 1,
+    };
+    if(output.buffer == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d bytes", output.capacity);
+        return NULL;
+    }
+    output.buffer[0] = '\0';
+
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, true, addJSONDataToBuffer, &output);
+    int errorOffset = 0;
+    int result = crasheecbor_convertToJSON(report, length, &context, &errorOffset);
+    crasheejson_endEncode(&context);
+    if(result != CrasheeJSON_OK && result != CrasheeJSON_ERROR_INCOMPLETE)
+    {
+        CrasheeLOG_ERROR("Could not convert binary report at offset %d: %s",
+                         errorOffset,
+                         crasheejson_stringForError(result));
+        free(output.buffer);
+        return NULL;
+    }
+    *jsonLength = output.length;
+    return output.buffer;
+}
+
+/** Map a report's file as it is on disk. Must be called with g_mutex held.
+ * Reports are only ever deleted, never truncated, so the mapping stays
+ * valid after the lock is released. Reports packed into segments are small,
+ * and are read into a buffer instead.
+ */
+static bool mapRawReport(const int64_t reportID, CrasheeFileView* const report)
+{
+    const int index = findReport(reportID);
+    if(index >= 0 && g_reports[index].segment != 0)
+    {
+        return readSegmentReport(&g_reports[index], report);
+    }
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    getCrashReportPathByID(reportID, path);
+    bool isMapped = crasheefu_mapFile(path, report, 0);
+    if(!isMapped && errno == ENOENT && refreshIndex())
+    {
+        // Deleted behind our back, so stop listing it.
+        const int index = findReport(reportID);
+        if(index >= 0 && g_reports[index].info.state != CrasheeReportStateWriting)
+        {
+            appendEntryRecord(ManifestOperation_Remove, &g_reports[index]);
+            refreshIndex();
+        }
+    }
+    return isMapped;
+}
+
+/** Turn a raw report into a JSON view, in place. Needs no lock.
+ * The view is released on failure.
+ */
+static bool decodeReport(CrasheeFileView* const report, bool* const isFixedUp)
+{
+    if(crasheelz_isCompressed(report->data, report->length))
+    {
+        int length = 0;
+        char* decompressed = crasheelz_decompressStream(report->data, report->length, &length);
+        crasheefu_unmapFile(report);
+        if(decompressed == NULL)
+        {
+            return false;
+        }
+        crasheefu_viewBuffer(report, decompressed, length);
+    }
+    else if(crasheelz_isDictionaryCompressed(report->data, report->length))
+    {
+        const uint32_t dictionaryID = crasheelz_getDictionaryID(report->data, report->length);
+        const CrasheeLZDictionary* const dictionary = crasheecrd_getDictionary(dictionaryID);
+        int length = 0;
+        char* decompressed = NULL;
+        if(dictionary == NULL)
+        {
+            CrasheeLOG_ERROR("Report was compressed with unknown dictionary %u", dictionaryID);
+        }
+        else
+        {
+            decompressed = crasheelz_decompressWithDictionary(report->data, report->length, dictionary, &length);
+        }
+        crasheefu_unmapFile(report);
+        if(decompressed == NULL)
+        {
+            return false;
+        }
+        crasheefu_viewBuffer(report, decompressed, length);
+    }
+    const bool fixedUp = report->length >= FIXED_UP_MAGIC_LENGTH &&
+                         memcmp(report->data, g_fixedUpMagic, FIXED_UP_MAGIC_LENGTH) == 0;
+    if(isFixedUp != NULL)
+    {
+        *isFixedUp = fixedUp;
+    }
+    if(fixedUp)
+    {
+        report->data += FIXED_UP_MAGIC_LENGTH;
+        report->length -= FIXED_UP_MAGIC_LENGTH;
+    }
+    else if(crasheecbor_isCBOR(report->data, report->length))
+    {
+        int length = 0;
+        char* json = convertReportToJSON(report->data, report->length, &length);
+        crasheefu_unmapFile(report);
+        if(json == NULL)
+        {
+            return false;
+        }
+        crasheefu_viewBuffer(report, json, length);
+    }
+    return true;
+}
+
+
+// ============================================================================
+#pragma mark - Signatures -
+// ============================================================================
+
+/* A hot bug fills the store with copies of the same crash, pushing out the
+ * rare ones. So each new crash report gets a signature (see
+ * CrasheeCrashReportSignature.h), and one that matches a report still in the
+ * store is coalesced into it: that report's occurrences are counted, and the
+ * new one is deleted. Every g_fullCrashReportInterval'th occurrence is kept
+ * as a full report anyway.
+ *
+ * Signatures are kept in an append-only log of fixed size records, like the
+ * manifest, where the last record for a report wins. A crash report with no
+ * record hasn't had its signature taken yet.
+ */
+
+#define SIGNATURES_FILENAME "signatures.bin"
+#define SIGNATURES_VERSION 1
+/** Compact the signature log at startup once it has this many more records than reports. */
+#define SIGNATURES_SLACK_RECORDS 64
+
+typedef struct
+{
+    int64_t reportID;
+    /** 0 if no signature could be taken. */
+    uint64_t signature;
+    int64_t firstOccurredAt;
+    int64_t lastOccurredAt;
+    /** How many crashes the report stands for, itself included. */
+    uint32_t occurrenceCount;
+    uint32_t checksum;
+} SignatureRecord;
+
+_Static_assert(sizeof(SignatureRecord) == 40, "Signature records must be packed");
+
+static const char g_signaturesMagic[4] = {(char)0x89, 'C', 'R', 'G'};
+
+/** 0 to keep only the first occurrence of a crash as a full report. */
+static int g_fullCrashReportInterval;
+static int g_signaturesFD = -1;
+static int g_signatureRecordCount;
+/** The last record for each report, in no particular order. */
+static SignatureRecord* g_signatures;
+static int g_signatureCount;
+static int g_signatureCapacity;
+/** Set when there may be crash reports whose signatures haven't been taken. */
+static _Atomic(bool) g_isCoalescingNeeded;
+
+static void getSignaturesPath(char* pathBuffer)
+{
+    crasheefmt_format(pathBuffer, CrasheeCRS_MAX_PATH_LENGTH, "%s/" SIGNATURES_FILENAME, g_reportsPath);
+}
+
+static uint32_t getSignatureChecksum(const SignatureRecord* const record)
+{
+    return getChecksum(record, offsetof(SignatureRecord, checksum));
+}
+
+static int findSignature(const int64_t reportID)
+{
+    for(int i = 0; i < g_signatureCount; i++)
+    {
+        if(g_signatures[i].reportID == reportID)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool setSignature(const SignatureRecord* const record)
+{
+    int index = findSignature(record->reportID);
+    if(index < 0)
+    {
+        if(g_signatureCount == g_signatureCapacity)
+        {
+            const int newCapacity = g_signatureCapacity == 0 ? 16 : g_signatureCapacity * 2;
+            SignatureRecord* newSignatures = realloc(g_signatures, sizeof(*g_signatures) * (size_t)newCapacity);
+            if(newSignatures == NULL)
+            {
+                CrasheeLOG_ERROR("Could not allocate %d signatures", newCapacity);
+                return false;
+            }
+            g_signatures = newSignatures;
+            g_signatureCapacity = newCapacity;
+        }
+        index = g_signatureCount++;
+    }
+    g_signatures[index] = *record;
+    return true;
+}
+
+static void closeSignatures()
+{
+    if(g_signaturesFD >= 0)
+    {
+        close(g_signaturesFD);
+        g_signaturesFD = -1;
+    }
+    g_signatureRecordCount = 0;
+}
+
+/** Replace the signature log with one that has a record per report in the store. */
+static bool writeSignatures()
+{
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    char tempPath[CrasheeCRS_MAX_PATH_LENGTH];
+    getSignaturesPath(path);
+    crasheefmt_format(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    // Reports deleted since their records were written are dropped.
+    int count = 0;
+    for(int i = 0; i < g_signatureCount; i++)
+    {
+        if(findReport(g_signatures[i].reportID) >= 0)
+        {
+            g_signatures[count++] = g_signatures[i];
+        }
+    }
+    g_signatureCount = count;
+
+    int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", tempPath, strerror(errno));
+        return false;
+    }
+    // Same layout as the manifest's header.
+    ManifestHeader header = { .version = SIGNATURES_VERSION };
+    memcpy(header.magic, g_signaturesMagic, sizeof(header.magic));
+    const bool isWritten = crasheefu_writeBytesToFD(fd, (const char*)&header, sizeof(header)) &&
+                           crasheefu_writeBytesToFD(fd, (const char*)g_signatures, (int)(sizeof(*g_signatures) * (size_t)count));
+    close(fd);
+    if(!isWritten || rename(tempPath, path) != 0)
+    {
+        CrasheeLOG_ERROR("Could not write signatures %s: %s", path, strerror(errno));
+        unlink(tempPath);
+        return false;
+    }
+
+    closeSignatures();
+    g_signaturesFD = open(path, O_RDWR | O_APPEND);
+    g_signatureRecordCount = count;
+    return g_signaturesFD >= 0;
+}
+
+/** Load the signature log, compacting it if it has grown or is damaged.
+ * Must be called with the index loaded.
+ */
+static void loadSignatures()
+{
+    closeSignatures();
+    g_signatureCount = 0;
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    getSignaturesPath(path);
+    g_signaturesFD = open(path, O_RDWR | O_APPEND);
+    if(g_signaturesFD < 0)
+    {
+        // The reports get their signatures taken again.
+        writeSignatures();
+        return;
+    }
+
+    bool isDamaged = false;
+    ManifestHeader header;
+    if(read(g_signaturesFD, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+       memcmp(header.magic, g_signaturesMagic, sizeof(g_signaturesMagic)) != 0 ||
+       header.version != SIGNATURES_VERSION)
+    {
+        CrasheeLOG_ERROR("Signatures %s are damaged", path);
+        isDamaged = true;
+    }
+    SignatureRecord records[64];
+    ssize_t bytesRead;
+    while(!isDamaged && (bytesRead = read(g_signaturesFD, records, sizeof(records))) > 0)
+    {
+        // A torn record at the end is treated like a damaged one.
+        const int recordCount = (int)(bytesRead / (ssize_t)sizeof(*records));
+        isDamaged = bytesRead % (ssize_t)sizeof(*records) != 0;
+        for(int i = 0; i < recordCount; i++)
+        {
+            if(records[i].checksum != getSignatureChecksum(&records[i]))
+            {
+                CrasheeLOG_ERROR("Signature record %d is damaged", g_signatureRecordCount);
+                isDamaged = true;
+                break;
+            }
+            setSignature(&records[i]);
+            g_signatureRecordCount++;
+        }
+    }
+    if(isDamaged || g_signatureRecordCount > g_reportCount + SIGNATURES_SLACK_RECORDS)
+    {
+        writeSignatures();
+    }
+}
+
+static bool appendSignature(SignatureRecord* const record)
+{
+    record->checksum = getSignatureChecksum(record);
+    if(g_signaturesFD < 0 || write(g_signaturesFD, record, sizeof(*record)) != (ssize_t)sizeof(*record))
+    {
+        CrasheeLOG_ERROR("Could not write signature for report %016llx", record->reportID);
+        return false;
+    }
+    g_signatureRecordCount++;
+    return setSignature(record);
+}
+
+static bool getReportSignature(const int64_t reportID, uint64_t* const signature)
+{
+    CrasheeFileView report;
+    if(!mapRawReport(reportID, &report) || !decodeReport(&report, NULL))
+    {
+        return false;
+    }
+    const bool hasSignature = crasheecrsig_getSignature(report.data, report.length, signature);
+    crasheefu_unmapFile(&report);
+    return hasSignature;
+}
+
+/** Find the report that a crash with this signature should be coalesced into.
+ *
+ * @return Its index in g_signatures, or -1 if the crash should be kept.
+ */
+static int findCoalescingTarget(const SignatureRecord* const record)
 {
-    int64_t diff = *(int64_t*)a - *(int64_t*)b;
-    if(diff < 0)
+    if(record->signature == 0)
+    {
+        return -1;
+    }
+    int latest = -1;
+    for(int i = 0; i < g_signatureCount; i++)
+    {
+        const SignatureRecord* const candidate = &g_signatures[i];
+        if(candidate->signature == record->signature &&
+           candidate->reportID < record->reportID &&
+           (latest < 0 || candidate->reportID > g_signatures[latest].reportID) &&
+           findReport(candidate->reportID) >= 0)
+        {
+            latest = i;
+        }
+    }
+    if(latest >= 0 &&
+       g_fullCrashReportInterval > 0 &&
+       g_signatures[latest].occurrenceCount >= (uint32_t)g_fullCrashReportInterval)
     {
+        // Time for another full report.
         return -1;
     }
-    else if(diff > 0)
+    return latest;
+}
+
+/** Take the signatures of crash reports that don't have one yet, and
+ * coalesce those that are repeats of a report in the store into it.
+ * Must be called with g_mutex held.
+ */
+static void coalesceCrashReports()
+{
+    updateIndex();
+    int i = 0;
+    while(i < g_reportCount)
+    {
+        const CrasheeReportInfo info = g_reports[i].info;
+        if(info.kind != CrasheeReportKindCrash ||
+           info.state == CrasheeReportStateWriting ||
+           findSignature(info.reportID) >= 0)
+        {
+            i++;
+            continue;
+        }
+        SignatureRecord record =
+        {
+            .reportID = info.reportID,
+            .firstOccurredAt = info.createdAt,
+            .lastOccurredAt = info.createdAt,
+            .occurrenceCount = 1,
+        };
+        getReportSignature(info.reportID, &record.signature);
+        const int target = findCoalescingTarget(&record);
+        if(target < 0)
+        {
+            appendSignature(&record);
+            i++;
+            continue;
+        }
+
+        SignatureRecord occurrence = g_signatures[target];
+        occurrence.occurrenceCount++;
+        if(info.createdAt < occurrence.firstOccurredAt)
+        {
+            occurrence.firstOccurredAt = info.createdAt;
+        }
+        if(info.createdAt > occurrence.lastOccurredAt)
+        {
+            occurrence.lastOccurredAt = info.createdAt;
+        }
+        // Only let the report go once its occurrence is on record.
+        if(!appendSignature(&occurrence))
+        {
+            i++;
+            continue;
+        }
+        deleteReportWithID(info.reportID);
+        // Deleting shifts the index down, unless the report couldn't be removed from it.
+        if(i < g_reportCount && g_reports[i].info.reportID == info.reportID)
+        {
+            i++;
+        }
+    }
+}
+
+
+// ============================================================================
+#pragma mark - Transcoding -
+// ============================================================================
+
+/* Fixed up reports are pretty printed JSON, most of which is whitespace and
+ * the same few field names over and over. Once a report in its own file has
+ * been fixed up, it's re-encoded in the background without whitespace and
+ * compressed against a dictionary of what reports usually contain (see
+ * CrasheeCrashReportDictionary.h). decodeReport() undoes this, so readers
+ * never see the difference.
+ *
+ * Reports packed into segments are small user reports, and are left alone.
+ */
+
+/** Set when a report may have been fixed up since the last pass. */
+static _Atomic(bool) g_isTranscodingNeeded;
+
+static bool isTranscodingCandidate(const IndexEntry* const entry)
+{
+    return entry->segment == 0 &&
+           entry->info.state == CrasheeReportStateFixedUp &&
+           entry->info.type == CrasheeReportTypeJSON;
+}
+
+/** Encode a fixed up report the way it's kept at rest. Needs no lock.
+ *
+ * @param report The report as it is on disk, fixed up magic and all.
+ *
+ * @param encodedLength Receives the length of the encoded report.
+ *
+ * @return The newly allocated encoded report, or NULL if it couldn't be
+ *         encoded or wouldn't be any smaller.
+ */
+static char* encodeReportAtRest(const CrasheeFileView* const report, int* const encodedLength)
+{
+    int minifiedLength = 0;
+    char* minified = crasheecrf_minifyCrashReport(report->data + FIXED_UP_MAGIC_LENGTH,
+                                                  report->length - FIXED_UP_MAGIC_LENGTH,
+                                                  &minifiedLength);
+    if(minified == NULL)
+    {
+        return NULL;
+    }
+    // Still fixed up once it's decompressed again.
+    char* plain = malloc((size_t)minifiedLength + FIXED_UP_MAGIC_LENGTH);
+    if(plain == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d bytes", minifiedLength + FIXED_UP_MAGIC_LENGTH);
+        free(minified);
+        return NULL;
+    }
+    memcpy(plain, g_fixedUpMagic, FIXED_UP_MAGIC_LENGTH);
+    memcpy(plain + FIXED_UP_MAGIC_LENGTH, minified, (size_t)minifiedLength);
+    free(minified);
+
+    char* encoded = crasheelz_compressWithDictionary(plain,
+                                                     minifiedLength + FIXED_UP_MAGIC_LENGTH,
+                                                     crasheecrd_getCurrentDictionary(),
+                                                     encodedLength);
+    free(plain);
+    if(encoded != NULL && *encodedLength >= report->length)
+    {
+        free(encoded);
+        return NULL;
+    }
+    return encoded;
+}
+
+/** Write a report that was encoded at rest to a temporary file. Needs no lock. */
+static bool writeTranscodedReport(const char* const path, const char* const data, const int length)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", path, strerror(errno));
+        return false;
+    }
+    bool isWritten = crasheefu_writeBytesToFD(fd, data, length);
+    if(close(fd) != 0)
+    {
+        CrasheeLOG_ERROR("Could not write file %s: %s", path, strerror(errno));
+        isWritten = false;
+    }
+    return isWritten;
+}
+
+/** Re-encode the fixed up reports that are still plain JSON.
+ * Must be called with g_mutex held, but releases it while encoding each
+ * report, so that adding and reading reports doesn't have to wait.
+ */
+static void transcodeReports()
+{
+    updateIndex();
+    int64_t lastReportID = 0;
+    for(;;)
+    {
+        // The index may have changed while the lock was released.
+        int index = findReport(lastReportID + 1);
+        if(index < 0)
+        {
+            index = -index - 1;
+        }
+        while(index < g_reportCount && !isTranscodingCandidate(&g_reports[index]))
+        {
+            index++;
+        }
+        if(index >= g_reportCount)
+        {
+            break;
+        }
+        const IndexEntry entry = g_reports[index];
+        lastReportID = entry.info.reportID;
+        CrasheeFileView report;
+        if(!mapRawReport(lastReportID, &report))
+        {
+            continue;
+        }
+
+        char tempPath[CrasheeCRS_MAX_PATH_LENGTH];
+        // Must not look like a report name, or it would be listed as one.
+        crasheefmt_format(tempPath, sizeof(tempPath), "%s/transcode-%016llx.tmp", g_reportsPath, lastReportID);
+        pthread_mutex_unlock(&g_mutex);
+        int encodedLength = 0;
+        char* encoded = NULL;
+        if(report.length > FIXED_UP_MAGIC_LENGTH)
+        {
+            encoded = encodeReportAtRest(&report, &encodedLength);
+        }
+        crasheefu_unmapFile(&report);
+        const bool isWritten = encoded != NULL && writeTranscodedReport(tempPath, encoded, encodedLength);
+        free(encoded);
+        pthread_mutex_lock(&g_mutex);
+
+        // Only replace the report if it's still the one that was encoded.
+        bool isReplaced = false;
+        refreshIndex();
+        index = findReport(lastReportID);
+        if(isWritten &&
+           index >= 0 &&
+           isTranscodingCandidate(&g_reports[index]) &&
+           g_reports[index].info.size == entry.info.size &&
+           publishReportFile(tempPath, lastReportID, g_durability == CrasheeReportDurabilitySync))
+        {
+            CrasheeReportInfo info = g_reports[index].info;
+            info.size = encodedLength;
+            info.type = CrasheeReportTypeCompressed;
+            appendRecord(ManifestOperation_Set, &info);
+            refreshIndex();
+            commitReport(lastReportID);
+            isReplaced = true;
+        }
+        if(isWritten && !isReplaced)
+        {
+            unlink(tempPath);
+        }
+    }
+}
+
+
+// ============================================================================
+#pragma mark - Report Slot -
+// ============================================================================
+
+/* Crash reports are written into a slot: a file that was created and had its
+ * space reserved ahead of time, so that the crash handler doesn't have to
+ * create files or allocate disk space, which is slow and fails on a full
+ * disk. crasheecrs_getNextCrashReport() moves the slot to the report's path,
+ * and crasheecrs_notifyReportWritten() gives back the space the report didn't
+ * use. A fresh slot is then prepared on the maintenance thread.
+ */
+
+#define REPORT_SLOT_FILENAME "next-report.slot"
+
+static int64_t g_reportSlotSize = CrasheeCRS_DEFAULT_REPORT_SLOT_SIZE;
+static char g_reportSlotPath[CrasheeCRS_MAX_PATH_LENGTH];
+/** The ready slot, kept open so that its reserved space is held on to. -1 if there is none. */
+static _Atomic(int) g_reportSlotFD = -1;
+/** The slot handed out to a report that is still being written. */
+static int g_claimedSlotFD = -1;
+static int64_t g_claimedSlotReportID;
+
+/** Written to in order to wake the maintenance thread. */
+static int g_maintenanceWakePipe[2] = {-1, -1};
+
+/** This function is async-safe. */
+static void wakeMaintenanceThread()
+{
+    if(g_maintenanceWakePipe[1] < 0)
+    {
+        return;
+    }
+    const char byte = 0;
+    // A full pipe means the thread has plenty of wake-ups coming already.
+    if(write(g_maintenanceWakePipe[1], &byte, 1) != 1 && errno != EAGAIN)
+    {
+        CrasheeLOG_ERROR("Could not wake the maintenance thread: %s", strerror(errno));
+    }
+}
+
+/** Must be called with g_mutex held. */
+static void prepareReportSlot()
+{
+    if(g_reportSlotSize <= 0 || g_reportSlotFD >= 0)
+    {
+        return;
+    }
+    int fd = open(g_reportSlotPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", g_reportSlotPath, strerror(errno));
+        return;
+    }
+    // Still worth having if this fails, as the file already exists.
+    crasheefu_preallocateFile(fd, g_reportSlotSize);
+    g_reportSlotFD = fd;
+}
+
+/** Must be called with g_mutex held. */
+static void discardReportSlot()
+{
+    const int fd = atomic_exchange(&g_reportSlotFD, -1);
+    if(fd >= 0)
+    {
+        close(fd);
+        unlink(g_reportSlotPath);
+    }
+}
+
+/** Move the slot, if one is ready, to a report's path.
+ * This function is async-safe.
+ */
+static void claimReportSlot(const int64_t reportID)
+{
+    const int fd = atomic_exchange(&g_reportSlotFD, -1);
+    if(fd < 0)
+    {
+        return;
+    }
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    getInProgressPathByID(reportID, path);
+    if(rename(g_reportSlotPath, path) != 0)
+    {
+        // The report will be created from scratch instead.
+        close(fd);
+        return;
+    }
+    g_claimedSlotFD = fd;
+    g_claimedSlotReportID = reportID;
+}
+
+/** Give back the reserved space a report didn't use, and ask for a new slot.
+ * This function is async-safe.
+ */
+static void releaseReportSlot(const int64_t reportID)
+{
+    if(g_claimedSlotFD < 0 || g_claimedSlotReportID != reportID)
+    {
+        return;
+    }
+    struct stat st;
+    if(fstat(g_claimedSlotFD, &st) != 0 || ftruncate(g_claimedSlotFD, st.st_size) != 0)
+    {
+        CrasheeLOG_ERROR("Could not trim report slot: %s", strerror(errno));
+    }
+    close(g_claimedSlotFD);
+    g_claimedSlotFD = -1;
+    wakeMaintenanceThread();
+}
+
+
+// ============================================================================
+#pragma mark - Maintenance Thread -
+// ============================================================================
+
+/* Work that can wait, like preparing report slots, coalescing repeated
+ * crashes, deleting old reports, compressing fixed up reports and compacting
+ * segments, is done on a
+ * background thread so that it's never in the way of launching the app or
+ * adding reports.
+ */
+
+/** Set when the retention limits may have been exceeded. */
+static _Atomic(bool) g_isRetentionNeeded;
+
+static void* maintenanceThread(__unused void* userData)
+{
+    for(;;)
+    {
+        pthread_mutex_lock(&g_mutex);
+        prepareReportSlot();
+        // Before retention, so that repeats don't count against the limits.
+        if(atomic_exchange(&g_isCoalescingNeeded, false))
+        {
+            coalesceCrashReports();
+        }
+        if(atomic_exchange(&g_isRetentionNeeded, false))
+        {
+            enforceRetention();
+        }
+        // After retention, so that no time is spent on reports about to go.
+        if(atomic_exchange(&g_isTranscodingNeeded, false))
+        {
+            transcodeReports();
+        }
+        if(atomic_exchange(&g_isCompactionNeeded, false))
+        {
+            compactSegments();
+        }
+        pthread_mutex_unlock(&g_mutex);
+
+        char byte;
+        ssize_t bytesRead;
+        while((bytesRead = read(g_maintenanceWakePipe[0], &byte, 1)) < 0 && errno == EINTR)
+        {
+        }
+        if(bytesRead <= 0)
+        {
+            return NULL;
+        }
+    }
+}
+
+/** Start the maintenance thread, or wake it if it's already running.
+ * Must be called with g_mutex held.
+ */
+static void startMaintenanceThread()
+{
+    if(g_maintenanceWakePipe[0] >= 0)
+    {
+        wakeMaintenanceThread();
+        return;
+    }
+    if(pipe(g_maintenanceWakePipe) != 0)
+    {
+        CrasheeLOG_ERROR("Could not create pipe: %s", strerror(errno));
+        return;
+    }
+    // Woken with g_mutex held, so waking must never wait for the thread.
+    fcntl(g_maintenanceWakePipe[1], F_SETFL, O_NONBLOCK);
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int error = pthread_create(&thread, &attr, maintenanceThread, NULL);
+    if(error != 0)
     {
-        return 1;
+        CrasheeLOG_ERROR("pthread_create: %s", strerror(error));
     }
-    return 0;
+    pthread_attr_destroy(&attr);
 }
 
-static inline int64_t getNextUniqueID()
+/** Have old reports deleted if a report that was just added took the store
+ * over one of its limits, fixed up reports compressed, and segments compacted
+ * if deleting left them mostly holes. Must be called with g_mutex held.
+ */
+static void requestMaintenance()
+{
+    if(isRetentionNeeded())
+    {
+        g_isRetentionNeeded = true;
+    }
+    if(g_isRetentionNeeded || g_isCompactionNeeded || g_isTranscodingNeeded)
+    {
+        wakeMaintenanceThread();
+    }
+}
+
+
+
+// ============================================================================
+#pragma mark - User Reports -
+// ============================================================================
+
+static CrasheeReportInfo makeUserReportInfo(const int64_t reportID, const int reportLength)
+{
+    return (CrasheeReportInfo)
+    {
+        .reportID = reportID,
+        .size = reportLength,
+        .createdAt = (int64_t)time(NULL),
+        .type = CrasheeReportTypeJSON,
+        .state = CrasheeReportStatePending,
+        .kind = CrasheeReportKindUser,
+    };
+}
+
+/** Write a user report to a file of its own and publish it. Needs no lock:
+ * the report has a name of its own, and until its manifest record lands
+ * it's just an unlisted file.
+ */
+static bool writeUserReportFile(const int64_t reportID, const char* const report, const int reportLength)
+{
+    char inProgressPath[CrasheeCRS_MAX_PATH_LENGTH];
+    getInProgressPathByID(reportID, inProgressPath);
+
+    int fd = open(inProgressPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", inProgressPath, strerror(errno));
+        return false;
+    }
+    bool isWritten = crasheefu_writeBytesToFD(fd, report, reportLength);
+    if(close(fd) != 0)
+    {
+        CrasheeLOG_ERROR("Could not write file %s: %s", inProgressPath, strerror(errno));
+        isWritten = false;
+    }
+    if(!isWritten || !publishReportFile(inProgressPath, reportID, g_durability == CrasheeReportDurabilitySync))
+    {
+        unlink(inProgressPath);
+        return false;
+    }
+    return true;
+}
+
+/** Add several user reports. Files are written without the lock held, and
+ * the lock is then taken once to list all of them with a single manifest write.
+ *
+ * @param reportIDs Receives each report's ID, or 0 if it couldn't be added.
+ *
+ * @return The number of reports that were added.
+ */
+static int addUserReports(const char* const* const reports,
+                          const int* const reportLengths,
+                          const int count,
+                          int64_t* const reportIDs)
+{
+    ManifestRecord* records = malloc(sizeof(*records) * (size_t)(count > 0 ? count : 1));
+    if(records == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d manifest records", count);
+        int addedCount = 0;
+        for(int i = 0; i < count; i++)
+        {
+            reportIDs[i] = crasheecrs_addUserReport(reports[i], reportLengths[i]);
+            addedCount += reportIDs[i] != 0;
+        }
+        return addedCount;
+    }
+
+    const bool isInSegments = g_userReportStorage == CrasheeUserReportStorageSegments;
+    if(!isInSegments)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            const int64_t reportID = getNextUniqueID();
+            reportIDs[i] = writeUserReportFile(reportID, reports[i], reportLengths[i]) ? reportID : 0;
+        }
+    }
+
+    int addedCount = 0;
+    pthread_mutex_lock(&g_mutex);
+    for(int i = 0; i < count; i++)
+    {
+        const int64_t reportID = isInSegments ? getNextUniqueID() : reportIDs[i];
+        IndexEntry entry = { .info = makeUserReportInfo(reportID, reportLengths[i]) };
+        if(isInSegments)
+        {
+            reportIDs[i] = appendToSegment(&entry, reports[i], reportLengths[i]) ? reportID : 0;
+        }
+        if(reportIDs[i] != 0)
+        {
+            records[addedCount++] = makeRecord(ManifestOperation_Set, &entry);
+            commitReport(reportIDs[i]);
+        }
+    }
+    appendRecords(records, addedCount);
+    refreshIndex();
+    requestMaintenance();
+    pthread_mutex_unlock(&g_mutex);
+    free(records);
+    return addedCount;
+}
+
+/** Delete several reports, taking the lock once to drop all of them with a
+ * single manifest write. Their files are unlinked after that write, with the
+ * lock still held: a report being fixed up or compressed in the meantime
+ * would otherwise be published again over a file that was just unlinked.
+ *
+ * @return The number of reports that were in the store.
+ */
+static int deleteReports(const int64_t* const reportIDs, const int count)
+{
+    ManifestRecord* records = malloc(sizeof(*records) * (size_t)(count > 0 ? count : 1));
+    int deletedCount = 0;
+    pthread_mutex_lock(&g_mutex);
+    refreshIndex();
+    if(records == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d manifest records", count);
+        for(int i = 0; i < count; i++)
+        {
+            if(findReport(reportIDs[i]) >= 0)
+            {
+                deleteReportWithID(reportIDs[i]);
+                deletedCount++;
+            }
+        }
+    }
+    else
+    {
+        for(int i = 0; i < count; i++)
+        {
+            const int index = findReport(reportIDs[i]);
+            if(index >= 0)
+            {
+                records[deletedCount++] = makeRecord(ManifestOperation_Remove, &g_reports[index]);
+            }
+        }
+        appendRecords(records, deletedCount);
+        refreshIndex();
+        for(int i = 0; i < deletedCount; i++)
+        {
+            if(records[i].segment != 0)
+            {
+                // The report stays in its segment until that is compacted.
+                noteSegmentShrunk(records[i].segment);
+                continue;
+            }
+            char path[CrasheeCRS_MAX_PATH_LENGTH];
+            getCrashReportPathByID(records[i].reportID, path);
+            if(unlink(path) != 0 && errno != ENOENT)
+            {
+                CrasheeLOG_ERROR("Could not delete %s: %s", path, strerror(errno));
+            }
+        }
+    }
+    requestMaintenance();
+    pthread_mutex_unlock(&g_mutex);
+    free(records);
+    return deletedCount;
+}
+
+
+// ============================================================================
+#pragma mark - I/O Queue -
+// ============================================================================
+
+/* Batches of reads, additions and deletions can be handed to a background
+ * thread, so that a caller such as an upload pipeline can get on with network
+ * work while the disk is busy. Batches run one at a time, in the order they
+ * were submitted, so deleting reports can be queued right behind reading them.
+ */
+
+typedef enum
 {
-    return g_nextUniqueIDHigh + g_nextUniqueIDLow++;
-}
+    IOOperation_Read,
+    IOOperation_Add,
+    IOOperation_Delete,
+} IOOperation;
 
-static void getCrashReportPathByID(int64_t id, char* pathBuffer)
+typedef struct IOBatch
 {
-    snprintf(pathBuffer, CrasheeCRS_MAX_PATH_LENGTH, "%s/%s-report-%016llx.json", g_reportsPath, g_appName, id);
-    
-}
+    struct IOBatch* next;
+    IOOperation operation;
+    /** The reports to read or delete, or the IDs of the reports added. */
+    int64_t* reportIDs;
+    int count;
+    /** Copies of the reports to add. */
+    char** reports;
+    int* reportLengths;
+    CrasheeReportViewCallback callback;
+    CrasheeReportBatchCallback completion;
+    void* userData;
+} IOBatch;
 
-static int64_t getReportIDFromFilename(const char* filename)
-{
-    char scanFormat[100];
-    sprintf(scanFormat, "%s-report-%%" PRIx64 ".json", g_appName);
-    
-    int64_t reportID = 0;
-    sscanf(filename, scanFormat, &reportID);
-    return reportID;
-}
+static pthread_mutex_t g_ioQueueMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ioQueueCondition = PTHREAD_COND_INITIALIZER;
+static IOBatch* g_ioQueueHead;
+static IOBatch* g_ioQueueTail;
+static bool g_isIOThreadRunning;
 
-static int getReportCount()
+/** Make a batch, with a copy of the report IDs if there are any. */
+static IOBatch* makeIOBatch(const IOOperation operation,
+                            const int64_t* const reportIDs,
+                            const int count,
+                            const CrasheeReportBatchCallback completion,
+                            void* const userData)
 {
-    int count = 0;
-    DIR* dir = opendir(g_reportsPath);
-    if(dir == NULL)
+    IOBatch* batch = calloc(1, sizeof(*batch));
+    int64_t* batchReportIDs = calloc((size_t)(count > 0 ? count : 1), sizeof(*batchReportIDs));
+    if(batch == NULL || batchReportIDs == NULL)
     {
-        CrasheeLOG_ERROR("Could not open directory %s", g_reportsPath);
-        goto done;
+        CrasheeLOG_ERROR("Could not allocate a batch of %d reports", count);
+        free(batch);
+        free(batchReportIDs);
+        return NULL;
     }
-    struct dirent* ent;
-    while((ent = readdir(dir)) != NULL)
+    if(reportIDs != NULL && count > 0)
     {
-        if(getReportIDFromFilename(ent->d_name) > 0)
-        {
-            count++;
-        }
+        memcpy(batchReportIDs, reportIDs, sizeof(*batchReportIDs) * (size_t)count);
     }
+    batch->operation = operation;
+    batch->reportIDs = batchReportIDs;
+    batch->count = count;
+    batch->completion = completion;
+    batch->userData = userData;
+    return batch;
+}
 
-done:
-    if(dir != NULL)
+static void freeIOBatch(IOBatch* const batch)
+{
+    for(int i = 0; batch->reports != NULL && i < batch->count; i++)
     {
-        closedir(dir);
+        free(batch->reports[i]);
     }
-    return count;
+    free(batch->reports);
+    free(batch->reportLengths);
+    free(batch->reportIDs);
+    free(batch);
 }
 
-static int getReportIDs(int64_t* reportIDs, int count)
+static void runIOBatch(IOBatch* const batch)
 {
-    int index = 0;
-    DIR* dir = opendir(g_reportsPath);
-    if(dir == NULL)
+    int completedCount = 0;
+    switch(batch->operation)
     {
-        CrasheeLOG_ERROR("Could not open directory %s", g_reportsPath);
-        goto done;
+        case IOOperation_Read:
+            completedCount = crasheecrs_readReports(batch->reportIDs, batch->count, 0, batch->callback, batch->userData);
+            break;
+        case IOOperation_Add:
+            completedCount = addUserReports((const char* const*)batch->reports, batch->reportLengths, batch->count, batch->reportIDs);
+            break;
+        case IOOperation_Delete:
+            completedCount = deleteReports(batch->reportIDs, batch->count);
+            break;
+    }
+    if(batch->completion != NULL)
+    {
+        batch->completion(batch->reportIDs, batch->count, completedCount, batch->userData);
     }
+}
 
-    struct dirent* ent;
-    while((ent = readdir(dir)) != NULL && index < count)
+static void* ioThread(__unused void* userData)
+{
+    pthread_mutex_lock(&g_ioQueueMutex);
+    for(;;)
     {
-        int64_t reportID = getReportIDFromFilename(ent->d_name);
-        if(reportID > 0)
+        while(g_ioQueueHead == NULL)
         {
-            reportIDs[index++] = reportID;
+            pthread_cond_wait(&g_ioQueueCondition, &g_ioQueueMutex);
         }
-    }
+        IOBatch* const batch = g_ioQueueHead;
+        g_ioQueueHead = batch->next;
+        if(g_ioQueueHead == NULL)
+        {
+            g_ioQueueTail = NULL;
+        }
+        pthread_mutex_unlock(&g_ioQueueMutex);
 
-    qsort(reportIDs, (unsigned)count, sizeof(reportIDs[0]), compareInt64);
+        runIOBatch(batch);
+        freeIOBatch(batch);
 
-done:
-    if(dir != NULL)
-    {
-        closedir(dir);
+        pthread_mutex_lock(&g_ioQueueMutex);
     }
-    return index;
+    return NULL;
 }
 
-static void pruneReports()
+/** Queue a batch for the I/O thread, starting the thread if needed.
+ * The queue takes ownership of the batch.
+ *
+ * @return false if the batch couldn't be queued, in which case it's freed.
+ */
+static bool submitIOBatch(IOBatch* const batch)
 {
-    int reportCount = getReportCount();
-    if(reportCount > g_maxReportCount)
+    pthread_mutex_lock(&g_ioQueueMutex);
+    if(!g_isIOThreadRunning)
+    {
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        int error = pthread_create(&thread, &attr, ioThread, NULL);
+        if(error != 0)
+        {
+            CrasheeLOG_ERROR("pthread_create: %s", strerror(error));
+        }
+        g_isIOThreadRunning = error == 0;
+        pthread_attr_destroy(&attr);
+    }
+    const bool isQueued = g_isIOThreadRunning;
+    if(isQueued)
     {
-        int64_t reportIDs[reportCount];
-        reportCount = getReportIDs(reportIDs, reportCount);
-        
-        for(int i = 0; i < reportCount - g_maxReportCount; i++)
+        if(g_ioQueueTail != NULL)
+        {
+            g_ioQueueTail->next = batch;
+        }
+        else
         {
-            crasheecrs_deleteReportWithID(reportIDs[i]);
+            g_ioQueueHead = batch;
         }
+        g_ioQueueTail = batch;
+        pthread_cond_signal(&g_ioQueueCondition);
     }
+    pthread_mutex_unlock(&g_ioQueueMutex);
+    if(!isQueued)
+    {
+        freeIOBatch(batch);
+    }
+    return isQueued;
 }
 
-static void initializeIDs()
-{
-    time_t rawTime;
-    time(&rawTime);
-    struct tm time;
-    gmtime_r(&rawTime, &time);
-    int64_t baseID = (int64_t)time.tm_sec
-                   + (int64_t)time.tm_min * 61
-                   + (int64_t)time.tm_hour * 61 * 60
-                   + (int64_t)time.tm_yday * 61 * 60 * 24
-                   + (int64_t)time.tm_year * 61 * 60 * 24 * 366;
-    baseID <<= 23;
-
-    g_nextUniqueIDHigh = baseID & ~(int64_t)0xffffffff;
-    g_nextUniqueIDLow = (uint32_t)(baseID & 0xffffffff);
-}
 
 
 // Public API
@@ -179,8 +2557,27 @@ void crasheecrs_initialize(const char* appName, const char* reportsPath)
     g_appName = strdup(appName);
     g_reportsPath = strdup(reportsPath);
     crasheefu_makePath(reportsPath);
-    pruneReports();
+    if(!openManifest())
+    {
+        rebuildManifest();
+    }
+    resolveWritingReports();
+    if(g_manifestRecordCount > g_reportCount + MANIFEST_SLACK_RECORDS)
+    {
+        writeManifest();
+    }
+    loadSignatures();
     initializeIDs();
+    crasheefmt_format(g_reportSlotPath, sizeof(g_reportSlotPath), "%s/" REPORT_SLOT_FILENAME, g_reportsPath);
+    prepareReportSlot();
+    // Crashes from the last launch are coalesced, old reports are deleted,
+    // reports fixed up earlier are compressed and segments left by earlier
+    // launches are compacted, in the background, out of the way of the launch.
+    g_isCoalescingNeeded = true;
+    g_isRetentionNeeded = true;
+    g_isTranscodingNeeded = true;
+    g_isCompactionNeeded = true;
+    startMaintenanceThread();
     pthread_mutex_unlock(&g_mutex);
 }
 
@@ -189,15 +2586,53 @@ int64_t crasheecrs_getNextCrashReport(char* crashReportPathBuffer)
     int64_t nextID = getNextUniqueID();
     if(crashReportPathBuffer)
     {
-        getCrashReportPathByID(nextID, crashReportPathBuffer);
+        getInProgressPathByID(nextID, crashReportPathBuffer);
     }
+    claimReportSlot(nextID);
+    // Resolved at the next launch if the crash handler doesn't get to
+    // crasheecrs_notifyReportWritten().
+    const CrasheeReportInfo info =
+    {
+        .reportID = nextID,
+        .createdAt = (int64_t)time(NULL),
+        .type = CrasheeReportTypeUnknown,
+        .state = CrasheeReportStateWriting,
+        .kind = CrasheeReportKindCrash,
+    };
+    appendRecord(ManifestOperation_Set, &info);
     return nextID;
 }
 
+void crasheecrs_notifyReportWritten(int64_t reportID)
+{
+    releaseReportSlot(reportID);
+    char inProgressPath[CrasheeCRS_MAX_PATH_LENGTH];
+    getInProgressPathByID(reportID, inProgressPath);
+    // A crashing process won't be around for a group commit.
+    publishReportFile(inProgressPath, reportID, g_durability != CrasheeReportDurabilityNone);
+    crasheecrs_notifyReportRewritten(reportID);
+}
+
+void crasheecrs_notifyReportRewritten(int64_t reportID)
+{
+    CrasheeReportInfo info;
+    if(getReportInfoFromFile(reportID, &info))
+    {
+        info.kind = CrasheeReportKindCrash;
+        appendRecord(ManifestOperation_Set, &info);
+    }
+}
+
+void crasheecrs_getCrashReportPath(int64_t reportID, char* crashReportPathBuffer)
+{
+    getCrashReportPathByID(reportID, crashReportPathBuffer);
+}
+
 int crasheecrs_getReportCount()
 {
     pthread_mutex_lock(&g_mutex);
-    int count = getReportCount();
+    updateIndex();
+    int count = g_reportCount - g_writingReportCount;
     pthread_mutex_unlock(&g_mutex);
     return count;
 }
@@ -205,54 +2640,307 @@ int crasheecrs_getReportCount()
 int crasheecrs_getReportIDs(int64_t* reportIDs, int count)
 {
     pthread_mutex_lock(&g_mutex);
-    count = getReportIDs(reportIDs, count);
+    updateIndex();
+    int index = 0;
+    for(int i = 0; i < g_reportCount && index < count; i++)
+    {
+        if(g_reports[i].info.state != CrasheeReportStateWriting)
+        {
+            reportIDs[index++] = g_reports[i].info.reportID;
+        }
+    }
     pthread_mutex_unlock(&g_mutex);
-    return count;
+    return index;
 }
 
-char* crasheecrs_readReport(int64_t reportID)
+int crasheecrs_getReportInfos(CrasheeReportInfo* reportInfos, int count)
 {
     pthread_mutex_lock(&g_mutex);
-    char path[CrasheeCRS_MAX_PATH_LENGTH];
-    getCrashReportPathByID(reportID, path);
-    char* result;
-    crasheefu_readEntireFile(path, &result, NULL, 2000000);
+    updateIndex();
+    int index = 0;
+    for(int i = 0; i < g_reportCount && index < count; i++)
+    {
+        if(g_reports[i].info.state != CrasheeReportStateWriting)
+        {
+            reportInfos[index++] = g_reports[i].info;
+        }
+    }
     pthread_mutex_unlock(&g_mutex);
-    return result;
+    return index;
 }
 
-int64_t crasheecrs_addUserReport(const char* report, int reportLength)
+bool crasheecrs_getReportOccurrences(int64_t reportID, CrasheeReportOccurrences* occurrences)
+{
+    pthread_mutex_lock(&g_mutex);
+    updateIndex();
+    const int index = findReport(reportID);
+    const int signature = findSignature(reportID);
+    if(signature >= 0)
+    {
+        *occurrences = (CrasheeReportOccurrences)
+        {
+            .occurrenceCount = (int)g_signatures[signature].occurrenceCount,
+            .firstOccurredAt = g_signatures[signature].firstOccurredAt,
+            .lastOccurredAt = g_signatures[signature].lastOccurredAt,
+        };
+    }
+    else if(index >= 0)
+    {
+        const int64_t createdAt = g_reports[index].info.createdAt;
+        *occurrences = (CrasheeReportOccurrences)
+        {
+            .occurrenceCount = 1,
+            .firstOccurredAt = createdAt,
+            .lastOccurredAt = createdAt,
+        };
+    }
+    pthread_mutex_unlock(&g_mutex);
+    return index >= 0;
+}
+
+bool crasheecrs_mapReport(int64_t reportID, CrasheeFileView* report, bool* isFixedUp)
+{
+    pthread_mutex_lock(&g_mutex);
+    bool isMapped = mapRawReport(reportID, report);
+    pthread_mutex_unlock(&g_mutex);
+    return isMapped && decodeReport(report, isFixedUp);
+}
+
+typedef struct
+{
+    const int64_t* reportIDs;
+    /** The raw reports, or empty views for those that couldn't be mapped. */
+    CrasheeFileView* reports;
+    int reportCount;
+    CrasheeReportViewCallback callback;
+    void* userData;
+    _Atomic(int) nextIndex;
+    _Atomic(int) readCount;
+} ReadBatch;
+
+static void* readReportsThread(void* userData)
 {
+    ReadBatch* batch = (ReadBatch*)userData;
+    for(int i = batch->nextIndex++; i < batch->reportCount; i = batch->nextIndex++)
+    {
+        // Keep the disk busy with the reports coming up next.
+        if(i + READ_AHEAD_COUNT < batch->reportCount)
+        {
+            crasheefu_prefetchView(&batch->reports[i + READ_AHEAD_COUNT]);
+        }
+        CrasheeFileView* report = &batch->reports[i];
+        bool isFixedUp = false;
+        if(report->data != NULL && decodeReport(report, &isFixedUp))
+        {
+            batch->callback(batch->reportIDs[i], report, isFixedUp, batch->userData);
+            batch->readCount++;
+        }
+        crasheefu_unmapFile(report);
+    }
+    return NULL;
+}
+
+int crasheecrs_readReports(const int64_t* reportIDs,
+                           int count,
+                           int maxThreadCount,
+                           CrasheeReportViewCallback callback,
+                           void* userData)
+{
+    if(count <= 0)
+    {
+        return 0;
+    }
+    CrasheeFileView* reports = calloc((size_t)count, sizeof(*reports));
+    if(reports == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d report views", count);
+        return 0;
+    }
+
+    // Mapping only opens the files; the reading happens in the workers.
+    // Reports in segments are read here, but they're small.
     pthread_mutex_lock(&g_mutex);
-    int64_t currentID = getNextUniqueID();
-    char crashReportPath[CrasheeCRS_MAX_PATH_LENGTH];
-    getCrashReportPathByID(currentID, crashReportPath);
+    for(int i = 0; i < count; i++)
+    {
+        // Left empty if it can't be mapped.
+        mapRawReport(reportIDs[i], &reports[i]);
+    }
+    pthread_mutex_unlock(&g_mutex);
+    for(int i = 0; i < count && i < READ_AHEAD_COUNT; i++)
+    {
+        crasheefu_prefetchView(&reports[i]);
+    }
+
+    ReadBatch batch =
+    {
+        .reportIDs = reportIDs,
+        .reports = reports,
+        .reportCount = count,
+        .callback = callback,
+        .userData = userData,
+        .nextIndex = 0,
+        .readCount = 0,
+    };
+    if(maxThreadCount <= 0)
+    {
+        maxThreadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(maxThreadCount > MAX_READ_THREADS)
+    {
+        maxThreadCount = MAX_READ_THREADS;
+    }
+    if(maxThreadCount > count)
+    {
+        maxThreadCount = count;
+    }
+
+    // The calling thread does its share too.
+    pthread_t threads[MAX_READ_THREADS];
+    int threadCount = 0;
+    while(threadCount < maxThreadCount - 1 &&
+          pthread_create(&threads[threadCount], NULL, readReportsThread, &batch) == 0)
+    {
+        threadCount++;
+    }
+    readReportsThread(&batch);
+    for(int i = 0; i < threadCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(reports);
+    return batch.readCount;
+}
+
+void crasheecrs_unmapReport(CrasheeFileView* report)
+{
+    crasheefu_unmapFile(report);
+}
+
+char* crasheecrs_readReport(int64_t reportID)
+{
+    CrasheeFileView report;
+    if(!crasheecrs_mapReport(reportID, &report, NULL))
+    {
+        return NULL;
+    }
+    char* result = malloc((size_t)report.length + 1);
+    if(result == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d bytes", report.length + 1);
+    }
+    else
+    {
+        memcpy(result, report.data, (size_t)report.length);
+        result[report.length] = '\0';
+    }
+    crasheecrs_unmapReport(&report);
+    return result;
+}
 
-    int fd = open(crashReportPath, O_WRONLY | O_CREAT, 0644);
+bool crasheecrs_replaceWithFixedUpReport(int64_t reportID,
+                                         bool (*writeReport)(int fd, void* userData),
+                                         void* userData)
+{
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    char tempPath[CrasheeCRS_MAX_PATH_LENGTH];
+    getCrashReportPathByID(reportID, path);
+    // Must not look like a report name, or it would be listed as one.
+    crasheefmt_format(tempPath, sizeof(tempPath), "%s/fixup-%016llx.tmp", g_reportsPath, reportID);
+
+    int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
     if(fd < 0)
     {
-        CrasheeLOG_ERROR("Could not open file %s: %s", crashReportPath, strerror(errno));
-        goto done;
+        CrasheeLOG_ERROR("Could not open file %s: %s", tempPath, strerror(errno));
+        return false;
+    }
+    bool isWritten = crasheefu_writeBytesToFD(fd, g_fixedUpMagic, FIXED_UP_MAGIC_LENGTH) &&
+                     writeReport(fd, userData);
+    if(close(fd) != 0)
+    {
+        CrasheeLOG_ERROR("Could not write file %s: %s", tempPath, strerror(errno));
+        isWritten = false;
     }
 
-    int bytesWritten = (int)write(fd, report, (unsigned)reportLength);
-    if(bytesWritten < 0)
+    bool isReplaced = false;
+    if(isWritten)
     {
-        CrasheeLOG_ERROR("Could not write to file %s: %s", crashReportPath, strerror(errno));
-        goto done;
+        pthread_mutex_lock(&g_mutex);
+        const int index = findReport(reportID);
+        if(index >= 0 && g_reports[index].segment != 0)
+        {
+            isReplaced = replaceSegmentReport(&g_reports[index], tempPath);
+            if(isReplaced)
+            {
+                // It was copied into the segment.
+                unlink(tempPath);
+                commitReport(reportID);
+                requestMaintenance();
+            }
+        }
+        else if(access(path, F_OK) == 0)
+        {
+            isReplaced = publishReportFile(tempPath, reportID, g_durability == CrasheeReportDurabilitySync);
+            CrasheeReportInfo info;
+            if(isReplaced && getReportInfoFromFile(reportID, &info))
+            {
+                if(index >= 0)
+                {
+                    info.createdAt = g_reports[index].info.createdAt;
+                    info.kind = g_reports[index].info.kind;
+                }
+                appendRecord(ManifestOperation_Set, &info);
+                refreshIndex();
+                commitReport(reportID);
+                g_isTranscodingNeeded = true;
+                requestMaintenance();
+            }
+        }
+        pthread_mutex_unlock(&g_mutex);
     }
-    else if(bytesWritten < reportLength)
+    if(!isReplaced)
     {
-        CrasheeLOG_ERROR("Expected to write %d bytes to file %s, but only wrote %d", crashReportPath, reportLength, bytesWritten);
+        unlink(tempPath);
     }
+    return isReplaced;
+}
 
-done:
-    if(fd >= 0)
+/** Add a user report by appending it to the active segment. */
+static int64_t addUserReportToSegment(const char* const report, const int reportLength)
+{
+    IndexEntry entry = { .info = makeUserReportInfo(getNextUniqueID(), reportLength) };
+    pthread_mutex_lock(&g_mutex);
+    const bool isAppended = appendToSegment(&entry, report, reportLength);
+    if(isAppended)
     {
-        close(fd);
+        appendEntryRecord(ManifestOperation_Set, &entry);
+        refreshIndex();
+        commitReport(entry.info.reportID);
+        requestMaintenance();
     }
     pthread_mutex_unlock(&g_mutex);
+    return isAppended ? entry.info.reportID : 0;
+}
+
+int64_t crasheecrs_addUserReport(const char* report, int reportLength)
+{
+    if(g_userReportStorage == CrasheeUserReportStorageSegments)
+    {
+        return addUserReportToSegment(report, reportLength);
+    }
+    const int64_t currentID = getNextUniqueID();
+    if(!writeUserReportFile(currentID, report, reportLength))
+    {
+        return 0;
+    }
 
+    const CrasheeReportInfo info = makeUserReportInfo(currentID, reportLength);
+    pthread_mutex_lock(&g_mutex);
+    appendRecord(ManifestOperation_Set, &info);
+    refreshIndex();
+    commitReport(currentID);
+    requestMaintenance();
+    pthread_mutex_unlock(&g_mutex);
     return currentID;
 }
 
@@ -260,17 +2948,161 @@ void crasheecrs_deleteAllReports()
 {
     pthread_mutex_lock(&g_mutex);
     crasheefu_deleteContentsOfPath(g_reportsPath);
+    closeActiveSegment();
+    closeManifest();
+    clearIndex();
+    writeManifest();
+    writeSignatures();
+    discardReportSlot();
+    prepareReportSlot();
     pthread_mutex_unlock(&g_mutex);
 }
 
 void crasheecrs_deleteReportWithID(int64_t reportID)
 {
-    char path[CrasheeCRS_MAX_PATH_LENGTH];
-    getCrashReportPathByID(reportID, path);
-    crasheefu_removeFile(path, true);
+    pthread_mutex_lock(&g_mutex);
+    deleteReportWithID(reportID);
+    requestMaintenance();
+    pthread_mutex_unlock(&g_mutex);
+}
+
+bool crasheecrs_readReportsAsync(const int64_t* reportIDs,
+                                 int count,
+                                 CrasheeReportViewCallback callback,
+                                 CrasheeReportBatchCallback completion,
+                                 void* userData)
+{
+    IOBatch* batch = makeIOBatch(IOOperation_Read, reportIDs, count, completion, userData);
+    if(batch == NULL)
+    {
+        return false;
+    }
+    batch->callback = callback;
+    return submitIOBatch(batch);
+}
+
+bool crasheecrs_addUserReportsAsync(const char* const* reports,
+                                    const int* reportLengths,
+                                    int count,
+                                    CrasheeReportBatchCallback completion,
+                                    void* userData)
+{
+    IOBatch* batch = makeIOBatch(IOOperation_Add, NULL, count, completion, userData);
+    if(batch == NULL)
+    {
+        return false;
+    }
+    // The caller's reports may be gone by the time the batch runs.
+    batch->reports = calloc((size_t)(count > 0 ? count : 1), sizeof(*batch->reports));
+    batch->reportLengths = calloc((size_t)(count > 0 ? count : 1), sizeof(*batch->reportLengths));
+    if(batch->reports == NULL || batch->reportLengths == NULL)
+    {
+        goto failed;
+    }
+    for(int i = 0; i < count; i++)
+    {
+        batch->reports[i] = malloc((size_t)(reportLengths[i] > 0 ? reportLengths[i] : 1));
+        if(batch->reports[i] == NULL)
+        {
+            goto failed;
+        }
+        memcpy(batch->reports[i], reports[i], (size_t)reportLengths[i]);
+        batch->reportLengths[i] = reportLengths[i];
+    }
+    return submitIOBatch(batch);
+
+failed:
+    CrasheeLOG_ERROR("Could not copy a batch of %d reports", count);
+    freeIOBatch(batch);
+    return false;
+}
+
+bool crasheecrs_deleteReportsAsync(const int64_t* reportIDs,
+                                   int count,
+                                   CrasheeReportBatchCallback completion,
+                                   void* userData)
+{
+    IOBatch* batch = makeIOBatch(IOOperation_Delete, reportIDs, count, completion, userData);
+    return batch != NULL && submitIOBatch(batch);
+}
+
+/** Have old reports deleted to meet limits that just changed. */
+static void setRetentionNeeded()
+{
+    if(g_reportsPath != NULL)
+    {
+        g_isRetentionNeeded = true;
+        wakeMaintenanceThread();
+    }
 }
 
 void crasheecrs_setMaxReportCount(int maxReportCount)
 {
+    pthread_mutex_lock(&g_mutex);
     g_maxReportCount = maxReportCount;
+    setRetentionNeeded();
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void crasheecrs_setMaxReportBytes(int64_t maxReportBytes)
+{
+    pthread_mutex_lock(&g_mutex);
+    g_maxReportBytes = maxReportBytes;
+    setRetentionNeeded();
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void crasheecrs_setMaxReportAge(int64_t maxReportAge)
+{
+    pthread_mutex_lock(&g_mutex);
+    g_maxReportAge = maxReportAge;
+    setRetentionNeeded();
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void crasheecrs_setMaxReportCountOfKind(CrasheeReportKind kind, int maxReportCount)
+{
+    if(kind != CrasheeReportKindCrash && kind != CrasheeReportKindUser)
+    {
+        CrasheeLOG_ERROR("Invalid report kind %d", kind);
+        return;
+    }
+    pthread_mutex_lock(&g_mutex);
+    g_maxReportCountByKind[kind] = maxReportCount;
+    setRetentionNeeded();
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void crasheecrs_setReportDurability(CrasheeReportDurability durability)
+{
+    pthread_mutex_lock(&g_mutex);
+    g_durability = durability;
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void crasheecrs_setFullCrashReportInterval(int interval)
+{
+    pthread_mutex_lock(&g_mutex);
+    g_fullCrashReportInterval = interval;
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void crasheecrs_setUserReportStorage(CrasheeUserReportStorage storage)
+{
+    pthread_mutex_lock(&g_mutex);
+    g_userReportStorage = storage;
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void crasheecrs_setReportSlotSize(int64_t reportSlotSize)
+{
+    pthread_mutex_lock(&g_mutex);
+    g_reportSlotSize = reportSlotSize;
+    if(g_reportsPath != NULL)
+    {
+        // Replaced with a slot of the new size, if any.
+        discardReportSlot();
+        prepareReportSlot();
+    }
+    pthread_mutex_unlock(&g_mutex);
 }
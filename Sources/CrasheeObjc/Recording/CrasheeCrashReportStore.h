@@ -32,10 +32,110 @@ extern "C" {
 #endif
 
 
+#include "Tools/CrasheeFileUtils.h"
+
+#include <stdbool.h>
 #include <stdint.h>
 
 #define CrasheeCRS_MAX_PATH_LENGTH 500
 
+/** Disk space reserved ahead of time for the next crash report, in bytes. */
+#ifndef CrasheeCRS_DEFAULT_REPORT_SLOT_SIZE
+    #define CrasheeCRS_DEFAULT_REPORT_SLOT_SIZE (512 * 1024)
+#endif
+
+/** How long the group commit thread waits for more reports to sync together. */
+#ifndef CrasheeCRS_GROUP_COMMIT_INTERVAL_MS
+    #define CrasheeCRS_GROUP_COMMIT_INTERVAL_MS 1000
+#endif
+
+/** The size at which a segment is sealed and a new one started. */
+#ifndef CrasheeCRS_SEGMENT_SIZE
+    #define CrasheeCRS_SEGMENT_SIZE (1024 * 1024)
+#endif
+
+/** Where user reports are kept. Crash reports always get a file each. */
+typedef enum
+{
+    /** A file per report. */
+    CrasheeUserReportStorageFiles = 0,
+    /** Packed together into a few append-only segment files, which makes
+     * adding many small reports much cheaper.
+     */
+    CrasheeUserReportStorageSegments,
+} CrasheeUserReportStorage;
+
+/** How hard to try to get reports onto permanent storage. Reports are always
+ * published whole, so neither readers nor a crash ever see half of one; this
+ * is about surviving the device losing power or the OS crashing.
+ */
+typedef enum
+{
+    /** Leave it to the OS. Cheapest, but the newest reports can be lost. */
+    CrasheeReportDurabilityNone = 0,
+    /** Sync each report before publishing it. */
+    CrasheeReportDurabilitySync,
+    /** Sync reports in batches, CrasheeCRS_GROUP_COMMIT_INTERVAL_MS after
+     * they're published, so that bursts cost one sync. Crash reports are
+     * synced like CrasheeReportDurabilitySync, as the process won't be
+     * around for the next batch.
+     */
+    CrasheeReportDurabilityGroupCommit,
+} CrasheeReportDurability;
+
+/** How a report is stored on disk. */
+typedef enum
+{
+    CrasheeReportTypeUnknown = 0,
+    CrasheeReportTypeJSON,
+    CrasheeReportTypeCBOR,
+    CrasheeReportTypeCompressed,
+} CrasheeReportType;
+
+typedef enum
+{
+    /** A crash handler started writing the report, and may not have finished. */
+    CrasheeReportStateWriting = 0,
+    /** The report needs fixing up before it is read. */
+    CrasheeReportStatePending,
+    /** The report was stored with crasheecrs_replaceWithFixedUpReport(). */
+    CrasheeReportStateFixedUp,
+} CrasheeReportState;
+
+/** Where a report came from, for per-kind retention limits. */
+typedef enum
+{
+    /** Found on disk when the manifest was rebuilt. */
+    CrasheeReportKindUnknown = 0,
+    CrasheeReportKindCrash,
+    /** Added with crasheecrs_addUserReport(). */
+    CrasheeReportKindUser,
+} CrasheeReportKind;
+
+typedef struct
+{
+    int64_t reportID;
+    /** Size of the report file in bytes. */
+    int64_t size;
+    /** When the report was created, in seconds since 1970. */
+    int64_t createdAt;
+    CrasheeReportType type;
+    CrasheeReportState state;
+    CrasheeReportKind kind;
+} CrasheeReportInfo;
+
+/** How many crashes a report stands for, once repeats of it have been
+ * coalesced into it.
+ */
+typedef struct
+{
+    /** Includes the report itself. */
+    int occurrenceCount;
+    /** In seconds since 1970. */
+    int64_t firstOccurredAt;
+    int64_t lastOccurredAt;
+} CrasheeReportOccurrences;
+
 /** Initialize the report store.
  *
  * @param appName The application's name.
@@ -45,14 +145,19 @@ void crasheecrs_initialize(const char* appName, const char* reportsPath);
 
 /** Get the next crash report to be generated.
  * Max length for paths is CrasheeCRS_MAX_PATH_LENGTH
+ * The report is written to an in-progress path, and isn't listed until
+ * crasheecrs_notifyReportWritten() publishes it under its real one.
+ * If a report slot is ready, it is moved to the in-progress path, so the
+ * report can be written without creating a file or allocating disk space.
+ * This function is async-safe.
  *
- * @param crashReportPathBuffer Buffer to store the crash report path.
+ * @param crashReportPathBuffer Buffer to store the path to write the report to.
  *
  * @return the report ID of the next report.
  */
 int64_t crasheecrs_getNextCrashReport(char* crashReportPathBuffer);
 
-/** Get the number of reports on disk.
+/** Get the number of reports on disk, not counting any still being written.
  */
 int crasheecrs_getReportCount(void);
 
@@ -65,7 +170,58 @@ int crasheecrs_getReportCount(void);
  */
 int crasheecrs_getReportIDs(int64_t* reportIDs, int count);
 
-/** Read a report.
+/** Get information about all reports on disk, oldest first.
+ * Counts and listings come from the store's manifest, so the reports
+ * directory isn't scanned.
+ *
+ * @param reportInfos An array big enough to hold all report infos.
+ * @param count How many reports the array can hold.
+ *
+ * @return The number of report infos that were placed in the array.
+ */
+int crasheecrs_getReportInfos(CrasheeReportInfo* reportInfos, int count);
+
+/** Get how many crashes a report stands for. Crash reports with the same
+ * signature as one already in the store are coalesced into it in the
+ * background, shortly after launch.
+ *
+ * @param reportID The ID of the report.
+ * @param occurrences Receives the occurrences.
+ *
+ * @return false if there is no such report.
+ */
+bool crasheecrs_getReportOccurrences(int64_t reportID, CrasheeReportOccurrences* occurrences);
+
+/** Publish a crash report returned by crasheecrs_getNextCrashReport() once
+ * it has been written, and give back the slot space it didn't use.
+ * Reports that are never published are picked up at the next launch.
+ * This function is async-safe.
+ *
+ * @param reportID The report's ID.
+ */
+void crasheecrs_notifyReportWritten(int64_t reportID);
+
+/** Update the store's record of a crash report that was rewritten in place
+ * after crasheecrs_notifyReportWritten() had already published it, such as
+ * when the app crashes again while handling a crash.
+ * This function is async-safe.
+ *
+ * @param reportID The report's ID.
+ */
+void crasheecrs_notifyReportRewritten(int64_t reportID);
+
+/** Get the path a crash report is published under.
+ * Max length for paths is CrasheeCRS_MAX_PATH_LENGTH
+ * This function is async-safe.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param crashReportPathBuffer Buffer to store the path in.
+ */
+void crasheecrs_getCrashReportPath(int64_t reportID, char* crashReportPathBuffer);
+
+/** Read a report. Fixed up reports are compressed in the background once
+ * they have been written, and are decompressed again here.
  *
  * @param reportID The report's ID.
  *
@@ -74,12 +230,178 @@ int crasheecrs_getReportIDs(int64_t* reportIDs, int count);
  */
 char* crasheecrs_readReport(int64_t reportID);
 
-/** Add a custom report to the store.
+/** Map a report into memory, without copying it.
+ * Compressed and binary reports are converted to JSON in a heap buffer, and
+ * are handed out the same way.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param report Filled in with a read-only view of the JSON report, which is
+ *               NOT null terminated. Release it with crasheecrs_unmapReport().
+ *
+ * @param isFixedUp Set to true if the report has already been fixed up and
+ *                  stored with crasheecrs_replaceWithFixedUpReport() (can be NULL).
+ *
+ * @return true if the report was found and could be mapped.
+ */
+bool crasheecrs_mapReport(int64_t reportID, CrasheeFileView* report, bool* isFixedUp);
+
+/** Called with each report read by crasheecrs_readReports().
+ *
+ * @param reportID The report's ID.
+ *
+ * @param report A read-only view of the JSON report, which is NOT null
+ *               terminated. It is only valid during the call.
+ *
+ * @param isFixedUp true if the report has already been fixed up.
+ *
+ * @param userData The user data passed to crasheecrs_readReports().
+ */
+typedef void (*CrasheeReportViewCallback)(int64_t reportID,
+                                          const CrasheeFileView* report,
+                                          bool isFixedUp,
+                                          void* userData);
+
+/** Read several reports at once. The store is locked once to open all of
+ * them, then they are read and decoded by a few worker threads, and each is
+ * handed to the callback as soon as it's ready, in no particular order.
+ * Reports that can't be read are skipped.
+ *
+ * @param reportIDs The IDs of the reports to read.
+ *
+ * @param count The number of report IDs.
+ *
+ * @param maxThreadCount The most threads to use, including the calling
+ *                       thread, or 0 for one per CPU (up to 4).
+ *
+ * @param callback Called with each report. It may be called from several
+ *                 threads at once.
+ *
+ * @param userData Any data you would like passed to the callback.
+ *
+ * @return The number of reports passed to the callback.
+ */
+int crasheecrs_readReports(const int64_t* reportIDs,
+                           int count,
+                           int maxThreadCount,
+                           CrasheeReportViewCallback callback,
+                           void* userData);
+
+/** Called when a batch submitted with one of the asynchronous functions below
+ * has finished. It is called on the store's I/O thread.
+ *
+ * @param reportIDs The reports the batch was for. For added reports, their
+ *                  new IDs, with 0 for any that couldn't be added. Only valid
+ *                  during the call.
+ *
+ * @param count The number of reports in the batch.
+ *
+ * @param completedCount How many of them were read, added or deleted.
+ *
+ * @param userData The user data passed when submitting the batch.
+ */
+typedef void (*CrasheeReportBatchCallback)(const int64_t* reportIDs,
+                                           int count,
+                                           int completedCount,
+                                           void* userData);
+
+/* The asynchronous functions below return right away, and do their work on
+ * the store's I/O thread. Batches run one at a time, in the order they were
+ * submitted, so reports can be deleted by queueing a batch right behind the
+ * one that reads them. Each function returns false if the batch couldn't be
+ * queued, in which case its callbacks are never called.
+ */
+
+/** Read several reports in the background, like crasheecrs_readReports().
+ *
+ * @param reportIDs The IDs of the reports to read. They are copied.
+ *
+ * @param count The number of report IDs.
+ *
+ * @param callback Called with each report, possibly from several threads at once.
+ *
+ * @param completion Called once all reports have been read (can be NULL).
+ *
+ * @param userData Any data you would like passed to the callbacks.
+ *
+ * @return true if the batch was queued.
+ */
+bool crasheecrs_readReportsAsync(const int64_t* reportIDs,
+                                 int count,
+                                 CrasheeReportViewCallback callback,
+                                 CrasheeReportBatchCallback completion,
+                                 void* userData);
+
+/** Add several user reports in the background. The store is locked once for
+ * the whole batch, rather than once per report.
+ *
+ * @param reports The reports' contents (must be JSON encoded). They are copied.
+ *
+ * @param reportLengths The length of each report in bytes.
+ *
+ * @param count The number of reports.
+ *
+ * @param completion Called with the new reports' IDs once they have been added (can be NULL).
+ *
+ * @param userData Any data you would like passed to the completion.
+ *
+ * @return true if the batch was queued.
+ */
+bool crasheecrs_addUserReportsAsync(const char* const* reports,
+                                    const int* reportLengths,
+                                    int count,
+                                    CrasheeReportBatchCallback completion,
+                                    void* userData);
+
+/** Delete several reports in the background. The store is locked once for
+ * the whole batch, rather than once per report.
+ *
+ * @param reportIDs The IDs of the reports to delete. They are copied.
+ *
+ * @param count The number of report IDs.
+ *
+ * @param completion Called once the reports have been deleted (can be NULL).
+ *
+ * @param userData Any data you would like passed to the completion.
+ *
+ * @return true if the batch was queued.
+ */
+bool crasheecrs_deleteReportsAsync(const int64_t* reportIDs,
+                                   int count,
+                                   CrasheeReportBatchCallback completion,
+                                   void* userData);
+
+/** Release a report mapped by crasheecrs_mapReport().
+ *
+ * @param report The report view.
+ */
+void crasheecrs_unmapReport(CrasheeFileView* report);
+
+/** Replace a report with its fixed up version, so that it never has to be
+ * fixed up again. The new version is written to a temporary file, which then
+ * replaces the report in one step, so readers see either version complete.
+ * Nothing is replaced if the report was deleted in the meantime.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param writeReport Called to write the fixed up JSON report to fd.
+ *                    Return false to abandon the replacement.
+ *
+ * @param userData Any data you would like passed to writeReport.
+ *
+ * @return true if the report was replaced.
+ */
+bool crasheecrs_replaceWithFixedUpReport(int64_t reportID,
+                                         bool (*writeReport)(int fd, void* userData),
+                                         void* userData);
+
+/** Add a custom report to the store. Threads can add reports concurrently;
+ * with file storage each one is written and published without the store lock.
  *
  * @param report The report's contents (must be JSON encoded).
  * @param reportLength The length of the report in bytes.
  *
- * @return the new report's ID.
+ * @return the new report's ID, or 0 if it couldn't be written.
  */
 int64_t crasheecrs_addUserReport(const char* report, int reportLength);
 
@@ -99,6 +421,63 @@ void crasheecrs_deleteReportWithID(int64_t reportID);
  */
     void crasheecrs_setMaxReportCount(int maxReportCount);
 
+/** Set the most disk space reports may take up before old ones get deleted.
+ * Default: 0
+ *
+ * @param maxReportBytes The total size in bytes, or 0 for no limit.
+ */
+void crasheecrs_setMaxReportBytes(int64_t maxReportBytes);
+
+/** Set how long reports are kept before they get deleted.
+ * Default: 0
+ *
+ * @param maxReportAge The age in seconds, or 0 for no limit.
+ */
+void crasheecrs_setMaxReportAge(int64_t maxReportAge);
+
+/** Set the maximum number of reports of one kind allowed on disk before old
+ * ones of that kind get deleted, so that a burst of user reports can't push
+ * out crash reports, or the other way around.
+ * Reports of unknown kind only count towards the overall limits.
+ * Default: 0
+ *
+ * @param kind CrasheeReportKindCrash or CrasheeReportKindUser.
+ *
+ * @param maxReportCount The maximum number of reports, or 0 for no limit.
+ */
+void crasheecrs_setMaxReportCountOfKind(CrasheeReportKind kind, int maxReportCount);
+
+/** Set how hard to try to get reports onto permanent storage.
+ * Default: CrasheeReportDurabilityNone
+ *
+ * @param durability The durability policy.
+ */
+void crasheecrs_setReportDurability(CrasheeReportDurability durability);
+
+/** Set how often a crash that repeats one already in the store is kept as a
+ * full report. The other repeats are only counted, in the report they repeat.
+ * Default: 0
+ *
+ * @param interval Keep every interval'th occurrence, 0 to keep only the
+ *                 first, or 1 to keep them all.
+ */
+void crasheecrs_setFullCrashReportInterval(int interval);
+
+/** Set where new user reports are kept. Reports already stored stay where they are.
+ * Default: CrasheeUserReportStorageFiles
+ *
+ * @param storage The storage to use.
+ */
+void crasheecrs_setUserReportStorage(CrasheeUserReportStorage storage);
+
+/** Set how much disk space to reserve ahead of time for the next crash report.
+ * Reports can grow past this, but then need to allocate space as they are
+ * written. Default: CrasheeCRS_DEFAULT_REPORT_SLOT_SIZE
+ *
+ * @param reportSlotSize The size in bytes, or 0 to create reports as they are written.
+ */
+void crasheecrs_setReportSlotSize(int64_t reportSlotSize);
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,6 +42,21 @@ extern "C" {
 #include <stdint.h>
 
 
+/**
+ * Encoding used when writing reports to disk.
+ */
+typedef enum
+{
+    /** Pretty printed JSON text. */
+    CrasheeCrashReportFormatJSON,
+
+    /** Binary CBOR. Integers are written natively and data elements as raw
+     * bytes. The report store converts these reports back to JSON when they
+     * are read.
+     */
+    CrasheeCrashReportFormatCBOR,
+} CrasheeCrashReportFormat;
+
 /**
  * Encapsulates report writing functionality.
  */
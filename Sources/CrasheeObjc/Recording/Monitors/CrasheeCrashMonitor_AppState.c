@@ -204,9 +204,8 @@ static bool loadState(const char* const path)
     }
     close(fd);
 
-    char* data;
-    int length;
-    if(!crasheefu_readEntireFile(path, &data, &length, 50000))
+    CrasheeFileView file;
+    if(!crasheefu_mapFile(path, &file, 50000))
     {
         CrasheeLOG_ERROR("%s: Could not load file", path);
         return false;
@@ -220,20 +219,33 @@ static bool loadState(const char* const path)
     callbaccrashee.onEndData = onEndData;
     callbaccrashee.onFloatingPointElement = onFloatingPointElement;
     callbaccrashee.onIntegerElement = onIntegerElement;
+    callbaccrashee.onUnsignedIntegerElement = NULL;
     callbaccrashee.onNullElement = onNullElement;
     callbaccrashee.onStringElement = onStringElement;
 
+    const char* const paths[] =
+    {
+        kKeyFormatVersion,
+        kKeyCrashedLastLaunch,
+        kKeyActiveDurationSinceLastCrash,
+        kKeyBackgroundDurationSinceLastCrash,
+        kKeyLaunchesSinceLastCrash,
+        kKeySessionsSinceLastCrash,
+    };
+
     int errorOffset = 0;
 
     char stringBuffer[1000];
-    const int result = crasheejson_decode(data,
-                                     (int)length,
-                                     stringBuffer,
-                                     sizeof(stringBuffer),
-                                     &callbaccrashee,
-                                     &g_state,
-                                     &errorOffset);
-    free(data);
+    const int result = crasheejson_decodePaths(file.data,
+                                               file.length,
+                                               stringBuffer,
+                                               sizeof(stringBuffer),
+                                               paths,
+                                               sizeof(paths) / sizeof(*paths),
+                                               &callbaccrashee,
+                                               &g_state,
+                                               &errorOffset);
+    crasheefu_unmapFile(&file);
     if(result != CrasheeJSON_OK)
     {
         CrasheeLOG_ERROR("%s, offset %d: %s",
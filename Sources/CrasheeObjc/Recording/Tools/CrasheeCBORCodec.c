@@ -0,0 +1,1155 @@
+//
+//  CrasheeCBORCodec.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "CrasheeCBORCodec.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// ============================================================================
+#pragma mark - Configuration -
+// ============================================================================
+
+/** Set to 1 if you're also compiling CrasheeLogger and want to use it here */
+#ifndef CrasheeCBORCODEC_UseCrasheeLogger
+    #define CrasheeCBORCODEC_UseCrasheeLogger 1
+#endif
+
+#if CrasheeCBORCODEC_UseCrasheeLogger
+    #include "CrasheeLogger.h"
+#else
+    #define CrasheeLOG_DEBUG(FMT, ...)
+    #define CrasheeLOG_ERROR(FMT, ...)
+#endif
+
+/** The maximum container depth the converter will follow. */
+#ifndef CrasheeCBORCODEC_MaxDepth
+    #define CrasheeCBORCODEC_MaxDepth 100
+#endif
+
+/** The length of the (stack) buffer that the converter copies object keys
+ * into. Longer keys are copied to the heap.
+ */
+#ifndef CrasheeCBORCODEC_MaxKeyLength
+    #define CrasheeCBORCODEC_MaxKeyLength 256
+#endif
+
+
+// ============================================================================
+#pragma mark - Helpers -
+// ============================================================================
+
+// Compiler hints for "if" statements
+#define likely_if(x) if(__builtin_expect(x,1))
+#define unlikely_if(x) if(__builtin_expect(x,0))
+
+#define MAJOR_UINT     (0 << 5)
+#define MAJOR_NEGINT   (1 << 5)
+#define MAJOR_BYTES    (2 << 5)
+#define MAJOR_TEXT     (3 << 5)
+#define MAJOR_ARRAY    (4 << 5)
+#define MAJOR_MAP      (5 << 5)
+#define MAJOR_TAG      (6 << 5)
+#define MAJOR_SIMPLE   (7 << 5)
+
+#define INFO_INDEFINITE 31
+
+#define SIMPLE_FALSE   0xf4
+#define SIMPLE_TRUE    0xf5
+#define SIMPLE_NULL    0xf6
+#define SIMPLE_FLOAT32 0xfa
+#define SIMPLE_FLOAT64 0xfb
+#define BREAK          0xff
+
+#define TAG_ENCODED_CBOR  24
+#define TAG_SELF_DESCRIBE 55799
+
+/** Self-describe tag (55799), used as a magic number for CBOR reports. */
+static const unsigned char g_magic[CrasheeCBOR_MAGIC_LENGTH] = {0xd9, 0xd9, 0xf7};
+
+
+// ============================================================================
+#pragma mark - Encode -
+// ============================================================================
+
+#define addData(CONTEXT,DATA,LENGTH) \
+    (CONTEXT)->addData(DATA, LENGTH, (CONTEXT)->userData)
+
+static inline void storeBigEndian(unsigned char* dst, uint64_t value, int byteCount)
+{
+    for(int i = byteCount - 1; i >= 0; i--)
+    {
+        dst[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+/** Write a CBOR item head (major type + argument) using the shortest form.
+ *
+ * @param context The encoding context.
+ *
+ * @param major The major type (already shifted).
+ *
+ * @param value The argument.
+ *
+ * @return CrasheeJSON_OK if the data was handled successfully.
+ */
+static int addHead(CrasheeCBOREncodeContext* const context, const int major, const uint64_t value)
+{
+    unsigned char buffer[9];
+    int length;
+    likely_if(value < 24)
+    {
+        buffer[0] = (unsigned char)(major | (int)value);
+        length = 1;
+    }
+    else if(value <= 0xff)
+    {
+        buffer[0] = (unsigned char)(major | 24);
+        length = 2;
+    }
+    else if(value <= 0xffff)
+    {
+        buffer[0] = (unsigned char)(major | 25);
+        length = 3;
+    }
+    else if(value <= 0xffffffff)
+    {
+        buffer[0] = (unsigned char)(major | 26);
+        length = 5;
+    }
+    else
+    {
+        buffer[0] = (unsigned char)(major | 27);
+        length = 9;
+    }
+    storeBigEndian(buffer + 1, value, length - 1);
+    return addData(context, (const char*)buffer, length);
+}
+
+static inline int addByte(CrasheeCBOREncodeContext* const context, const int value)
+{
+    const char byte = (char)value;
+    return addData(context, &byte, 1);
+}
+
+static int addTextString(CrasheeCBOREncodeContext* const context, const char* const string, const int length)
+{
+    int result = addHead(context, MAJOR_TEXT, (uint64_t)length);
+    likely_if(result == CrasheeJSON_OK && length > 0)
+    {
+        result = addData(context, string, length);
+    }
+    return result;
+}
+
+/** Add the key for the next element if we're in an object. */
+static int beginElement(CrasheeCBOREncodeContext* const context, const char* const name)
+{
+    if(context->isObject[context->containerLevel])
+    {
+        unlikely_if(name == NULL)
+        {
+            CrasheeLOG_DEBUG("Name was null inside an object");
+            return CrasheeJSON_ERROR_INVALID_DATA;
+        }
+        return addTextString(context, name, (int)strlen(name));
+    }
+    return CrasheeJSON_OK;
+}
+
+int crasheecbor_beginEncode(CrasheeCBOREncodeContext* const context,
+                            CrasheeJSONAddDataFunc addDataFunc,
+                            void* const userData)
+{
+    memset(context, 0, sizeof(*context));
+    context->addData = addDataFunc;
+    context->userData = userData;
+    return addData(context, (const char*)g_magic, sizeof(g_magic));
+}
+
+int crasheecbor_endEncode(CrasheeCBOREncodeContext* const context)
+{
+    int result = CrasheeJSON_OK;
+    while(context->containerLevel > 0)
+    {
+        unlikely_if((result = crasheecbor_endContainer(context)) != CrasheeJSON_OK)
+        {
+            return result;
+        }
+    }
+    return result;
+}
+
+int crasheecbor_addBooleanElement(CrasheeCBOREncodeContext* const context,
+                                  const char* const name,
+                                  const bool value)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    return addByte(context, value ? SIMPLE_TRUE : SIMPLE_FALSE);
+}
+
+int crasheecbor_addIntegerElement(CrasheeCBOREncodeContext* const context,
+                                  const char* const name,
+                                  const int64_t value)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    if(value < 0)
+    {
+        return addHead(context, MAJOR_NEGINT, (uint64_t)(-1 - value));
+    }
+    return addHead(context, MAJOR_UINT, (uint64_t)value);
+}
+
+int crasheecbor_addUIntegerElement(CrasheeCBOREncodeContext* const context,
+                                   const char* const name,
+                                   const uint64_t value)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    return addHead(context, MAJOR_UINT, value);
+}
+
+int crasheecbor_addFloatingPointElement(CrasheeCBOREncodeContext* const context,
+                                        const char* const name,
+                                        const double value)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    unsigned char buffer[9];
+    const float floatValue = (float)value;
+    if((double)floatValue == value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &floatValue, sizeof(bits));
+        buffer[0] = SIMPLE_FLOAT32;
+        storeBigEndian(buffer + 1, bits, 4);
+        return addData(context, (const char*)buffer, 5);
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    buffer[0] = SIMPLE_FLOAT64;
+    storeBigEndian(buffer + 1, bits, 8);
+    return addData(context, (const char*)buffer, 9);
+}
+
+int crasheecbor_addNullElement(CrasheeCBOREncodeContext* const context,
+                               const char* const name)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    return addByte(context, SIMPLE_NULL);
+}
+
+int crasheecbor_addStringElement(CrasheeCBOREncodeContext* const context,
+                                 const char* const name,
+                                 const char* const value,
+                                 int length)
+{
+    unlikely_if(value == NULL)
+    {
+        return crasheecbor_addNullElement(context, name);
+    }
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    if(length == CrasheeCBOR_SIZE_AUTOMATIC)
+    {
+        length = (int)strlen(value);
+    }
+    return addTextString(context, value, length);
+}
+
+int crasheecbor_beginStringElement(CrasheeCBOREncodeContext* const context,
+                                   const char* const name)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    return addByte(context, MAJOR_TEXT | INFO_INDEFINITE);
+}
+
+int crasheecbor_appendStringElement(CrasheeCBOREncodeContext* const context,
+                                    const char* const value,
+                                    const int length)
+{
+    unlikely_if(length <= 0)
+    {
+        return CrasheeJSON_OK;
+    }
+    return addTextString(context, value, length);
+}
+
+int crasheecbor_endStringElement(CrasheeCBOREncodeContext* const context)
+{
+    return addByte(context, BREAK);
+}
+
+int crasheecbor_addDataElement(CrasheeCBOREncodeContext* const context,
+                               const char* const name,
+                               const char* const value,
+                               const int length)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    result = addHead(context, MAJOR_BYTES, (uint64_t)length);
+    likely_if(result == CrasheeJSON_OK && length > 0)
+    {
+        result = addData(context, value, length);
+    }
+    return result;
+}
+
+int crasheecbor_beginDataElement(CrasheeCBOREncodeContext* const context,
+                                 const char* const name)
+{
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    return addByte(context, MAJOR_BYTES | INFO_INDEFINITE);
+}
+
+int crasheecbor_appendDataElement(CrasheeCBOREncodeContext* const context,
+                                  const char* const value,
+                                  const int length)
+{
+    unlikely_if(length <= 0)
+    {
+        return CrasheeJSON_OK;
+    }
+    int result = addHead(context, MAJOR_BYTES, (uint64_t)length);
+    likely_if(result == CrasheeJSON_OK)
+    {
+        result = addData(context, value, length);
+    }
+    return result;
+}
+
+int crasheecbor_endDataElement(CrasheeCBOREncodeContext* const context)
+{
+    return addByte(context, BREAK);
+}
+
+static int beginContainer(CrasheeCBOREncodeContext* const context,
+                          const char* const name,
+                          const bool isObject)
+{
+    unlikely_if(context->containerLevel + 1 >= (int)(sizeof(context->isObject) / sizeof(*context->isObject)))
+    {
+        CrasheeLOG_DEBUG("Containers nested too deeply");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    int result = beginElement(context, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+
+    context->containerLevel++;
+    context->isObject[context->containerLevel] = isObject;
+
+    return addByte(context, (isObject ? MAJOR_MAP : MAJOR_ARRAY) | INFO_INDEFINITE);
+}
+
+int crasheecbor_beginObject(CrasheeCBOREncodeContext* const context,
+                            const char* const name)
+{
+    return beginContainer(context, name, true);
+}
+
+int crasheecbor_beginArray(CrasheeCBOREncodeContext* const context,
+                           const char* const name)
+{
+    return beginContainer(context, name, false);
+}
+
+int crasheecbor_endContainer(CrasheeCBOREncodeContext* const context)
+{
+    unlikely_if(context->containerLevel <= 0)
+    {
+        return CrasheeJSON_OK;
+    }
+    context->containerLevel--;
+    return addByte(context, BREAK);
+}
+
+int crasheecbor_addCBORFromFile(CrasheeCBOREncodeContext* const context,
+                                const char* const name,
+                                const char* const filename)
+{
+    const int fd = open(filename, O_RDONLY);
+    unlikely_if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open file %s: %s", filename, strerror(errno));
+        return crasheecbor_addNullElement(context, name);
+    }
+
+    int result = beginElement(context, name);
+    if(result == CrasheeJSON_OK)
+    {
+        result = addHead(context, MAJOR_TAG, TAG_ENCODED_CBOR);
+    }
+    if(result == CrasheeJSON_OK)
+    {
+        result = addByte(context, MAJOR_BYTES | INFO_INDEFINITE);
+        char buffer[1024];
+        int bytesRead;
+        while(result == CrasheeJSON_OK && (bytesRead = (int)read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            result = crasheecbor_appendDataElement(context, buffer, bytesRead);
+        }
+        // Always close the byte string, even if we failed to write its content.
+        int closeResult = addByte(context, BREAK);
+        if(result == CrasheeJSON_OK)
+        {
+            result = closeResult;
+        }
+    }
+    close(fd);
+    return result;
+}
+
+
+// ============================================================================
+#pragma mark - JSON to CBOR -
+// ============================================================================
+
+typedef struct
+{
+    CrasheeCBOREncodeContext* encodeContext;
+    /** Name to give the top element (the decoder always reports it as NULL). */
+    const char* topName;
+    bool isTopElement;
+    int baseLevel;
+    bool closeLastContainer;
+} JSONToCBORContext;
+
+static inline const char* elementName(JSONToCBORContext* const context, const char* const name)
+{
+    unlikely_if(context->isTopElement)
+    {
+        context->isTopElement = false;
+        return context->topName;
+    }
+    return name;
+}
+
+static int jsonToCBOR_onBooleanElement(const char* const name, const bool value, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_addBooleanElement(context->encodeContext, elementName(context, name), value);
+}
+
+static int jsonToCBOR_onFloatingPointElement(const char* const name, const double value, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_addFloatingPointElement(context->encodeContext, elementName(context, name), value);
+}
+
+static int jsonToCBOR_onIntegerElement(const char* const name, const int64_t value, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_addIntegerElement(context->encodeContext, elementName(context, name), value);
+}
+
+static int jsonToCBOR_onUnsignedIntegerElement(const char* const name, const uint64_t value, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_addUIntegerElement(context->encodeContext, elementName(context, name), value);
+}
+
+static int jsonToCBOR_onNullElement(const char* const name, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_addNullElement(context->encodeContext, elementName(context, name));
+}
+
+static int jsonToCBOR_onStringElement(const char* const name, const char* const value, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_addStringElement(context->encodeContext, elementName(context, name), value, CrasheeCBOR_SIZE_AUTOMATIC);
+}
+
+static int jsonToCBOR_onBeginObject(const char* const name, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_beginObject(context->encodeContext, elementName(context, name));
+}
+
+static int jsonToCBOR_onBeginArray(const char* const name, void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    return crasheecbor_beginArray(context->encodeContext, elementName(context, name));
+}
+
+static int jsonToCBOR_onEndContainer(void* const userData)
+{
+    JSONToCBORContext* context = userData;
+    if(context->closeLastContainer || context->encodeContext->containerLevel > context->baseLevel + 1)
+    {
+        return crasheecbor_endContainer(context->encodeContext);
+    }
+    return CrasheeJSON_OK;
+}
+
+static int jsonToCBOR_onEndData(__unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+int crasheecbor_addJSONElement(CrasheeCBOREncodeContext* const encodeContext,
+                               const char* const name,
+                               const char* const jsonData,
+                               const int jsonDataLength,
+                               const bool closeLastContainer)
+{
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee =
+    {
+        .onBeginArray = jsonToCBOR_onBeginArray,
+        .onBeginObject = jsonToCBOR_onBeginObject,
+        .onBooleanElement = jsonToCBOR_onBooleanElement,
+        .onEndContainer = jsonToCBOR_onEndContainer,
+        .onEndData = jsonToCBOR_onEndData,
+        .onFloatingPointElement = jsonToCBOR_onFloatingPointElement,
+        .onIntegerElement = jsonToCBOR_onIntegerElement,
+        .onUnsignedIntegerElement = jsonToCBOR_onUnsignedIntegerElement,
+        .onNullElement = jsonToCBOR_onNullElement,
+        .onStringElement = jsonToCBOR_onStringElement,
+    };
+    JSONToCBORContext context =
+    {
+        .encodeContext = encodeContext,
+        .topName = name,
+        .isTopElement = true,
+        .baseLevel = encodeContext->containerLevel,
+        .closeLastContainer = closeLastContainer,
+    };
+    char stringBuffer[5000];
+    int result = crasheejson_decode(jsonData,
+                                    jsonDataLength,
+                                    stringBuffer,
+                                    sizeof(stringBuffer),
+                                    &callbaccrashee,
+                                    &context,
+                                    NULL);
+    while(closeLastContainer && encodeContext->containerLevel > context.baseLevel)
+    {
+        crasheecbor_endContainer(encodeContext);
+    }
+    return result;
+}
+
+
+// ============================================================================
+#pragma mark - CBOR to JSON -
+// ============================================================================
+
+typedef struct
+{
+    const unsigned char* ptr;
+    const unsigned char* end;
+    CrasheeJSONEncodeContext* encodeContext;
+    int depth;
+} CBORDecodeContext;
+
+static int convertItem(CBORDecodeContext* context, const char* name);
+static int convertHead(CBORDecodeContext* context, const char* name, int major, int info, uint64_t value);
+static int skipItem(CBORDecodeContext* context, int depth);
+
+static inline uint64_t loadBigEndian(const unsigned char* src, int byteCount)
+{
+    uint64_t value = 0;
+    for(int i = 0; i < byteCount; i++)
+    {
+        value = (value << 8) | src[i];
+    }
+    return value;
+}
+
+/** Read an item head.
+ *
+ * @param context The decoding context.
+ *
+ * @param major Where to store the major type (shifted).
+ *
+ * @param info Where to store the additional information bits.
+ *
+ * @param value Where to store the argument (0 for indefinite lengths).
+ *
+ * @return CrasheeJSON_OK if successful.
+ */
+static int readHead(CBORDecodeContext* const context, int* const major, int* const info, uint64_t* const value)
+{
+    unlikely_if(context->ptr >= context->end)
+    {
+        return CrasheeJSON_ERROR_INCOMPLETE;
+    }
+    const int initial = *context->ptr++;
+    *major = initial & 0xe0;
+    *info = initial & 0x1f;
+    likely_if(*info < 24)
+    {
+        *value = (uint64_t)*info;
+        return CrasheeJSON_OK;
+    }
+    if(*info == INFO_INDEFINITE)
+    {
+        *value = 0;
+        return CrasheeJSON_OK;
+    }
+    unlikely_if(*info > 27)
+    {
+        CrasheeLOG_DEBUG("Invalid additional info %d", *info);
+        return CrasheeJSON_ERROR_INVALID_CHARACTER;
+    }
+    const int byteCount = 1 << (*info - 24);
+    unlikely_if(context->end - context->ptr < byteCount)
+    {
+        return CrasheeJSON_ERROR_INCOMPLETE;
+    }
+    *value = loadBigEndian(context->ptr, byteCount);
+    context->ptr += byteCount;
+    return CrasheeJSON_OK;
+}
+
+static inline bool isBreak(CBORDecodeContext* const context)
+{
+    likely_if(context->ptr < context->end && *context->ptr == BREAK)
+    {
+        context->ptr++;
+        return true;
+    }
+    return false;
+}
+
+static double halfToDouble(const unsigned int half)
+{
+    const int exponent = (half >> 10) & 0x1f;
+    const double mantissa = half & 0x3ff;
+    double value;
+    if(exponent == 0)
+    {
+        value = mantissa / (1 << 24);
+    }
+    else if(exponent != 31)
+    {
+        value = (mantissa + 1024) * (double)(1 << exponent) / (double)(1 << 25);
+    }
+    else
+    {
+        value = mantissa == 0 ? __builtin_inf() : __builtin_nan("");
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/* Elements that can't be converted, such as containers nested too deeply or
+ * map keys that aren't text, are skipped or replaced with null, so that one
+ * bad element doesn't cost the rest of the report. Only data that is cut
+ * short, or too damaged to find the next element in, stops the conversion.
+ */
+
+/** Skip the rest of an item whose head has already been read.
+ *
+ * @param depth How many containers deep the skipping has gone.
+ *
+ * @return CrasheeJSON_OK if the end of the item was found.
+ */
+static int skipItemBody(CBORDecodeContext* const context,
+                        const int major,
+                        const int info,
+                        const uint64_t value,
+                        const int depth)
+{
+    unlikely_if(depth >= CrasheeCBORCODEC_MaxDepth)
+    {
+        CrasheeLOG_DEBUG("Containers nested too deeply to skip");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    const bool isIndefinite = info == INFO_INDEFINITE;
+    int result = CrasheeJSON_OK;
+    switch(major)
+    {
+        case MAJOR_BYTES:
+        case MAJOR_TEXT:
+            if(!isIndefinite)
+            {
+                unlikely_if(value > (uint64_t)(context->end - context->ptr))
+                {
+                    return CrasheeJSON_ERROR_INCOMPLETE;
+                }
+                context->ptr += value;
+                return CrasheeJSON_OK;
+            }
+            // Chunks are skipped whatever their type, as they're skipped anyway.
+            while(result == CrasheeJSON_OK && !isBreak(context))
+            {
+                result = skipItem(context, depth + 1);
+            }
+            return result;
+        case MAJOR_ARRAY:
+        case MAJOR_MAP:
+        {
+            const uint64_t itemsPerEntry = major == MAJOR_MAP ? 2 : 1;
+            for(uint64_t count = value; result == CrasheeJSON_OK && (isIndefinite || count > 0); count--)
+            {
+                if(isIndefinite && isBreak(context))
+                {
+                    break;
+                }
+                for(uint64_t i = 0; result == CrasheeJSON_OK && i < itemsPerEntry; i++)
+                {
+                    result = skipItem(context, depth + 1);
+                }
+            }
+            return result;
+        }
+        case MAJOR_TAG:
+            return skipItem(context, depth + 1);
+        default:
+            // Integers and simple values are all head.
+            return CrasheeJSON_OK;
+    }
+}
+
+/** Skip over an item.
+ *
+ * @param depth How many containers deep the skipping has gone.
+ *
+ * @return CrasheeJSON_OK if the end of the item was found.
+ */
+static int skipItem(CBORDecodeContext* const context, const int depth)
+{
+    int major;
+    int info;
+    uint64_t value;
+    int result = readHead(context, &major, &info, &value);
+    unlikely_if(result == CrasheeJSON_ERROR_INVALID_CHARACTER)
+    {
+        // A reserved head is a single byte.
+        return CrasheeJSON_OK;
+    }
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    return skipItemBody(context, major, info, value, depth);
+}
+
+/** Convert a text or byte string, either definite or indefinite length. */
+static int convertString(CBORDecodeContext* const context,
+                         const char* const name,
+                         const int major,
+                         const int info,
+                         const uint64_t length)
+{
+    CrasheeJSONEncodeContext* const json = context->encodeContext;
+    const bool isText = major == MAJOR_TEXT;
+    if(info != INFO_INDEFINITE)
+    {
+        unlikely_if(length > (uint64_t)(context->end - context->ptr))
+        {
+            return CrasheeJSON_ERROR_INCOMPLETE;
+        }
+        const char* const value = (const char*)context->ptr;
+        context->ptr += length;
+        return isText ? crasheejson_addStringElement(json, name, value, (int)length)
+                      : crasheejson_addDataElement(json, name, value, (int)length);
+    }
+
+    int result = isText ? crasheejson_beginStringElement(json, name) : crasheejson_beginDataElement(json, name);
+    while(result == CrasheeJSON_OK && !isBreak(context))
+    {
+        int chunkMajor;
+        int chunkInfo;
+        uint64_t chunkLength;
+        unlikely_if((result = readHead(context, &chunkMajor, &chunkInfo, &chunkLength)) != CrasheeJSON_OK)
+        {
+            break;
+        }
+        unlikely_if(chunkMajor != major || chunkInfo == INFO_INDEFINITE)
+        {
+            CrasheeLOG_DEBUG("Skipping invalid chunk in indefinite length string");
+            result = skipItemBody(context, chunkMajor, chunkInfo, chunkLength, 0);
+            continue;
+        }
+        unlikely_if(chunkLength > (uint64_t)(context->end - context->ptr))
+        {
+            result = CrasheeJSON_ERROR_INCOMPLETE;
+            break;
+        }
+        const char* const chunk = (const char*)context->ptr;
+        context->ptr += chunkLength;
+        result = isText ? crasheejson_appendStringElement(json, chunk, (int)chunkLength)
+                        : crasheejson_appendDataElement(json, chunk, (int)chunkLength);
+    }
+    // Always close the string so the output stays well formed.
+    int closeResult = isText ? crasheejson_endStringElement(json) : crasheejson_endDataElement(json);
+    return result != CrasheeJSON_OK ? result : closeResult;
+}
+
+/** Convert an embedded encoded data item (tag 24). */
+static int convertEmbedded(CBORDecodeContext* const context, const char* const name)
+{
+    int major;
+    int info;
+    uint64_t length;
+    int result = readHead(context, &major, &info, &length);
+    unlikely_if(result == CrasheeJSON_ERROR_INVALID_CHARACTER)
+    {
+        return crasheejson_addNullElement(context->encodeContext, name);
+    }
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    unlikely_if(major != MAJOR_BYTES)
+    {
+        CrasheeLOG_DEBUG("Expected a byte string after tag 24");
+        // Treat it like any other tag.
+        return convertHead(context, name, major, info, length);
+    }
+
+    // Gather the (possibly chunked) contents into one contiguous buffer.
+    const unsigned char* data = context->ptr;
+    unsigned char* gathered = NULL;
+    if(info != INFO_INDEFINITE)
+    {
+        unlikely_if(length > (uint64_t)(context->end - context->ptr))
+        {
+            return CrasheeJSON_ERROR_INCOMPLETE;
+        }
+        context->ptr += length;
+    }
+    else
+    {
+        gathered = malloc((size_t)(context->end - context->ptr));
+        unlikely_if(gathered == NULL)
+        {
+            return CrasheeJSON_ERROR_CANNOT_ADD_DATA;
+        }
+        length = 0;
+        while(!isBreak(context))
+        {
+            int chunkMajor;
+            int chunkInfo;
+            uint64_t chunkLength;
+            result = readHead(context, &chunkMajor, &chunkInfo, &chunkLength);
+            unlikely_if(result == CrasheeJSON_OK && (chunkMajor != MAJOR_BYTES || chunkInfo == INFO_INDEFINITE))
+            {
+                CrasheeLOG_DEBUG("Skipping invalid chunk in embedded data");
+                result = skipItemBody(context, chunkMajor, chunkInfo, chunkLength, 0);
+                chunkLength = 0;
+            }
+            else unlikely_if(result == CrasheeJSON_ERROR_INVALID_CHARACTER)
+            {
+                // A reserved head is a single byte.
+                result = CrasheeJSON_OK;
+                chunkLength = 0;
+            }
+            unlikely_if(result != CrasheeJSON_OK || chunkLength > (uint64_t)(context->end - context->ptr))
+            {
+                free(gathered);
+                return result != CrasheeJSON_OK ? result : CrasheeJSON_ERROR_INCOMPLETE;
+            }
+            memcpy(gathered + length, context->ptr, (size_t)chunkLength);
+            context->ptr += chunkLength;
+            length += chunkLength;
+        }
+        data = gathered;
+    }
+
+    CrasheeJSONEncodeContext* const json = context->encodeContext;
+    if(crasheecbor_isCBOR((const char*)data, (int)length))
+    {
+        CBORDecodeContext embedded =
+        {
+            .ptr = data,
+            .end = data + length,
+            .encodeContext = json,
+            .depth = context->depth,
+        };
+        const int containerLevel = json->containerLevel;
+        result = convertItem(&embedded, name);
+        // An embedded report may have been cut short by a crash.
+        if(result == CrasheeJSON_ERROR_INCOMPLETE)
+        {
+            while(json->containerLevel > containerLevel)
+            {
+                crasheejson_endContainer(json);
+            }
+            result = CrasheeJSON_OK;
+        }
+    }
+    else if(length > 0 && (data[0] == '{' || data[0] == '['))
+    {
+        // Written by an earlier launch that was configured for JSON.
+        result = crasheejson_addJSONElement(json, name, (const char*)data, (int)length, true);
+    }
+    else
+    {
+        result = crasheejson_addDataElement(json, name, (const char*)data, (int)length);
+    }
+    free(gathered);
+    return result;
+}
+
+static int convertContainer(CBORDecodeContext* const context,
+                            const char* const name,
+                            const bool isObject,
+                            const int info,
+                            uint64_t count)
+{
+    CrasheeJSONEncodeContext* const json = context->encodeContext;
+    unlikely_if(context->depth >= CrasheeCBORCODEC_MaxDepth)
+    {
+        CrasheeLOG_DEBUG("Containers nested too deeply. Replacing with null");
+        const int result = skipItemBody(context, isObject ? MAJOR_MAP : MAJOR_ARRAY, info, count, 0);
+        unlikely_if(result != CrasheeJSON_OK)
+        {
+            return result;
+        }
+        return crasheejson_addNullElement(json, name);
+    }
+    int result = isObject ? crasheejson_beginObject(json, name) : crasheejson_beginArray(json, name);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    context->depth++;
+
+    const bool isIndefinite = info == INFO_INDEFINITE;
+    char keyBuffer[CrasheeCBORCODEC_MaxKeyLength];
+    for(; isIndefinite || count > 0; count--)
+    {
+        if(isIndefinite && isBreak(context))
+        {
+            break;
+        }
+        if(!isObject)
+        {
+            unlikely_if((result = convertItem(context, NULL)) != CrasheeJSON_OK)
+            {
+                return result;
+            }
+            continue;
+        }
+
+        int keyMajor;
+        int keyInfo;
+        uint64_t keyLength;
+        result = readHead(context, &keyMajor, &keyInfo, &keyLength);
+        unlikely_if(result != CrasheeJSON_OK && result != CrasheeJSON_ERROR_INVALID_CHARACTER)
+        {
+            return result;
+        }
+        unlikely_if(result != CrasheeJSON_OK || keyMajor != MAJOR_TEXT || keyInfo == INFO_INDEFINITE)
+        {
+            CrasheeLOG_DEBUG("Skipping an entry whose key isn't definite length text");
+            unlikely_if(result == CrasheeJSON_OK &&
+                        (result = skipItemBody(context, keyMajor, keyInfo, keyLength, 0)) != CrasheeJSON_OK)
+            {
+                return result;
+            }
+            unlikely_if((result = skipItem(context, 0)) != CrasheeJSON_OK)
+            {
+                return result;
+            }
+            continue;
+        }
+        unlikely_if(keyLength > (uint64_t)(context->end - context->ptr))
+        {
+            return CrasheeJSON_ERROR_INCOMPLETE;
+        }
+        char* key = keyBuffer;
+        unlikely_if(keyLength >= sizeof(keyBuffer) && (key = malloc((size_t)keyLength + 1)) == NULL)
+        {
+            return CrasheeJSON_ERROR_CANNOT_ADD_DATA;
+        }
+        memcpy(key, context->ptr, (size_t)keyLength);
+        key[keyLength] = '\0';
+        context->ptr += keyLength;
+        result = convertItem(context, key);
+        if(key != keyBuffer)
+        {
+            free(key);
+        }
+        unlikely_if(result != CrasheeJSON_OK)
+        {
+            return result;
+        }
+    }
+
+    context->depth--;
+    return crasheejson_endContainer(json);
+}
+
+static int convertItem(CBORDecodeContext* const context, const char* const name)
+{
+    int major;
+    int info;
+    uint64_t value;
+    int result = readHead(context, &major, &info, &value);
+    unlikely_if(result == CrasheeJSON_ERROR_INVALID_CHARACTER)
+    {
+        // A reserved head is a single byte, so the next item can still be found.
+        return crasheejson_addNullElement(context->encodeContext, name);
+    }
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        return result;
+    }
+    return convertHead(context, name, major, info, value);
+}
+
+/** Convert an item whose head has already been read. */
+static int convertHead(CBORDecodeContext* const context,
+                       const char* const name,
+                       const int major,
+                       const int info,
+                       const uint64_t value)
+{
+    CrasheeJSONEncodeContext* const json = context->encodeContext;
+    switch(major)
+    {
+        case MAJOR_UINT:
+            return crasheejson_addUIntegerElement(json, name, value);
+        case MAJOR_NEGINT:
+            unlikely_if(value > INT64_MAX)
+            {
+                return crasheejson_addFloatingPointElement(json, name, -1.0 - (double)value);
+            }
+            return crasheejson_addIntegerElement(json, name, -1 - (int64_t)value);
+        case MAJOR_BYTES:
+        case MAJOR_TEXT:
+            return convertString(context, name, major, info, value);
+        case MAJOR_ARRAY:
+            return convertContainer(context, name, false, info, value);
+        case MAJOR_MAP:
+            return convertContainer(context, name, true, info, value);
+        case MAJOR_TAG:
+            if(value == TAG_ENCODED_CBOR)
+            {
+                return convertEmbedded(context, name);
+            }
+            // Other tags (including self-describe) don't change the JSON representation.
+            return convertItem(context, name);
+        default:
+            break;
+    }
+
+    switch(info)
+    {
+        case SIMPLE_FALSE & 0x1f:
+            return crasheejson_addBooleanElement(json, name, false);
+        case SIMPLE_TRUE & 0x1f:
+            return crasheejson_addBooleanElement(json, name, true);
+        case 25:
+            return crasheejson_addFloatingPointElement(json, name, halfToDouble((unsigned int)value));
+        case 26:
+        {
+            const uint32_t bits = (uint32_t)value;
+            float floatValue;
+            memcpy(&floatValue, &bits, sizeof(floatValue));
+            return crasheejson_addFloatingPointElement(json, name, floatValue);
+        }
+        case 27:
+        {
+            double doubleValue;
+            memcpy(&doubleValue, &value, sizeof(doubleValue));
+            return crasheejson_addFloatingPointElement(json, name, doubleValue);
+        }
+        case INFO_INDEFINITE:
+            CrasheeLOG_DEBUG("Unexpected break. Replacing with null");
+            return crasheejson_addNullElement(json, name);
+        default:
+            // null, undefined, and unassigned simple values.
+            return crasheejson_addNullElement(json, name);
+    }
+}
+
+bool crasheecbor_isCBOR(const char* const data, const int length)
+{
+    return data != NULL && length >= CrasheeCBOR_MAGIC_LENGTH && memcmp(data, g_magic, sizeof(g_magic)) == 0;
+}
+
+int crasheecbor_convertToJSON(const char* const data,
+                              const int length,
+                              CrasheeJSONEncodeContext* const encodeContext,
+                              int* const errorOffset)
+{
+    CBORDecodeContext context =
+    {
+        .ptr = (const unsigned char*)data,
+        .end = (const unsigned char*)data + length,
+        .encodeContext = encodeContext,
+        .depth = 0,
+    };
+    const int containerLevel = encodeContext->containerLevel;
+
+    int result = convertItem(&context, NULL);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        while(encodeContext->containerLevel > containerLevel)
+        {
+            crasheejson_endContainer(encodeContext);
+        }
+        if(errorOffset != NULL)
+        {
+            *errorOffset = (int)((const char*)context.ptr - data);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,380 @@
+//
+//  CrasheeCBORCodec.h
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+/* Writes report data as CBOR (RFC 7049), and converts it back to JSON.
+ *
+ * The encoder mirrors the JSON encoder API so that either one can sit behind
+ * a CrasheeCrashReportWriter. Containers and incrementally-built strings are
+ * written with indefinite lengths so nothing needs to be known in advance.
+ * Integers are written natively and data elements as raw byte strings.
+ */
+
+
+#ifndef HDR_CrasheeCBORCodec_h
+#define HDR_CrasheeCBORCodec_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "CrasheeJSONCodec.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Tells the encoder to automatically determine the length of a field value.
+ * Currently, this is done using strlen().
+ */
+#define CrasheeCBOR_SIZE_AUTOMATIC CrasheeJSON_SIZE_AUTOMATIC
+
+/** Length of the self-describe tag written at the start of every encoding. */
+#define CrasheeCBOR_MAGIC_LENGTH 3
+
+// ============================================================================
+// Encode
+// ============================================================================
+
+/** Encoder context. All functions return CrasheeJSON_* result codes, and data
+ * is handed to a CrasheeJSONAddDataFunc so that the same sinks can be used for
+ * both encodings.
+ */
+typedef struct
+{
+    /** Function to call to add more encoded data. */
+    CrasheeJSONAddDataFunc addData;
+
+    /** User-specified data */
+    void* userData;
+
+    /** How many containers deep we are. */
+    int containerLevel;
+
+    /** Whether or not the current container is an object. */
+    bool isObject[200];
+
+} CrasheeCBOREncodeContext;
+
+
+/** Begin a new encoding process.
+ *
+ * @param context The encoding context.
+ *
+ * @param addData Function to handle adding data.
+ *
+ * @param userData User-specified data which gets passed to addData.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_beginEncode(CrasheeCBOREncodeContext* context,
+                            CrasheeJSONAddDataFunc addData,
+                            void* userData);
+
+/** End the encoding process, ending any remaining open containers.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_endEncode(CrasheeCBOREncodeContext* context);
+
+/** Add a boolean element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param value The element's value.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addBooleanElement(CrasheeCBOREncodeContext* context,
+                                  const char* name,
+                                  bool value);
+
+/** Add an integer element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param value The element's value.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addIntegerElement(CrasheeCBOREncodeContext* context,
+                                  const char* name,
+                                  int64_t value);
+
+/** Add an unsigned integer element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param value The element's value.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addUIntegerElement(CrasheeCBOREncodeContext* context,
+                                   const char* name,
+                                   uint64_t value);
+
+/** Add a floating point element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param value The element's value.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addFloatingPointElement(CrasheeCBOREncodeContext* context,
+                                        const char* name,
+                                        double value);
+
+/** Add a null element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addNullElement(CrasheeCBOREncodeContext* context,
+                               const char* name);
+
+/** Add a string element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param value The element's value.
+ *
+ * @param length the length of the string, or CrasheeCBOR_SIZE_AUTOMATIC.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addStringElement(CrasheeCBOREncodeContext* context,
+                                 const char* name,
+                                 const char* value,
+                                 int length);
+
+/** Start an incrementally-built string element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_beginStringElement(CrasheeCBOREncodeContext* context,
+                                   const char* name);
+
+/** Add a string fragment to an incrementally-built string element.
+ *
+ * @param context The encoding context.
+ *
+ * @param value The string fragment.
+ *
+ * @param length the length of the string fragment.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_appendStringElement(CrasheeCBOREncodeContext* context,
+                                    const char* value,
+                                    int length);
+
+/** End an incrementally-built string element.
+ *
+ * @param context The encoding context.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_endStringElement(CrasheeCBOREncodeContext* context);
+
+/** Add a raw byte string element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param value The element's value.
+ *
+ * @param length The length of the data.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addDataElement(CrasheeCBOREncodeContext* context,
+                               const char* name,
+                               const char* value,
+                               int length);
+
+/** Start an incrementally-built byte string element.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_beginDataElement(CrasheeCBOREncodeContext* context,
+                                 const char* name);
+
+/** Add a data fragment to an incrementally-built byte string element.
+ *
+ * @param context The encoding context.
+ *
+ * @param value The data fragment.
+ *
+ * @param length the length of the data fragment.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_appendDataElement(CrasheeCBOREncodeContext* context,
+                                  const char* value,
+                                  int length);
+
+/** End an incrementally-built byte string element.
+ *
+ * @param context The encoding context.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_endDataElement(CrasheeCBOREncodeContext* context);
+
+/** Decode a JSON element and add it as CBOR.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param jsonData The element's value. MUST BE VALID JSON!
+ *
+ * @param jsonDataLength The length of the element.
+ *
+ * @param closeLastContainer If false, do not close the last container.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addJSONElement(CrasheeCBOREncodeContext* context,
+                               const char* name,
+                               const char* jsonData,
+                               int jsonDataLength,
+                               bool closeLastContainer);
+
+/** Embed the contents of a previously written CBOR file as an encoded data
+ * item (tag 24). The file is copied as-is and not validated, so a report that
+ * was truncated by a crash can still be embedded.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The element's name.
+ *
+ * @param filename The file to read from.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_addCBORFromFile(CrasheeCBOREncodeContext* context,
+                                const char* name,
+                                const char* filename);
+
+/** Begin a new object container.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The object's name.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_beginObject(CrasheeCBOREncodeContext* context,
+                            const char* name);
+
+/** Begin a new array container.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The array's name.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_beginArray(CrasheeCBOREncodeContext* context,
+                           const char* name);
+
+/** End the current container and return to the next higher level.
+ *
+ * @param context The encoding context.
+ *
+ * @return CrasheeJSON_OK if the process was successful.
+ */
+int crasheecbor_endContainer(CrasheeCBOREncodeContext* context);
+
+
+// ============================================================================
+// Convert
+// ============================================================================
+
+/** Check if a buffer starts with the CBOR self-describe tag written by
+ * crasheecbor_beginEncode().
+ *
+ * @param data The data to check.
+ *
+ * @param length The length of the data.
+ *
+ * @return true if the data is CBOR encoded.
+ */
+bool crasheecbor_isCBOR(const char* data, int length);
+
+/** Convert CBOR encoded data to JSON.
+ *
+ * Truncated containers (for example from a report that was interrupted by a
+ * crash) are closed, so the JSON output is always well formed. Elements that
+ * can't be converted, such as map entries with keys that aren't text, are
+ * skipped or replaced with null rather than failing the conversion.
+ *
+ * @param data The CBOR encoded data.
+ *
+ * @param length The length of the data.
+ *
+ * @param context The JSON encoding context to write to. Must already have
+ *                been started with crasheejson_beginEncode().
+ *
+ * @param errorOffset If not null, will contain the offset into the data
+ *                    where the error (if any) occurred.
+ *
+ * @return CrasheeJSON_OK if succesful. An error code otherwise.
+ */
+int crasheecbor_convertToJSON(const char* data,
+                              int length,
+                              CrasheeJSONEncodeContext* context,
+                              int* errorOffset);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeCBORCodec_h
@@ -0,0 +1,60 @@
+//
+//  CrasheeCRC32.h
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/* CRC-32 (IEEE 802.3, as used by zlib and PNG), for noticing damaged data on
+ * disk. Table driven, with no state, so it is safe to call from anywhere.
+ */
+
+
+#ifndef HDR_CrasheeCRC32_h
+#define HDR_CrasheeCRC32_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/** Add data to a running CRC.
+ *
+ * @param crc The CRC so far, or 0 to start a new one.
+ *
+ * @param data The data to add.
+ *
+ * @param length The length of the data.
+ *
+ * @return The CRC of everything added so far.
+ */
+uint32_t crasheecrc_update(uint32_t crc, const void* data, size_t length);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeCRC32_h
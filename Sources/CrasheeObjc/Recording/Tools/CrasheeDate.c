@@ -23,20 +23,20 @@
 //
 
 #include "CrasheeDate.h"
-#include <stdio.h>
+#include "CrasheeFormat.h"
 #include <time.h>
 
 void crasheedate_utcStringFromTimestamp(time_t timestamp, char* buffer21Chars)
 {
     struct tm result = {0};
     gmtime_r(&timestamp, &result);
-    snprintf(buffer21Chars, 21, "%04d-%02d-%02dT%02d:%02d:%02dZ",
-             result.tm_year + 1900,
-             result.tm_mon+1,
-             result.tm_mday,
-             result.tm_hour,
-             result.tm_min,
-             result.tm_sec);
+    crasheefmt_format(buffer21Chars, 21, "%04d-%02d-%02dT%02d:%02d:%02dZ",
+                      result.tm_year + 1900,
+                      result.tm_mon+1,
+                      result.tm_mday,
+                      result.tm_hour,
+                      result.tm_min,
+                      result.tm_sec);
 }
 
 void crasheedate_utcStringFromMicroseconds(int64_t microseconds, char* buffer28Chars)
@@ -46,12 +46,12 @@ void crasheedate_utcStringFromMicroseconds(int64_t microseconds, char* buffer28C
     long micros = (long)(microseconds % 1000000);
 
     gmtime_r(&curtime, &result);
-    snprintf(buffer28Chars, 28, "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
-             result.tm_year + 1900,
-             result.tm_mon + 1,
-             result.tm_mday,
-             result.tm_hour,
-             result.tm_min,
-             result.tm_sec,
-             micros);
+    crasheefmt_format(buffer28Chars, 28, "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
+                      result.tm_year + 1900,
+                      result.tm_mon + 1,
+                      result.tm_mday,
+                      result.tm_hour,
+                      result.tm_min,
+                      result.tm_sec,
+                      micros);
 }
@@ -26,6 +26,8 @@
 
 
 #include "CrasheeFileUtils.h"
+#include "CrasheeFormat.h"
+#include "../CrasheeSystemCapabilities.h"
 
 //#define CrasheeLogger_LocalLevel TRACE
 #include "CrasheeLogger.h"
@@ -33,10 +35,13 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 
@@ -202,6 +207,32 @@ static bool deletePathContents(const char* path, bool deleteTopLevelPathAlso)
     return true;
 }
 
+static bool writeVectorsToFD(const int fd, struct iovec* vectors, int count)
+{
+    while(count > 0)
+    {
+        ssize_t bytesWritten = writev(fd, vectors, count);
+        if(bytesWritten == -1)
+        {
+            CrasheeLOG_ERROR("Could not write to fd %d: %s", fd, strerror(errno));
+            return false;
+        }
+        // Skip everything that was written, then trim any partially written vector.
+        while(count > 0 && (size_t)bytesWritten >= vectors->iov_len)
+        {
+            bytesWritten -= (ssize_t)vectors->iov_len;
+            vectors++;
+            count--;
+        }
+        if(count > 0)
+        {
+            vectors->iov_base = (char*)vectors->iov_base + bytesWritten;
+            vectors->iov_len -= (size_t)bytesWritten;
+        }
+    }
+    return true;
+}
+
 // ============================================================================
 #pragma mark - API -
 // ============================================================================
@@ -245,6 +276,11 @@ bool crasheefu_readBytesFromFD(const int fd, char* const bytes, int length)
             CrasheeLOG_ERROR("Could not write to fd %d: %s", fd, strerror(errno));
             return false;
         }
+        if(bytesRead == 0)
+        {
+            // End of file.
+            return false;
+        }
         length -= bytesRead;
         pos += bytesRead;
     }
@@ -322,6 +358,139 @@ done:
     return isSuccessful;
 }
 
+bool crasheefu_mapFile(const char* const path, CrasheeFileView* const view, const int maxLength)
+{
+    memset(view, 0, sizeof(*view));
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        CrasheeLOG_ERROR("Could not open %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0)
+    {
+        CrasheeLOG_ERROR("Could not stat %s: %s", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+    if(st.st_size > INT32_MAX)
+    {
+        CrasheeLOG_ERROR("%s is too large (%lld bytes)", path, (long long)st.st_size);
+        close(fd);
+        return false;
+    }
+    const int fileLength = (int)st.st_size;
+    if(fileLength == 0)
+    {
+        // Empty files can't be mapped.
+        close(fd);
+        view->data = "";
+        return true;
+    }
+
+    void* memory = mmap(NULL, (size_t)fileLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(memory == MAP_FAILED)
+    {
+        CrasheeLOG_ERROR("Could not map %s: %s", path, strerror(errno));
+        return false;
+    }
+    // Everything that maps a file reads it from start to end.
+    madvise(memory, (size_t)fileLength, MADV_SEQUENTIAL);
+
+    int offset = 0;
+    if(maxLength > 0 && maxLength < fileLength)
+    {
+        offset = fileLength - maxLength;
+    }
+    view->data = (const char*)memory + offset;
+    view->length = fileLength - offset;
+    view->memory = memory;
+    view->memoryLength = (size_t)fileLength;
+    view->isMapped = true;
+    return true;
+}
+
+void crasheefu_viewBuffer(CrasheeFileView* const view, char* const buffer, const int length)
+{
+    view->data = buffer;
+    view->length = length;
+    view->memory = buffer;
+    view->memoryLength = (size_t)length;
+    view->isMapped = false;
+}
+
+bool crasheefu_syncFD(const int fd)
+{
+#if CrasheeCRASH_HOST_APPLE
+    // fsync() only gets as far as the drive's cache here.
+    if(fcntl(fd, F_FULLFSYNC) == 0)
+    {
+        return true;
+    }
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+bool crasheefu_preallocateFile(const int fd, const int64_t length)
+{
+#if CrasheeCRASH_HOST_APPLE
+    fstore_t store =
+    {
+        .fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL,
+        .fst_posmode = F_PEOFPOSMODE,
+        .fst_offset = 0,
+        .fst_length = (off_t)length,
+    };
+    if(fcntl(fd, F_PREALLOCATE, &store) < 0)
+    {
+        // Settle for space that isn't contiguous.
+        store.fst_flags = F_ALLOCATEALL;
+        if(fcntl(fd, F_PREALLOCATE, &store) < 0)
+        {
+            CrasheeLOG_ERROR("Could not preallocate %lld bytes: %s", (long long)length, strerror(errno));
+            return false;
+        }
+    }
+    return true;
+#elif defined(FALLOC_FL_KEEP_SIZE)
+    if(fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)length) < 0)
+    {
+        CrasheeLOG_ERROR("Could not preallocate %lld bytes: %s", (long long)length, strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void crasheefu_prefetchView(const CrasheeFileView* const view)
+{
+    if(view->isMapped)
+    {
+        madvise(view->memory, view->memoryLength, MADV_WILLNEED);
+    }
+}
+
+void crasheefu_unmapFile(CrasheeFileView* const view)
+{
+    if(view->isMapped)
+    {
+        munmap(view->memory, view->memoryLength);
+    }
+    else
+    {
+        free(view->memory);
+    }
+    memset(view, 0, sizeof(*view));
+}
+
 bool crasheefu_writeStringToFD(const int fd, const char* const string)
 {
     if(*string != 0)
@@ -365,7 +534,7 @@ bool crasheefu_writeFmtArgsToFD(const int fd,
     if(*fmt != 0)
     {
         char buffer[CrasheeFU_WriteFmtBufferSize];
-        vsnprintf(buffer, sizeof(buffer), fmt, args);
+        crasheefmt_vformat(buffer, sizeof(buffer), fmt, args);
         return crasheefu_writeStringToFD(fd, buffer);
     }
     return false;
@@ -449,12 +618,41 @@ bool crasheefu_deleteContentsOfPath(const char* path)
     return deletePathContents(path, false);
 }
 
-bool crasheefu_openBufferedWriter(CrasheeBufferedWriter* writer, const char* const path, char* writeBuffer, int writeBufferLength)
+/** Open a report slot that may already have been moved to the path, or
+ * create the file if it wasn't. The slot is written from the start.
+ */
+static int openReportSlot(const char* const path)
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if(fd < 0)
+    {
+        return -1;
+    }
+    // A slot is empty, with its space reserved past its end. Truncating would
+    // give that space back, so only do it if there is anything to get rid of.
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (st.st_size != 0 && ftruncate(fd, 0) != 0))
+    {
+        const int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+static bool openBufferedWriter(CrasheeBufferedWriter* const writer,
+                               const char* const path,
+                               char* const writeBuffer,
+                               const int writeBufferLength,
+                               const bool isReportSlot)
 {
     writer->buffer = writeBuffer;
     writer->bufferLength = writeBufferLength;
     writer->position = 0;
-    writer->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    writer->compressor = NULL;
+    writer->vectored = false;
+    writer->fd = isReportSlot ? openReportSlot(path) : open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
     if(writer->fd < 0)
     {
         CrasheeLOG_ERROR("Could not open crash report file %s: %s", path, strerror(errno));
@@ -463,6 +661,41 @@ bool crasheefu_openBufferedWriter(CrasheeBufferedWriter* writer, const char* con
     return true;
 }
 
+bool crasheefu_openBufferedWriter(CrasheeBufferedWriter* writer, const char* const path, char* writeBuffer, int writeBufferLength)
+{
+    return openBufferedWriter(writer, path, writeBuffer, writeBufferLength, false);
+}
+
+bool crasheefu_openCompressedBufferedWriter(CrasheeBufferedWriter* writer,
+                                            const char* const path,
+                                            CrasheeLZWorkspace* workspace,
+                                            bool isReportSlot)
+{
+    if(!openBufferedWriter(writer, path, workspace->inputBuffer, sizeof(workspace->inputBuffer), isReportSlot))
+    {
+        return false;
+    }
+    writer->compressor = workspace;
+
+    char magic[CrasheeLZ_MAGIC_LENGTH];
+    crasheelz_writeMagic(magic);
+    return crasheefu_writeBytesToFD(writer->fd, magic, sizeof(magic));
+}
+
+bool crasheefu_openVectoredBufferedWriter(CrasheeBufferedWriter* writer,
+                                          const char* const path,
+                                          char* writeBuffer,
+                                          int writeBufferLength,
+                                          bool isReportSlot)
+{
+    if(!openBufferedWriter(writer, path, writeBuffer, writeBufferLength, isReportSlot))
+    {
+        return false;
+    }
+    writer->vectored = true;
+    return true;
+}
+
 void crasheefu_closeBufferedWriter(CrasheeBufferedWriter* writer)
 {
     if(writer->fd > 0)
@@ -475,13 +708,44 @@ void crasheefu_closeBufferedWriter(CrasheeBufferedWriter* writer)
 
 bool crasheefu_writeBufferedWriter(CrasheeBufferedWriter* writer, const char* restrict const data, const int length)
 {
+    if(writer->vectored && length >= CrasheeFU_VECTORED_DIRECT_WRITE_LENGTH)
+    {
+        // Send the buffered data and the caller's data in one go, without copying the latter.
+        struct iovec vectors[] =
+        {
+            {.iov_base = writer->buffer, .iov_len = (size_t)writer->position},
+            {.iov_base = (void*)data, .iov_len = (size_t)length},
+        };
+        const int skip = writer->position > 0 ? 0 : 1;
+        if(!writeVectorsToFD(writer->fd, vectors + skip, 2 - skip))
+        {
+            return false;
+        }
+        writer->position = 0;
+        return true;
+    }
     if(length > writer->bufferLength - writer->position)
     {
         crasheefu_flushBufferedWriter(writer);
     }
     if(length > writer->bufferLength)
     {
-        return crasheefu_writeBytesToFD(writer->fd, data, length);
+        if(writer->compressor == NULL)
+        {
+            return crasheefu_writeBytesToFD(writer->fd, data, length);
+        }
+        // Everything must pass through the compressor, one frame at a time.
+        for(int offset = 0; offset < length; offset += writer->bufferLength)
+        {
+            const int chunkLength = length - offset < writer->bufferLength ? length - offset : writer->bufferLength;
+            memcpy(writer->buffer, data + offset, chunkLength);
+            writer->position = chunkLength;
+            if(!crasheefu_flushBufferedWriter(writer))
+            {
+                return false;
+            }
+        }
+        return true;
     }
     memcpy(writer->buffer + writer->position, data, length);
     writer->position += length;
@@ -492,7 +756,15 @@ bool crasheefu_flushBufferedWriter(CrasheeBufferedWriter* writer)
 {
     if(writer->fd > 0 && writer->position > 0)
     {
-        if(!crasheefu_writeBytesToFD(writer->fd, writer->buffer, writer->position))
+        if(writer->compressor != NULL)
+        {
+            const int frameLength = crasheelz_encodeFrame(writer->compressor, writer->buffer, writer->position);
+            if(!crasheefu_writeBytesToFD(writer->fd, writer->compressor->outputBuffer, frameLength))
+            {
+                return false;
+            }
+        }
+        else if(!crasheefu_writeBytesToFD(writer->fd, writer->buffer, writer->position))
         {
             return false;
         }
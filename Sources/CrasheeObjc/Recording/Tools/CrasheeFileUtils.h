@@ -39,10 +39,20 @@ extern "C" {
 
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stddef.h>
+
+#include "CrasheeLZ.h"
 
 
 #define CrasheeFU_MAX_PATH_LENGTH 500
 
+/** In vectored mode, writes at least this long are sent straight from the
+ * caller's memory instead of being copied into the write buffer.
+ */
+#ifndef CrasheeFU_VECTORED_DIRECT_WRITE_LENGTH
+    #define CrasheeFU_VECTORED_DIRECT_WRITE_LENGTH 256
+#endif
+
 /** Get the last entry in a file path. Assumes UNIX style separators.
  *
  * @param path The file path.
@@ -91,6 +101,82 @@ bool crasheefu_readBytesFromFD(const int fd, char* bytes, int length);
  */
 bool crasheefu_readEntireFile(const char* path, char** data, int* length, int maxLength);
 
+/** A read-only view of a file's contents. */
+typedef struct
+{
+    /** The contents. NOT null terminated. */
+    const char* data;
+
+    /** The length of the contents. */
+    int length;
+
+    /** The memory backing the view: a mapping of the file, or a heap buffer. */
+    void* memory;
+    size_t memoryLength;
+    bool isMapped;
+} CrasheeFileView;
+
+/** Map a file into memory, read-only, instead of reading it into a buffer.
+ * The file must not be truncated while it is mapped, but it may be deleted.
+ *
+ * @param path The path to the file.
+ *
+ * @param view Filled in with the view. Release it with crasheefu_unmapFile().
+ *
+ * @param maxLength the maximum amount of bytes to view. It will skip beginning
+ *                  bytes if necessary, and always get the latter part of the file.
+ *                  0 = no maximum.
+ *
+ * @return true if the operation was successful.
+ */
+bool crasheefu_mapFile(const char* path, CrasheeFileView* view, int maxLength);
+
+/** Make a view of a heap buffer, taking ownership of it.
+ * This allows data that had to be transformed to be handed out the same way
+ * as a mapped file.
+ *
+ * @param view The view to fill in. Release it with crasheefu_unmapFile().
+ *
+ * @param buffer A buffer allocated with malloc(). It will be freed with the view.
+ *
+ * @param length The length of the data in the buffer.
+ */
+void crasheefu_viewBuffer(CrasheeFileView* view, char* buffer, int length);
+
+/** Flush a file's data to permanent storage, past any caches in the drive.
+ * This function is async-safe.
+ *
+ * @param fd The file to flush.
+ *
+ * @return true if the data was flushed.
+ */
+bool crasheefu_syncFD(int fd);
+
+/** Reserve disk space for a file without changing its length, so that
+ * writing up to that many bytes later doesn't have to allocate any.
+ *
+ * @param fd The file to reserve space for.
+ *
+ * @param length The number of bytes to reserve.
+ *
+ * @return true if the space was reserved.
+ */
+bool crasheefu_preallocateFile(int fd, int64_t length);
+
+/** Ask the system to start reading a mapped view in from disk, so that it is
+ * ready by the time it is used. Does nothing for views of heap buffers.
+ *
+ * @param view The view.
+ */
+void crasheefu_prefetchView(const CrasheeFileView* view);
+
+/** Release a view made by crasheefu_mapFile() or crasheefu_viewBuffer().
+ * The view is left empty. Releasing an empty view does nothing.
+ *
+ * @param view The view.
+ */
+void crasheefu_unmapFile(CrasheeFileView* view);
+
 /** Write a string to a file.
  *
  * @param fd The file descriptor.
@@ -168,9 +254,11 @@ typedef struct
     int bufferLength;
     int position;
     int fd;
+    CrasheeLZWorkspace* compressor;
+    bool vectored;
 } CrasheeBufferedWriter;
 
-/** Open a file for buffered writing.
+/** Open a file for buffered writing. The file must not already exist.
  *
  * @param writer The writer to initialize.
  *
@@ -184,6 +272,56 @@ typedef struct
  */
 bool crasheefu_openBufferedWriter(CrasheeBufferedWriter* writer, const char* const path, char* writeBuffer, int writeBufferLength);
 
+/** Open a file for buffered writing, compressing everything written.
+ *
+ * Each flush writes one compressed frame, so flush at natural boundaries
+ * rather than after every write. Read the file back with
+ * crasheelz_decompressStream() or crasheelz_decompressFile().
+ *
+ * @param writer The writer to initialize.
+ *
+ * @param path The path of the file to open.
+ *
+ * @param workspace Compression workspace. Its input buffer becomes the write buffer.
+ *
+ * @param isReportSlot If true, the file may be a report slot that was moved
+ *                     to the path, and is written from the start. Otherwise
+ *                     it must not already exist.
+ *
+ * @return True if the file was successfully opened.
+ */
+bool crasheefu_openCompressedBufferedWriter(CrasheeBufferedWriter* writer,
+                                            const char* const path,
+                                            CrasheeLZWorkspace* workspace,
+                                            bool isReportSlot);
+
+/** Open a file for vectored buffered writing.
+ *
+ * Small writes are copied into the write buffer as usual. Writes of at least
+ * CrasheeFU_VECTORED_DIRECT_WRITE_LENGTH bytes are not copied: they go out
+ * straight from the caller's memory in the same writev() as the buffered
+ * data before them.
+ *
+ * @param writer The writer to initialize.
+ *
+ * @param path The path of the file to open.
+ *
+ * @param writeBuffer Memory to use as the write buffer.
+ *
+ * @param writeBufferLength Length of the memory to use as the write buffer.
+ *
+ * @param isReportSlot If true, the file may be a report slot that was moved
+ *                     to the path, and is written from the start. Otherwise
+ *                     it must not already exist.
+ *
+ * @return True if the file was successfully opened.
+ */
+bool crasheefu_openVectoredBufferedWriter(CrasheeBufferedWriter* writer,
+                                          const char* const path,
+                                          char* writeBuffer,
+                                          int writeBufferLength,
+                                          bool isReportSlot);
+
 /** Close a buffered writer.
  *
  * @param writer The writer to close.
@@ -0,0 +1,155 @@
+//
+//  CrasheeFormat.h
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+/* Async-safe number and string formatting.
+ *
+ * The standard printf family may take locks and allocate memory, so it can't
+ * be relied upon from within a signal handler. These functions write only to
+ * caller supplied buffers and touch no global state.
+ */
+
+
+#ifndef HDR_CrasheeFormat_h
+#define HDR_CrasheeFormat_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/** Buffer length required to format any 64-bit integer, including the null terminator. */
+#define CrasheeFMT_INT64_BUFFER_LENGTH 21
+
+/** Buffer length required to format any 64-bit value as hex, including the null terminator. */
+#define CrasheeFMT_HEX64_BUFFER_LENGTH 17
+
+/** Buffer length required to format any double, including the null terminator. */
+#define CrasheeFMT_DOUBLE_BUFFER_LENGTH 26
+
+/** Buffer length required to format a UUID, including the null terminator. */
+#define CrasheeFMT_UUID_BUFFER_LENGTH 37
+
+
+/** Format an unsigned integer in decimal.
+ *
+ * @param buffer Buffer of at least CrasheeFMT_INT64_BUFFER_LENGTH bytes.
+ *
+ * @param value The value to format.
+ *
+ * @return The number of characters written, not including the null terminator.
+ */
+int crasheefmt_uint64(char* buffer, uint64_t value);
+
+/** Format a signed integer in decimal.
+ *
+ * @param buffer Buffer of at least CrasheeFMT_INT64_BUFFER_LENGTH bytes.
+ *
+ * @param value The value to format.
+ *
+ * @return The number of characters written, not including the null terminator.
+ */
+int crasheefmt_int64(char* buffer, int64_t value);
+
+/** Format an unsigned integer in hexadecimal, without a "0x" prefix.
+ *
+ * @param buffer Buffer of at least CrasheeFMT_HEX64_BUFFER_LENGTH bytes.
+ *
+ * @param value The value to format.
+ *
+ * @param minDigits Pad with leading zeroes to at least this many digits (max 16).
+ *
+ * @param uppercase If true, use A-F rather than a-f.
+ *
+ * @return The number of characters written, not including the null terminator.
+ */
+int crasheefmt_hex64(char* buffer, uint64_t value, int minDigits, bool uppercase);
+
+/** Format a double using the fewest digits that will parse back to the
+ * same value (the Ryu algorithm).
+ *
+ * Values in [1e-5, 1e17) are written in plain notation, everything else in
+ * exponent notation (e.g. "1.5e+20"). NaN and infinity are written as "nan",
+ * "inf" and "-inf".
+ *
+ * @param buffer Buffer of at least CrasheeFMT_DOUBLE_BUFFER_LENGTH bytes.
+ *
+ * @param value The value to format.
+ *
+ * @return The number of characters written, not including the null terminator.
+ */
+int crasheefmt_double(char* buffer, double value);
+
+/** Format 16 UUID bytes as an uppercase "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX" string.
+ *
+ * @param buffer Buffer of at least CrasheeFMT_UUID_BUFFER_LENGTH bytes.
+ *
+ * @param uuidBytes The 16 bytes of the UUID.
+ */
+void crasheefmt_uuid(char* buffer, const unsigned char* uuidBytes);
+
+/** Minimal snprintf replacement.
+ *
+ * Supports the conversions %d %i %u %x %X %o %p %c %s %f %g %e and %%, the
+ * '-' and '0' flags, field width, precision, and the hh/h/l/ll/j/z/t length
+ * modifiers. %e and %g are written in shortest round-trip form and ignore
+ * precision.
+ *
+ * @param buffer The buffer to write into. Always null terminated if bufferLength > 0.
+ *
+ * @param bufferLength The length of the buffer.
+ *
+ * @param fmt The format string.
+ *
+ * @return The number of characters written, not including the null terminator.
+ *         Output that doesn't fit is truncated.
+ */
+int crasheefmt_format(char* buffer, int bufferLength, const char* fmt, ...);
+
+/** va_list variant of crasheefmt_format().
+ *
+ * @param buffer The buffer to write into. Always null terminated if bufferLength > 0.
+ *
+ * @param bufferLength The length of the buffer.
+ *
+ * @param fmt The format string.
+ *
+ * @param args The arguments.
+ *
+ * @return The number of characters written, not including the null terminator.
+ */
+int crasheefmt_vformat(char* buffer, int bufferLength, const char* fmt, va_list args);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeFormat_h
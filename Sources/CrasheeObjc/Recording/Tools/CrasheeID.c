@@ -23,7 +23,7 @@
 //
 
 
-#include <stdio.h>
+#include "CrasheeFormat.h"
 #include <uuid/uuid.h>
 
 
@@ -31,23 +31,5 @@ void crasheeid_generate(char* destinationBuffer37Bytes)
 {
     uuid_t uuid;
     uuid_generate(uuid);
-    sprintf(destinationBuffer37Bytes,
-            "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X",
-            (unsigned)uuid[0],
-            (unsigned)uuid[1],
-            (unsigned)uuid[2],
-            (unsigned)uuid[3],
-            (unsigned)uuid[4],
-            (unsigned)uuid[5],
-            (unsigned)uuid[6],
-            (unsigned)uuid[7],
-            (unsigned)uuid[8],
-            (unsigned)uuid[9],
-            (unsigned)uuid[10],
-            (unsigned)uuid[11],
-            (unsigned)uuid[12],
-            (unsigned)uuid[13],
-            (unsigned)uuid[14],
-            (unsigned)uuid[15]
-            );
+    crasheefmt_uuid(destinationBuffer37Bytes, uuid);
 }
@@ -26,6 +26,9 @@
 
 
 #include "CrasheeJSONCodec.h"
+#include "CrasheeFormat.h"
+#include "CrasheeNumber.h"
+#include "CrasheeString.h"
 
 #include <ctype.h>
 #include <errno.h>
@@ -58,6 +61,88 @@
     #define CrasheeJSONCODEC_WorkBufferSize 512
 #endif
 
+/** Set to 1 to scan strings for characters that need escaping 16-32 bytes at
+ * a time using SSE2/AVX2 (x86_64) or NEON (arm64). Other architectures use a
+ * word-at-a-time scalar scan.
+ */
+#ifndef CrasheeJSONCODEC_UseSIMD
+    #define CrasheeJSONCODEC_UseSIMD 1
+#endif
+
+#if CrasheeJSONCODEC_UseSIMD && defined(__SSE2__)
+    #include <emmintrin.h>
+    #define CrasheeJSONCODEC_HAS_SSE2 1
+    #if defined(__SSSE3__)
+        #include <tmmintrin.h>
+        #define CrasheeJSONCODEC_HAS_SSSE3 1
+    #endif
+    #if defined(__AVX2__)
+        #include <immintrin.h>
+        #define CrasheeJSONCODEC_HAS_AVX2 1
+    #endif
+#elif CrasheeJSONCODEC_UseSIMD && defined(__ARM_NEON) && (defined(__arm64__) || defined(__aarch64__))
+    #include <arm_neon.h>
+    #define CrasheeJSONCODEC_HAS_NEON 1
+#endif
+
+/** Set to 1 to have crasheejson_decode() locate every structural character,
+ * string delimiter and value start 64 bytes at a time before parsing, instead
+ * of walking the input byte by byte. On by default only where the SIMD units
+ * above are available; the scalar version is slower than the plain parser.
+ * crasheejson_decodeSlices() always works this way.
+ */
+#ifndef CrasheeJSONCODEC_UseStructuralIndex
+    #if CrasheeJSONCODEC_HAS_SSE2 || CrasheeJSONCODEC_HAS_NEON
+        #define CrasheeJSONCODEC_UseStructuralIndex 1
+    #else
+        #define CrasheeJSONCODEC_UseStructuralIndex 0
+    #endif
+#endif
+
+/** How many structural positions to index ahead of the parser (minimum 64).
+ * The index lives on the stack, 4 bytes per entry.
+ */
+#ifndef CrasheeJSONCODEC_StructuralIndexSize
+    #define CrasheeJSONCODEC_StructuralIndexSize 1024
+#endif
+
+/** The size of the buffer that crasheejson_addJSONFromFile() reads through.
+ * It lives on the stack.
+ */
+#ifndef CrasheeJSONCODEC_FileReadBufferSize
+    #define CrasheeJSONCODEC_FileReadBufferSize 16384
+#endif
+
+/** The size of the (stack) buffer that crasheejson_addJSONFromFile() and
+ * crasheejson_addJSONElement() decode names and strings into.
+ * 1/4 of it is used for names.
+ */
+#ifndef CrasheeJSONCODEC_AddJSONStringBufferSize
+    #define CrasheeJSONCODEC_AddJSONStringBufferSize 8192
+#endif
+
+/** The deepest container nesting that crasheejson_decode() will accept. */
+#ifndef CrasheeJSONCODEC_MaxDecodeDepth
+    #define CrasheeJSONCODEC_MaxDecodeDepth 512
+#endif
+
+/** Set to 1 to replace bytes in decoded names and strings that aren't part of
+ * well-formed UTF-8 with CrasheeJSONCODEC_UTF8Replacement. Reports that get
+ * past the decoder end up in Foundation, which refuses the whole document
+ * otherwise. A report can pick up bad bytes from anywhere it copies text
+ * verbatim, such as a console log line cut off mid-character.
+ */
+#ifndef CrasheeJSONCODEC_ValidateUTF8
+    #define CrasheeJSONCODEC_ValidateUTF8 1
+#endif
+
+/** What decoded bad UTF-8 bytes and unpaired UTF-16 surrogate escapes become.
+ * Must be a single ASCII character so that a string never grows.
+ */
+#ifndef CrasheeJSONCODEC_UTF8Replacement
+    #define CrasheeJSONCODEC_UTF8Replacement '?'
+#endif
+
 
 // ============================================================================
 #pragma mark - Helpers -
@@ -88,6 +173,8 @@ const char* crasheejson_stringForError(const int error)
             return "Incomplete data";
         case CrasheeJSON_ERROR_INVALID_DATA:
             return "Invalid data";
+        case CrasheeJSON_SKIP_CONTAINER:
+            return "Container skipped";
         default:
             return "(unknown error)";
     }
@@ -112,37 +199,124 @@ const char* crasheejson_stringForError(const int error)
 #define addJSONData(CONTEXT,DATA,LENGTH) \
     (CONTEXT)->addJSONData(DATA, LENGTH, (CONTEXT)->userData)
 
-/** Escape a string portion for use with JSON and send to data handler.
+/** Find the next character in a string that must be escaped for JSON
+ * ('\\', '"', or a control character).
+ *
+ * Never reads past the end of the string.
+ *
+ * @param src The start of the string portion to scan.
+ *
+ * @param srcEnd The end of the string portion.
+ *
+ * @return A pointer to the first character needing escaping, or srcEnd.
+ */
+static inline const char* findNextEscape(const char* src, const char* const srcEnd)
+{
+#if CrasheeJSONCODEC_HAS_AVX2
+    const __m256i quote32 = _mm256_set1_epi8('\"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i control32 = _mm256_set1_epi8(0x1f);
+    for(; srcEnd - src >= 32; src += 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)src);
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32),
+                                          _mm256_cmpeq_epi8(chunk, backslash32));
+        // min(ch, 0x1f) == ch only for ch <= 0x1f (unsigned).
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control32), chunk));
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+        unlikely_if(mask != 0)
+        {
+            return src + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if CrasheeJSONCODEC_HAS_SSE2
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for(; srcEnd - src >= 16; src += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)src);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                       _mm_cmpeq_epi8(chunk, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+        unlikely_if(mask != 0)
+        {
+            return src + __builtin_ctz(mask);
+        }
+    }
+#elif CrasheeJSONCODEC_HAS_NEON
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(' ');
+    for(; srcEnd - src >= 16; src += 16)
+    {
+        const uint8x16_t chunk = vld1q_u8((const uint8_t*)src);
+        uint8x16_t special = vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash));
+        special = vorrq_u8(special, vcltq_u8(chunk, control));
+        unlikely_if(vmaxvq_u8(special) != 0)
+        {
+            // Narrow each byte lane to a nybble so the position can be found with ctz.
+            const uint8x8_t nybbles = vshrn_n_u16(vreinterpretq_u16_u8(special), 4);
+            const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nybbles), 0);
+            return src + (__builtin_ctzll(mask) >> 2);
+        }
+    }
+#else
+    // Word-at-a-time scan: flags any word containing a byte < 0x20, '"' or '\\'.
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highBits = 0x8080808080808080ULL;
+    for(; srcEnd - src >= 8; src += 8)
+    {
+        uint64_t word;
+        memcpy(&word, src, sizeof(word));
+        const uint64_t quoteXor = word ^ (ones * '\"');
+        const uint64_t backslashXor = word ^ (ones * '\\');
+        const uint64_t flags = ((word - ones * 0x20) |
+                                (quoteXor - ones) |
+                                (backslashXor - ones)) & ~word & highBits;
+        unlikely_if(flags != 0)
+        {
+            break;
+        }
+    }
+#endif
+
+    for(; src < srcEnd; src++)
+    {
+        const unsigned char ch = (unsigned char)*src;
+        unlikely_if(ch == '\\' || ch == '\"' || ch < ' ')
+        {
+            break;
+        }
+    }
+    return src;
+}
+
+/** Escape a run of characters that need escaping and send to data handler.
+ * Stops at the first character that doesn't need escaping, or when the work
+ * buffer is full.
  *
  * @param context The JSON context.
  *
- * @param string The string to escape and write.
+ * @param srcPtr In: Where to start escaping. Out: Where escaping stopped.
  *
- * @param length The length of the string.
+ * @param srcEnd The end of the string.
  *
  * @return CrasheeJSON_OK if the data was handled successfully.
  */
 static int appendEscapedString(CrasheeJSONEncodeContext* const context,
-                               const char* restrict const string,
-                               int length)
+                               const char** const srcPtr,
+                               const char* const srcEnd)
 {
     char workBuffer[CrasheeJSONCODEC_WorkBufferSize];
-    const char* const srcEnd = string + length;
+    // Room for the longest escape, \u00XX.
+    char* const dstEnd = workBuffer + sizeof(workBuffer) - 6;
+    const char* src = *srcPtr;
+    char* dst = workBuffer;
 
-    const char* restrict src = string;
-    char* restrict dst = workBuffer;
-
-    // Simple case (no escape or special characters)
-    for(; src < srcEnd &&
-        *src != '\\' &&
-        *src != '\"' &&
-        (unsigned char)*src >= ' '; src++)
-    {
-        *dst++ = *src;
-    }
-
-    // Deal with complicated case (if any)
-    for(; src < srcEnd; src++)
+    for(; src < srcEnd && dst < dstEnd; src++)
     {
         switch(*src)
         {
@@ -173,20 +347,28 @@ static int appendEscapedString(CrasheeJSONEncodeContext* const context,
                 break;
             default:
                 unlikely_if((unsigned char)*src < ' ')
-            {
-                CrasheeLOG_DEBUG("Invalid character 0x%02x in string: %s",
-                            *src, string);
-                return CrasheeJSON_ERROR_INVALID_CHARACTER;
-            }
-                *dst++ = *src;
+                {
+                    // Such as the escape that starts a terminal color code.
+                    *dst++ = '\\';
+                    *dst++ = 'u';
+                    *dst++ = '0';
+                    *dst++ = '0';
+                    *dst++ = g_hexNybbles[(*src >> 4) & 15];
+                    *dst++ = g_hexNybbles[*src & 15];
+                    break;
+                }
+                goto done;
         }
     }
-    int encLength = (int)(dst - workBuffer);
-    dst -= encLength;
-    return addJSONData(context, dst, encLength);
+
+done:
+    *srcPtr = src;
+    return addJSONData(context, workBuffer, (int)(dst - workBuffer));
 }
 
 /** Escape a string for use with JSON and send to data handler.
+ * Runs of characters that don't need escaping are passed straight through
+ * without being copied.
  *
  * @param context The JSON context.
  *
@@ -201,22 +383,27 @@ static int addEscapedString(CrasheeJSONEncodeContext* const context,
                             int length)
 {
     int result = CrasheeJSON_OK;
+    const char* src = string;
+    const char* const srcEnd = string + length;
 
-    // Keep adding portions until the whole string has been processed.
-    int offset = 0;
-    while(offset < length)
+    while(src < srcEnd)
     {
-        int toAdd = length - offset;
-        unlikely_if(toAdd > CrasheeJSONCODEC_WorkBufferSize / 2)
+        const char* const cleanEnd = findNextEscape(src, srcEnd);
+        likely_if(cleanEnd > src)
         {
-            toAdd = CrasheeJSONCODEC_WorkBufferSize / 2;
+            unlikely_if((result = addJSONData(context, src, (int)(cleanEnd - src))) != CrasheeJSON_OK)
+            {
+                return result;
+            }
+            src = cleanEnd;
         }
-        result = appendEscapedString(context, string + offset, toAdd);
-        unlikely_if(result != CrasheeJSON_OK)
+        unlikely_if(src < srcEnd)
         {
-            break;
+            unlikely_if((result = appendEscapedString(context, &src, srcEnd)) != CrasheeJSON_OK)
+            {
+                return result;
+            }
         }
-        offset += toAdd;
     }
     return result;
 }
@@ -284,6 +471,14 @@ int crasheejson_beginElement(CrasheeJSONEncodeContext* const context, const char
     // Add a name field if we're in an object.
     if(context->isObject[context->containerLevel])
     {
+        // Interned names are already quoted and terminated.
+        uintptr_t offset = (uintptr_t)name - (uintptr_t)context->internedNames;
+        likely_if(offset < (uintptr_t)context->internedNameCount * sizeof(*context->internedNames) &&
+                  offset % sizeof(*context->internedNames) == 0)
+        {
+            const CrasheeJSONInternedName* interned = (const CrasheeJSONInternedName*)(const void*)name;
+            return addJSONData(context, interned->quoted, interned->quotedLength + (context->prettyPrint ? 1 : 0));
+        }
         unlikely_if(name == NULL)
         {
             CrasheeLOG_DEBUG("Name was null inside an object");
@@ -346,9 +541,9 @@ int crasheejson_addFloatingPointElement(CrasheeJSONEncodeContext* const context,
     {
         return result;
     }
-    char buff[30];
-    sprintf(buff, "%lg", value);
-    return addJSONData(context, buff, (int)strlen(buff));
+    char buff[CrasheeFMT_DOUBLE_BUFFER_LENGTH];
+    const int length = crasheefmt_double(buff, value);
+    return addJSONData(context, buff, length);
 }
 
 int crasheejson_addIntegerElement(CrasheeJSONEncodeContext* const context,
@@ -360,9 +555,9 @@ int crasheejson_addIntegerElement(CrasheeJSONEncodeContext* const context,
     {
         return result;
     }
-    char buff[30];
-    sprintf(buff, "%" PRId64, value);
-    return addJSONData(context, buff, (int)strlen(buff));
+    char buff[CrasheeFMT_INT64_BUFFER_LENGTH];
+    const int length = crasheefmt_int64(buff, value);
+    return addJSONData(context, buff, length);
 }
 
 int crasheejson_addUIntegerElement(CrasheeJSONEncodeContext* const context,
@@ -374,9 +569,9 @@ int crasheejson_addUIntegerElement(CrasheeJSONEncodeContext* const context,
     {
         return result;
     }
-    char buff[30];
-    sprintf(buff, "%" PRIu64, value);
-    return addJSONData(context, buff, (int)strlen(buff));
+    char buff[CrasheeFMT_INT64_BUFFER_LENGTH];
+    const int length = crasheefmt_uint64(buff, value);
+    return addJSONData(context, buff, length);
 }
 
 int crasheejson_addNullElement(CrasheeJSONEncodeContext* const context,
@@ -464,18 +659,22 @@ int crasheejson_appendDataElement(CrasheeJSONEncodeContext* const context,
 {
     unsigned char* currentByte = (unsigned char*)value;
     unsigned char* end = currentByte + length;
-    char chars[2];
+    char chars[128];
     int result = CrasheeJSON_OK;
     while(currentByte < end)
     {
-        chars[0] = g_hexNybbles[(*currentByte>>4)&15];
-        chars[1] = g_hexNybbles[*currentByte&15];
-        result = addJSONData(context, chars, sizeof(chars));
+        // Encode a chunk at a time so that large dumps don't cost a callback per byte.
+        int charCount = 0;
+        for(; currentByte < end && charCount < (int)sizeof(chars); currentByte++)
+        {
+            chars[charCount++] = g_hexNybbles[(*currentByte>>4)&15];
+            chars[charCount++] = g_hexNybbles[*currentByte&15];
+        }
+        result = addJSONData(context, chars, charCount);
         if(result != CrasheeJSON_OK)
         {
             break;
         }
-        currentByte++;
     }
     return result;
 }
@@ -565,6 +764,14 @@ void crasheejson_beginEncode(CrasheeJSONEncodeContext* const context,
     context->containerFirstEntry = true;
 }
 
+void crasheejson_setInternedNames(CrasheeJSONEncodeContext* const context,
+                             const CrasheeJSONInternedName* const names,
+                             const int count)
+{
+    context->internedNames = names;
+    context->internedNameCount = names == NULL ? 0 : count;
+}
+
 int crasheejson_endEncode(CrasheeJSONEncodeContext* const context)
 {
     int result = CrasheeJSON_OK;
@@ -601,10 +808,31 @@ typedef struct
     int stringBufferLength;
     /** The callbaccrashee to call while decoding. */
     CrasheeJSONDecodeCallbaccrashee* const callbaccrashee;
+    /** If not NULL, strings are reported as slices to these callbaccrashee instead. */
+    CrasheeJSONSliceDecodeCallbaccrashee* const sliceCallbaccrashee;
     /** Data that was specified when calling crasheejson_decode(). */
     void* userData;
 } CrasheeJSONDecodeContext;
 
+typedef enum
+{
+    ScalarType_Boolean,
+    ScalarType_Integer,
+    ScalarType_UnsignedInteger,
+    ScalarType_FloatingPoint,
+    ScalarType_Null,
+} ScalarType;
+
+/** A decoded number, boolean, or null. */
+typedef struct
+{
+    ScalarType type;
+    bool asBoolean;
+    int64_t asInteger;
+    uint64_t asUnsignedInteger;
+    double asFloatingPoint;
+} ScalarValue;
+
 /** Lookup table for converting hex values to integers.
  * INV (0x11111) is used to mark invalid characters so that any attempted
  * invalid nybble conversion is always > 0xffff.
@@ -641,39 +869,42 @@ static const unsigned int g_hexConversion[] =
  */
 static int writeUTF8(unsigned int character, char** dst);
 
-/** Decode a string value.
+/** Copy the contents of a string, converting any escape sequences.
  *
- * @param context The decoding context.
+ * @param src The start of the string contents (after the opening quote).
+ *
+ * @param srcEnd The end of the string contents (the closing quote).
  *
- * @param dstBuffer Buffer to hold the decoded string.
+ * @param fastCopy If true, the contents contain no escape sequences.
  *
- * @param dstBufferLength Length of the destination buffer.
+ * @param dstBuffer Buffer to hold the decoded string (must be longer than the contents).
+ *                  If fastCopy is false, this may be src itself.
  *
  * @return CrasheeJSON_OK if successful.
  */
-static int decodeString(CrasheeJSONDecodeContext* context, char* dstBuffer, int dstBufferLength);
+static int unescapeString(const char* src, const char* const srcEnd, const bool fastCopy, char* const dstBuffer);
 
-/** Decode a JSON element.
- *
- * @param name This element's name (or NULL if it has none).
+/** Decode a number, boolean, or null element.
  *
  * @param context The decoding context.
  *
+ * @param value Filled in with the decoded value.
+ *
  * @return CrasheeJSON_OK if successful.
  */
-static int decodeElement(const char* const name,
-                                CrasheeJSONDecodeContext* context);
-
+static int decodeScalar(CrasheeJSONDecodeContext* context, ScalarValue* const value);
 
-/** Skip past any whitespace.
+/** Pass a decoded number, boolean, or null element to the callbaccrashee.
  *
- * @param CONTEXT The decoding context.
+ * @param name This element's name (or NULL if it has none).
+ *
+ * @param value The decoded value.
+ *
+ * @param context The decoding context.
+ *
+ * @return The callback's result.
  */
-#define SKIP_WHITESPACE(CONTEXT) \
-while(CONTEXT->bufferPtr < CONTEXT->bufferEnd && isspace(*CONTEXT->bufferPtr)) \
-{ \
-    CONTEXT->bufferPtr++; \
-}
+static inline int reportScalar(const char* const name, const ScalarValue* const value, CrasheeJSONDecodeContext* context);
 
 
 /** Check if a character is valid for representing part of a floating point
@@ -735,51 +966,46 @@ static int writeUTF8(unsigned int character, char** dst)
     return CrasheeJSON_ERROR_INVALID_CHARACTER;
 }
 
-static int decodeString(CrasheeJSONDecodeContext* context, char* dstBuffer, int dstBufferLength)
+/** Check whether a string needs repairUTF8(), if CrasheeJSONCODEC_ValidateUTF8 asks for it. */
+static inline bool isUTF8RepairNeeded(const char* const string, const int length)
 {
-    *dstBuffer = '\0';
-    unlikely_if(*context->bufferPtr != '\"')
-    {
-        CrasheeLOG_DEBUG("Expected '\"' but got '%c'", *context->bufferPtr);
-        return CrasheeJSON_ERROR_INVALID_CHARACTER;
-    }
-
-    const char* src = context->bufferPtr + 1;
-    bool fastCopy = true;
+#if CrasheeJSONCODEC_ValidateUTF8
+    return !crasheestring_isValidUTF8(string, length);
+#else
+    return false;
+#endif
+}
 
-    for(; src < context->bufferEnd && *src != '\"'; src++)
-    {
-        unlikely_if(*src == '\\')
-        {
-            fastCopy = false;
-            src++;
-        }
-    }
-    unlikely_if(src >= context->bufferEnd)
-    {
-        CrasheeLOG_DEBUG("Premature end of data");
-        return CrasheeJSON_ERROR_INCOMPLETE;
-    }
-    const char* srcEnd = src;
-    src = context->bufferPtr + 1;
-    int length = (int)(srcEnd - src);
-    if(length >= dstBufferLength)
-    {
-        CrasheeLOG_DEBUG("String is too long");
-        return CrasheeJSON_ERROR_DATA_TOO_LONG;
-    }
+/** Replace bad UTF-8 in place. The length doesn't change. */
+static void repairUTF8(char* const string, const int length)
+{
+    const int replacedCount = crasheestring_replaceInvalidUTF8(string, length, CrasheeJSONCODEC_UTF8Replacement);
+    CrasheeLOG_DEBUG("Replaced %d invalid UTF-8 bytes in string", replacedCount);
+    (void)replacedCount;
+}
 
-    context->bufferPtr = srcEnd + 1;
+static int unescapeString(const char* src, const char* const srcEnd, const bool fastCopy, char* const dstBuffer)
+{
+    // Escapes are plain ASCII, and decode to valid UTF-8 because unpaired
+    // surrogates are replaced below, so checking the raw source covers the
+    // unescaped result as well.
+    const bool isRepairNeeded = isUTF8RepairNeeded(src, (int)(srcEnd - src));
 
     // If no escape characters were encountered, we can fast copy.
     likely_if(fastCopy)
     {
+        const int length = (int)(srcEnd - src);
         memcpy(dstBuffer, src, length);
         dstBuffer[length] = 0;
+        unlikely_if(isRepairNeeded)
+        {
+            repairUTF8(dstBuffer, length);
+        }
         return CrasheeJSON_OK;
     }
 
     char* dst = dstBuffer;
+    int result;
 
     for(; src < srcEnd; src++)
     {
@@ -824,10 +1050,10 @@ static int decodeString(CrasheeJSONDecodeContext* context, char* dstBuffer, int
                         return CrasheeJSON_ERROR_INCOMPLETE;
                     }
                     unsigned int accum =
-                    g_hexConversion[src[1]] << 12 |
-                    g_hexConversion[src[2]] << 8 |
-                    g_hexConversion[src[3]] << 4 |
-                    g_hexConversion[src[4]];
+                    g_hexConversion[(unsigned char)src[1]] << 12 |
+                    g_hexConversion[(unsigned char)src[2]] << 8 |
+                    g_hexConversion[(unsigned char)src[3]] << 4 |
+                    g_hexConversion[(unsigned char)src[4]];
                     unlikely_if(accum > 0xffff)
                     {
                         CrasheeLOG_DEBUG("Invalid unicode sequence: %c%c%c%c",
@@ -835,47 +1061,38 @@ static int decodeString(CrasheeJSONDecodeContext* context, char* dstBuffer, int
                         return CrasheeJSON_ERROR_INVALID_CHARACTER;
                     }
 
-                    // UTF-16 Trail surrogate on its own.
-                    unlikely_if(accum >= 0xdc00 && accum <= 0xdfff)
-                    {
-                        CrasheeLOG_DEBUG("Unexpected trail surrogate: 0x%04x",
-                                    accum);
-                        return CrasheeJSON_ERROR_INVALID_CHARACTER;
-                    }
-
                     // UTF-16 Lead surrogate.
                     unlikely_if(accum >= 0xd800 && accum <= 0xdbff)
                     {
                         // Fetch trail surrogate.
-                        unlikely_if(src + 11 > srcEnd)
-                        {
-                            CrasheeLOG_DEBUG("Premature end of data");
-                            return CrasheeJSON_ERROR_INCOMPLETE;
-                        }
-                        unlikely_if(src[5] != '\\' ||
-                                    src[6] != 'u')
+                        unsigned int accum2 = 0;
+                        likely_if(src + 11 <= srcEnd && src[5] == '\\' && src[6] == 'u')
                         {
-                            CrasheeLOG_DEBUG("Expected \"\\u\" but got: \"%c%c\"",
-                                        src[5], src[6]);
-                            return CrasheeJSON_ERROR_INVALID_CHARACTER;
+                            accum2 =
+                            g_hexConversion[(unsigned char)src[7]] << 12 |
+                            g_hexConversion[(unsigned char)src[8]] << 8 |
+                            g_hexConversion[(unsigned char)src[9]] << 4 |
+                            g_hexConversion[(unsigned char)src[10]];
                         }
-                        src += 6;
-                        unsigned int accum2 =
-                        g_hexConversion[src[1]] << 12 |
-                        g_hexConversion[src[2]] << 8 |
-                        g_hexConversion[src[3]] << 4 |
-                        g_hexConversion[src[4]];
-                        unlikely_if(accum2 < 0xdc00 || accum2 > 0xdfff)
+                        likely_if(accum2 >= 0xdc00 && accum2 <= 0xdfff)
                         {
-                            CrasheeLOG_DEBUG("Invalid trail surrogate: 0x%04x",
-                                        accum2);
-                            return CrasheeJSON_ERROR_INVALID_CHARACTER;
+                            // And combine 20 bit result.
+                            accum = (((accum - 0xd800) << 10) | (accum2 - 0xdc00)) + 0x10000;
+                            src += 6;
                         }
-                        // And combine 20 bit result.
-                        accum = ((accum - 0xd800) << 10) | (accum2 - 0xdc00);
                     }
 
-                    int result = writeUTF8(accum, &dst);
+                    // UTF-16 surrogate that isn't part of a pair. Whatever
+                    // follows a lone lead surrogate is decoded on its own.
+                    unlikely_if(accum >= 0xd800 && accum <= 0xdfff)
+                    {
+                        CrasheeLOG_DEBUG("Unpaired surrogate: 0x%04x", accum);
+                        *dst++ = CrasheeJSONCODEC_UTF8Replacement;
+                        src += 4;
+                        continue;
+                    }
+
+                    result = writeUTF8(accum, &dst);
                     unlikely_if(result != CrasheeJSON_OK)
                     {
                         return result;
@@ -891,110 +1108,17 @@ static int decodeString(CrasheeJSONDecodeContext* context, char* dstBuffer, int
     }
 
     *dst = 0;
+    unlikely_if(isRepairNeeded)
+    {
+        repairUTF8(dstBuffer, (int)(dst - dstBuffer));
+    }
     return CrasheeJSON_OK;
 }
 
-static int decodeElement(const char* const name, CrasheeJSONDecodeContext* context)
+static int decodeScalar(CrasheeJSONDecodeContext* context, ScalarValue* const value)
 {
-    SKIP_WHITESPACE(context);
-    unlikely_if(context->bufferPtr >= context->bufferEnd)
-    {
-        CrasheeLOG_DEBUG("Premature end of data");
-        return CrasheeJSON_ERROR_INCOMPLETE;
-    }
-
-    int sign = 1;
-    int result;
-
     switch(*context->bufferPtr)
     {
-        case '[':
-        {
-            context->bufferPtr++;
-            result = context->callbaccrashee->onBeginArray(name, context->userData);
-            unlikely_if(result != CrasheeJSON_OK) return result;
-            while(context->bufferPtr < context->bufferEnd)
-            {
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd)
-                {
-                    break;
-                }
-                unlikely_if(*context->bufferPtr == ']')
-                {
-                    context->bufferPtr++;
-                    return context->callbaccrashee->onEndContainer(context->userData);
-                }
-                result = decodeElement(NULL, context);
-                unlikely_if(result != CrasheeJSON_OK) return result;
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd)
-                {
-                    break;
-                }
-                likely_if(*context->bufferPtr == ',')
-                {
-                    context->bufferPtr++;
-                }
-            }
-            CrasheeLOG_DEBUG("Premature end of data");
-            return CrasheeJSON_ERROR_INCOMPLETE;
-        }
-        case '{':
-        {
-            context->bufferPtr++;
-            result = context->callbaccrashee->onBeginObject(name, context->userData);
-            unlikely_if(result != CrasheeJSON_OK) return result;
-            while(context->bufferPtr < context->bufferEnd)
-            {
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd)
-                {
-                    break;
-                }
-                unlikely_if(*context->bufferPtr == '}')
-                {
-                    context->bufferPtr++;
-                    return context->callbaccrashee->onEndContainer(context->userData);
-                }
-                result = decodeString(context, context->nameBuffer, context->nameBufferLength);
-                unlikely_if(result != CrasheeJSON_OK) return result;
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd)
-                {
-                    break;
-                }
-                unlikely_if(*context->bufferPtr != ':')
-                {
-                    CrasheeLOG_DEBUG("Expected ':' but got '%c'", *context->bufferPtr);
-                    return CrasheeJSON_ERROR_INVALID_CHARACTER;
-                }
-                context->bufferPtr++;
-                SKIP_WHITESPACE(context);
-                result = decodeElement(context->nameBuffer, context);
-                unlikely_if(result != CrasheeJSON_OK) return result;
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd)
-                {
-                    break;
-                }
-                likely_if(*context->bufferPtr == ',')
-                {
-                    context->bufferPtr++;
-                }
-            }
-            CrasheeLOG_DEBUG("Premature end of data");
-            return CrasheeJSON_ERROR_INCOMPLETE;
-        }
-        case '\"':
-        {
-            result = decodeString(context, context->stringBuffer, context->stringBufferLength);
-            unlikely_if(result != CrasheeJSON_OK) return result;
-            result = context->callbaccrashee->onStringElement(name,
-                                                context->stringBuffer,
-                                                context->userData);
-            return result;
-        }
         case 'f':
         {
             unlikely_if(context->bufferEnd - context->bufferPtr < 5)
@@ -1012,7 +1136,9 @@ static int decodeElement(const char* const name, CrasheeJSONDecodeContext* conte
                 return CrasheeJSON_ERROR_INVALID_CHARACTER;
             }
             context->bufferPtr += 5;
-            return context->callbaccrashee->onBooleanElement(name, false, context->userData);
+            value->type = ScalarType_Boolean;
+            value->asBoolean = false;
+            return CrasheeJSON_OK;
         }
         case 't':
         {
@@ -1030,7 +1156,9 @@ static int decodeElement(const char* const name, CrasheeJSONDecodeContext* conte
                 return CrasheeJSON_ERROR_INVALID_CHARACTER;
             }
             context->bufferPtr += 4;
-            return context->callbaccrashee->onBooleanElement(name, true, context->userData);
+            value->type = ScalarType_Boolean;
+            value->asBoolean = true;
+            return CrasheeJSON_OK;
         }
         case 'n':
         {
@@ -1048,107 +1176,1417 @@ static int decodeElement(const char* const name, CrasheeJSONDecodeContext* conte
                 return CrasheeJSON_ERROR_INVALID_CHARACTER;
             }
             context->bufferPtr += 4;
-            return context->callbaccrashee->onNullElement(name, context->userData);
+            value->type = ScalarType_Null;
+            return CrasheeJSON_OK;
         }
         case '-':
-            sign = -1;
-            context->bufferPtr++;
-            unlikely_if(!isdigit(*context->bufferPtr))
-        {
-            CrasheeLOG_DEBUG("Not a digit: '%c'", *context->bufferPtr);
-            return CrasheeJSON_ERROR_INVALID_CHARACTER;
-        }
-            // Fall through
         case '0': case '1': case '2': case '3': case '4':
         case '5': case '6': case '7': case '8': case '9':
         {
-            // Try integer conversion.
+            // Short plain integers (by far the most common numbers in a
+            // report) are handled here, without a call into the parser.
+            const char* ptr = context->bufferPtr;
+            const bool negative = *ptr == '-';
+            if(negative)
+            {
+                ptr++;
+            }
+            const char* const digitsEnd = ptr + 18 < context->bufferEnd ? ptr + 18 : context->bufferEnd;
             int64_t accum = 0;
-            const char* const start = context->bufferPtr;
-
-            for(; context->bufferPtr < context->bufferEnd && isdigit(*context->bufferPtr); context->bufferPtr++)
+            while(ptr < digitsEnd && *ptr >= '0' && *ptr <= '9')
             {
-                accum = accum * 10 + (*context->bufferPtr - '0');
-                unlikely_if(accum < 0)
-                {
-                    // Overflow
-                    break;
-                }
+                accum = accum * 10 + (*ptr++ - '0');
             }
-
-            unlikely_if(context->bufferPtr >= context->bufferEnd)
+            likely_if(ptr < context->bufferEnd && ptr > context->bufferPtr + negative && !isFPChar(*ptr))
             {
-                CrasheeLOG_DEBUG("Premature end of data");
-                return CrasheeJSON_ERROR_INCOMPLETE;
+                context->bufferPtr = ptr;
+                value->type = ScalarType_Integer;
+                value->asInteger = negative ? -accum : accum;
+                return CrasheeJSON_OK;
             }
 
-            if(!isFPChar(*context->bufferPtr) && accum >= 0)
+            CrasheeNumber number;
+            const char* const numberEnd = crasheenumber_parse(context->bufferPtr, context->bufferEnd, &number);
+            unlikely_if(numberEnd == NULL)
             {
-                accum *= sign;
-                return context->callbaccrashee->onIntegerElement(name, accum, context->userData);
+                // A '-' without a digit after it.
+                context->bufferPtr++;
+                unlikely_if(context->bufferPtr >= context->bufferEnd)
+                {
+                    CrasheeLOG_DEBUG("Premature end of data");
+                    return CrasheeJSON_ERROR_INCOMPLETE;
+                }
+                CrasheeLOG_DEBUG("Not a digit: '%c'", *context->bufferPtr);
+                return CrasheeJSON_ERROR_INVALID_CHARACTER;
             }
 
+            // Anything else that could be part of a number ("1.2.3", "1e")
+            // is swallowed, and makes it floating point.
+            context->bufferPtr = numberEnd;
             while(context->bufferPtr < context->bufferEnd && isFPChar(*context->bufferPtr))
             {
                 context->bufferPtr++;
             }
-
             unlikely_if(context->bufferPtr >= context->bufferEnd)
             {
                 CrasheeLOG_DEBUG("Premature end of data");
                 return CrasheeJSON_ERROR_INCOMPLETE;
             }
 
-            // our buffer is not necessarily NULL-terminated, so
-            // it would be undefined to call sscanf/sttod etc. directly.
-            // instead we create a temporary string.
-            double value;
-            int len = (int)(context->bufferPtr - start);
-            if(len >= context->stringBufferLength)
+            switch(number.type)
             {
-                CrasheeLOG_DEBUG("Number is too long.");
-                return CrasheeJSON_ERROR_DATA_TOO_LONG;
+                case CrasheeNumberType_Integer:
+                    likely_if(context->bufferPtr == numberEnd)
+                    {
+                        value->type = ScalarType_Integer;
+                        value->asInteger = number.asInteger;
+                        return CrasheeJSON_OK;
+                    }
+                    value->type = ScalarType_FloatingPoint;
+                    value->asFloatingPoint = (double)number.asInteger;
+                    return CrasheeJSON_OK;
+                case CrasheeNumberType_UnsignedInteger:
+                    likely_if(context->bufferPtr == numberEnd)
+                    {
+                        value->type = ScalarType_UnsignedInteger;
+                        value->asUnsignedInteger = number.asUnsignedInteger;
+                        return CrasheeJSON_OK;
+                    }
+                    value->type = ScalarType_FloatingPoint;
+                    value->asFloatingPoint = (double)number.asUnsignedInteger;
+                    return CrasheeJSON_OK;
+                case CrasheeNumberType_FloatingPoint:
+                default:
+                    value->type = ScalarType_FloatingPoint;
+                    value->asFloatingPoint = number.asFloatingPoint;
+                    return CrasheeJSON_OK;
             }
-            strncpy(context->stringBuffer, start, len);
-            context->stringBuffer[len] = '\0';
-
-            sscanf(context->stringBuffer, "%lg", &value);
-
-            value *= sign;
-            return context->callbaccrashee->onFloatingPointElement(name, value, context->userData);
         }
     }
     CrasheeLOG_DEBUG("Invalid character '%c'", *context->bufferPtr);
     return CrasheeJSON_ERROR_INVALID_CHARACTER;
 }
 
-int crasheejson_decode(const char* const data,
-                  int length,
-                  char* stringBuffer,
-                  int stringBufferLength,
-                  CrasheeJSONDecodeCallbaccrashee* const callbaccrashee,
-                  void* const userData,
-                  int* const errorOffset)
+static inline int reportScalar(const char* const name, const ScalarValue* const value, CrasheeJSONDecodeContext* context)
 {
-    char* nameBuffer = stringBuffer;
-    int nameBufferLength = stringBufferLength / 4;
-    stringBuffer = nameBuffer + nameBufferLength;
-    stringBufferLength -= nameBufferLength;
-    CrasheeJSONDecodeContext context =
+    switch(value->type)
     {
-        .bufferPtr = (char*)data,
-        .bufferEnd = (char*)data + length,
-        .nameBuffer = nameBuffer,
-        .nameBufferLength = nameBufferLength,
-        .stringBuffer = stringBuffer,
-        .stringBufferLength = (int)stringBufferLength,
-        .callbaccrashee = callbaccrashee,
-        .userData = userData
-    };
-
+        case ScalarType_Boolean:
+            return context->callbaccrashee->onBooleanElement(name, value->asBoolean, context->userData);
+        case ScalarType_Integer:
+            return context->callbaccrashee->onIntegerElement(name, value->asInteger, context->userData);
+        case ScalarType_UnsignedInteger:
+            likely_if(context->callbaccrashee->onUnsignedIntegerElement != NULL)
+            {
+                return context->callbaccrashee->onUnsignedIntegerElement(name, value->asUnsignedInteger, context->userData);
+            }
+            return context->callbaccrashee->onFloatingPointElement(name, (double)value->asUnsignedInteger, context->userData);
+        case ScalarType_FloatingPoint:
+            return context->callbaccrashee->onFloatingPointElement(name, value->asFloatingPoint, context->userData);
+        case ScalarType_Null:
+        default:
+            return context->callbaccrashee->onNullElement(name, context->userData);
+    }
+}
+
+// ============================================================================
+#pragma mark - Push Decoder -
+// ============================================================================
+
+/* The push decoder keeps everything it needs between chunks in a
+ * CrasheeJSONPushDecoder, so it never recurses and can stop anywhere.
+ * A token that is complete within a chunk is decoded straight from it.
+ * Only a token that runs off the end of a chunk is copied (still escaped)
+ * into the name or string buffer, and decoded once its end arrives.
+ */
+
+enum
+{
+    /** A value, or the end of the array (after '[' or ','). */
+    PushState_Value,
+    /** A member name, or the end of the object (after '{' or ','). */
+    PushState_Name,
+    /** The ':' after a member name. */
+    PushState_Colon,
+    /** A ',' or the end of the container. */
+    PushState_AfterValue,
+    /** The rest of a member name that started in an earlier chunk. */
+    PushState_InName,
+    /** The rest of a string that started in an earlier chunk. */
+    PushState_InString,
+    /** The rest of a number or literal that started in an earlier chunk. */
+    PushState_InScalar,
+    /** The contents of a container that a callback asked to skip. */
+    PushState_Skipping,
+    /** The top level element is complete. Anything after it is ignored. */
+    PushState_Done,
+};
+
+/** The state to move to once a value is complete. */
+static inline int pushStateAfterValue(const CrasheeJSONPushDecoder* const decoder)
+{
+    return decoder->depth == 0 ? PushState_Done : PushState_AfterValue;
+}
+
+/** The name of the value being decoded. */
+static inline const char* pushValueName(const CrasheeJSONPushDecoder* const decoder)
+{
+    unlikely_if(decoder->depth == 0)
+    {
+        return decoder->topLevelName;
+    }
+    return decoder->isObject[decoder->depth - 1] ? decoder->nameBuffer : NULL;
+}
+
+/** Skip whitespace, stopping at the end of the chunk. */
+static inline const char* skipPushWhitespace(const char* ptr, const char* const end)
+{
+    while(ptr < end && isspace(*ptr))
+    {
+        ptr++;
+    }
+    return ptr;
+}
+
+/** Check if a character can be part of a number or literal. */
+static inline bool isScalarChar(const char ch)
+{
+    return isFPChar(ch) || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+/** Find the end of a string's contents, finishing any escape sequence
+ * that the previous chunk ended in.
+ *
+ * @param decoder The decoder. Records any escape sequences.
+ *
+ * @param src Where to start looking.
+ *
+ * @param end The end of the chunk.
+ *
+ * @return The closing quote, or end if the string continues in the next chunk.
+ */
+static const char* findPushStringEnd(CrasheeJSONPushDecoder* const decoder, const char* src, const char* const end)
+{
+    unlikely_if(decoder->pendingEscape && src < end)
+    {
+        decoder->pendingEscape = false;
+        src++;
+    }
+    for(;;)
+    {
+        // Also stops at control characters, which are allowed through as-is.
+        src = findNextEscape(src, end);
+        unlikely_if(src >= end)
+        {
+            return end;
+        }
+        likely_if(*src == '\"')
+        {
+            return src;
+        }
+        if(*src == '\\')
+        {
+            decoder->pendingHasEscapes = true;
+            unlikely_if(src + 1 >= end)
+            {
+                decoder->pendingEscape = true;
+                return end;
+            }
+            src++;
+        }
+        src++;
+    }
+}
+
+/** Decode the string (or the rest of the string) whose contents start at *ptr.
+ * If it doesn't end in this chunk, what there is of it is kept for the next one.
+ */
+static int pushDecodeString(CrasheeJSONPushDecoder* const decoder,
+                            const char** const ptr,
+                            const char* const end,
+                            const bool isName)
+{
+    char* const buffer = isName ? decoder->nameBuffer : decoder->stringBuffer;
+    const int bufferLength = isName ? decoder->nameBufferLength : decoder->stringBufferLength;
+    const char* const src = *ptr;
+    const char* const srcEnd = findPushStringEnd(decoder, src, end);
+    const int length = (int)(srcEnd - src);
+    unlikely_if(decoder->pendingLength + length >= bufferLength)
+    {
+        CrasheeLOG_DEBUG("String is too long");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+
+    unlikely_if(srcEnd >= end)
+    {
+        memcpy(buffer + decoder->pendingLength, src, (size_t)length);
+        decoder->pendingLength += length;
+        decoder->state = isName ? PushState_InName : PushState_InString;
+        *ptr = end;
+        return CrasheeJSON_OK;
+    }
+
+    int result;
+    likely_if(decoder->pendingLength == 0)
+    {
+        result = unescapeString(src, srcEnd, !decoder->pendingHasEscapes, buffer);
+    }
+    else
+    {
+        memcpy(buffer + decoder->pendingLength, src, (size_t)length);
+        const int totalLength = decoder->pendingLength + length;
+        if(decoder->pendingHasEscapes)
+        {
+            result = unescapeString(buffer, buffer + totalLength, false, buffer);
+        }
+        else
+        {
+            // Checked here as a whole, so that where the chunks split doesn't matter.
+            buffer[totalLength] = '\0';
+            result = CrasheeJSON_OK;
+            unlikely_if(isUTF8RepairNeeded(buffer, totalLength))
+            {
+                repairUTF8(buffer, totalLength);
+            }
+        }
+    }
+    unlikely_if(result != CrasheeJSON_OK) return result;
+    *ptr = srcEnd + 1;
+    decoder->pendingLength = 0;
+    decoder->pendingHasEscapes = false;
+
+    if(isName)
+    {
+        decoder->state = PushState_Colon;
+        return CrasheeJSON_OK;
+    }
+    decoder->state = pushStateAfterValue(decoder);
+    return decoder->callbaccrashee->onStringElement(pushValueName(decoder), buffer, decoder->userData);
+}
+
+/** Check the result of decoding a number or literal with decodeScalar().
+ *
+ * @param result What decodeScalar() returned.
+ *
+ * @param hasTerminator If true, the scalar was followed by a character that can't be part of it.
+ *
+ * @param context The context that was decoded from.
+ *
+ * @param scalarEnd Where the scalar's characters end.
+ *
+ * @return The result, made stricter.
+ */
+static inline int checkPushScalar(const int result,
+                                  const bool hasTerminator,
+                                  const CrasheeJSONDecodeContext* const context,
+                                  const char* const scalarEnd)
+{
+    // A scalar that is followed by something else can't be incomplete, only wrong ("tru]").
+    unlikely_if(result == CrasheeJSON_ERROR_INCOMPLETE && hasTerminator)
+    {
+        return CrasheeJSON_ERROR_INVALID_CHARACTER;
+    }
+    // Trailing characters ("truex", "0f") would otherwise be taken as a second value.
+    unlikely_if(result == CrasheeJSON_OK && context->bufferPtr != scalarEnd)
+    {
+        CrasheeLOG_DEBUG("Invalid character '%c'", *context->bufferPtr);
+        return CrasheeJSON_ERROR_INVALID_CHARACTER;
+    }
+    return result;
+}
+
+/** Decode a number or literal that was split across chunks, and is now in the string buffer.
+ *
+ * @param decoder The decoder.
+ *
+ * @param hasTerminator If true, the scalar is followed by terminator. Otherwise, the data has ended.
+ *
+ * @param terminator The character following the scalar.
+ *
+ * @param context A decoding context to use.
+ *
+ * @param value Filled in with the decoded value.
+ *
+ * @return CrasheeJSON_OK if successful.
+ */
+static int decodePendingScalar(CrasheeJSONPushDecoder* const decoder,
+                               const bool hasTerminator,
+                               const char terminator,
+                               CrasheeJSONDecodeContext* const context,
+                               ScalarValue* const value)
+{
+    char* const buffer = decoder->stringBuffer;
+    const int length = decoder->pendingLength;
+    decoder->pendingLength = 0;
+    // decodeScalar() needs to see what follows a number to know that it's complete.
+    buffer[length] = terminator;
+    context->bufferPtr = buffer;
+    context->bufferEnd = buffer + length + (hasTerminator ? 1 : 0);
+    return checkPushScalar(decodeScalar(context, value), hasTerminator, context, buffer + length);
+}
+
+/** Decode the number or literal (or the rest of it) that starts at *ptr.
+ * If it runs to the end of this chunk, it is kept for the next one.
+ */
+static int pushDecodeScalar(CrasheeJSONPushDecoder* const decoder,
+                            const char** const ptr,
+                            const char* const end)
+{
+    CrasheeJSONDecodeContext context =
+    {
+        .callbaccrashee = decoder->callbaccrashee,
+        .userData = decoder->userData,
+    };
+    ScalarValue value;
+    int result;
+    likely_if(decoder->pendingLength == 0)
+    {
+        // Usually the scalar is followed by something else in this chunk,
+        // and decodeScalar() stops right there.
+        context.bufferPtr = *ptr;
+        context.bufferEnd = end;
+        result = decodeScalar(&context, &value);
+        likely_if(result == CrasheeJSON_OK && context.bufferPtr < end && !isScalarChar(*context.bufferPtr))
+        {
+            *ptr = context.bufferPtr;
+            decoder->state = pushStateAfterValue(decoder);
+            return reportScalar(pushValueName(decoder), &value, &context);
+        }
+    }
+
+    const char* runEnd = *ptr;
+    while(runEnd < end && isScalarChar(*runEnd))
+    {
+        runEnd++;
+    }
+    likely_if(decoder->pendingLength == 0 && runEnd < end)
+    {
+        // Show decodeScalar() exactly what decodePendingScalar() would,
+        // so that the result doesn't depend on where the chunks are split.
+        context.bufferPtr = *ptr;
+        context.bufferEnd = runEnd + 1;
+        result = checkPushScalar(decodeScalar(&context, &value), true, &context, runEnd);
+        *ptr = context.bufferPtr;
+    }
+    else
+    {
+        const int length = (int)(runEnd - *ptr);
+        unlikely_if(decoder->pendingLength + length >= decoder->stringBufferLength)
+        {
+            CrasheeLOG_DEBUG("Number is too long");
+            return CrasheeJSON_ERROR_DATA_TOO_LONG;
+        }
+        memcpy(decoder->stringBuffer + decoder->pendingLength, *ptr, (size_t)length);
+        decoder->pendingLength += length;
+        *ptr = runEnd;
+        unlikely_if(runEnd >= end)
+        {
+            decoder->state = PushState_InScalar;
+            return CrasheeJSON_OK;
+        }
+        result = decodePendingScalar(decoder, true, *runEnd, &context, &value);
+    }
+    unlikely_if(result != CrasheeJSON_OK) return result;
+
+    decoder->state = pushStateAfterValue(decoder);
+    return reportScalar(pushValueName(decoder), &value, &context);
+}
+
+/** Continue skipping a container, up to and including its closing bracket. */
+static int pushSkipContainer(CrasheeJSONPushDecoder* const decoder,
+                             const char** const ptr,
+                             const char* const end)
+{
+    const char* src = *ptr;
+    while(src < end)
+    {
+        if(decoder->skipInString)
+        {
+            src = findPushStringEnd(decoder, src, end);
+            unlikely_if(src >= end)
+            {
+                break;
+            }
+            decoder->skipInString = false;
+            src++;
+            continue;
+        }
+        switch(*src++)
+        {
+            case '\"':
+                decoder->skipInString = true;
+                break;
+            case '[':
+            case '{':
+                decoder->skipDepth++;
+                break;
+            case ']':
+            case '}':
+                likely_if(--decoder->skipDepth > 0)
+                {
+                    break;
+                }
+                unlikely_if(src[-1] != decoder->skipClosingBracket)
+                {
+                    *ptr = src - 1;
+                    CrasheeLOG_DEBUG("Expected '%c' but got '%c'", decoder->skipClosingBracket, src[-1]);
+                    return CrasheeJSON_ERROR_INVALID_CHARACTER;
+                }
+                *ptr = src;
+                decoder->pendingHasEscapes = false;
+                decoder->state = pushStateAfterValue(decoder);
+                return CrasheeJSON_OK;
+        }
+    }
+    *ptr = end;
+    return CrasheeJSON_OK;
+}
+
+static int pushBeginContainer(CrasheeJSONPushDecoder* const decoder, const bool isObject)
+{
+    unlikely_if(decoder->depth >= CrasheeJSON_PUSH_DECODE_MAX_DEPTH)
+    {
+        CrasheeLOG_DEBUG("Containers are nested too deeply");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    const char* const name = pushValueName(decoder);
+    const int result = isObject ?
+        decoder->callbaccrashee->onBeginObject(name, decoder->userData) :
+        decoder->callbaccrashee->onBeginArray(name, decoder->userData);
+    if(result == CrasheeJSON_SKIP_CONTAINER)
+    {
+        decoder->state = PushState_Skipping;
+        decoder->skipDepth = 1;
+        decoder->skipInString = false;
+        decoder->skipClosingBracket = isObject ? '}' : ']';
+        return CrasheeJSON_OK;
+    }
+    decoder->isObject[decoder->depth++] = isObject;
+    decoder->state = isObject ? PushState_Name : PushState_Value;
+    return result;
+}
+
+static int pushEndContainer(CrasheeJSONPushDecoder* const decoder)
+{
+    decoder->depth--;
+    decoder->state = pushStateAfterValue(decoder);
+    return decoder->callbaccrashee->onEndContainer(decoder->userData);
+}
+
+/** Begin a push decode.
+ *
+ * @param topLevelName The name to report for the top level element.
+ */
+static void beginPushDecode(CrasheeJSONPushDecoder* const decoder,
+                            const char* const topLevelName,
+                            char* const stringBuffer,
+                            const int stringBufferLength,
+                            CrasheeJSONDecodeCallbaccrashee* const callbaccrashee,
+                            void* const userData)
+{
+    // Split the same way as crasheejson_decode().
+    const int nameBufferLength = stringBufferLength / 4;
+    decoder->callbaccrashee = callbaccrashee;
+    decoder->userData = userData;
+    decoder->topLevelName = topLevelName;
+    decoder->nameBuffer = stringBuffer;
+    decoder->nameBufferLength = nameBufferLength;
+    decoder->stringBuffer = stringBuffer + nameBufferLength;
+    decoder->stringBufferLength = stringBufferLength - nameBufferLength;
+    decoder->state = PushState_Value;
+    decoder->result = CrasheeJSON_OK;
+    decoder->offset = 0;
+    decoder->depth = 0;
+    decoder->pendingLength = 0;
+    decoder->pendingHasEscapes = false;
+    decoder->pendingEscape = false;
+    decoder->skipDepth = 0;
+    decoder->skipInString = false;
+    decoder->skipClosingBracket = '\0';
+}
+
+void crasheejson_beginPushDecode(CrasheeJSONPushDecoder* const decoder,
+                                 char* const stringBuffer,
+                                 const int stringBufferLength,
+                                 CrasheeJSONDecodeCallbaccrashee* const callbaccrashee,
+                                 void* const userData)
+{
+    beginPushDecode(decoder, NULL, stringBuffer, stringBufferLength, callbaccrashee, userData);
+}
+
+int crasheejson_feedPushDecoder(CrasheeJSONPushDecoder* const decoder,
+                                const char* const data,
+                                const int length)
+{
+    unlikely_if(decoder->result != CrasheeJSON_OK)
+    {
+        return decoder->result;
+    }
+
     const char* ptr = data;
+    const char* const end = data + length;
+    int result = CrasheeJSON_OK;
+    while(result == CrasheeJSON_OK && ptr < end)
+    {
+        switch(decoder->state)
+        {
+            case PushState_InName:
+                result = pushDecodeString(decoder, &ptr, end, true);
+                continue;
+            case PushState_InString:
+                result = pushDecodeString(decoder, &ptr, end, false);
+                continue;
+            case PushState_InScalar:
+                result = pushDecodeScalar(decoder, &ptr, end);
+                continue;
+            case PushState_Skipping:
+                result = pushSkipContainer(decoder, &ptr, end);
+                continue;
+            case PushState_Done:
+                ptr = end;
+                continue;
+        }
+
+        ptr = skipPushWhitespace(ptr, end);
+        unlikely_if(ptr >= end)
+        {
+            break;
+        }
+        char ch = *ptr;
+        const bool inObject = decoder->depth > 0 && decoder->isObject[decoder->depth - 1];
+
+        // The usual ', "name": value' sequence goes through in one pass.
+        switch(decoder->state)
+        {
+            case PushState_AfterValue:
+                likely_if(ch == ',')
+                {
+                    ptr = skipPushWhitespace(ptr + 1, end);
+                }
+                else if(ch == (inObject ? '}' : ']'))
+                {
+                    ptr++;
+                    result = pushEndContainer(decoder);
+                    continue;
+                }
+                // A missing ',' is tolerated, as in the other decoders.
+                decoder->state = inObject ? PushState_Name : PushState_Value;
+                unlikely_if(ptr >= end)
+                {
+                    continue;
+                }
+                ch = *ptr;
+                if(!inObject)
+                {
+                    break;
+                }
+                // Fall through.
+            case PushState_Name:
+                if(ch == '}')
+                {
+                    ptr++;
+                    result = pushEndContainer(decoder);
+                    continue;
+                }
+                unlikely_if(ch != '\"')
+                {
+                    CrasheeLOG_DEBUG("Expected '\"' but got '%c'", ch);
+                    result = CrasheeJSON_ERROR_INVALID_CHARACTER;
+                    continue;
+                }
+                ptr++;
+                result = pushDecodeString(decoder, &ptr, end, true);
+                unlikely_if(result != CrasheeJSON_OK || decoder->state != PushState_Colon)
+                {
+                    continue;
+                }
+                ptr = skipPushWhitespace(ptr, end);
+                unlikely_if(ptr >= end)
+                {
+                    continue;
+                }
+                ch = *ptr;
+                // Fall through.
+            case PushState_Colon:
+                unlikely_if(ch != ':')
+                {
+                    CrasheeLOG_DEBUG("Expected ':' but got '%c'", ch);
+                    result = CrasheeJSON_ERROR_INVALID_CHARACTER;
+                    continue;
+                }
+                ptr = skipPushWhitespace(ptr + 1, end);
+                decoder->state = PushState_Value;
+                unlikely_if(ptr >= end)
+                {
+                    continue;
+                }
+                ch = *ptr;
+                break;
+        }
+
+        switch(ch)
+        {
+            case '[':
+            case '{':
+                result = pushBeginContainer(decoder, ch == '{');
+                ptr++;
+                continue;
+            case '\"':
+                ptr++;
+                result = pushDecodeString(decoder, &ptr, end, false);
+                continue;
+            case ']':
+                likely_if(decoder->depth > 0 && !inObject)
+                {
+                    ptr++;
+                    result = pushEndContainer(decoder);
+                    continue;
+                }
+                break;
+        }
+        result = pushDecodeScalar(decoder, &ptr, end);
+    }
+
+    decoder->offset += (int)(ptr - data);
+    decoder->result = result;
+    return result;
+}
+
+int crasheejson_endPushDecode(CrasheeJSONPushDecoder* const decoder)
+{
+    int result = decoder->result;
+    likely_if(result == CrasheeJSON_OK && decoder->state == PushState_InScalar)
+    {
+        CrasheeJSONDecodeContext context =
+        {
+            .callbaccrashee = decoder->callbaccrashee,
+            .userData = decoder->userData,
+        };
+        ScalarValue value;
+        result = decodePendingScalar(decoder, false, '\0', &context, &value);
+        likely_if(result == CrasheeJSON_OK)
+        {
+            decoder->state = pushStateAfterValue(decoder);
+            result = reportScalar(pushValueName(decoder), &value, &context);
+        }
+    }
+    unlikely_if(result == CrasheeJSON_OK && decoder->state != PushState_Done)
+    {
+        CrasheeLOG_DEBUG("Premature end of data");
+        result = CrasheeJSON_ERROR_INCOMPLETE;
+    }
+    likely_if(result == CrasheeJSON_OK)
+    {
+        result = decoder->callbaccrashee->onEndData(decoder->userData);
+    }
+    decoder->result = result;
+    return result;
+}
+
+
+// ============================================================================
+#pragma mark - Structural Index -
+// ============================================================================
+
+/* crasheejson_decode() works in two stages:
+ *
+ * 1. Each 64-byte block of input is classified into bitmasks (quotes,
+ *    backslashes, whitespace, operators). From these, escaped characters and
+ *    string interiors are resolved with bit arithmetic, and the offsets of
+ *    all operators outside of strings, all unescaped quotes, and the first
+ *    character of every other value are appended to an index.
+ *
+ * 2. The parser walks the index rather than the input, so whitespace and
+ *    string contents are never visited one byte at a time.
+ *
+ * Stage 1 runs ahead of stage 2 in bounded batches so that no allocation is
+ * needed regardless of the input size.
+ *
+ * crasheejson_decodeSlices() always decodes this way, since the string
+ * positions fall out of stage 1 for free.
+ */
+
+/** Classification of one 64-byte block, one bit per byte. */
+typedef struct
+{
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t whitespace;
+    /** { } [ ] : , */
+    uint64_t op;
+} BlockMasks;
+
+typedef struct
+{
+    const char* data;
+    int length;
+    /** Offset of the next block to index. */
+    int scanOffset;
+    /** All ones if the last block indexed ended inside a string. */
+    uint64_t inStringCarry;
+    /** 1 if the first byte of the next block is escaped by a backslash. */
+    uint64_t escapeCarry;
+    /** 1 if the last block indexed ended in the middle of a value. */
+    uint64_t scalarCarry;
+    /** Offsets into data, in order. */
+    uint32_t positions[CrasheeJSONCODEC_StructuralIndexSize];
+    int positionCount;
+    int positionIndex;
+} StructuralIndex;
+
+#if CrasheeJSONCODEC_HAS_NEON
+/** Gather the top bit of each byte of four comparison results into a 64-bit mask. */
+static inline uint64_t neonMask64(const uint8x16_t m0, const uint8x16_t m1, const uint8x16_t m2, const uint8x16_t m3)
+{
+    const uint8x16_t bits = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                             0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, bits), vandq_u8(m1, bits));
+    const uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, bits), vandq_u8(m3, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+#endif
+
+/* Whitespace and operators are classified by looking up the low and high
+ * nybble of each byte in two 16-entry tables and ANDing the results:
+ *
+ *   0x01 '\t' - '\r'   high 0, low 9 - d
+ *   0x02 ' '           high 2, low 0
+ *   0x04 ','           high 2, low c
+ *   0x08 ':'           high 3, low a
+ *   0x10 [ ] { }       high 5 or 7, low b or d
+ */
+#define CLASS_WHITESPACE 0x03
+#define CLASS_OPERATOR 0x1c
+#define LOW_NYBBLE_CLASSES 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x09, 0x11, 0x05, 0x11, 0, 0
+#define HIGH_NYBBLE_CLASSES 0x01, 0, 0x06, 0x08, 0, 0x10, 0, 0x10, 0, 0, 0, 0, 0, 0, 0, 0
+
+static inline void classifyBlock(const char* const src, BlockMasks* const masks)
+{
+#if CrasheeJSONCODEC_HAS_AVX2
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i lowTable = _mm256_setr_epi8(LOW_NYBBLE_CLASSES, LOW_NYBBLE_CLASSES);
+    const __m256i highTable = _mm256_setr_epi8(HIGH_NYBBLE_CLASSES, HIGH_NYBBLE_CLASSES);
+    const __m256i nybbleMask = _mm256_set1_epi8(0x0f);
+    const __m256i whitespaceClass = _mm256_set1_epi8(CLASS_WHITESPACE);
+    const __m256i operatorClass = _mm256_set1_epi8(CLASS_OPERATOR);
+    const __m256i zero = _mm256_setzero_si256();
+    memset(masks, 0, sizeof(*masks));
+    for(int i = 0; i < 2; i++)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(src + i * 32));
+        const __m256i classes = _mm256_and_si256(_mm256_shuffle_epi8(lowTable, _mm256_and_si256(chunk, nybbleMask)),
+                                                 _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nybbleMask)));
+        const int shift = i * 32;
+        masks->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)) << shift;
+        masks->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)) << shift;
+        masks->whitespace |= (uint64_t)(uint32_t)~_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(classes, whitespaceClass), zero)) << shift;
+        masks->op |= (uint64_t)(uint32_t)~_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(classes, operatorClass), zero)) << shift;
+    }
+#elif CrasheeJSONCODEC_HAS_SSSE3
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lowTable = _mm_setr_epi8(LOW_NYBBLE_CLASSES);
+    const __m128i highTable = _mm_setr_epi8(HIGH_NYBBLE_CLASSES);
+    const __m128i nybbleMask = _mm_set1_epi8(0x0f);
+    const __m128i whitespaceClass = _mm_set1_epi8(CLASS_WHITESPACE);
+    const __m128i operatorClass = _mm_set1_epi8(CLASS_OPERATOR);
+    const __m128i zero = _mm_setzero_si128();
+    memset(masks, 0, sizeof(*masks));
+    for(int i = 0; i < 4; i++)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(src + i * 16));
+        const __m128i classes = _mm_and_si128(_mm_shuffle_epi8(lowTable, _mm_and_si128(chunk, nybbleMask)),
+                                              _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(chunk, 4), nybbleMask)));
+        const int shift = i * 16;
+        masks->quote |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) << shift;
+        masks->backslash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)) << shift;
+        masks->whitespace |= (uint64_t)(~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(classes, whitespaceClass), zero)) & 0xffff) << shift;
+        masks->op |= (uint64_t)(~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(classes, operatorClass), zero)) & 0xffff) << shift;
+    }
+#elif CrasheeJSONCODEC_HAS_SSE2
+    // No byte shuffle, so compare against each character instead.
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8(4);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    memset(masks, 0, sizeof(*masks));
+    for(int i = 0; i < 4; i++)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(src + i * 16));
+        // '\t' to '\r' are 9 to 13.
+        const __m128i fromTab = _mm_sub_epi8(chunk, tab);
+        const __m128i whitespace = _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                                _mm_cmpeq_epi8(_mm_min_epu8(fromTab, four), fromTab));
+        // '[' and ']' are '{' and '}' without the 0x20 bit.
+        const __m128i folded = _mm_or_si128(chunk, caseBit);
+        const __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace),
+                                                     _mm_cmpeq_epi8(folded, closeBrace)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(chunk, colon),
+                                                     _mm_cmpeq_epi8(chunk, comma)));
+        const int shift = i * 16;
+        masks->quote |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) << shift;
+        masks->backslash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)) << shift;
+        masks->whitespace |= (uint64_t)(uint32_t)_mm_movemask_epi8(whitespace) << shift;
+        masks->op |= (uint64_t)(uint32_t)_mm_movemask_epi8(op) << shift;
+    }
+#elif CrasheeJSONCODEC_HAS_NEON
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t lowTable = {LOW_NYBBLE_CLASSES};
+    const uint8x16_t highTable = {HIGH_NYBBLE_CLASSES};
+    const uint8x16_t nybbleMask = vdupq_n_u8(0x0f);
+    const uint8x16_t whitespaceClass = vdupq_n_u8(CLASS_WHITESPACE);
+    const uint8x16_t operatorClass = vdupq_n_u8(CLASS_OPERATOR);
+    uint8x16_t quotes[4];
+    uint8x16_t backslashes[4];
+    uint8x16_t whitespace[4];
+    uint8x16_t ops[4];
+    for(int i = 0; i < 4; i++)
+    {
+        const uint8x16_t chunk = vld1q_u8((const uint8_t*)src + i * 16);
+        const uint8x16_t classes = vandq_u8(vqtbl1q_u8(lowTable, vandq_u8(chunk, nybbleMask)),
+                                            vqtbl1q_u8(highTable, vshrq_n_u8(chunk, 4)));
+        quotes[i] = vceqq_u8(chunk, quote);
+        backslashes[i] = vceqq_u8(chunk, backslash);
+        whitespace[i] = vtstq_u8(classes, whitespaceClass);
+        ops[i] = vtstq_u8(classes, operatorClass);
+    }
+    masks->quote = neonMask64(quotes[0], quotes[1], quotes[2], quotes[3]);
+    masks->backslash = neonMask64(backslashes[0], backslashes[1], backslashes[2], backslashes[3]);
+    masks->whitespace = neonMask64(whitespace[0], whitespace[1], whitespace[2], whitespace[3]);
+    masks->op = neonMask64(ops[0], ops[1], ops[2], ops[3]);
+#else
+    memset(masks, 0, sizeof(*masks));
+    for(int i = 0; i < 64; i++)
+    {
+        const uint64_t bit = 1ULL << i;
+        switch(src[i])
+        {
+            case '\"':
+                masks->quote |= bit;
+                break;
+            case '\\':
+                masks->backslash |= bit;
+                break;
+            case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+                masks->whitespace |= bit;
+                break;
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                masks->op |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+#endif
+}
+
+/** Find the characters that are escaped by a preceding backslash.
+ * A backslash escapes the next character only if it ends an odd-length run.
+ *
+ * @param backslash Positions of all backslashes in the block.
+ *
+ * @param escapeCarry In: 1 if the first character is escaped. Out: Same for the next block.
+ *
+ * @return Positions of all escaped characters.
+ */
+static inline uint64_t findEscaped(uint64_t backslash, uint64_t* const escapeCarry)
+{
+    const uint64_t evenBits = 0x5555555555555555ULL;
+    const uint64_t escapedFirst = *escapeCarry;
+    likely_if(backslash == 0)
+    {
+        *escapeCarry = 0;
+        return escapedFirst;
+    }
+    backslash &= ~escapedFirst;
+    const uint64_t followsEscape = (backslash << 1) | escapedFirst;
+    // Adding the start of each run that begins on an odd bit to the run carries
+    // past its end, which flips the even/odd parity for the rest of that run.
+    const uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits;
+    *escapeCarry = __builtin_add_overflow(oddSequenceStarts, backslash, &sequencesStartingOnEvenBits) ? 1 : 0;
+    const uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+}
+
+/** Each bit of the result is the XOR of that bit and every bit below it. */
+static inline uint64_t prefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+static inline void indexBlock(StructuralIndex* const index, const char* const src)
+{
+    BlockMasks masks;
+    classifyBlock(src, &masks);
+
+    const uint64_t quotes = masks.quote & ~findEscaped(masks.backslash, &index->escapeCarry);
+    // Set from each opening quote up to (not including) its closing quote.
+    const uint64_t inString = prefixXor(quotes) ^ index->inStringCarry;
+    index->inStringCarry = (uint64_t)((int64_t)inString >> 63);
+
+    const uint64_t scalar = ~(masks.whitespace | masks.op | quotes | inString);
+    const uint64_t scalarStarts = scalar & ~((scalar << 1) | index->scalarCarry);
+    index->scalarCarry = scalar >> 63;
+
+    uint64_t structurals = (masks.op & ~inString) | quotes | scalarStarts;
+    const uint32_t base = (uint32_t)index->scanOffset;
+    uint32_t* dst = index->positions + index->positionCount;
+    while(structurals != 0)
+    {
+        *dst++ = base + (uint32_t)__builtin_ctzll(structurals);
+        structurals &= structurals - 1;
+    }
+    index->positionCount = (int)(dst - index->positions);
+}
+
+/** Replace the index contents with the next batch of positions.
+ * Afterwards, positionCount is 0 only if the end of the data was reached.
+ */
+static void fillStructuralIndex(StructuralIndex* const index)
+{
+    index->positionCount = 0;
+    index->positionIndex = 0;
+    while(index->scanOffset < index->length &&
+          index->positionCount <= CrasheeJSONCODEC_StructuralIndexSize - 64)
+    {
+        const char* block = index->data + index->scanOffset;
+        const int remaining = index->length - index->scanOffset;
+        char tail[64];
+        unlikely_if(remaining < 64)
+        {
+            // Whitespace padding can't change the meaning of what precedes it.
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, remaining);
+            block = tail;
+        }
+        indexBlock(index, block);
+        index->scanOffset += 64;
+    }
+}
+
+static inline int peekStructural(StructuralIndex* const index)
+{
+    unlikely_if(index->positionIndex >= index->positionCount)
+    {
+        fillStructuralIndex(index);
+        unlikely_if(index->positionCount == 0)
+        {
+            return -1;
+        }
+    }
+    return (int)index->positions[index->positionIndex];
+}
+
+static inline int nextStructural(StructuralIndex* const index)
+{
+    const int position = peekStructural(index);
+    index->positionIndex++;
+    return position;
+}
+
+static void initStructuralIndex(StructuralIndex* const index, const char* const data, const int length)
+{
+    // Not zero-initialized as a whole: the positions array is only read after being filled.
+    index->data = data;
+    index->length = length;
+    index->scanOffset = 0;
+    index->inStringCarry = 0;
+    index->escapeCarry = 0;
+    index->scalarCarry = 0;
+    index->positionCount = 0;
+    index->positionIndex = 0;
+}
+
+/** Skip to the end of the container whose opening bracket was the last indexed position.
+ * Strings are already excluded from the index, so this only needs to count brackets.
+ *
+ * @param context The decoding context. bufferPtr is left after the closing bracket.
+ *
+ * @param index The structural index.
+ *
+ * @param closingBracket The bracket that must close the container.
+ *
+ * @return CrasheeJSON_OK if successful.
+ */
+static int skipIndexedContainer(CrasheeJSONDecodeContext* const context,
+                                StructuralIndex* const index,
+                                const char closingBracket)
+{
+    const char* const data = index->data;
+    int depth = 1;
+    for(;;)
+    {
+        const int position = nextStructural(index);
+        unlikely_if(position < 0)
+        {
+            context->bufferPtr = context->bufferEnd;
+            CrasheeLOG_DEBUG("Premature end of data");
+            return CrasheeJSON_ERROR_INCOMPLETE;
+        }
+        switch(data[position])
+        {
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                likely_if(--depth > 0)
+                {
+                    break;
+                }
+                context->bufferPtr = data + position;
+                unlikely_if(data[position] != closingBracket)
+                {
+                    CrasheeLOG_DEBUG("Expected '%c' but got '%c'", closingBracket, data[position]);
+                    return CrasheeJSON_ERROR_INVALID_CHARACTER;
+                }
+                context->bufferPtr++;
+                return CrasheeJSON_OK;
+        }
+    }
+}
+
+/** Locate the contents of the string whose opening quote is at context->bufferPtr.
+ * The closing quote is the next indexed position.
+ */
+static inline int sliceIndexedString(CrasheeJSONDecodeContext* const context,
+                              StructuralIndex* const index,
+                              CrasheeJSONSlice* const slice)
+{
+    const char* const src = context->bufferPtr + 1;
+    const int endPosition = nextStructural(index);
+    unlikely_if(endPosition < 0)
+    {
+        context->bufferPtr = context->bufferEnd;
+        CrasheeLOG_DEBUG("Premature end of data");
+        return CrasheeJSON_ERROR_INCOMPLETE;
+    }
+    const char* const srcEnd = index->data + endPosition;
+    context->bufferPtr = srcEnd + 1;
+    slice->string = src;
+    slice->length = (int)(srcEnd - src);
+    // Inside a string, anything findNextEscape() stops at is a backslash or a raw control character.
+    slice->hasEscapes = findNextEscape(src, srcEnd) != srcEnd;
+    return CrasheeJSON_OK;
+}
+
+/** Decode the string whose opening quote is at context->bufferPtr into dstBuffer. */
+static int decodeIndexedString(CrasheeJSONDecodeContext* const context,
+                               StructuralIndex* const index,
+                               char* const dstBuffer,
+                               const int dstBufferLength)
+{
+    CrasheeJSONSlice slice;
+    const int result = sliceIndexedString(context, index, &slice);
+    unlikely_if(result != CrasheeJSON_OK) return result;
+    unlikely_if(slice.length >= dstBufferLength)
+    {
+        context->bufferPtr = slice.string - 1;
+        CrasheeLOG_DEBUG("String is too long");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    return unescapeString(slice.string, slice.string + slice.length, !slice.hasEscapes, dstBuffer);
+}
+
+static inline int reportSliceScalar(const CrasheeJSONSlice* const name,
+                             const ScalarValue* const value,
+                             CrasheeJSONDecodeContext* const context)
+{
+    switch(value->type)
+    {
+        case ScalarType_Boolean:
+            return context->sliceCallbaccrashee->onBooleanElement(name, value->asBoolean, context->userData);
+        case ScalarType_Integer:
+            return context->sliceCallbaccrashee->onIntegerElement(name, value->asInteger, context->userData);
+        case ScalarType_UnsignedInteger:
+            likely_if(context->sliceCallbaccrashee->onUnsignedIntegerElement != NULL)
+            {
+                return context->sliceCallbaccrashee->onUnsignedIntegerElement(name, value->asUnsignedInteger, context->userData);
+            }
+            return context->sliceCallbaccrashee->onFloatingPointElement(name, (double)value->asUnsignedInteger, context->userData);
+        case ScalarType_FloatingPoint:
+            return context->sliceCallbaccrashee->onFloatingPointElement(name, value->asFloatingPoint, context->userData);
+        case ScalarType_Null:
+        default:
+            return context->sliceCallbaccrashee->onNullElement(name, context->userData);
+    }
+}
+
+/** Check if a character ends a number or literal, i.e. is indexed separately or not at all. */
+static inline bool isValueTerminator(const char ch)
+{
+    switch(ch)
+    {
+        case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+        case '{': case '}': case '[': case ']': case ':': case ',': case '\"':
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Decode a complete document by walking the structural index.
+ * Produces the same callbacks (and accepts the same input) as the push decoder.
+ * If context->sliceCallbaccrashee is set, strings and names are reported as
+ * slices of the input instead of being decoded.
+ *
+ * @param context The decoding context. bufferPtr is left near any error.
+ *
+ * @param index The structural index, positioned at the start of the data.
+ *
+ * @return CrasheeJSON_OK if successful.
+ */
+static int decodeIndexedDocument(CrasheeJSONDecodeContext* const context, StructuralIndex* const index)
+{
+    CrasheeJSONDecodeCallbaccrashee* const callbaccrashee = context->callbaccrashee;
+    CrasheeJSONSliceDecodeCallbaccrashee* const sliceCallbaccrashee = context->sliceCallbaccrashee;
+    int (*const onEndContainer)(void* userData) = sliceCallbaccrashee != NULL ?
+        sliceCallbaccrashee->onEndContainer : callbaccrashee->onEndContainer;
+    void* const userData = context->userData;
+    const char* const data = index->data;
+    bool isObject[CrasheeJSONCODEC_MaxDecodeDepth];
+    int depth = 0;
+    const char* name = NULL;
+    CrasheeJSONSlice nameSlice;
+    const CrasheeJSONSlice* sliceName = NULL;
+    CrasheeJSONSlice valueSlice;
+    ScalarValue scalar;
+    int result;
+
+    for(;;)
+    {
+        int position = nextStructural(index);
+        unlikely_if(position < 0)
+        {
+            context->bufferPtr = context->bufferEnd;
+            CrasheeLOG_DEBUG("Premature end of data");
+            return CrasheeJSON_ERROR_INCOMPLETE;
+        }
+        context->bufferPtr = data + position;
+        bool afterValue = true;
+
+        switch(data[position])
+        {
+            case '[':
+            case '{':
+                unlikely_if(depth >= CrasheeJSONCODEC_MaxDecodeDepth)
+                {
+                    CrasheeLOG_DEBUG("Containers are nested too deeply");
+                    return CrasheeJSON_ERROR_DATA_TOO_LONG;
+                }
+                isObject[depth] = data[position] == '{';
+                context->bufferPtr++;
+                if(sliceCallbaccrashee != NULL)
+                {
+                    result = isObject[depth] ?
+                        sliceCallbaccrashee->onBeginObject(sliceName, userData) :
+                        sliceCallbaccrashee->onBeginArray(sliceName, userData);
+                }
+                else
+                {
+                    result = isObject[depth] ?
+                        callbaccrashee->onBeginObject(name, userData) :
+                        callbaccrashee->onBeginArray(name, userData);
+                }
+                if(result == CrasheeJSON_SKIP_CONTAINER)
+                {
+                    result = skipIndexedContainer(context, index, isObject[depth] ? '}' : ']');
+                    break;
+                }
+                depth++;
+                afterValue = false;
+                break;
+            case '\"':
+                if(sliceCallbaccrashee != NULL)
+                {
+                    result = sliceIndexedString(context, index, &valueSlice);
+                    unlikely_if(result != CrasheeJSON_OK) return result;
+                    result = sliceCallbaccrashee->onStringElement(sliceName, &valueSlice, userData);
+                    break;
+                }
+                result = decodeIndexedString(context, index, context->stringBuffer, context->stringBufferLength);
+                unlikely_if(result != CrasheeJSON_OK) return result;
+                result = callbaccrashee->onStringElement(name, context->stringBuffer, userData);
+                break;
+            default:
+                result = decodeScalar(context, &scalar);
+                unlikely_if(result != CrasheeJSON_OK) return result;
+                result = sliceCallbaccrashee != NULL ?
+                    reportSliceScalar(sliceName, &scalar, context) :
+                    reportScalar(name, &scalar, context);
+                unlikely_if(context->bufferPtr < context->bufferEnd && !isValueTerminator(*context->bufferPtr))
+                {
+                    // Only part of the run was consumed ("truex", "12abc"). The value has already
+                    // been reported. Hand the rest back to the index, reusing the slot just consumed,
+                    // so that it's parsed next and fails there, as nothing but a terminator may
+                    // follow a value.
+                    index->positions[--index->positionIndex] = (uint32_t)(context->bufferPtr - data);
+                }
+                break;
+        }
+        unlikely_if(result != CrasheeJSON_OK) return result;
+
+        // Close any finished containers and find where the next value belongs.
+        for(;;)
+        {
+            unlikely_if(depth == 0)
+            {
+                return CrasheeJSON_OK;
+            }
+            position = peekStructural(index);
+            unlikely_if(position < 0)
+            {
+                context->bufferPtr = context->bufferEnd;
+                CrasheeLOG_DEBUG("Premature end of data");
+                return CrasheeJSON_ERROR_INCOMPLETE;
+            }
+            context->bufferPtr = data + position;
+            const char ch = data[position];
+            if(afterValue && ch == ',')
+            {
+                index->positionIndex++;
+                afterValue = false;
+                continue;
+            }
+            if(ch == (isObject[depth - 1] ? '}' : ']'))
+            {
+                index->positionIndex++;
+                context->bufferPtr++;
+                depth--;
+                result = onEndContainer(userData);
+                unlikely_if(result != CrasheeJSON_OK) return result;
+                afterValue = true;
+                continue;
+            }
+            if(!isObject[depth - 1])
+            {
+                name = NULL;
+                sliceName = NULL;
+                break;
+            }
+
+            unlikely_if(ch != '\"')
+            {
+                CrasheeLOG_DEBUG("Expected '\"' but got '%c'", ch);
+                return CrasheeJSON_ERROR_INVALID_CHARACTER;
+            }
+            index->positionIndex++;
+            if(sliceCallbaccrashee != NULL)
+            {
+                result = sliceIndexedString(context, index, &nameSlice);
+                sliceName = &nameSlice;
+            }
+            else
+            {
+                result = decodeIndexedString(context, index, context->nameBuffer, context->nameBufferLength);
+                name = context->nameBuffer;
+            }
+            unlikely_if(result != CrasheeJSON_OK) return result;
+            position = nextStructural(index);
+            unlikely_if(position < 0)
+            {
+                context->bufferPtr = context->bufferEnd;
+                CrasheeLOG_DEBUG("Premature end of data");
+                return CrasheeJSON_ERROR_INCOMPLETE;
+            }
+            context->bufferPtr = data + position;
+            unlikely_if(data[position] != ':')
+            {
+                CrasheeLOG_DEBUG("Expected ':' but got '%c'", data[position]);
+                return CrasheeJSON_ERROR_INVALID_CHARACTER;
+            }
+            break;
+        }
+    }
+}
+
+int crasheejson_decode(const char* const data,
+                  int length,
+                  char* stringBuffer,
+                  int stringBufferLength,
+                  CrasheeJSONDecodeCallbaccrashee* const callbaccrashee,
+                  void* const userData,
+                  int* const errorOffset)
+{
+#if CrasheeJSONCODEC_UseStructuralIndex
+    char* nameBuffer = stringBuffer;
+    int nameBufferLength = stringBufferLength / 4;
+    stringBuffer = nameBuffer + nameBufferLength;
+    stringBufferLength -= nameBufferLength;
+    CrasheeJSONDecodeContext context =
+    {
+        .bufferPtr = (char*)data,
+        .bufferEnd = (char*)data + length,
+        .nameBuffer = nameBuffer,
+        .nameBufferLength = nameBufferLength,
+        .stringBuffer = stringBuffer,
+        .stringBufferLength = (int)stringBufferLength,
+        .callbaccrashee = callbaccrashee,
+        .userData = userData
+    };
+
+    StructuralIndex index;
+    initStructuralIndex(&index, data, length);
+    int result = decodeIndexedDocument(&context, &index);
+    likely_if(result == CrasheeJSON_OK)
+    {
+        result = callbaccrashee->onEndData(userData);
+    }
+
+    unlikely_if(result != CrasheeJSON_OK && errorOffset != NULL)
+    {
+        *errorOffset = (int)(context.bufferPtr - data);
+    }
+    return result;
+#else
+    CrasheeJSONPushDecoder decoder;
+    crasheejson_beginPushDecode(&decoder, stringBuffer, stringBufferLength, callbaccrashee, userData);
+    crasheejson_feedPushDecoder(&decoder, data, length);
+    const int result = crasheejson_endPushDecode(&decoder);
+    unlikely_if(result != CrasheeJSON_OK && errorOffset != NULL)
+    {
+        *errorOffset = decoder.offset;
+    }
+    return result;
+#endif
+}
+
+int crasheejson_decodeSlices(const char* const data,
+                             const int length,
+                             CrasheeJSONSliceDecodeCallbaccrashee* const callbaccrashee,
+                             void* const userData,
+                             int* const errorOffset)
+{
+    CrasheeJSONDecodeContext context =
+    {
+        .bufferPtr = data,
+        .bufferEnd = data + length,
+        .callbaccrashee = NULL,
+        .sliceCallbaccrashee = callbaccrashee,
+        .userData = userData
+    };
 
-    int result = decodeElement(NULL, &context);
+    StructuralIndex index;
+    initStructuralIndex(&index, data, length);
+    int result = decodeIndexedDocument(&context, &index);
     likely_if(result == CrasheeJSON_OK)
     {
         result = callbaccrashee->onEndData(userData);
@@ -1156,65 +2594,299 @@ int crasheejson_decode(const char* const data,
 
     unlikely_if(result != CrasheeJSON_OK && errorOffset != NULL)
     {
-        *errorOffset = (int)(ptr - data);
+        *errorOffset = (int)(context.bufferPtr - data);
     }
     return result;
 }
 
-struct JSONFromFileContext;
-typedef void (*UpdateDecoderCallback)(struct JSONFromFileContext* context);
+int crasheejson_unescapeSlice(const CrasheeJSONSlice* const slice,
+                              char* const dstBuffer,
+                              const int dstBufferLength)
+{
+    // Escape sequences only ever shrink when decoded.
+    unlikely_if(slice->length >= dstBufferLength)
+    {
+        CrasheeLOG_DEBUG("String is too long");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    return unescapeString(slice->string, slice->string + slice->length, !slice->hasEscapes, dstBuffer);
+}
+
+
+// ============================================================================
+#pragma mark - Path Subscription -
+// ============================================================================
 
-typedef struct JSONFromFileContext
+typedef enum
 {
-    CrasheeJSONEncodeContext* encodeContext;
-    CrasheeJSONDecodeContext* decodeContext;
-    char* bufferStart;
-    const char* sourceFilename;
-    int fd;
-    bool isEOF;
-    bool closeLastContainer;
-    UpdateDecoderCallback updateDecoderCallback;
-} JSONFromFileContext;
+    PathMatch_None,
+    PathMatch_Partial,
+    PathMatch_Full,
+} PathMatch;
 
-static void updateDecoder_doNothing(__unused struct JSONFromFileContext* context)
+typedef struct
 {
-    
+    /** The paths to decode. */
+    const char* const* paths;
+    /** The number of paths. */
+    int pathCount;
+    /** The callbaccrashee to pass the matching elements to. */
+    CrasheeJSONDecodeCallbaccrashee* callbaccrashee;
+    /** Data that was specified when calling crasheejson_decodePaths(). */
+    void* userData;
+    /** How many containers are open in the matched element being decoded (0 if none). */
+    int matchedDepth;
+    /** How many containers leading to a path are open. */
+    int depth;
+    /** For each container leading to a path, the paths that continue below it (one bit per path). */
+    uint64_t candidates[CrasheeJSONCODEC_MaxDecodeDepth + 1];
+} PathDecodeContext;
+
+/** Check if a name matches one component of a path.
+ *
+ * @param path The path.
+ *
+ * @param componentIndex The index of the component to compare against.
+ *
+ * @param name The element's name (NULL for array elements).
+ *
+ * @param isLast Set to true if the component is the path's last one.
+ *
+ * @return true if the name matches.
+ */
+static bool matchPathComponent(const char* path, int componentIndex, const char* const name, bool* const isLast)
+{
+    for(; componentIndex > 0; componentIndex--)
+    {
+        path = strchr(path, '/');
+        unlikely_if(path == NULL)
+        {
+            return false;
+        }
+        path++;
+    }
+    const char* const componentEnd = strchr(path, '/');
+    const size_t length = componentEnd != NULL ? (size_t)(componentEnd - path) : strlen(path);
+    *isLast = componentEnd == NULL;
+    if(length == 1 && *path == '*')
+    {
+        return true;
+    }
+    return name != NULL && strncmp(name, path, length) == 0 && name[length] == '\0';
 }
 
-static void updateDecoder_readFile(struct JSONFromFileContext* context)
+/** Match an element in the innermost open container against the paths that continue below it.
+ *
+ * @param context The path decoding context (depth must be > 0).
+ *
+ * @param name The element's name.
+ *
+ * @param candidates Set to the paths that continue below the element.
+ *
+ * @return How the element matched.
+ */
+static PathMatch matchPathElement(PathDecodeContext* const context, const char* const name, uint64_t* const candidates)
 {
-    likely_if(!context->isEOF)
+    const uint64_t parentCandidates = context->candidates[context->depth - 1];
+    *candidates = 0;
+    for(int i = 0; i < context->pathCount; i++)
     {
-        const char* end = context->decodeContext->bufferEnd;
-        char* start = context->bufferStart;
-        const char* ptr = context->decodeContext->bufferPtr;
-        int bufferLength = (int)(end - start);
-        int remainingLength = (int)(end - ptr);
-        unlikely_if(remainingLength < bufferLength / 2)
+        bool isLast;
+        if((parentCandidates & (1ull << i)) &&
+           matchPathComponent(context->paths[i], context->depth - 1, name, &isLast))
         {
-            int fillLength = bufferLength - remainingLength;
-            memcpy(start, ptr, remainingLength);
-            context->decodeContext->bufferPtr = start;
-            int bytesRead = (int)read(context->fd, start+remainingLength, (unsigned)fillLength);
-            unlikely_if(bytesRead < fillLength)
+            if(isLast)
             {
-                if(bytesRead < 0)
-                {
-                    CrasheeLOG_ERROR("Error reading file %s: %s", context->sourceFilename, strerror(errno));
-                }
-                context->isEOF = true;
+                return PathMatch_Full;
             }
+            *candidates |= 1ull << i;
+        }
+    }
+    return *candidates != 0 ? PathMatch_Partial : PathMatch_None;
+}
+
+/** Check if a scalar element is at (or inside) one of the paths. */
+static inline bool isOnPath(PathDecodeContext* const context, const char* const name)
+{
+    uint64_t candidates;
+    return context->matchedDepth > 0 ||
+        (context->depth > 0 && matchPathElement(context, name, &candidates) == PathMatch_Full);
+}
+
+static int pathDecode_onBeginContainer(const char* const name, PathDecodeContext* const context, const bool isObject)
+{
+    CrasheeJSONDecodeCallbaccrashee* const callbaccrashee = context->callbaccrashee;
+    int* openDepth = &context->matchedDepth;
+    if(context->matchedDepth == 0)
+    {
+        unlikely_if(context->depth > CrasheeJSONCODEC_MaxDecodeDepth)
+        {
+            CrasheeLOG_DEBUG("Containers are nested too deeply");
+            return CrasheeJSON_ERROR_DATA_TOO_LONG;
+        }
+        uint64_t candidates = context->pathCount == 64 ? ~0ull : (1ull << context->pathCount) - 1;
+        const PathMatch match = context->depth == 0 ?
+            PathMatch_Partial : matchPathElement(context, name, &candidates);
+        switch(match)
+        {
+            case PathMatch_None:
+                return CrasheeJSON_SKIP_CONTAINER;
+            case PathMatch_Partial:
+                context->candidates[context->depth] = candidates;
+                openDepth = &context->depth;
+                break;
+            case PathMatch_Full:
+                break;
+        }
+    }
+
+    const int result = isObject ?
+        callbaccrashee->onBeginObject(name, context->userData) :
+        callbaccrashee->onBeginArray(name, context->userData);
+    // A skipped container never ends, so don't count it as open.
+    likely_if(result != CrasheeJSON_SKIP_CONTAINER)
+    {
+        (*openDepth)++;
+    }
+    return result;
+}
+
+static int pathDecode_onBeginObject(const char* const name, void* const userData)
+{
+    return pathDecode_onBeginContainer(name, userData, true);
+}
+
+static int pathDecode_onBeginArray(const char* const name, void* const userData)
+{
+    return pathDecode_onBeginContainer(name, userData, false);
+}
+
+static int pathDecode_onEndContainer(void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    if(context->matchedDepth > 0)
+    {
+        context->matchedDepth--;
+    }
+    else
+    {
+        context->depth--;
+    }
+    return context->callbaccrashee->onEndContainer(context->userData);
+}
+
+static int pathDecode_onBooleanElement(const char* const name, const bool value, void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    unlikely_if(!isOnPath(context, name)) return CrasheeJSON_OK;
+    return context->callbaccrashee->onBooleanElement(name, value, context->userData);
+}
+
+static int pathDecode_onFloatingPointElement(const char* const name, const double value, void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    unlikely_if(!isOnPath(context, name)) return CrasheeJSON_OK;
+    return context->callbaccrashee->onFloatingPointElement(name, value, context->userData);
+}
+
+static int pathDecode_onIntegerElement(const char* const name, const int64_t value, void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    unlikely_if(!isOnPath(context, name)) return CrasheeJSON_OK;
+    return context->callbaccrashee->onIntegerElement(name, value, context->userData);
+}
+
+static int pathDecode_onUnsignedIntegerElement(const char* const name, const uint64_t value, void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    unlikely_if(!isOnPath(context, name)) return CrasheeJSON_OK;
+    return context->callbaccrashee->onUnsignedIntegerElement(name, value, context->userData);
+}
+
+static int pathDecode_onNullElement(const char* const name, void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    unlikely_if(!isOnPath(context, name)) return CrasheeJSON_OK;
+    return context->callbaccrashee->onNullElement(name, context->userData);
+}
+
+static int pathDecode_onStringElement(const char* const name, const char* const value, void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    unlikely_if(!isOnPath(context, name)) return CrasheeJSON_OK;
+    return context->callbaccrashee->onStringElement(name, value, context->userData);
+}
+
+static int pathDecode_onEndData(void* const userData)
+{
+    PathDecodeContext* const context = userData;
+    return context->callbaccrashee->onEndData(context->userData);
+}
+
+int crasheejson_decodePaths(const char* const data,
+                            const int length,
+                            char* const stringBuffer,
+                            const int stringBufferLength,
+                            const char* const* const paths,
+                            const int pathCount,
+                            CrasheeJSONDecodeCallbaccrashee* const callbaccrashee,
+                            void* const userData,
+                            int* const errorOffset)
+{
+    unlikely_if(pathCount < 0 || pathCount > CrasheeJSON_MAX_DECODE_PATHS)
+    {
+        CrasheeLOG_DEBUG("Too many paths: %d", pathCount);
+        return CrasheeJSON_ERROR_INVALID_DATA;
+    }
+    for(int i = 0; i < pathCount; i++)
+    {
+        if(*paths[i] == '\0')
+        {
+            return crasheejson_decode(data, length, stringBuffer, stringBufferLength,
+                                      callbaccrashee, userData, errorOffset);
         }
     }
+
+    PathDecodeContext context =
+    {
+        .paths = paths,
+        .pathCount = pathCount,
+        .callbaccrashee = callbaccrashee,
+        .userData = userData,
+        .matchedDepth = 0,
+        .depth = 0,
+    };
+    CrasheeJSONDecodeCallbaccrashee pathCallbaccrashee =
+    {
+        .onBeginArray = pathDecode_onBeginArray,
+        .onBeginObject = pathDecode_onBeginObject,
+        .onBooleanElement = pathDecode_onBooleanElement,
+        .onEndContainer = pathDecode_onEndContainer,
+        .onEndData = pathDecode_onEndData,
+        .onFloatingPointElement = pathDecode_onFloatingPointElement,
+        .onIntegerElement = pathDecode_onIntegerElement,
+        .onUnsignedIntegerElement = callbaccrashee->onUnsignedIntegerElement != NULL ?
+            pathDecode_onUnsignedIntegerElement : NULL,
+        .onNullElement = pathDecode_onNullElement,
+        .onStringElement = pathDecode_onStringElement,
+    };
+    return crasheejson_decode(data, length, stringBuffer, stringBufferLength,
+                              &pathCallbaccrashee, &context, errorOffset);
 }
 
+
+typedef struct
+{
+    CrasheeJSONEncodeContext* encodeContext;
+    bool closeLastContainer;
+} JSONFromFileContext;
+
 static int addJSONFromFile_onBooleanElement(const char* const name,
                                             const bool value,
                                             void* const userData)
 {
     JSONFromFileContext* context = (JSONFromFileContext*)userData;
     int result = crasheejson_addBooleanElement(context->encodeContext, name, value);
-    context->updateDecoderCallback(context);
     return result;
 }
 
@@ -1224,7 +2896,6 @@ static int addJSONFromFile_onFloatingPointElement(const char* const name,
 {
     JSONFromFileContext* context = (JSONFromFileContext*)userData;
     int result = crasheejson_addFloatingPointElement(context->encodeContext, name, value);
-    context->updateDecoderCallback(context);
     return result;
 }
 
@@ -1234,7 +2905,15 @@ static int addJSONFromFile_onIntegerElement(const char* const name,
 {
     JSONFromFileContext* context = (JSONFromFileContext*)userData;
     int result = crasheejson_addIntegerElement(context->encodeContext, name, value);
-    context->updateDecoderCallback(context);
+    return result;
+}
+
+static int addJSONFromFile_onUnsignedIntegerElement(const char* const name,
+                                                    const uint64_t value,
+                                                    void* const userData)
+{
+    JSONFromFileContext* context = (JSONFromFileContext*)userData;
+    int result = crasheejson_addUIntegerElement(context->encodeContext, name, value);
     return result;
 }
 
@@ -1243,7 +2922,6 @@ static int addJSONFromFile_onNullElement(const char* const name,
 {
     JSONFromFileContext* context = (JSONFromFileContext*)userData;
     int result = crasheejson_addNullElement(context->encodeContext, name);
-    context->updateDecoderCallback(context);
     return result;
 }
 
@@ -1253,7 +2931,6 @@ static int addJSONFromFile_onStringElement(const char* const name,
 {
     JSONFromFileContext* context = (JSONFromFileContext*)userData;
     int result = crasheejson_addStringElement(context->encodeContext, name, value, (int)strlen(value));
-    context->updateDecoderCallback(context);
     return result;
 }
 
@@ -1262,7 +2939,6 @@ static int addJSONFromFile_onBeginObject(const char* const name,
 {
     JSONFromFileContext* context = (JSONFromFileContext*)userData;
     int result = crasheejson_beginObject(context->encodeContext, name);
-    context->updateDecoderCallback(context);
     return result;
 }
 
@@ -1271,7 +2947,6 @@ static int addJSONFromFile_onBeginArray(const char* const name,
 {
     JSONFromFileContext* context = (JSONFromFileContext*)userData;
     int result = crasheejson_beginArray(context->encodeContext, name);
-    context->updateDecoderCallback(context);
     return result;
 }
 
@@ -1283,7 +2958,6 @@ static int addJSONFromFile_onEndContainer(void* const userData)
     {
         result = crasheejson_endContainer(context->encodeContext);
     }
-    context->updateDecoderCallback(context);
     return result;
 }
 
@@ -1292,58 +2966,69 @@ static int addJSONFromFile_onEndData(__unused void* const userData)
     return CrasheeJSON_OK;
 }
 
+static const CrasheeJSONDecodeCallbaccrashee g_addJSONFromFileCallbaccrashee =
+{
+    .onBeginArray = addJSONFromFile_onBeginArray,
+    .onBeginObject = addJSONFromFile_onBeginObject,
+    .onBooleanElement = addJSONFromFile_onBooleanElement,
+    .onEndContainer = addJSONFromFile_onEndContainer,
+    .onEndData = addJSONFromFile_onEndData,
+    .onFloatingPointElement = addJSONFromFile_onFloatingPointElement,
+    .onIntegerElement = addJSONFromFile_onIntegerElement,
+    .onUnsignedIntegerElement = addJSONFromFile_onUnsignedIntegerElement,
+    .onNullElement = addJSONFromFile_onNullElement,
+    .onStringElement = addJSONFromFile_onStringElement,
+};
+
 int crasheejson_addJSONFromFile(CrasheeJSONEncodeContext* const encodeContext,
                            const char* restrict const name,
                            const char* restrict const filename,
                            const bool closeLastContainer)
 {
-    CrasheeJSONDecodeCallbaccrashee callbaccrashee =
-    {
-        .onBeginArray = addJSONFromFile_onBeginArray,
-        .onBeginObject = addJSONFromFile_onBeginObject,
-        .onBooleanElement = addJSONFromFile_onBooleanElement,
-        .onEndContainer = addJSONFromFile_onEndContainer,
-        .onEndData = addJSONFromFile_onEndData,
-        .onFloatingPointElement = addJSONFromFile_onFloatingPointElement,
-        .onIntegerElement = addJSONFromFile_onIntegerElement,
-        .onNullElement = addJSONFromFile_onNullElement,
-        .onStringElement = addJSONFromFile_onStringElement,
-    };
-    char nameBuffer[100] = {0};
-    char stringBuffer[500] = {0};
-    char fileBuffer[1000] = {0};
-    CrasheeJSONDecodeContext decodeContext =
+    const int fd = open(filename, O_RDONLY);
+    unlikely_if(fd < 0)
     {
-        .bufferPtr = fileBuffer,
-        .bufferEnd = fileBuffer + sizeof(fileBuffer),
-        .nameBuffer = nameBuffer,
-        .nameBufferLength = sizeof(nameBuffer),
-        .stringBuffer = stringBuffer,
-        .stringBufferLength = sizeof(stringBuffer),
-        .callbaccrashee = &callbaccrashee,
-        .userData = NULL,
-    };
+        CrasheeLOG_ERROR("Could not open file %s: %s", filename, strerror(errno));
+        return CrasheeJSON_ERROR_INCOMPLETE;
+    }
 
-    int fd = open(filename, O_RDONLY);
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee = g_addJSONFromFileCallbaccrashee;
     JSONFromFileContext jsonContext =
     {
         .encodeContext = encodeContext,
-        .decodeContext = &decodeContext,
-        .bufferStart = fileBuffer,
-        .sourceFilename = filename,
-        .fd = fd,
         .closeLastContainer = closeLastContainer,
-        .isEOF = false,
-        .updateDecoderCallback = updateDecoder_readFile,
     };
-    decodeContext.userData = &jsonContext;
+    char stringBuffer[CrasheeJSONCODEC_AddJSONStringBufferSize];
+    char readBuffer[CrasheeJSONCODEC_FileReadBufferSize];
+    CrasheeJSONPushDecoder decoder;
+    beginPushDecode(&decoder, name, stringBuffer, sizeof(stringBuffer), &callbaccrashee, &jsonContext);
     int containerLevel = encodeContext->containerLevel;
 
-    // Manually trigger a data load.
-    decodeContext.bufferPtr = decodeContext.bufferEnd;
-    jsonContext.updateDecoderCallback(&jsonContext);
-
-    int result = decodeElement(name, &decodeContext);
+    int result = CrasheeJSON_OK;
+    for(;;)
+    {
+        const ssize_t bytesRead = read(fd, readBuffer, sizeof(readBuffer));
+        unlikely_if(bytesRead < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            CrasheeLOG_ERROR("Error reading file %s: %s", filename, strerror(errno));
+            result = CrasheeJSON_ERROR_INCOMPLETE;
+            break;
+        }
+        if(bytesRead == 0)
+        {
+            result = crasheejson_endPushDecode(&decoder);
+            break;
+        }
+        result = crasheejson_feedPushDecoder(&decoder, readBuffer, (int)bytesRead);
+        unlikely_if(result != CrasheeJSON_OK)
+        {
+            break;
+        }
+    }
     close(fd);
     while(closeLastContainer && encodeContext->containerLevel > containerLevel)
     {
@@ -1359,47 +3044,19 @@ int crasheejson_addJSONElement(CrasheeJSONEncodeContext* const encodeContext,
                           const int jsonDataLength,
                           const bool closeLastContainer)
 {
-    CrasheeJSONDecodeCallbaccrashee callbaccrashee =
-    {
-        .onBeginArray = addJSONFromFile_onBeginArray,
-        .onBeginObject = addJSONFromFile_onBeginObject,
-        .onBooleanElement = addJSONFromFile_onBooleanElement,
-        .onEndContainer = addJSONFromFile_onEndContainer,
-        .onEndData = addJSONFromFile_onEndData,
-        .onFloatingPointElement = addJSONFromFile_onFloatingPointElement,
-        .onIntegerElement = addJSONFromFile_onIntegerElement,
-        .onNullElement = addJSONFromFile_onNullElement,
-        .onStringElement = addJSONFromFile_onStringElement,
-    };
-    char nameBuffer[100] = {0};
-    char stringBuffer[5000] = {0};
-    CrasheeJSONDecodeContext decodeContext =
-    {
-        .bufferPtr = jsonData,
-        .bufferEnd = jsonData + jsonDataLength,
-        .nameBuffer = nameBuffer,
-        .nameBufferLength = sizeof(nameBuffer),
-        .stringBuffer = stringBuffer,
-        .stringBufferLength = sizeof(stringBuffer),
-        .callbaccrashee = &callbaccrashee,
-        .userData = NULL,
-    };
-    
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee = g_addJSONFromFileCallbaccrashee;
     JSONFromFileContext jsonContext =
     {
         .encodeContext = encodeContext,
-        .decodeContext = &decodeContext,
-        .bufferStart = (char*)jsonData,
-        .sourceFilename = NULL,
-        .fd = 0,
         .closeLastContainer = closeLastContainer,
-        .isEOF = false,
-        .updateDecoderCallback = updateDecoder_doNothing,
     };
-    decodeContext.userData = &jsonContext;
+    char stringBuffer[CrasheeJSONCODEC_AddJSONStringBufferSize];
+    CrasheeJSONPushDecoder decoder;
+    beginPushDecode(&decoder, name, stringBuffer, sizeof(stringBuffer), &callbaccrashee, &jsonContext);
     int containerLevel = encodeContext->containerLevel;
-    
-    int result = decodeElement(name, &decodeContext);
+
+    crasheejson_feedPushDecoder(&decoder, jsonData, jsonDataLength);
+    int result = crasheejson_endPushDecode(&decoder);
     while(closeLastContainer && encodeContext->containerLevel > containerLevel)
     {
         crasheejson_endContainer(encodeContext);
@@ -71,6 +71,13 @@ enum
      * semantic or structural reasons.
      */
     CrasheeJSON_ERROR_INVALID_DATA = 5,
+
+    /** Decoding: Not an error. Returned by the onBeginObject and onBeginArray
+     * callbaccrashee to have the decoder skip to the end of the container,
+     * without making any callbaccrashee for its contents or its end.
+     * The skipped contents are only checked for balanced brackets and quotes.
+     */
+    CrasheeJSON_SKIP_CONTAINER = 6,
 };
 
 /** Get a description for an error code.
@@ -99,6 +106,27 @@ const char* crasheejson_stringForError(const int error);
  */
 typedef int (*CrasheeJSONAddDataFunc)(const char* data, int length, void* userData);
 
+/** Longest element name that can be interned. */
+#define CrasheeJSON_INTERNED_NAME_MAX_LENGTH 39
+
+/** An element name with its encoded key form precomputed.
+ * Names must not require escaping.
+ */
+typedef struct
+{
+    /** The plain name. Must be the first field. */
+    char name[CrasheeJSON_INTERNED_NAME_MAX_LENGTH + 1];
+
+    /** The name quoted and followed by ": ". */
+    char quoted[CrasheeJSON_INTERNED_NAME_MAX_LENGTH + 5];
+
+    /** Length of the quoted form without the trailing space. */
+    uint8_t quotedLength;
+} CrasheeJSONInternedName;
+
+/** Static initializer for an interned name. NAME must be a string literal. */
+#define CrasheeJSON_INTERNED_NAME(NAME) { NAME, "\"" NAME "\": ", sizeof(NAME) + 2 }
+
 typedef struct
 {
     /** Function to call to add more encoded JSON data. */
@@ -118,6 +146,12 @@ typedef struct
 
     bool prettyPrint;
 
+    /** Table of names whose keys can be written without escaping. */
+    const CrasheeJSONInternedName* internedNames;
+
+    /** Number of entries in internedNames. */
+    int internedNameCount;
+
 } CrasheeJSONEncodeContext;
 
 
@@ -142,6 +176,20 @@ void crasheejson_beginEncode(CrasheeJSONEncodeContext* context,
  */
 int crasheejson_endEncode(CrasheeJSONEncodeContext* context);
 
+/** Register a table of interned element names.
+ * Any element name that points to the name field of an entry in this table
+ * is written using its precomputed key form.
+ *
+ * @param context The encoding context.
+ *
+ * @param names The table of names (must remain valid during encoding).
+ *
+ * @param count The number of entries in the table.
+ */
+void crasheejson_setInternedNames(CrasheeJSONEncodeContext* context,
+                             const CrasheeJSONInternedName* names,
+                             int count);
+
 /** Add a boolean element.
  *
  * @param context The encoding context.
@@ -413,7 +461,7 @@ int crasheejson_addJSONFromFile(CrasheeJSONEncodeContext* const context,
 
 /**
  * Callbaccrashee called during a JSON decode process.
- * All function pointers must point to valid functions.
+ * All function pointers except onUnsignedIntegerElement must point to valid functions.
  */
 typedef struct CrasheeJSONDecodeCallbaccrashee
 {
@@ -459,6 +507,21 @@ typedef struct CrasheeJSONDecodeCallbaccrashee
                             int64_t value,
                             void* userData);
 
+    /** Called when an integer element too large for int64_t is decoded.
+     * If NULL, such elements are passed to onFloatingPointElement instead.
+     *
+     * @param name The element's name.
+     *
+     * @param value The element's value.
+     *
+     * @param userData Data that was specified when calling crasheejson_decode().
+     *
+     * @return CrasheeJSON_OK if decoding should continue.
+     */
+    int (*onUnsignedIntegerElement)(const char* name,
+                                    uint64_t value,
+                                    void* userData);
+
     /** Called when a null element is decoded.
      *
      * @param name The element's name.
@@ -490,7 +553,8 @@ typedef struct CrasheeJSONDecodeCallbaccrashee
      *
      * @param userData Data that was specified when calling crasheejson_decode().
      *
-     * @return CrasheeJSON_OK if decoding should continue.
+     * @return CrasheeJSON_OK if decoding should continue, or
+     *         CrasheeJSON_SKIP_CONTAINER to skip over the object.
      */
     int (*onBeginObject)(const char* name,
                          void* userData);
@@ -501,7 +565,8 @@ typedef struct CrasheeJSONDecodeCallbaccrashee
      *
      * @param userData Data that was specified when calling crasheejson_decode().
      *
-     * @return CrasheeJSON_OK if decoding should continue.
+     * @return CrasheeJSON_OK if decoding should continue, or
+     *         CrasheeJSON_SKIP_CONTAINER to skip over the array.
      */
     int (*onBeginArray)(const char* name,
                         void* userData);
@@ -555,6 +620,261 @@ int crasheejson_decode(const char* data,
                   int* errorOffset);
 
 
+/**
+ * A string as it appears in the source data, without its surrounding quotes.
+ * The contents are not NUL terminated.
+ */
+typedef struct
+{
+    /** The first byte of the string's contents. */
+    const char* string;
+
+    /** The length of the contents in bytes, as encoded. */
+    int length;
+
+    /** If false, the contents contain no escape sequences and can be used as-is.
+     * Otherwise, use crasheejson_unescapeSlice() to get the actual string.
+     */
+    bool hasEscapes;
+} CrasheeJSONSlice;
+
+/**
+ * Callbaccrashee called during a crasheejson_decodeSlices() process.
+ * These match CrasheeJSONDecodeCallbaccrashee, except that names and string
+ * values are slices into the source data. Names are NULL for elements
+ * that are not in an object. Slices are only valid for the duration of the call.
+ * All function pointers except onUnsignedIntegerElement must point to valid functions.
+ */
+typedef struct CrasheeJSONSliceDecodeCallbaccrashee
+{
+    int (*onBooleanElement)(const CrasheeJSONSlice* name,
+                            bool value,
+                            void* userData);
+
+    int (*onFloatingPointElement)(const CrasheeJSONSlice* name,
+                                  double value,
+                                  void* userData);
+
+    int (*onIntegerElement)(const CrasheeJSONSlice* name,
+                            int64_t value,
+                            void* userData);
+
+    int (*onUnsignedIntegerElement)(const CrasheeJSONSlice* name,
+                                    uint64_t value,
+                                    void* userData);
+
+    int (*onNullElement)(const CrasheeJSONSlice* name,
+                         void* userData);
+
+    int (*onStringElement)(const CrasheeJSONSlice* name,
+                           const CrasheeJSONSlice* value,
+                           void* userData);
+
+    int (*onBeginObject)(const CrasheeJSONSlice* name,
+                         void* userData);
+
+    int (*onBeginArray)(const CrasheeJSONSlice* name,
+                        void* userData);
+
+    int (*onEndContainer)(void* userData);
+
+    int (*onEndData)(void* userData);
+
+} CrasheeJSONSliceDecodeCallbaccrashee;
+
+
+/** Decode JSON data without copying any strings.
+ *
+ * Unlike crasheejson_decode(), there is no limit on the length of strings or
+ * names. Escape sequences are not checked until a slice is unescaped.
+ *
+ * @param data UTF-8 encoded JSON data.
+ *
+ * @param length Length of the data.
+ *
+ * @param callbaccrashee The callbaccrashee to call while decoding.
+ *
+ * @param userData Any data you would like passed to the callbaccrashee.
+ *
+ * @param errorOffset If not null, will contain the offset into the data
+ *                    where the error (if any) occurred.
+ *
+ * @return CrasheeJSON_OK if succesful. An error code otherwise.
+ */
+int crasheejson_decodeSlices(const char* data,
+                             int length,
+                             CrasheeJSONSliceDecodeCallbaccrashee* callbaccrashee,
+                             void* userData,
+                             int* errorOffset);
+
+/** Decode the escape sequences in a slice produced by crasheejson_decodeSlices().
+ *
+ * @param slice The slice to unescape.
+ *
+ * @param dstBuffer Buffer to hold the NUL terminated result.
+ *
+ * @param dstBufferLength The length of the buffer. Must be greater than
+ *                        slice->length.
+ *
+ * @return CrasheeJSON_OK if succesful. An error code otherwise.
+ */
+int crasheejson_unescapeSlice(const CrasheeJSONSlice* slice,
+                              char* dstBuffer,
+                              int dstBufferLength);
+
+/** The most paths that can be passed to crasheejson_decodePaths(). */
+#define CrasheeJSON_MAX_DECODE_PATHS 64
+
+/** Decode only the parts of a JSON document that are at the specified paths.
+ *
+ * A path is a list of object member names separated by '/', starting at
+ * the top level container (e.g. "crash/error/signal"). A "*" component
+ * matches any name, as well as any array element. An empty path matches
+ * the entire document.
+ *
+ * Every element at a path, including the entire contents of a container,
+ * is passed to callbaccrashee. So are the containers leading to it, so the
+ * callbaccrashee see a well formed document. Everything else is skipped
+ * without being decoded.
+ *
+ * @param data UTF-8 encoded JSON data.
+ *
+ * @param length Length of the data.
+ *
+ * @param stringBuffer A buffer to use for decoding strings (as in crasheejson_decode()).
+ *
+ * @param stringBufferLength The length of the string buffer.
+ *
+ * @param paths The paths to decode.
+ *
+ * @param pathCount The number of paths (at most CrasheeJSON_MAX_DECODE_PATHS).
+ *
+ * @param callbaccrashee The callbaccrashee to call while decoding.
+ *
+ * @param userData Any data you would like passed to the callbaccrashee.
+ *
+ * @param errorOffset If not null, will contain the offset into the data
+ *                    where the error (if any) occurred.
+ *
+ * @return CrasheeJSON_OK if succesful. An error code otherwise.
+ */
+int crasheejson_decodePaths(const char* data,
+                            int length,
+                            char* stringBuffer,
+                            int stringBufferLength,
+                            const char* const* paths,
+                            int pathCount,
+                            CrasheeJSONDecodeCallbaccrashee* callbaccrashee,
+                            void* userData,
+                            int* errorOffset);
+
+/** The deepest container nesting that a push decoder will accept. */
+#define CrasheeJSON_PUSH_DECODE_MAX_DEPTH 512
+
+/**
+ * State of an incremental decode, for data that arrives in pieces.
+ * Contains no pointers to the data, so it can be fed chunks from a reused buffer.
+ * All fields are private, except where noted.
+ */
+typedef struct
+{
+    /** The callbaccrashee to call while decoding. */
+    CrasheeJSONDecodeCallbaccrashee* callbaccrashee;
+
+    /** Data that was specified when calling crasheejson_beginPushDecode(). */
+    void* userData;
+
+    /** The name to report for the top level element. */
+    const char* topLevelName;
+
+    /** Buffer for decoding names. */
+    char* nameBuffer;
+    int nameBufferLength;
+
+    /** Buffer for decoding strings, and for numbers split across chunks. */
+    char* stringBuffer;
+    int stringBufferLength;
+
+    /** What is expected next in the input. */
+    int state;
+
+    /** The result of the last call. Once an error occurs, it is returned for all further calls. */
+    int result;
+
+    /** Public: The number of bytes consumed so far. If an error occurred, its offset. */
+    int offset;
+
+    /** How many containers deep we are. */
+    int depth;
+
+    /** Whether or not each open container is an object. */
+    bool isObject[CrasheeJSON_PUSH_DECODE_MAX_DEPTH];
+
+    /** Bytes of a string or scalar that was split across chunks. */
+    int pendingLength;
+
+    /** The pending string contains escape sequences. */
+    bool pendingHasEscapes;
+
+    /** The last chunk ended in a backslash. */
+    bool pendingEscape;
+
+    /** How many containers deep we are inside a skipped container. */
+    int skipDepth;
+
+    /** The skip scan is inside a string. */
+    bool skipInString;
+
+    /** The bracket that must end the skipped container. */
+    char skipClosingBracket;
+} CrasheeJSONPushDecoder;
+
+/** Begin decoding JSON data that will be passed in pieces to crasheejson_feedPushDecoder().
+ * Tokens (including strings) can be split anywhere across pieces.
+ * Containers are tracked in the decoder rather than by recursion.
+ *
+ * @param decoder The decoder to initialize.
+ *
+ * @param stringBuffer A buffer to use for decoding strings (as in crasheejson_decode()).
+ *                     Must remain valid until the decode is finished.
+ *
+ * @param stringBufferLength The length of the string buffer.
+ *
+ * @param callbaccrashee The callbaccrashee to call while decoding.
+ *
+ * @param userData Any data you would like passed to the callbaccrashee.
+ */
+void crasheejson_beginPushDecode(CrasheeJSONPushDecoder* decoder,
+                                 char* stringBuffer,
+                                 int stringBufferLength,
+                                 CrasheeJSONDecodeCallbaccrashee* callbaccrashee,
+                                 void* userData);
+
+/** Decode the next piece of JSON data, making callbaccrashee as elements complete.
+ *
+ * @param decoder The decoder.
+ *
+ * @param data The next piece of UTF-8 encoded JSON data. Not referenced after
+ *             this call returns.
+ *
+ * @param length Length of the data.
+ *
+ * @return CrasheeJSON_OK if succesful. An error code otherwise.
+ */
+int crasheejson_feedPushDecoder(CrasheeJSONPushDecoder* decoder,
+                                const char* data,
+                                int length);
+
+/** Finish decoding, and call onEndData.
+ *
+ * @param decoder The decoder.
+ *
+ * @return CrasheeJSON_OK if succesful. CrasheeJSON_ERROR_INCOMPLETE if the data
+ *         ended before the top level element did. Any earlier error otherwise.
+ */
+int crasheejson_endPushDecode(CrasheeJSONPushDecoder* decoder);
+
+
 #ifdef __cplusplus
 }
 #endif
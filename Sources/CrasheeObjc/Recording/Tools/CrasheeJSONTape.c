@@ -0,0 +1,779 @@
+//
+//  CrasheeJSONTape.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+
+#include "CrasheeJSONTape.h"
+#include "CrasheeJSONCodec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//#define CrasheeLogger_LocalLevel TRACE
+#include "CrasheeLogger.h"
+
+#define likely_if(x) if(__builtin_expect(x,1))
+#define unlikely_if(x) if(__builtin_expect(x,0))
+
+
+// ============================================================================
+#pragma mark - Entries -
+// ============================================================================
+
+/* Every entry holds its type in the top 8 bits, and a 56-bit payload:
+ *
+ * - Null: Unused.
+ * - Boolean: 1 or 0.
+ * - Integer, UnsignedInteger, FloatingPoint: Unused. The next entry holds
+ *   the raw 64-bit value.
+ * - String: The string's offset into the strings block in the low 32 bits,
+ *   and its length in the upper 24.
+ * - Object, Array: The index of the entry after the matching EndContainer in
+ *   the low 32 bits, and the number of values in the upper 24 (saturating).
+ * - EndContainer: The index of the matching Object or Array entry.
+ */
+
+#define TYPE_SHIFT 56
+#define PAYLOAD_MASK ((1ull << TYPE_SHIFT) - 1)
+#define LOW_MASK 0xffffffffull
+#define HIGH_SHIFT 32
+#define HIGH_MASK 0xffffffull
+
+/** The longest string that fits in an entry. */
+#define MAX_STRING_LENGTH ((int)HIGH_MASK)
+
+/** Containers with this many values or more have to be counted. */
+#define COUNT_SATURATED ((int)HIGH_MASK)
+
+static inline uint64_t makeEntry(const CrasheeJSONTapeType type, const uint64_t payload)
+{
+    return ((uint64_t)type << TYPE_SHIFT) | (payload & PAYLOAD_MASK);
+}
+
+static inline CrasheeJSONTapeType entryType(const CrasheeJSONTape* const tape, const int index)
+{
+    return (CrasheeJSONTapeType)(tape->entries[index] >> TYPE_SHIFT);
+}
+
+static inline uint64_t entryPayload(const CrasheeJSONTape* const tape, const int index)
+{
+    return tape->entries[index] & PAYLOAD_MASK;
+}
+
+static inline bool isContainer(const CrasheeJSONTapeType type)
+{
+    return type == CrasheeJSONTapeType_Object || type == CrasheeJSONTapeType_Array;
+}
+
+static inline bool isNumber(const CrasheeJSONTapeType type)
+{
+    return type >= CrasheeJSONTapeType_Integer && type <= CrasheeJSONTapeType_FloatingPoint;
+}
+
+/** The index of the entry following a value, and everything it contains. */
+static inline int indexAfterValue(const CrasheeJSONTape* const tape, const int index)
+{
+    switch(entryType(tape, index))
+    {
+        case CrasheeJSONTapeType_Object:
+        case CrasheeJSONTapeType_Array:
+            return (int)(entryPayload(tape, index) & LOW_MASK);
+        case CrasheeJSONTapeType_Integer:
+        case CrasheeJSONTapeType_UnsignedInteger:
+        case CrasheeJSONTapeType_FloatingPoint:
+            return index + 2;
+        default:
+            return index + 1;
+    }
+}
+
+
+// ============================================================================
+#pragma mark - Building -
+// ============================================================================
+
+typedef struct
+{
+    CrasheeJSONTape* tape;
+    int entryCapacity;
+    int stringsCapacity;
+
+    /** The innermost open container, or -1. While a container is open, its
+     * entry holds the index of the container it's in, instead of its end.
+     */
+    int container;
+} TapeBuilder;
+
+/** Make sure the arena is at least a certain size. Its contents are lost. */
+static bool reserveArena(CrasheeJSONTape* const tape, const size_t size)
+{
+    likely_if(tape->arenaSize >= size)
+    {
+        return true;
+    }
+    free(tape->arena);
+    tape->arena = malloc(size);
+    tape->arenaSize = tape->arena == NULL ? 0 : size;
+    return tape->arena != NULL;
+}
+
+/** Lay out the entries and strings in the arena. */
+static void useArena(TapeBuilder* const builder, const int entryCapacity)
+{
+    CrasheeJSONTape* const tape = builder->tape;
+    const size_t entriesSize = (size_t)entryCapacity * sizeof(*tape->entries);
+    const size_t stringsSize = tape->arenaSize - entriesSize;
+    tape->entries = tape->arena;
+    tape->strings = (char*)tape->arena + entriesSize;
+    builder->entryCapacity = entryCapacity;
+    builder->stringsCapacity = stringsSize > INT32_MAX ? INT32_MAX : (int)stringsSize;
+}
+
+/** Move everything to a bigger arena, with room for more entries or strings. */
+static int growArena(TapeBuilder* const builder, const int entriesNeeded, const int stringsNeeded)
+{
+    CrasheeJSONTape* const tape = builder->tape;
+    int entryCapacity = builder->entryCapacity;
+    int stringsCapacity = builder->stringsCapacity;
+    while(entryCapacity - tape->entryCount < entriesNeeded)
+    {
+        unlikely_if(entryCapacity > INT32_MAX / 16)
+        {
+            CrasheeLOG_ERROR("Document is too large");
+            return CrasheeJSON_ERROR_DATA_TOO_LONG;
+        }
+        entryCapacity *= 2;
+    }
+    while(stringsCapacity - tape->stringsLength < stringsNeeded)
+    {
+        unlikely_if(stringsCapacity > INT32_MAX / 2)
+        {
+            CrasheeLOG_ERROR("Document is too large");
+            return CrasheeJSON_ERROR_DATA_TOO_LONG;
+        }
+        stringsCapacity *= 2;
+    }
+
+    const size_t entriesSize = (size_t)entryCapacity * sizeof(*tape->entries);
+    const size_t size = entriesSize + (size_t)stringsCapacity;
+    char* const arena = malloc(size);
+    unlikely_if(arena == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate memory");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    memcpy(arena, tape->entries, (size_t)tape->entryCount * sizeof(*tape->entries));
+    memcpy(arena + entriesSize, tape->strings, (size_t)tape->stringsLength);
+    free(tape->arena);
+    tape->arena = arena;
+    tape->arenaSize = size;
+    useArena(builder, entryCapacity);
+    return CrasheeJSON_OK;
+}
+
+static inline int reserveEntries(TapeBuilder* const builder, const int count)
+{
+    unlikely_if(builder->entryCapacity - builder->tape->entryCount < count)
+    {
+        return growArena(builder, count, 0);
+    }
+    return CrasheeJSON_OK;
+}
+
+/** Add the string entry for a name or a string value. */
+static int addString(TapeBuilder* const builder, const CrasheeJSONSlice* const slice)
+{
+    CrasheeJSONTape* const tape = builder->tape;
+    unlikely_if(slice->length > MAX_STRING_LENGTH)
+    {
+        CrasheeLOG_DEBUG("String is too long");
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    int result = reserveEntries(builder, 1);
+    unlikely_if(result != CrasheeJSON_OK) return result;
+    unlikely_if(builder->stringsCapacity - tape->stringsLength <= slice->length)
+    {
+        result = growArena(builder, 0, slice->length + 1);
+        unlikely_if(result != CrasheeJSON_OK) return result;
+    }
+
+    char* const dst = tape->strings + tape->stringsLength;
+    int length = slice->length;
+    likely_if(!slice->hasEscapes)
+    {
+        memcpy(dst, slice->string, (size_t)length);
+        dst[length] = '\0';
+    }
+    else
+    {
+        result = crasheejson_unescapeSlice(slice, dst, builder->stringsCapacity - tape->stringsLength);
+        unlikely_if(result != CrasheeJSON_OK) return result;
+        // An escaped NUL ends the string early, as it would for any C string.
+        length = (int)strlen(dst);
+    }
+    const uint64_t payload = (uint64_t)tape->stringsLength | ((uint64_t)length << HIGH_SHIFT);
+    tape->stringsLength += length + 1;
+    tape->entries[tape->entryCount++] = makeEntry(CrasheeJSONTapeType_String, payload);
+    return CrasheeJSON_OK;
+}
+
+/** Start adding a value: add its name if it has one, and count it in its container. */
+static int beginValue(TapeBuilder* const builder, const CrasheeJSONSlice* const name, const int entryCount)
+{
+    CrasheeJSONTape* const tape = builder->tape;
+    if(name != NULL)
+    {
+        const int result = addString(builder, name);
+        unlikely_if(result != CrasheeJSON_OK) return result;
+    }
+    likely_if(builder->container >= 0)
+    {
+        const uint64_t entry = tape->entries[builder->container];
+        likely_if(((entry >> HIGH_SHIFT) & HIGH_MASK) < HIGH_MASK)
+        {
+            tape->entries[builder->container] = entry + (1ull << HIGH_SHIFT);
+        }
+    }
+    return reserveEntries(builder, entryCount);
+}
+
+static int addScalar(TapeBuilder* const builder,
+                     const CrasheeJSONSlice* const name,
+                     const CrasheeJSONTapeType type,
+                     const uint64_t value)
+{
+    const int entryCount = isNumber(type) ? 2 : 1;
+    const int result = beginValue(builder, name, entryCount);
+    unlikely_if(result != CrasheeJSON_OK) return result;
+    CrasheeJSONTape* const tape = builder->tape;
+    if(entryCount == 2)
+    {
+        tape->entries[tape->entryCount++] = makeEntry(type, 0);
+        tape->entries[tape->entryCount++] = value;
+    }
+    else
+    {
+        tape->entries[tape->entryCount++] = makeEntry(type, value);
+    }
+    return CrasheeJSON_OK;
+}
+
+static int beginContainer(TapeBuilder* const builder,
+                          const CrasheeJSONSlice* const name,
+                          const CrasheeJSONTapeType type)
+{
+    const int result = beginValue(builder, name, 1);
+    unlikely_if(result != CrasheeJSON_OK) return result;
+    CrasheeJSONTape* const tape = builder->tape;
+    const int index = tape->entryCount++;
+    tape->entries[index] = makeEntry(type, (uint32_t)builder->container);
+    builder->container = index;
+    return CrasheeJSON_OK;
+}
+
+static int onBooleanElement(const CrasheeJSONSlice* const name, const bool value, void* const userData)
+{
+    return addScalar(userData, name, CrasheeJSONTapeType_Boolean, value ? 1 : 0);
+}
+
+static int onFloatingPointElement(const CrasheeJSONSlice* const name, const double value, void* const userData)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return addScalar(userData, name, CrasheeJSONTapeType_FloatingPoint, bits);
+}
+
+static int onIntegerElement(const CrasheeJSONSlice* const name, const int64_t value, void* const userData)
+{
+    return addScalar(userData, name, CrasheeJSONTapeType_Integer, (uint64_t)value);
+}
+
+static int onUnsignedIntegerElement(const CrasheeJSONSlice* const name, const uint64_t value, void* const userData)
+{
+    return addScalar(userData, name, CrasheeJSONTapeType_UnsignedInteger, value);
+}
+
+static int onNullElement(const CrasheeJSONSlice* const name, void* const userData)
+{
+    return addScalar(userData, name, CrasheeJSONTapeType_Null, 0);
+}
+
+static int onStringElement(const CrasheeJSONSlice* const name, const CrasheeJSONSlice* const value, void* const userData)
+{
+    const int result = beginValue(userData, name, 0);
+    unlikely_if(result != CrasheeJSON_OK) return result;
+    return addString(userData, value);
+}
+
+static int onBeginObject(const CrasheeJSONSlice* const name, void* const userData)
+{
+    return beginContainer(userData, name, CrasheeJSONTapeType_Object);
+}
+
+static int onBeginArray(const CrasheeJSONSlice* const name, void* const userData)
+{
+    return beginContainer(userData, name, CrasheeJSONTapeType_Array);
+}
+
+static int onEndContainer(void* const userData)
+{
+    TapeBuilder* const builder = userData;
+    int result = reserveEntries(builder, 1);
+    unlikely_if(result != CrasheeJSON_OK) return result;
+    CrasheeJSONTape* const tape = builder->tape;
+    const int start = builder->container;
+    const int endIndex = tape->entryCount++;
+    tape->entries[endIndex] = makeEntry(CrasheeJSONTapeType_EndContainer, (uint64_t)start);
+
+    const uint64_t entry = tape->entries[start];
+    builder->container = (int32_t)(uint32_t)(entry & LOW_MASK);
+    tape->entries[start] = (entry & ~LOW_MASK) | (uint64_t)(endIndex + 1);
+    return CrasheeJSON_OK;
+}
+
+static int onEndData(__unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+void crasheetape_init(CrasheeJSONTape* const tape)
+{
+    memset(tape, 0, sizeof(*tape));
+}
+
+void crasheetape_free(CrasheeJSONTape* const tape)
+{
+    free(tape->arena);
+    crasheetape_init(tape);
+}
+
+int crasheetape_parse(CrasheeJSONTape* const tape, const char* const data, const int length, int* const errorOffset)
+{
+    static CrasheeJSONSliceDecodeCallbaccrashee callbaccrashee =
+    {
+        .onBooleanElement = onBooleanElement,
+        .onFloatingPointElement = onFloatingPointElement,
+        .onIntegerElement = onIntegerElement,
+        .onUnsignedIntegerElement = onUnsignedIntegerElement,
+        .onNullElement = onNullElement,
+        .onStringElement = onStringElement,
+        .onBeginObject = onBeginObject,
+        .onBeginArray = onBeginArray,
+        .onEndContainer = onEndContainer,
+        .onEndData = onEndData,
+    };
+
+    tape->entryCount = 0;
+    tape->stringsLength = 0;
+    if(errorOffset != NULL)
+    {
+        *errorOffset = 0;
+    }
+
+    // Crash reports take well over four bytes per entry (mostly names and
+    // indentation), and unescaped strings are never longer than the source.
+    // Anything denser grows the entries as it goes.
+    const int entryCapacity = length / 4 + 16;
+    const size_t size = (size_t)entryCapacity * sizeof(*tape->entries) + (size_t)length + 1;
+    unlikely_if(!reserveArena(tape, size))
+    {
+        CrasheeLOG_ERROR("Could not allocate %zu bytes for a JSON tape", size);
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+
+    TapeBuilder builder =
+    {
+        .tape = tape,
+        .container = -1,
+    };
+    useArena(&builder, entryCapacity);
+    const int result = crasheejson_decodeSlices(data, length, &callbaccrashee, &builder, errorOffset);
+    unlikely_if(result != CrasheeJSON_OK)
+    {
+        tape->entryCount = 0;
+        tape->stringsLength = 0;
+    }
+    return result;
+}
+
+bool crasheetape_root(const CrasheeJSONTape* const tape, CrasheeJSONTapeCursor* const cursor)
+{
+    unlikely_if(tape->entryCount == 0)
+    {
+        return false;
+    }
+    cursor->tape = tape;
+    cursor->index = 0;
+    cursor->nameIndex = -1;
+    return true;
+}
+
+CrasheeJSONTapeType crasheetape_type(const CrasheeJSONTapeCursor* const cursor)
+{
+    return entryType(cursor->tape, cursor->index);
+}
+
+const char* crasheetape_name(const CrasheeJSONTapeCursor* const cursor)
+{
+    if(cursor->nameIndex < 0)
+    {
+        return NULL;
+    }
+    return cursor->tape->strings + (entryPayload(cursor->tape, cursor->nameIndex) & LOW_MASK);
+}
+
+int crasheetape_count(const CrasheeJSONTapeCursor* const cursor)
+{
+    unlikely_if(!isContainer(crasheetape_type(cursor)))
+    {
+        return 0;
+    }
+    const int count = (int)((entryPayload(cursor->tape, cursor->index) >> HIGH_SHIFT) & HIGH_MASK);
+    likely_if(count < COUNT_SATURATED)
+    {
+        return count;
+    }
+
+    CrasheeJSONTapeCursor child;
+    int counted = 0;
+    if(crasheetape_firstChild(cursor, &child))
+    {
+        do
+        {
+            counted++;
+        } while(crasheetape_next(&child));
+    }
+    return counted;
+}
+
+bool crasheetape_firstChild(const CrasheeJSONTapeCursor* const container, CrasheeJSONTapeCursor* const child)
+{
+    const CrasheeJSONTape* const tape = container->tape;
+    const CrasheeJSONTapeType type = crasheetape_type(container);
+    unlikely_if(!isContainer(type))
+    {
+        return false;
+    }
+    const int index = container->index + 1;
+    if(entryType(tape, index) == CrasheeJSONTapeType_EndContainer)
+    {
+        return false;
+    }
+    child->tape = tape;
+    if(type == CrasheeJSONTapeType_Object)
+    {
+        child->nameIndex = index;
+        child->index = index + 1;
+    }
+    else
+    {
+        child->nameIndex = -1;
+        child->index = index;
+    }
+    return true;
+}
+
+bool crasheetape_next(CrasheeJSONTapeCursor* const cursor)
+{
+    const CrasheeJSONTape* const tape = cursor->tape;
+    const int index = indexAfterValue(tape, cursor->index);
+    if(index >= tape->entryCount || entryType(tape, index) == CrasheeJSONTapeType_EndContainer)
+    {
+        return false;
+    }
+    if(cursor->nameIndex >= 0)
+    {
+        cursor->nameIndex = index;
+        cursor->index = index + 1;
+    }
+    else
+    {
+        cursor->index = index;
+    }
+    return true;
+}
+
+/** Check if a string entry holds a certain name. */
+static inline bool entryHasName(const CrasheeJSONTape* const tape, const int index, const char* const name, const int length)
+{
+    const uint64_t payload = entryPayload(tape, index);
+    return (int)((payload >> HIGH_SHIFT) & HIGH_MASK) == length &&
+           memcmp(tape->strings + (payload & LOW_MASK), name, (size_t)length) == 0;
+}
+
+bool crasheetape_find(const CrasheeJSONTapeCursor* const object, const char* const name, CrasheeJSONTapeCursor* const value)
+{
+    unlikely_if(crasheetape_type(object) != CrasheeJSONTapeType_Object)
+    {
+        return false;
+    }
+    const int length = (int)strlen(name);
+    CrasheeJSONTapeCursor child;
+    if(crasheetape_firstChild(object, &child))
+    {
+        do
+        {
+            if(entryHasName(child.tape, child.nameIndex, name, length))
+            {
+                *value = child;
+                return true;
+            }
+        } while(crasheetape_next(&child));
+    }
+    return false;
+}
+
+bool crasheetape_at(const CrasheeJSONTapeCursor* const array, int index, CrasheeJSONTapeCursor* const value)
+{
+    unlikely_if(crasheetape_type(array) != CrasheeJSONTapeType_Array || index < 0)
+    {
+        return false;
+    }
+    CrasheeJSONTapeCursor child;
+    if(!crasheetape_firstChild(array, &child))
+    {
+        return false;
+    }
+    while(index-- > 0)
+    {
+        if(!crasheetape_next(&child))
+        {
+            return false;
+        }
+    }
+    *value = child;
+    return true;
+}
+
+/** Check if a JSON pointer reference token (with ~0 and ~1 escapes) matches a name entry. */
+static bool tokenMatchesName(const CrasheeJSONTape* const tape,
+                             const int index,
+                             const char* token,
+                             const char* const tokenEnd)
+{
+    const uint64_t payload = entryPayload(tape, index);
+    const char* name = tape->strings + (payload & LOW_MASK);
+    const char* const nameEnd = name + ((payload >> HIGH_SHIFT) & HIGH_MASK);
+    while(token < tokenEnd)
+    {
+        char ch = *token++;
+        if(ch == '~')
+        {
+            ch = *token++ == '0' ? '~' : '/';
+        }
+        if(name >= nameEnd || *name++ != ch)
+        {
+            return false;
+        }
+    }
+    return name == nameEnd;
+}
+
+/** Parse an array index in a JSON pointer: digits, with no leading zeroes. */
+static bool parseTokenIndex(const char* token, const char* const tokenEnd, int* const index)
+{
+    const int length = (int)(tokenEnd - token);
+    unlikely_if(length == 0 || length > 9 || (length > 1 && *token == '0'))
+    {
+        return false;
+    }
+    int value = 0;
+    for(; token < tokenEnd; token++)
+    {
+        unlikely_if(*token < '0' || *token > '9')
+        {
+            return false;
+        }
+        value = value * 10 + (*token - '0');
+    }
+    *index = value;
+    return true;
+}
+
+bool crasheetape_pointer(const CrasheeJSONTapeCursor* const start,
+                         const char* pointer,
+                         CrasheeJSONTapeCursor* const value)
+{
+    CrasheeJSONTapeCursor cursor = *start;
+    while(*pointer != '\0')
+    {
+        unlikely_if(*pointer != '/')
+        {
+            CrasheeLOG_DEBUG("JSON pointer doesn't start with '/': %s", pointer);
+            return false;
+        }
+        const char* const token = pointer + 1;
+        const char* tokenEnd = token;
+        while(*tokenEnd != '\0' && *tokenEnd != '/')
+        {
+            unlikely_if(*tokenEnd == '~' && tokenEnd[1] != '0' && tokenEnd[1] != '1')
+            {
+                CrasheeLOG_DEBUG("Invalid escape in JSON pointer: %s", pointer);
+                return false;
+            }
+            tokenEnd++;
+        }
+        pointer = tokenEnd;
+
+        switch(crasheetape_type(&cursor))
+        {
+            case CrasheeJSONTapeType_Object:
+            {
+                CrasheeJSONTapeCursor child;
+                bool found = false;
+                if(crasheetape_firstChild(&cursor, &child))
+                {
+                    do
+                    {
+                        found = tokenMatchesName(child.tape, child.nameIndex, token, tokenEnd);
+                    } while(!found && crasheetape_next(&child));
+                }
+                if(!found)
+                {
+                    return false;
+                }
+                cursor = child;
+                break;
+            }
+            case CrasheeJSONTapeType_Array:
+            {
+                int index;
+                if(!parseTokenIndex(token, tokenEnd, &index) || !crasheetape_at(&cursor, index, &cursor))
+                {
+                    return false;
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    *value = cursor;
+    return true;
+}
+
+bool crasheetape_getBoolean(const CrasheeJSONTapeCursor* const cursor, bool* const value)
+{
+    unlikely_if(crasheetape_type(cursor) != CrasheeJSONTapeType_Boolean)
+    {
+        return false;
+    }
+    *value = entryPayload(cursor->tape, cursor->index) != 0;
+    return true;
+}
+
+bool crasheetape_getInteger(const CrasheeJSONTapeCursor* const cursor, int64_t* const value)
+{
+    const CrasheeJSONTapeType type = crasheetape_type(cursor);
+    unlikely_if(!isNumber(type))
+    {
+        return false;
+    }
+    const uint64_t raw = cursor->tape->entries[cursor->index + 1];
+    switch(type)
+    {
+        case CrasheeJSONTapeType_Integer:
+            *value = (int64_t)raw;
+            return true;
+        case CrasheeJSONTapeType_UnsignedInteger:
+            unlikely_if(raw > INT64_MAX)
+            {
+                return false;
+            }
+            *value = (int64_t)raw;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool crasheetape_getUnsignedInteger(const CrasheeJSONTapeCursor* const cursor, uint64_t* const value)
+{
+    const CrasheeJSONTapeType type = crasheetape_type(cursor);
+    unlikely_if(!isNumber(type))
+    {
+        return false;
+    }
+    const uint64_t raw = cursor->tape->entries[cursor->index + 1];
+    switch(type)
+    {
+        case CrasheeJSONTapeType_Integer:
+            unlikely_if((int64_t)raw < 0)
+            {
+                return false;
+            }
+            *value = raw;
+            return true;
+        case CrasheeJSONTapeType_UnsignedInteger:
+            *value = raw;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool crasheetape_getFloatingPoint(const CrasheeJSONTapeCursor* const cursor, double* const value)
+{
+    const CrasheeJSONTapeType type = crasheetape_type(cursor);
+    unlikely_if(!isNumber(type))
+    {
+        return false;
+    }
+    const uint64_t raw = cursor->tape->entries[cursor->index + 1];
+    switch(type)
+    {
+        case CrasheeJSONTapeType_Integer:
+            *value = (double)(int64_t)raw;
+            return true;
+        case CrasheeJSONTapeType_UnsignedInteger:
+            *value = (double)raw;
+            return true;
+        case CrasheeJSONTapeType_FloatingPoint:
+            memcpy(value, &raw, sizeof(*value));
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool crasheetape_getString(const CrasheeJSONTapeCursor* const cursor, const char** const value, int* const length)
+{
+    unlikely_if(crasheetape_type(cursor) != CrasheeJSONTapeType_String)
+    {
+        return false;
+    }
+    const uint64_t payload = entryPayload(cursor->tape, cursor->index);
+    *value = cursor->tape->strings + (payload & LOW_MASK);
+    if(length != NULL)
+    {
+        *length = (int)((payload >> HIGH_SHIFT) & HIGH_MASK);
+    }
+    return true;
+}
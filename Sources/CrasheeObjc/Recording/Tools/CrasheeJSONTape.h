@@ -0,0 +1,246 @@
+//
+//  CrasheeJSONTape.h
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+
+/* A parsed JSON document that can be walked in any order.
+ *
+ * crasheetape_parse() decodes a document once into a tape: a flat array of
+ * tagged 64-bit entries, in document order, and a block of unescaped strings
+ * that the entries refer to by offset. Both live in a single arena owned by
+ * the tape, which is reused by the next parse into the same tape.
+ *
+ * A cursor points at one value on the tape. Containers know where they end,
+ * so moving to the next sibling, looking up an object member or following a
+ * JSON pointer never looks at the contents of the containers it passes.
+ */
+
+
+#ifndef HDR_CrasheeJSONTape_h
+#define HDR_CrasheeJSONTape_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+typedef enum
+{
+    CrasheeJSONTapeType_Null,
+    CrasheeJSONTapeType_Boolean,
+    CrasheeJSONTapeType_Integer,
+    /** A positive integer too large for int64_t. */
+    CrasheeJSONTapeType_UnsignedInteger,
+    CrasheeJSONTapeType_FloatingPoint,
+    CrasheeJSONTapeType_String,
+    CrasheeJSONTapeType_Object,
+    CrasheeJSONTapeType_Array,
+    /** The end of an object or array. Cursors never point here. */
+    CrasheeJSONTapeType_EndContainer,
+} CrasheeJSONTapeType;
+
+typedef struct
+{
+    /** The entries, in document order. Each holds its type in the top 8 bits.
+     * Numbers are followed by an entry holding their raw 64-bit value.
+     * Object members are a string entry for the name, followed by the value.
+     */
+    uint64_t* entries;
+    int entryCount;
+
+    /** The NUL terminated strings that entries refer to. */
+    char* strings;
+    int stringsLength;
+
+    /** The memory holding the entries and strings. */
+    void* arena;
+    size_t arenaSize;
+} CrasheeJSONTape;
+
+typedef struct
+{
+    const CrasheeJSONTape* tape;
+
+    /** The value's entry. */
+    int index;
+
+    /** The entry holding the value's name, or -1 if it's not in an object. */
+    int nameIndex;
+} CrasheeJSONTapeCursor;
+
+
+/** Initialize an empty tape. */
+void crasheetape_init(CrasheeJSONTape* tape);
+
+/** Free the memory held by a tape. The tape can be parsed into again afterwards.
+ *
+ * @param tape The tape.
+ */
+void crasheetape_free(CrasheeJSONTape* tape);
+
+/** Parse a JSON document into a tape, replacing whatever it held before.
+ * The tape doesn't refer to the data afterwards.
+ *
+ * @param tape The tape to fill. Must have been initialized.
+ *
+ * @param data UTF-8 encoded JSON data.
+ *
+ * @param length Length of the data.
+ *
+ * @param errorOffset If not null, will contain the offset into the data
+ *                    where the error (if any) occurred.
+ *
+ * @return CrasheeJSON_OK if succesful. An error code otherwise.
+ *         The tape is empty if parsing failed.
+ */
+int crasheetape_parse(CrasheeJSONTape* tape, const char* data, int length, int* errorOffset);
+
+/** Get a cursor pointing at the top level value.
+ *
+ * @param tape The tape.
+ *
+ * @param cursor Filled in with the cursor.
+ *
+ * @return false if the tape is empty.
+ */
+bool crasheetape_root(const CrasheeJSONTape* tape, CrasheeJSONTapeCursor* cursor);
+
+/** Get the type of the value a cursor points at. */
+CrasheeJSONTapeType crasheetape_type(const CrasheeJSONTapeCursor* cursor);
+
+/** Get the name of the object member a cursor points at.
+ *
+ * @return The name, or NULL if the value isn't in an object.
+ */
+const char* crasheetape_name(const CrasheeJSONTapeCursor* cursor);
+
+/** Get the number of values in an object or array.
+ *
+ * @return The count, or 0 if the cursor doesn't point at a container.
+ */
+int crasheetape_count(const CrasheeJSONTapeCursor* cursor);
+
+/** Get the first value in an object or array.
+ *
+ * @param container A cursor pointing at the container.
+ *
+ * @param child Filled in with a cursor pointing at the first value.
+ *
+ * @return false if the container is empty, or isn't a container.
+ */
+bool crasheetape_firstChild(const CrasheeJSONTapeCursor* container, CrasheeJSONTapeCursor* child);
+
+/** Move a cursor to the next value in the same object or array.
+ *
+ * @param cursor The cursor to move. Left unchanged if there is no next value.
+ *
+ * @return false if the cursor was at the last value.
+ */
+bool crasheetape_next(CrasheeJSONTapeCursor* cursor);
+
+/** Look up an object member by name.
+ *
+ * @param object A cursor pointing at the object.
+ *
+ * @param name The member's name.
+ *
+ * @param value Filled in with a cursor pointing at the member's value.
+ *
+ * @return false if there is no such member, or object isn't an object.
+ */
+bool crasheetape_find(const CrasheeJSONTapeCursor* object, const char* name, CrasheeJSONTapeCursor* value);
+
+/** Get a value in an array by position.
+ *
+ * @param array A cursor pointing at the array.
+ *
+ * @param index The position of the value.
+ *
+ * @param value Filled in with a cursor pointing at the value.
+ *
+ * @return false if index is out of range, or array isn't an array.
+ */
+bool crasheetape_at(const CrasheeJSONTapeCursor* array, int index, CrasheeJSONTapeCursor* value);
+
+/** Follow a JSON pointer (RFC 6901), such as "/crash/threads/0/backtrace".
+ * "~1" in a reference token stands for '/', and "~0" for '~'.
+ *
+ * @param start A cursor pointing at the value to start from.
+ *
+ * @param pointer The JSON pointer. "" refers to start itself.
+ *
+ * @param value Filled in with a cursor pointing at the value referred to.
+ *
+ * @return false if the pointer is malformed or doesn't refer to anything.
+ */
+bool crasheetape_pointer(const CrasheeJSONTapeCursor* start, const char* pointer, CrasheeJSONTapeCursor* value);
+
+/** Get a boolean value.
+ *
+ * @return false if the value isn't a boolean.
+ */
+bool crasheetape_getBoolean(const CrasheeJSONTapeCursor* cursor, bool* value);
+
+/** Get an integer value. Unsigned integers that fit are also accepted.
+ *
+ * @return false if the value isn't an integer, or doesn't fit.
+ */
+bool crasheetape_getInteger(const CrasheeJSONTapeCursor* cursor, int64_t* value);
+
+/** Get an unsigned integer value. Non-negative integers are also accepted.
+ *
+ * @return false if the value isn't an integer, or is negative.
+ */
+bool crasheetape_getUnsignedInteger(const CrasheeJSONTapeCursor* cursor, uint64_t* value);
+
+/** Get a floating point value. Integers are converted.
+ *
+ * @return false if the value isn't a number.
+ */
+bool crasheetape_getFloatingPoint(const CrasheeJSONTapeCursor* cursor, double* value);
+
+/** Get a string value.
+ *
+ * @param cursor The cursor.
+ *
+ * @param value Filled in with the NUL terminated string, which lives as long as the tape's contents.
+ *
+ * @param length If not null, filled in with the length of the string in bytes.
+ *
+ * @return false if the value isn't a string.
+ */
+bool crasheetape_getString(const CrasheeJSONTapeCursor* cursor, const char** value, int* length);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeJSONTape_h
@@ -0,0 +1,738 @@
+//
+//  CrasheeLZ.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "CrasheeLZ.h"
+#include "CrasheeFileUtils.h"
+
+//#define CrasheeLogger_LocalLevel TRACE
+#include "CrasheeLogger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// Compiler hints for "if" statements
+#define likely_if(x) if(__builtin_expect(x,1))
+#define unlikely_if(x) if(__builtin_expect(x,0))
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MATCH_FIND_LIMIT 12
+#define RUN_MASK 15
+#define FRAME_STORED_FLAG 0x80000000u
+
+static const uint8_t g_magic[CrasheeLZ_MAGIC_LENGTH] = {0x89, 'C', 'L', 'Z'};
+static const uint8_t g_dictionaryMagic[CrasheeLZ_MAGIC_LENGTH] = {0x89, 'C', 'L', 'D'};
+
+
+// ============================================================================
+#pragma mark - Utility -
+// ============================================================================
+
+static inline uint32_t read32(const uint8_t* const ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hash32(const uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - CrasheeLZ_HASH_BITS);
+}
+
+static inline void writeLE32(uint8_t* const dst, const uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint32_t readLE32(const uint8_t* const src)
+{
+    return (uint32_t)src[0] | (uint32_t)src[1] << 8 | (uint32_t)src[2] << 16 | (uint32_t)src[3] << 24;
+}
+
+/** Count how many bytes match, stopping at limit. */
+static inline int matchLength(const uint8_t* ip, const uint8_t* match, const uint8_t* const limit)
+{
+    const uint8_t* const start = ip;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while(ip + 8 <= limit)
+    {
+        uint64_t a;
+        uint64_t b;
+        memcpy(&a, ip, sizeof(a));
+        memcpy(&b, match, sizeof(b));
+        const uint64_t diff = a ^ b;
+        if(diff != 0)
+        {
+            return (int)(ip - start) + (__builtin_ctzll(diff) >> 3);
+        }
+        ip += 8;
+        match += 8;
+    }
+#endif
+    while(ip < limit && *ip == *match)
+    {
+        ip++;
+        match++;
+    }
+    return (int)(ip - start);
+}
+
+/** Write an LZ4 length extension (the part beyond the 4-bit token field). */
+static inline uint8_t* writeLengthExtension(uint8_t* op, int length)
+{
+    for(; length >= 255; length -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+
+// ============================================================================
+#pragma mark - Block Codec -
+// ============================================================================
+
+/** Compress the data from start to srcEnd. Matches can reach back as far as
+ * base, so whatever lies between base and start (such as a dictionary) acts
+ * as history. srcEnd - base must be at most CrasheeLZ_BLOCK_SIZE.
+ */
+static int compressWithHistory(const uint8_t* const base,
+                               const uint8_t* const start,
+                               const uint8_t* const srcEnd,
+                               char* const dst,
+                               const int dstCapacity,
+                               uint16_t* const hashTable)
+{
+    memset(hashTable, 0, sizeof(*hashTable) << CrasheeLZ_HASH_BITS);
+    for(const uint8_t* ptr = base; ptr + 4 <= start; ptr++)
+    {
+        hashTable[hash32(read32(ptr))] = (uint16_t)(ptr - base);
+    }
+
+    const uint8_t* const matchFindLimit = srcEnd - MATCH_FIND_LIMIT;
+    const uint8_t* const matchLimit = srcEnd - LAST_LITERALS;
+    const uint8_t* ip = start;
+    const uint8_t* anchor = start;
+    uint8_t* op = (uint8_t*)dst;
+    uint8_t* const dstEnd = op + dstCapacity;
+
+    if(srcEnd - start > MATCH_FIND_LIMIT)
+    {
+        ip++;
+        while(ip < matchFindLimit)
+        {
+            // Find a match, skipping ahead faster the longer we go without one.
+            const uint8_t* match;
+            unsigned searchCount = 1 << 6;
+            for(;;)
+            {
+                const uint32_t hash = hash32(read32(ip));
+                match = base + hashTable[hash];
+                hashTable[hash] = (uint16_t)(ip - base);
+                if(read32(match) == read32(ip) && match < ip)
+                {
+                    break;
+                }
+                ip += searchCount++ >> 6;
+                if(ip >= matchFindLimit)
+                {
+                    goto lastLiterals;
+                }
+            }
+
+            while(ip > anchor && match > base && ip[-1] == match[-1])
+            {
+                ip--;
+                match--;
+            }
+
+            const int literalLength = (int)(ip - anchor);
+            const int extraMatch = matchLength(ip + MIN_MATCH, match + MIN_MATCH, matchLimit);
+
+            // token + literal length + literals + offset + match length
+            unlikely_if(op + 1 + literalLength / 255 + 1 + literalLength + 2 + extraMatch / 255 + 1 > dstEnd)
+            {
+                return 0;
+            }
+
+            uint8_t* const token = op++;
+            if(literalLength >= RUN_MASK)
+            {
+                *token = RUN_MASK << 4;
+                op = writeLengthExtension(op, literalLength - RUN_MASK);
+            }
+            else
+            {
+                *token = (uint8_t)(literalLength << 4);
+            }
+            memcpy(op, anchor, (size_t)literalLength);
+            op += literalLength;
+
+            const uint32_t offset = (uint32_t)(ip - match);
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+
+            if(extraMatch >= RUN_MASK)
+            {
+                *token |= RUN_MASK;
+                op = writeLengthExtension(op, extraMatch - RUN_MASK);
+            }
+            else
+            {
+                *token |= (uint8_t)extraMatch;
+            }
+
+            ip += MIN_MATCH + extraMatch;
+            anchor = ip;
+            if(ip >= matchFindLimit)
+            {
+                break;
+            }
+            hashTable[hash32(read32(ip - 2))] = (uint16_t)(ip - 2 - base);
+        }
+    }
+
+lastLiterals:
+    {
+        const int literalLength = (int)(srcEnd - anchor);
+        unlikely_if(op + 1 + literalLength / 255 + 1 + literalLength > dstEnd)
+        {
+            return 0;
+        }
+        if(literalLength >= RUN_MASK)
+        {
+            *op++ = RUN_MASK << 4;
+            op = writeLengthExtension(op, literalLength - RUN_MASK);
+        }
+        else
+        {
+            *op++ = (uint8_t)(literalLength << 4);
+        }
+        memcpy(op, anchor, (size_t)literalLength);
+        op += literalLength;
+    }
+    return (int)(op - (uint8_t*)dst);
+}
+
+/** Decompress a block into dst. Matches can reach back as far as history,
+ * which is dst or somewhere before it.
+ */
+static int decompressWithHistory(const char* const src,
+                                 const int srcLength,
+                                 const char* const history,
+                                 char* const dst,
+                                 const int dstCapacity)
+{
+    const uint8_t* ip = (const uint8_t*)src;
+    const uint8_t* const srcEnd = ip + srcLength;
+    uint8_t* op = (uint8_t*)dst;
+    uint8_t* const dstEnd = op + dstCapacity;
+
+    while(ip < srcEnd)
+    {
+        const unsigned token = *ip++;
+
+        int literalLength = (int)(token >> 4);
+        if(literalLength == RUN_MASK)
+        {
+            unsigned extension;
+            do
+            {
+                unlikely_if(ip >= srcEnd || literalLength > srcLength)
+                {
+                    return -1;
+                }
+                extension = *ip++;
+                literalLength += (int)extension;
+            } while(extension == 255);
+        }
+        unlikely_if(literalLength > srcEnd - ip || literalLength > dstEnd - op)
+        {
+            return -1;
+        }
+        memcpy(op, ip, (size_t)literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        if(ip >= srcEnd)
+        {
+            // The last sequence has literals only.
+            break;
+        }
+
+        unlikely_if(srcEnd - ip < 2)
+        {
+            return -1;
+        }
+        const int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        unlikely_if(offset == 0 || offset > op - (const uint8_t*)history)
+        {
+            return -1;
+        }
+
+        int length = (int)(token & RUN_MASK);
+        if(length == RUN_MASK)
+        {
+            unsigned extension;
+            do
+            {
+                unlikely_if(ip >= srcEnd || length > dstCapacity)
+                {
+                    return -1;
+                }
+                extension = *ip++;
+                length += (int)extension;
+            } while(extension == 255);
+        }
+        length += MIN_MATCH;
+        unlikely_if(length > dstEnd - op)
+        {
+            return -1;
+        }
+
+        const uint8_t* match = op - offset;
+        if(offset >= length)
+        {
+            memcpy(op, match, (size_t)length);
+            op += length;
+        }
+        else
+        {
+            // Overlapping copy repeats the last <offset> bytes.
+            for(int i = 0; i < length; i++)
+            {
+                *op++ = *match++;
+            }
+        }
+    }
+    return (int)(op - (uint8_t*)dst);
+}
+
+
+// ============================================================================
+#pragma mark - Block API -
+// ============================================================================
+
+int crasheelz_compressBlock(const char* const src,
+                            const int srcLength,
+                            char* const dst,
+                            const int dstCapacity,
+                            uint16_t* const hashTable)
+{
+    unlikely_if(srcLength > CrasheeLZ_BLOCK_SIZE || srcLength < 0)
+    {
+        return 0;
+    }
+    const uint8_t* const base = (const uint8_t*)src;
+    return compressWithHistory(base, base, base + srcLength, dst, dstCapacity, hashTable);
+}
+
+int crasheelz_decompressBlock(const char* const src, const int srcLength, char* const dst, const int dstCapacity)
+{
+    return decompressWithHistory(src, srcLength, dst, dst, dstCapacity);
+}
+
+
+// ============================================================================
+#pragma mark - Stream API -
+// ============================================================================
+
+void crasheelz_writeMagic(char* const dst)
+{
+    memcpy(dst, g_magic, sizeof(g_magic));
+}
+
+bool crasheelz_isCompressed(const char* const data, const int length)
+{
+    return length >= CrasheeLZ_MAGIC_LENGTH && memcmp(data, g_magic, sizeof(g_magic)) == 0;
+}
+
+int crasheelz_encodeFrame(CrasheeLZWorkspace* const workspace, const char* const src, const int srcLength)
+{
+    uint8_t* const header = (uint8_t*)workspace->outputBuffer;
+    char* const payload = workspace->outputBuffer + CrasheeLZ_FRAME_HEADER_LENGTH;
+
+    // Anything that doesn't come out at least one byte smaller is stored raw.
+    int storedLength = crasheelz_compressBlock(src, srcLength, payload, srcLength - 1, workspace->hashTable);
+    uint32_t storedField = (uint32_t)storedLength;
+    if(storedLength <= 0)
+    {
+        memcpy(payload, src, (size_t)srcLength);
+        storedLength = srcLength;
+        storedField = (uint32_t)srcLength | FRAME_STORED_FLAG;
+    }
+    writeLE32(header, storedField);
+    writeLE32(header + 4, (uint32_t)srcLength);
+    return CrasheeLZ_FRAME_HEADER_LENGTH + storedLength;
+}
+
+/** Decode a frame header.
+ *
+ * @return false if the header is invalid.
+ */
+static bool decodeFrameHeader(const uint8_t* const header, int* const storedLength, int* const originalLength, bool* const isRaw)
+{
+    const uint32_t storedField = readLE32(header);
+    *isRaw = (storedField & FRAME_STORED_FLAG) != 0;
+    *storedLength = (int)(storedField & ~FRAME_STORED_FLAG);
+    *originalLength = (int)readLE32(header + 4);
+    if(*storedLength > CrasheeLZ_BLOCK_SIZE || *originalLength > CrasheeLZ_BLOCK_SIZE)
+    {
+        return false;
+    }
+    return !*isRaw || *storedLength == *originalLength;
+}
+
+/** Walk the frames of a stream without decoding them, so that the output
+ * can be allocated in one go.
+ *
+ * @param frames The first frame header.
+ *
+ * @param end The end of the stream.
+ *
+ * @param maxFrameLength The largest original length a frame may have.
+ *
+ * @param totalLength Receives the total decompressed length.
+ *
+ * @return The end of the last complete, valid frame.
+ */
+static const uint8_t* measureFrames(const uint8_t* const frames,
+                                    const uint8_t* const end,
+                                    const int maxFrameLength,
+                                    int* const totalLength)
+{
+    *totalLength = 0;
+    const uint8_t* ptr = frames;
+    while(end - ptr >= CrasheeLZ_FRAME_HEADER_LENGTH)
+    {
+        int storedLength;
+        int originalLength;
+        bool isRaw;
+        if(!decodeFrameHeader(ptr, &storedLength, &originalLength, &isRaw) || originalLength > maxFrameLength)
+        {
+            CrasheeLOG_ERROR("Invalid frame header at offset %d", (int)(ptr - frames));
+            break;
+        }
+        if(end - ptr - CrasheeLZ_FRAME_HEADER_LENGTH < storedLength)
+        {
+            CrasheeLOG_INFO("Compressed stream is truncated");
+            break;
+        }
+        *totalLength += originalLength;
+        ptr += CrasheeLZ_FRAME_HEADER_LENGTH + storedLength;
+    }
+    return ptr;
+}
+
+char* crasheelz_decompressStream(const char* const data, const int length, int* const decompressedLength)
+{
+    if(!crasheelz_isCompressed(data, length))
+    {
+        return NULL;
+    }
+
+    int totalLength;
+    const uint8_t* ptr = (const uint8_t*)data + CrasheeLZ_MAGIC_LENGTH;
+    const uint8_t* const framesEnd = measureFrames(ptr, (const uint8_t*)data + length, CrasheeLZ_BLOCK_SIZE, &totalLength);
+
+    char* result = malloc((size_t)totalLength + 1);
+    if(result == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d bytes", totalLength + 1);
+        return NULL;
+    }
+
+    char* dst = result;
+    while(ptr < framesEnd)
+    {
+        int storedLength;
+        int originalLength;
+        bool isRaw;
+        decodeFrameHeader(ptr, &storedLength, &originalLength, &isRaw);
+        ptr += CrasheeLZ_FRAME_HEADER_LENGTH;
+        if(isRaw)
+        {
+            memcpy(dst, ptr, (size_t)storedLength);
+        }
+        else if(crasheelz_decompressBlock((const char*)ptr, storedLength, dst, originalLength) != originalLength)
+        {
+            CrasheeLOG_ERROR("Corrupt frame at offset %d", (int)(ptr - (const uint8_t*)data));
+            break;
+        }
+        dst += originalLength;
+        ptr += storedLength;
+    }
+
+    *dst = '\0';
+    if(decompressedLength != NULL)
+    {
+        *decompressedLength = (int)(dst - result);
+    }
+    return result;
+}
+
+bool crasheelz_decompressFile(const char* const srcPath, const char* const dstPath, CrasheeLZWorkspace* const workspace)
+{
+    bool isSuccessful = false;
+    int dstFD = -1;
+    int srcFD = open(srcPath, O_RDONLY);
+    if(srcFD < 0)
+    {
+        CrasheeLOG_ERROR("Could not open %s: %s", srcPath, strerror(errno));
+        goto done;
+    }
+    dstFD = open(dstPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(dstFD < 0)
+    {
+        CrasheeLOG_ERROR("Could not open %s: %s", dstPath, strerror(errno));
+        goto done;
+    }
+
+    char* const frame = workspace->outputBuffer;
+    char* const decompressed = workspace->inputBuffer;
+    int bytesRead = (int)read(srcFD, frame, CrasheeLZ_MAGIC_LENGTH);
+    if(!crasheelz_isCompressed(frame, bytesRead))
+    {
+        // Not compressed: plain copy.
+        while(bytesRead > 0)
+        {
+            if(!crasheefu_writeBytesToFD(dstFD, frame, bytesRead))
+            {
+                goto done;
+            }
+            bytesRead = (int)read(srcFD, frame, CrasheeLZ_BLOCK_SIZE);
+        }
+        isSuccessful = bytesRead == 0;
+        goto done;
+    }
+
+    for(;;)
+    {
+        if(!crasheefu_readBytesFromFD(srcFD, frame, CrasheeLZ_FRAME_HEADER_LENGTH))
+        {
+            // End of stream, or a truncated header.
+            break;
+        }
+        int storedLength;
+        int originalLength;
+        bool isRaw;
+        if(!decodeFrameHeader((const uint8_t*)frame, &storedLength, &originalLength, &isRaw))
+        {
+            CrasheeLOG_ERROR("Invalid frame header in %s", srcPath);
+            break;
+        }
+        if(!crasheefu_readBytesFromFD(srcFD, frame, storedLength))
+        {
+            CrasheeLOG_INFO("%s is truncated", srcPath);
+            break;
+        }
+        const char* output = frame;
+        if(!isRaw)
+        {
+            if(crasheelz_decompressBlock(frame, storedLength, decompressed, originalLength) != originalLength)
+            {
+                CrasheeLOG_ERROR("Corrupt frame in %s", srcPath);
+                break;
+            }
+            output = decompressed;
+        }
+        if(!crasheefu_writeBytesToFD(dstFD, output, originalLength))
+        {
+            goto done;
+        }
+    }
+    isSuccessful = true;
+
+done:
+    if(srcFD >= 0)
+    {
+        close(srcFD);
+    }
+    if(dstFD >= 0)
+    {
+        close(dstFD);
+    }
+    return isSuccessful;
+}
+
+
+// ============================================================================
+#pragma mark - Dictionary API -
+// ============================================================================
+
+bool crasheelz_isDictionaryCompressed(const char* const data, const int length)
+{
+    return length >= CrasheeLZ_DICTIONARY_HEADER_LENGTH &&
+           memcmp(data, g_dictionaryMagic, sizeof(g_dictionaryMagic)) == 0;
+}
+
+uint32_t crasheelz_getDictionaryID(const char* const data, const int length)
+{
+    if(!crasheelz_isDictionaryCompressed(data, length))
+    {
+        return 0;
+    }
+    return readLE32((const uint8_t*)data + CrasheeLZ_MAGIC_LENGTH);
+}
+
+char* crasheelz_compressWithDictionary(const char* const data,
+                                       const int length,
+                                       const CrasheeLZDictionary* const dictionary,
+                                       int* const compressedLength)
+{
+    unlikely_if(dictionary->length > CrasheeLZ_MAX_DICTIONARY_LENGTH || dictionary->length < 0 || length < 0)
+    {
+        CrasheeLOG_ERROR("Invalid dictionary or data length");
+        return NULL;
+    }
+
+    // The dictionary and the block must fit in the 16 bit match window together.
+    const int blockSize = CrasheeLZ_BLOCK_SIZE - dictionary->length;
+    const int frameCount = length / blockSize + 1;
+    const size_t capacity = CrasheeLZ_DICTIONARY_HEADER_LENGTH + (size_t)frameCount * CrasheeLZ_FRAME_HEADER_LENGTH + (size_t)length;
+    uint8_t* const result = malloc(capacity);
+    uint8_t* const history = malloc(CrasheeLZ_BLOCK_SIZE);
+    uint16_t* const hashTable = malloc(sizeof(*hashTable) << CrasheeLZ_HASH_BITS);
+    if(result == NULL || history == NULL || hashTable == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate compression buffers");
+        free(result);
+        free(history);
+        free(hashTable);
+        return NULL;
+    }
+
+    memcpy(result, g_dictionaryMagic, sizeof(g_dictionaryMagic));
+    writeLE32(result + CrasheeLZ_MAGIC_LENGTH, dictionary->id);
+    memcpy(history, dictionary->data, (size_t)dictionary->length);
+    uint8_t* const block = history + dictionary->length;
+
+    uint8_t* dst = result + CrasheeLZ_DICTIONARY_HEADER_LENGTH;
+    for(int offset = 0; offset < length; offset += blockSize)
+    {
+        const int srcLength = length - offset < blockSize ? length - offset : blockSize;
+        memcpy(block, data + offset, (size_t)srcLength);
+        char* const payload = (char*)dst + CrasheeLZ_FRAME_HEADER_LENGTH;
+
+        // Anything that doesn't come out at least one byte smaller is stored raw.
+        int storedLength = compressWithHistory(history, block, block + srcLength, payload, srcLength - 1, hashTable);
+        uint32_t storedField = (uint32_t)storedLength;
+        if(storedLength <= 0)
+        {
+            memcpy(payload, block, (size_t)srcLength);
+            storedLength = srcLength;
+            storedField = (uint32_t)srcLength | FRAME_STORED_FLAG;
+        }
+        writeLE32(dst, storedField);
+        writeLE32(dst + 4, (uint32_t)srcLength);
+        dst += CrasheeLZ_FRAME_HEADER_LENGTH + storedLength;
+    }
+
+    free(history);
+    free(hashTable);
+    if(compressedLength != NULL)
+    {
+        *compressedLength = (int)(dst - result);
+    }
+    return (char*)result;
+}
+
+char* crasheelz_decompressWithDictionary(const char* const data,
+                                         const int length,
+                                         const CrasheeLZDictionary* const dictionary,
+                                         int* const decompressedLength)
+{
+    if(crasheelz_getDictionaryID(data, length) != dictionary->id || dictionary->id == 0)
+    {
+        CrasheeLOG_ERROR("Stream was not compressed with dictionary %u", dictionary->id);
+        return NULL;
+    }
+    unlikely_if(dictionary->length > CrasheeLZ_MAX_DICTIONARY_LENGTH || dictionary->length < 0)
+    {
+        CrasheeLOG_ERROR("Invalid dictionary length %d", dictionary->length);
+        return NULL;
+    }
+
+    const int blockSize = CrasheeLZ_BLOCK_SIZE - dictionary->length;
+    int totalLength;
+    const uint8_t* ptr = (const uint8_t*)data + CrasheeLZ_DICTIONARY_HEADER_LENGTH;
+    const uint8_t* const framesEnd = measureFrames(ptr, (const uint8_t*)data + length, blockSize, &totalLength);
+
+    char* result = malloc((size_t)totalLength + 1);
+    char* const history = malloc(CrasheeLZ_BLOCK_SIZE);
+    if(result == NULL || history == NULL)
+    {
+        CrasheeLOG_ERROR("Could not allocate %d bytes", totalLength + 1);
+        free(result);
+        free(history);
+        return NULL;
+    }
+    memcpy(history, dictionary->data, (size_t)dictionary->length);
+    char* const block = history + dictionary->length;
+
+    char* dst = result;
+    while(ptr < framesEnd)
+    {
+        int storedLength;
+        int originalLength;
+        bool isRaw;
+        decodeFrameHeader(ptr, &storedLength, &originalLength, &isRaw);
+        ptr += CrasheeLZ_FRAME_HEADER_LENGTH;
+        if(isRaw)
+        {
+            memcpy(dst, ptr, (size_t)storedLength);
+        }
+        else if(decompressWithHistory((const char*)ptr, storedLength, history, block, originalLength) == originalLength)
+        {
+            memcpy(dst, block, (size_t)originalLength);
+        }
+        else
+        {
+            CrasheeLOG_ERROR("Corrupt frame at offset %d", (int)(ptr - (const uint8_t*)data));
+            break;
+        }
+        dst += originalLength;
+        ptr += storedLength;
+    }
+    free(history);
+
+    *dst = '\0';
+    if(decompressedLength != NULL)
+    {
+        *decompressedLength = (int)(dst - result);
+    }
+    return result;
+}
@@ -0,0 +1,256 @@
+//
+//  CrasheeLZ.h
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+/* LZ77 block compression for crash reports.
+ *
+ * Blocks use the LZ4 block format. A compressed stream is a magic number
+ * followed by independent frames, each holding at most one block:
+ *
+ *     [4 bytes] stored length, little endian. High bit set = stored raw.
+ *     [4 bytes] original length, little endian.
+ *     [stored length bytes] payload.
+ *
+ * Compression uses only the caller supplied workspace, so it is safe to
+ * call from a signal handler.
+ *
+ * Data at rest can instead be compressed against a dictionary of content it
+ * is likely to contain, which matches can refer back into as though it came
+ * right before each block. Such a stream starts with a different magic number
+ * and the ID of its dictionary, and has smaller frames so that dictionary and
+ * block fit in the match window together:
+ *
+ *     [4 bytes] magic: 0x89 'C' 'L' 'D'
+ *     [4 bytes] dictionary ID, little endian.
+ *     frames as above, each up to CrasheeLZ_BLOCK_SIZE - dictionary length.
+ */
+
+
+#ifndef HDR_CrasheeLZ_h
+#define HDR_CrasheeLZ_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/** The largest amount of data that can go into a single frame. */
+#define CrasheeLZ_BLOCK_SIZE 65536
+
+/** Length of the stream magic number. */
+#define CrasheeLZ_MAGIC_LENGTH 4
+
+/** Length of a frame header. */
+#define CrasheeLZ_FRAME_HEADER_LENGTH 8
+
+/** Length of the magic number and dictionary ID of a dictionary stream. */
+#define CrasheeLZ_DICTIONARY_HEADER_LENGTH 8
+
+/** The largest dictionary that can be used. */
+#define CrasheeLZ_MAX_DICTIONARY_LENGTH 32768
+
+#define CrasheeLZ_HASH_BITS 12
+
+/** Working memory for compression and file decompression.
+ * This is large (about 140k), so don't put it on the stack.
+ */
+typedef struct
+{
+    /** Uncompressed data for the frame being built. */
+    char inputBuffer[CrasheeLZ_BLOCK_SIZE];
+
+    /** The encoded frame. */
+    char outputBuffer[CrasheeLZ_FRAME_HEADER_LENGTH + CrasheeLZ_BLOCK_SIZE];
+
+    /** Match finder: hash of 4 bytes -> last position seen. */
+    uint16_t hashTable[1 << CrasheeLZ_HASH_BITS];
+} CrasheeLZWorkspace;
+
+/** Data that a dictionary stream refers back into. */
+typedef struct
+{
+    /** Recorded in each stream, so that it can be decompressed with the same
+     * dictionary. Must not be 0, and must change when the data does.
+     */
+    uint32_t id;
+
+    const char* data;
+
+    /** Length of the data (max CrasheeLZ_MAX_DICTIONARY_LENGTH). */
+    int length;
+} CrasheeLZDictionary;
+
+
+/** Compress a block of data.
+ *
+ * @param src The data to compress.
+ *
+ * @param srcLength Length of the data (max CrasheeLZ_BLOCK_SIZE).
+ *
+ * @param dst Buffer to hold the compressed data.
+ *
+ * @param dstCapacity Length of the destination buffer.
+ *
+ * @param hashTable A hash table of (1 << CrasheeLZ_HASH_BITS) entries.
+ *
+ * @return The compressed length, or 0 if the result would not fit in dst.
+ */
+int crasheelz_compressBlock(const char* src, int srcLength, char* dst, int dstCapacity, uint16_t* hashTable);
+
+/** Decompress a block of data.
+ *
+ * @param src The compressed data.
+ *
+ * @param srcLength Length of the compressed data.
+ *
+ * @param dst Buffer to hold the decompressed data.
+ *
+ * @param dstCapacity Length of the destination buffer.
+ *
+ * @return The decompressed length, or -1 if the data is malformed or doesn't fit.
+ */
+int crasheelz_decompressBlock(const char* src, int srcLength, char* dst, int dstCapacity);
+
+/** Write the stream magic number.
+ *
+ * @param dst Buffer of at least CrasheeLZ_MAGIC_LENGTH bytes.
+ */
+void crasheelz_writeMagic(char* dst);
+
+/** Check if data begins with the stream magic number.
+ *
+ * @param data The data to check.
+ *
+ * @param length The length of the data.
+ *
+ * @return true if the data is a compressed stream.
+ */
+bool crasheelz_isCompressed(const char* data, int length);
+
+/** Encode a frame into workspace->outputBuffer.
+ * If compression doesn't shrink the data, it is stored raw.
+ *
+ * @param workspace The workspace.
+ *
+ * @param src The data to encode (may be workspace->inputBuffer).
+ *
+ * @param srcLength The length of the data (max CrasheeLZ_BLOCK_SIZE).
+ *
+ * @return The length of the encoded frame.
+ */
+int crasheelz_encodeFrame(CrasheeLZWorkspace* workspace, const char* src, int srcLength);
+
+/** Decompress an entire stream into newly allocated memory.
+ * A truncated final frame is ignored.
+ *
+ * @param data The compressed stream, including the magic number.
+ *
+ * @param length The length of the stream.
+ *
+ * @param decompressedLength Receives the decompressed length (can be NULL).
+ *
+ * @return A null terminated buffer that must be freed, or NULL on error.
+ */
+char* crasheelz_decompressStream(const char* data, int length, int* decompressedLength);
+
+/** Decompress a file to another file without allocating memory.
+ * If the source isn't compressed, it is copied as is.
+ *
+ * @param srcPath The compressed file.
+ *
+ * @param dstPath The file to create.
+ *
+ * @param workspace The workspace.
+ *
+ * @return true if successful.
+ */
+bool crasheelz_decompressFile(const char* srcPath, const char* dstPath, CrasheeLZWorkspace* workspace);
+
+/** Check if data begins with the dictionary stream magic number.
+ *
+ * @param data The data to check.
+ *
+ * @param length The length of the data.
+ *
+ * @return true if the data is a dictionary compressed stream.
+ */
+bool crasheelz_isDictionaryCompressed(const char* data, int length);
+
+/** Get the ID of the dictionary a stream was compressed with.
+ *
+ * @param data The compressed stream.
+ *
+ * @param length The length of the stream.
+ *
+ * @return The dictionary ID, or 0 if this isn't a dictionary stream.
+ */
+uint32_t crasheelz_getDictionaryID(const char* data, int length);
+
+/** Compress data against a dictionary into newly allocated memory.
+ * Unlike the stream functions above, this allocates.
+ *
+ * @param data The data to compress.
+ *
+ * @param length The length of the data.
+ *
+ * @param dictionary The dictionary.
+ *
+ * @param compressedLength Receives the compressed length (can be NULL).
+ *
+ * @return A buffer that must be freed, or NULL on error.
+ */
+char* crasheelz_compressWithDictionary(const char* data,
+                                       int length,
+                                       const CrasheeLZDictionary* dictionary,
+                                       int* compressedLength);
+
+/** Decompress a dictionary stream into newly allocated memory.
+ * A truncated final frame is ignored.
+ *
+ * @param data The compressed stream, including its header.
+ *
+ * @param length The length of the stream.
+ *
+ * @param dictionary The dictionary whose ID is in the header.
+ *
+ * @param decompressedLength Receives the decompressed length (can be NULL).
+ *
+ * @return A null terminated buffer that must be freed, or NULL on error.
+ */
+char* crasheelz_decompressWithDictionary(const char* data,
+                                         int length,
+                                         const CrasheeLZDictionary* dictionary,
+                                         int* decompressedLength);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeLZ_h
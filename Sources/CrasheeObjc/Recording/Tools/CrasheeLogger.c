@@ -26,6 +26,7 @@
 
 
 #include "CrasheeLogger.h"
+#include "CrasheeFormat.h"
 #include "../CrasheeSystemCapabilities.h"
 
 // ===========================================================================
@@ -129,7 +130,7 @@ static inline void writeFmtArgsToLog(const char* fmt, va_list args)
     else
     {
         char buffer[CrasheeLOGGER_CBufferSize];
-        vsnprintf(buffer, sizeof(buffer), fmt, args);
+        crasheefmt_vformat(buffer, sizeof(buffer), fmt, args);
         writeToLog(buffer);
     }
 }
@@ -0,0 +1,94 @@
+//
+//  CrasheeNumber.h
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+/* Decimal number parsing.
+ *
+ * Converts numbers as written in JSON (an optional minus sign, digits, an
+ * optional fraction and an optional exponent). Integers are read 8 digits at
+ * a time, and floating point values use the Eisel-Lemire algorithm. The rare
+ * values that can't be decided that way are handed to strtod() in a form
+ * that doesn't depend on the current locale.
+ */
+
+
+#ifndef HDR_CrasheeNumber_h
+#define HDR_CrasheeNumber_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+typedef enum
+{
+    /** The value is in asInteger. */
+    CrasheeNumberType_Integer,
+
+    /** A positive integer too large for int64_t. The value is in asUnsignedInteger. */
+    CrasheeNumberType_UnsignedInteger,
+
+    /** A number with a fraction or exponent, or an integer too large for
+     * either integer type. The value is in asFloatingPoint.
+     */
+    CrasheeNumberType_FloatingPoint,
+} CrasheeNumberType;
+
+typedef struct
+{
+    CrasheeNumberType type;
+    int64_t asInteger;
+    uint64_t asUnsignedInteger;
+    double asFloatingPoint;
+} CrasheeNumber;
+
+
+/** Parse the decimal number at the start of a buffer.
+ *
+ * Leading zeroes are accepted. A '.' with no digits after it is part of the
+ * number; an exponent marker with no digits after it is not.
+ * Floating point values are correctly rounded.
+ *
+ * @param src The start of the number.
+ *
+ * @param srcEnd The end of the buffer. The number need not be terminated.
+ *
+ * @param number Filled in with the parsed number.
+ *
+ * @return A pointer to the first character after the number, or NULL if
+ *         src doesn't start with a number.
+ */
+const char* crasheenumber_parse(const char* src, const char* srcEnd, CrasheeNumber* number);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeNumber_h
@@ -43,62 +43,513 @@ static const int g_printableControlChars[0x20] =
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-static const int g_continuationByteCount[0x40] =
-{
-    /*
-     --0xxxxx = 1 (00-1f)
-     --10xxxx = 2 (20-2f)
-     --110xxx = 3 (30-37)
-     --1110xx = 4 (38-3b)
-     --11110x = 5 (3c-3d)
-     */
-    // 1  2  3  4  5  6  7  8  9  a  b  c  d  e  f
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 0, 0,
-};
+/** Set to 1 to validate UTF-8 16 bytes at a time using SSSE3 (x86_64) or
+ * NEON (arm64). Other architectures validate byte by byte.
+ */
+#ifndef CrasheeSTRING_UseSIMD
+    #define CrasheeSTRING_UseSIMD 1
+#endif
 
-bool crasheestring_isNullTerminatedUTF8String(const void* memory,
-                                        int minLength,
-                                        int maxLength)
+#if CrasheeSTRING_UseSIMD && defined(__SSSE3__)
+    #include <tmmintrin.h>
+    #define CrasheeSTRING_HAS_SSSE3 1
+#elif CrasheeSTRING_UseSIMD && defined(__ARM_NEON) && (defined(__arm64__) || defined(__aarch64__))
+    #include <arm_neon.h>
+    #define CrasheeSTRING_HAS_NEON 1
+#endif
+
+#define UTF8_BLOCK_SIZE 16
+
+
+// ============================================================================
+#pragma mark - UTF-8 Sequences -
+// ============================================================================
+
+/** Get the length of the multibyte UTF-8 sequence starting at ptr.
+ * Only the shortest form of code points up to 0x10ffff, excluding UTF-16
+ * surrogates, is accepted (RFC 3629).
+ *
+ * @param ptr The sequence's first byte, which is >= 0x80.
+ *
+ * @param end The end of the data.
+ *
+ * @return The length of the sequence, or 0 if it is invalid or runs past end.
+ */
+static int getUTF8SequenceLength(const unsigned char* const ptr, const unsigned char* const end)
+{
+    const unsigned char ch = ptr[0];
+    int length;
+    unsigned char secondMin = 0x80;
+    unsigned char secondMax = 0xbf;
+    if(ch >= 0xc2 && ch <= 0xdf)
+    {
+        length = 2;
+    }
+    else if(ch >= 0xe0 && ch <= 0xef)
+    {
+        length = 3;
+        if(ch == 0xe0)
+        {
+            // Overlong
+            secondMin = 0xa0;
+        }
+        else if(ch == 0xed)
+        {
+            // Surrogates
+            secondMax = 0x9f;
+        }
+    }
+    else if(ch >= 0xf0 && ch <= 0xf4)
+    {
+        length = 4;
+        if(ch == 0xf0)
+        {
+            // Overlong
+            secondMin = 0x90;
+        }
+        else if(ch == 0xf4)
+        {
+            // Above 0x10ffff
+            secondMax = 0x8f;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+
+    unlikely_if(end - ptr < length || ptr[1] < secondMin || ptr[1] > secondMax)
+    {
+        return 0;
+    }
+    for(int i = 2; i < length; i++)
+    {
+        unlikely_if((ptr[i] & 0xc0) != 0x80)
+        {
+            return 0;
+        }
+    }
+    return length;
+}
+
+
+// ============================================================================
+#pragma mark - Scalar UTF-8 -
+// ============================================================================
+
+#if !CrasheeSTRING_HAS_SSSE3 && !CrasheeSTRING_HAS_NEON
+
+static bool isValidUTF8(const unsigned char* ptr, const unsigned char* const end)
 {
-    const unsigned char* ptr = memory;
+    while(ptr < end)
+    {
+        // Skip ASCII a word at a time.
+        uint64_t word;
+        while(end - ptr >= (int)sizeof(word))
+        {
+            memcpy(&word, ptr, sizeof(word));
+            if(word & 0x8080808080808080ull)
+            {
+                break;
+            }
+            ptr += sizeof(word);
+        }
+        if(ptr >= end)
+        {
+            break;
+        }
+        likely_if(*ptr < 0x80)
+        {
+            ptr++;
+            continue;
+        }
+        const int length = getUTF8SequenceLength(ptr, end);
+        unlikely_if(length == 0)
+        {
+            return false;
+        }
+        ptr += length;
+    }
+    return true;
+}
+
+static bool isNullTerminatedUTF8(const unsigned char* const start, const int minLength, const int maxLength)
+{
+    const unsigned char* ptr = start;
     const unsigned char* const end = ptr + maxLength;
 
-    for(; ptr < end; ptr++)
+    while(ptr < end)
     {
-        unsigned char ch = *ptr;
+        const unsigned char ch = *ptr;
         unlikely_if(ch == 0)
         {
-            return (ptr - (const unsigned char*)memory) >= minLength;
+            return (ptr - start) >= minLength;
         }
         unlikely_if(ch & 0x80)
         {
-            unlikely_if((ch & 0xc0) != 0xc0)
+            // The terminator can't be part of a sequence, so a sequence
+            // that needs it is invalid regardless.
+            const int length = getUTF8SequenceLength(ptr, end);
+            unlikely_if(length == 0)
             {
                 return false;
             }
-            int continuationBytes = g_continuationByteCount[ch & 0x3f];
-            unlikely_if(continuationBytes == 0 || ptr + continuationBytes >= end)
+            ptr += length;
+            continue;
+        }
+        unlikely_if(ch < 0x20 && !g_printableControlChars[ch])
+        {
+            return false;
+        }
+        ptr++;
+    }
+    return false;
+}
+
+#else
+
+
+// ============================================================================
+#pragma mark - SIMD UTF-8 -
+// ============================================================================
+
+/* Range-based validation (Keiser & Lemire, "Validating UTF-8 in less than
+ * one instruction per byte"). Every byte is classified by three table
+ * lookups: the high and low nibbles of the byte before it, and its own high
+ * nibble. ANDing them together leaves a bit set for each kind of error that
+ * the pair of bytes makes. The third and fourth bytes of long sequences are
+ * checked separately, by looking two and three bytes back.
+ */
+
+#define TOO_SHORT      (1 << 0) // 11______ 0_______ or 11______ 11______
+#define TOO_LONG       (1 << 1) // 0_______ 10______
+#define OVERLONG_3     (1 << 2) // 11100000 100_____
+#define TOO_LARGE      (1 << 3) // 11110100 1001____ or 11110101+ 10______
+#define SURROGATE      (1 << 4) // 11101101 101_____
+#define OVERLONG_2     (1 << 5) // 1100000_ 10______
+#define TOO_LARGE_1000 (1 << 6) // 11110101+ 1000____
+#define OVERLONG_4     (1 << 6) // 11110000 1000____
+#define TWO_CONTS      (1 << 7) // 10______ 10______
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+static const uint8_t g_byte1High[UTF8_BLOCK_SIZE] =
+{
+    // 0_______: ASCII
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    // 10______: Continuation
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    // 1100____
+    TOO_SHORT | OVERLONG_2,
+    // 1101____
+    TOO_SHORT,
+    // 1110____
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    // 1111____
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+static const uint8_t g_byte1Low[UTF8_BLOCK_SIZE] =
+{
+    // ____0000
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    // ____0001
+    CARRY | OVERLONG_2,
+    // ____001_
+    CARRY,
+    CARRY,
+    // ____0100
+    CARRY | TOO_LARGE,
+    // ____0101 - ____1100
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    // ____1101
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    // ____111_
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+
+static const uint8_t g_byte2High[UTF8_BLOCK_SIZE] =
+{
+    // 0_______: ASCII
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    // 1000____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    // 1001____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    // 101_____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    // 11______
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+/** Lead bytes at the end of a block that need more bytes than the block has left. */
+static const uint8_t g_incompleteThreshold[UTF8_BLOCK_SIZE] =
+{
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1,
+};
+
+#if CrasheeSTRING_HAS_SSSE3
+
+typedef __m128i UTF8Block;
+
+#define loadBlock(SRC) _mm_loadu_si128((const __m128i*)(const void*)(SRC))
+#define splatBlock(VALUE) _mm_set1_epi8((char)(VALUE))
+#define orBlocks(A, B) _mm_or_si128(A, B)
+#define andBlocks(A, B) _mm_and_si128(A, B)
+#define xorBlocks(A, B) _mm_xor_si128(A, B)
+#define subtractSaturated(A, B) _mm_subs_epu8(A, B)
+#define lookupBlock(TABLE, INDEXES) _mm_shuffle_epi8(TABLE, INDEXES)
+#define highNibbles(BLOCK) _mm_and_si128(_mm_srli_epi16(BLOCK, 4), _mm_set1_epi8(0x0f))
+#define lowNibbles(BLOCK) _mm_and_si128(BLOCK, _mm_set1_epi8(0x0f))
+/** The block shifted along by N bytes, with the last N bytes of PREVIOUS shifted in. */
+#define precedingBytes(BLOCK, PREVIOUS, N) _mm_alignr_epi8(BLOCK, PREVIOUS, UTF8_BLOCK_SIZE - (N))
+
+static inline bool isASCIIBlock(const UTF8Block block)
+{
+    return _mm_movemask_epi8(block) == 0;
+}
+
+static inline bool isNonZeroBlock(const UTF8Block block)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128())) != 0xffff;
+}
+
+/** Check if any byte is below 0x20. */
+static inline bool hasControlChars(const UTF8Block block)
+{
+    const __m128i low = _mm_min_epu8(block, _mm_set1_epi8(0x1f));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(low, block)) != 0;
+}
+
+#else // NEON
+
+typedef uint8x16_t UTF8Block;
+
+#define loadBlock(SRC) vld1q_u8(SRC)
+#define splatBlock(VALUE) vdupq_n_u8(VALUE)
+#define orBlocks(A, B) vorrq_u8(A, B)
+#define andBlocks(A, B) vandq_u8(A, B)
+#define xorBlocks(A, B) veorq_u8(A, B)
+#define subtractSaturated(A, B) vqsubq_u8(A, B)
+#define lookupBlock(TABLE, INDEXES) vqtbl1q_u8(TABLE, INDEXES)
+#define highNibbles(BLOCK) vshrq_n_u8(BLOCK, 4)
+#define lowNibbles(BLOCK) vandq_u8(BLOCK, vdupq_n_u8(0x0f))
+/** The block shifted along by N bytes, with the last N bytes of PREVIOUS shifted in. */
+#define precedingBytes(BLOCK, PREVIOUS, N) vextq_u8(PREVIOUS, BLOCK, UTF8_BLOCK_SIZE - (N))
+
+static inline bool isASCIIBlock(const UTF8Block block)
+{
+    return vmaxvq_u8(block) < 0x80;
+}
+
+static inline bool isNonZeroBlock(const UTF8Block block)
+{
+    return vmaxvq_u8(block) != 0;
+}
+
+/** Check if any byte is below 0x20. */
+static inline bool hasControlChars(const UTF8Block block)
+{
+    return vminvq_u8(block) < 0x20;
+}
+
+#endif
+
+typedef struct
+{
+    UTF8Block byte1High;
+    UTF8Block byte1Low;
+    UTF8Block byte2High;
+    UTF8Block incompleteThreshold;
+
+    /** Accumulated errors. Any bit set means the data is invalid. */
+    UTF8Block errors;
+    UTF8Block previous;
+    /** Non-zero where the previous block ended part way through a sequence. */
+    UTF8Block previousIncomplete;
+} UTF8Validator;
+
+static inline void initUTF8Validator(UTF8Validator* const validator)
+{
+    validator->byte1High = loadBlock(g_byte1High);
+    validator->byte1Low = loadBlock(g_byte1Low);
+    validator->byte2High = loadBlock(g_byte2High);
+    validator->incompleteThreshold = loadBlock(g_incompleteThreshold);
+    validator->errors = splatBlock(0);
+    validator->previous = splatBlock(0);
+    validator->previousIncomplete = splatBlock(0);
+}
+
+static inline void validateUTF8Block(UTF8Validator* const validator, const UTF8Block block)
+{
+    likely_if(isASCIIBlock(block))
+    {
+        validator->errors = orBlocks(validator->errors, validator->previousIncomplete);
+        validator->previous = block;
+        validator->previousIncomplete = splatBlock(0);
+        return;
+    }
+
+    const UTF8Block previous = validator->previous;
+    const UTF8Block prev1 = precedingBytes(block, previous, 1);
+    const UTF8Block special = andBlocks(andBlocks(lookupBlock(validator->byte1High, highNibbles(prev1)),
+                                                  lookupBlock(validator->byte1Low, lowNibbles(prev1))),
+                                        lookupBlock(validator->byte2High, highNibbles(block)));
+
+    // Only the bytes two after 111_____ and three after 1111____ end up with the high bit set.
+    const UTF8Block isThirdByte = subtractSaturated(precedingBytes(block, previous, 2), splatBlock(0xe0 - 0x80));
+    const UTF8Block isFourthByte = subtractSaturated(precedingBytes(block, previous, 3), splatBlock(0xf0 - 0x80));
+    const UTF8Block mustBeContinuation = andBlocks(orBlocks(isThirdByte, isFourthByte), splatBlock(0x80));
+
+    validator->errors = orBlocks(validator->errors, xorBlocks(mustBeContinuation, special));
+    validator->previous = block;
+    validator->previousIncomplete = subtractSaturated(block, validator->incompleteThreshold);
+}
+
+/** Validate the final, partial block. The rest of the block is zeroes,
+ * so a sequence cut off by the end of the data shows up as too short.
+ */
+static inline bool finishUTF8Validation(UTF8Validator* const validator, const unsigned char* const src, const int length)
+{
+    unsigned char block[UTF8_BLOCK_SIZE] = {0};
+    memcpy(block, src, (size_t)length);
+    validateUTF8Block(validator, loadBlock(block));
+    return !isNonZeroBlock(orBlocks(validator->errors, validator->previousIncomplete));
+}
+
+static bool isValidUTF8(const unsigned char* ptr, const unsigned char* const end)
+{
+    UTF8Validator validator;
+    initUTF8Validator(&validator);
+    for(; end - ptr >= UTF8_BLOCK_SIZE; ptr += UTF8_BLOCK_SIZE)
+    {
+        validateUTF8Block(&validator, loadBlock(ptr));
+    }
+    return finishUTF8Validation(&validator, ptr, (int)(end - ptr));
+}
+
+/** Look for the terminator, or a control character other than tab, CR or LF.
+ *
+ * @return The offset of the terminator, length if there is none, or -1 if
+ *         there's an unprintable character first.
+ */
+static inline int findTerminator(const unsigned char* const src, const int length)
+{
+    for(int i = 0; i < length; i++)
+    {
+        const unsigned char ch = src[i];
+        unlikely_if(ch < 0x20)
+        {
+            if(ch == 0)
+            {
+                return i;
+            }
+            if(!g_printableControlChars[ch])
             {
-                return false;
+                return -1;
             }
-            for(int i = 0; i < continuationBytes; i++)
+        }
+    }
+    return length;
+}
+
+static bool isNullTerminatedUTF8(const unsigned char* const start, const int minLength, const int maxLength)
+{
+    UTF8Validator validator;
+    initUTF8Validator(&validator);
+    const unsigned char* ptr = start;
+    const unsigned char* const end = start + maxLength;
+
+    for(;;)
+    {
+        // Never read past end: a partial block is only scanned byte by byte.
+        const int length = end - ptr < UTF8_BLOCK_SIZE ? (int)(end - ptr) : UTF8_BLOCK_SIZE;
+        int terminator = length;
+        UTF8Block block = splatBlock(0);
+        likely_if(length == UTF8_BLOCK_SIZE)
+        {
+            block = loadBlock(ptr);
+            unlikely_if(hasControlChars(block))
             {
-                ptr++;
-                unlikely_if((*ptr & 0xc0) != 0x80)
-                {
-                    return false;
-                }
+                terminator = findTerminator(ptr, length);
             }
         }
-        else unlikely_if(ch < 0x20 && !g_printableControlChars[ch])
+        else
+        {
+            terminator = findTerminator(ptr, length);
+        }
+
+        unlikely_if(terminator < 0)
         {
             return false;
         }
+        unlikely_if(terminator < UTF8_BLOCK_SIZE)
+        {
+            if(terminator == length)
+            {
+                // Ran out of memory before finding a terminator.
+                return false;
+            }
+            return (ptr - start) + terminator >= minLength &&
+                   finishUTF8Validation(&validator, ptr, terminator);
+        }
+        validateUTF8Block(&validator, block);
+        ptr += UTF8_BLOCK_SIZE;
     }
-    return false;
+}
+
+#endif
+
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+bool crasheestring_isValidUTF8(const void* memory, int length)
+{
+    const unsigned char* const ptr = memory;
+    return isValidUTF8(ptr, ptr + length);
+}
+
+int crasheestring_replaceInvalidUTF8(char* const string, const int length, const char replacement)
+{
+    unsigned char* ptr = (unsigned char*)string;
+    const unsigned char* const end = ptr + length;
+    int replacedCount = 0;
+    while(ptr < end)
+    {
+        likely_if(*ptr < 0x80)
+        {
+            ptr++;
+            continue;
+        }
+        const int sequenceLength = getUTF8SequenceLength(ptr, end);
+        likely_if(sequenceLength > 0)
+        {
+            ptr += sequenceLength;
+            continue;
+        }
+        // Only the first byte is known to be bad. The next may start a valid sequence.
+        *ptr++ = (unsigned char)replacement;
+        replacedCount++;
+    }
+    return replacedCount;
+}
+
+bool crasheestring_isNullTerminatedUTF8String(const void* memory,
+                                        int minLength,
+                                        int maxLength)
+{
+    return isNullTerminatedUTF8(memory, minLength, maxLength);
 }
 
 
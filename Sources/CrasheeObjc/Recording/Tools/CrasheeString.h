@@ -46,6 +46,31 @@ extern "C" {
  */
 bool crasheestring_isNullTerminatedUTF8String(const void* memory, int minLength, int maxLength);
 
+/** Check if a block of memory is well-formed UTF-8 (RFC 3629).
+ * Overlong forms, UTF-16 surrogates, and code points above 0x10ffff are
+ * rejected, as is a sequence cut off by the end of the block.
+ * Control characters, including NUL, are allowed.
+ *
+ * @param memory The memory location to test.
+ *
+ * @param length The number of bytes to test.
+ */
+bool crasheestring_isValidUTF8(const void* memory, int length);
+
+/** Replace every byte that isn't part of a well-formed UTF-8 sequence, as
+ * crasheestring_isValidUTF8() defines it, with a replacement character.
+ * The length of the string doesn't change.
+ *
+ * @param string The string to repair.
+ *
+ * @param length The length of the string in bytes.
+ *
+ * @param replacement The ASCII character to replace bad bytes with.
+ *
+ * @return The number of bytes that were replaced.
+ */
+int crasheestring_replaceInvalidUTF8(char* string, int length, char replacement);
+
 /** Extract a hex value in the form "0x123456789abcdef" from a string.
  *
  * @param string The string to search.
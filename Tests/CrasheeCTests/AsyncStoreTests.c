@@ -0,0 +1,477 @@
+//
+//  AsyncStoreTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeCrashReportFixer.h"
+#include "CrasheeCrashReportStore.h"
+#include "CrasheeFileUtils.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+// ============================================================================
+#pragma mark - Helpers -
+// ============================================================================
+
+/** Wait up to 10 seconds for the store's background work to get somewhere. */
+#define WAIT_FOR(CONDITION) \
+    for(int waited = 0; waited < 1000 && !(CONDITION); waited++) usleep(10000)
+
+enum { MaxReports = 4000 };
+
+/** Collects what the completions of the batches submitted so far reported. */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    int batchCount;
+    int completedCount;
+    /** IDs of added reports, in the order the batches were submitted. */
+    int64_t reportIDs[MaxReports];
+    int reportIDCount;
+    /** Reports passed to the read callback, and how many didn't match. */
+    atomic_int readCount;
+    atomic_int mismatchCount;
+} Batches;
+
+static Batches g_batches =
+{
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .condition = PTHREAD_COND_INITIALIZER,
+};
+
+static void resetBatches(void)
+{
+    pthread_mutex_lock(&g_batches.mutex);
+    g_batches.batchCount = 0;
+    g_batches.completedCount = 0;
+    g_batches.reportIDCount = 0;
+    g_batches.readCount = 0;
+    g_batches.mismatchCount = 0;
+    pthread_mutex_unlock(&g_batches.mutex);
+}
+
+static void onBatchCompleted(__unused const int64_t* const reportIDs,
+                             __unused const int count,
+                             const int completedCount,
+                             void* const userData)
+{
+    Batches* const batches = userData;
+    pthread_mutex_lock(&batches->mutex);
+    batches->batchCount++;
+    batches->completedCount += completedCount;
+    pthread_cond_broadcast(&batches->condition);
+    pthread_mutex_unlock(&batches->mutex);
+}
+
+static void onAddBatchCompleted(const int64_t* const reportIDs,
+                                const int count,
+                                const int completedCount,
+                                void* const userData)
+{
+    Batches* const batches = userData;
+    pthread_mutex_lock(&batches->mutex);
+    for(int i = 0; i < count && batches->reportIDCount < MaxReports; i++)
+    {
+        batches->reportIDs[batches->reportIDCount++] = reportIDs[i];
+    }
+    pthread_mutex_unlock(&batches->mutex);
+    onBatchCompleted(reportIDs, count, completedCount, userData);
+}
+
+/** Wait for a number of batches to complete, for up to 30 seconds.
+ *
+ * @return false if they didn't.
+ */
+static bool waitForBatches(Batches* const batches, const int batchCount)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 30;
+    pthread_mutex_lock(&batches->mutex);
+    while(batches->batchCount < batchCount)
+    {
+        if(pthread_cond_timedwait(&batches->condition, &batches->mutex, &deadline) != 0)
+        {
+            break;
+        }
+    }
+    const bool isDone = batches->batchCount >= batchCount;
+    pthread_mutex_unlock(&batches->mutex);
+    return isDone;
+}
+
+/** Make report i, which says which one it is at the start. */
+static int makeReport(char* const buffer, const int index, const int length)
+{
+    const int headerLength = snprintf(buffer, 64, "{\"index\":%d,\"padding\":\"", index);
+    const int padding = length - headerLength - 2;
+    memset(buffer + headerLength, 'a' + index % 26, (size_t)padding);
+    memcpy(buffer + headerLength + padding, "\"}", 3);
+    return length;
+}
+
+static void checkReport(__unused const int64_t reportID,
+                        const CrasheeFileView* const report,
+                        __unused const bool isFixedUp,
+                        void* const userData)
+{
+    Batches* const batches = userData;
+    char header[64] = "";
+    memcpy(header, report->data, report->length < 63 ? (size_t)report->length : 63);
+    int index = -1;
+    sscanf(header, "{\"index\":%d", &index);
+    static _Thread_local char expected[4096];
+    const bool matches = index >= 0 &&
+                         report->length <= (int)sizeof(expected) &&
+                         makeReport(expected, index, (int)report->length) == report->length &&
+                         memcmp(expected, report->data, (size_t)report->length) == 0;
+    batches->readCount++;
+    batches->mismatchCount += !matches;
+}
+
+/** Count the files in a directory whose names contain a string. */
+static int countFiles(const char* const directory, const char* const nameContains)
+{
+    DIR* dir = opendir(directory);
+    if(dir == NULL)
+    {
+        return -1;
+    }
+    int count = 0;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        count += strstr(entry->d_name, nameContains) != NULL;
+    }
+    closedir(dir);
+    return count;
+}
+
+static void initializeStore(const char* const directory, const CrasheeUserReportStorage storage)
+{
+    crasheecrs_initialize("CrasheeCTests", directory);
+    crasheecrs_setMaxReportCount(100000);
+    crasheecrs_setMaxReportCountOfKind(CrasheeReportKindUser, 0);
+    crasheecrs_setMaxReportBytes(0);
+    crasheecrs_setMaxReportAge(0);
+    crasheecrs_setUserReportStorage(storage);
+    crasheecrs_deleteAllReports();
+}
+
+/** Submit reports to be added in batches, without waiting for them.
+ *
+ * @return The number of batches submitted.
+ */
+static int addReports(const int count, const int batchLength, const int reportLength)
+{
+    char* data = malloc((size_t)count * (size_t)(reportLength + 1));
+    const char** reports = malloc(sizeof(*reports) * (size_t)count);
+    int* reportLengths = malloc(sizeof(*reportLengths) * (size_t)count);
+    int batchCount = 0;
+    if(data != NULL && reports != NULL && reportLengths != NULL)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            reports[i] = data + i * (reportLength + 1);
+            reportLengths[i] = makeReport(data + i * (reportLength + 1), i, reportLength);
+        }
+        for(int i = 0; i < count; i += batchLength)
+        {
+            const int length = count - i < batchLength ? count - i : batchLength;
+            batchCount += crasheecrs_addUserReportsAsync(reports + i, reportLengths + i, length,
+                                                         onAddBatchCompleted, &g_batches);
+        }
+    }
+    // Reports are copied when queued.
+    free(data);
+    free(reports);
+    free(reportLengths);
+    return batchCount;
+}
+
+
+// ============================================================================
+#pragma mark - Tests -
+// ============================================================================
+
+/** Add, read and delete reports in batches queued back to back. */
+static void testBatches(const CrasheeUserReportStorage storage, const char* const name)
+{
+    enum { Count = 300, BatchLength = 50 };
+    char directory[400];
+    CrasheeTEST_CHECK(crasheetest_makeTemporaryDirectory(name, directory, sizeof(directory)));
+    initializeStore(directory, storage);
+    resetBatches();
+
+    CrasheeTEST_CHECK(addReports(Count, BatchLength, 1000) == Count / BatchLength);
+    CrasheeTEST_CHECK(waitForBatches(&g_batches, Count / BatchLength));
+    CrasheeTEST_CHECK(g_batches.completedCount == Count && g_batches.reportIDCount == Count);
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == Count);
+
+    // The reads run before the deletes queued right behind them.
+    static int64_t reportIDs[Count];
+    memcpy(reportIDs, g_batches.reportIDs, sizeof(reportIDs));
+    resetBatches();
+    CrasheeTEST_CHECK(crasheecrs_readReportsAsync(reportIDs, Count, checkReport, onBatchCompleted, &g_batches));
+    CrasheeTEST_CHECK(crasheecrs_deleteReportsAsync(reportIDs, Count, onBatchCompleted, &g_batches));
+    CrasheeTEST_CHECK(waitForBatches(&g_batches, 2));
+    CrasheeTEST_CHECK(g_batches.readCount == Count && g_batches.mismatchCount == 0);
+    CrasheeTEST_CHECK(g_batches.completedCount == Count * 2);
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == 0);
+    CrasheeTEST_CHECK(countFiles(directory, "-report-") == 0);
+
+    crasheecrs_initialize("CrasheeCTests", directory);
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == 0);
+    crasheecrs_deleteAllReports();
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageFiles);
+}
+
+typedef struct
+{
+    const char* data;
+    int length;
+} Report;
+
+static bool writeFixedUpReport(const int fd, void* const userData)
+{
+    const Report* const report = userData;
+    return crasheecrf_fixupCrashReportToFD(report->data, report->length, fd);
+}
+
+typedef struct
+{
+    const int64_t* reportIDs;
+    int count;
+} Fixer;
+
+/** Fix up crash reports, newest first, the way the report sink does on upload. */
+static void* fixUpReports(void* const userData)
+{
+    const Fixer* const fixer = userData;
+    for(int i = fixer->count - 1; i >= 0; i--)
+    {
+        CrasheeFileView view;
+        bool isFixedUp = false;
+        if(!crasheecrs_mapReport(fixer->reportIDs[i], &view, &isFixedUp))
+        {
+            continue;
+        }
+        if(!isFixedUp)
+        {
+            Report report = {view.data, (int)view.length};
+            crasheecrs_replaceWithFixedUpReport(fixer->reportIDs[i], writeFixedUpReport, &report);
+        }
+        crasheecrs_unmapReport(&view);
+    }
+    return NULL;
+}
+
+/** Deleting reports while they're being fixed up and compressed in the
+ * background must not leave any of them behind, listed or on disk.
+ */
+static void testDeleteWhileTranscoding(void)
+{
+    enum { Count = 200, BatchLength = 50, Rounds = 3 };
+    char directory[400];
+    CrasheeTEST_CHECK(crasheetest_makeTemporaryDirectory("async-transcoding", directory, sizeof(directory)));
+    // Small, so that fixing one up takes about as long as deleting a batch.
+    static const char report[] =
+        "{\"report\":{\"version\":\"3.3.0\",\"id\":\"1D7E0C1A-3B55-4F0E-8E2A-6A9F4C2D0B17\","
+        "\"process_name\":\"Sample\",\"timestamp\":1718000000,\"type\":\"standard\"},"
+        "\"system\":{\"system_name\":\"iOS\",\"CFBundleExecutable\":\"Sample\"},"
+        "\"crash\":{\"error\":{\"signal\":{\"signal\":11,\"name\":\"SIGSEGV\"},\"type\":\"signal\"},"
+        "\"threads\":[{\"index\":0,\"crashed\":true,\"backtrace\":{\"contents\":["
+        "{\"instruction_addr\":4295000000,\"object_addr\":4294967296,\"object_name\":\"Sample\"}]}}]}}";
+    const int reportLength = (int)sizeof(report) - 1;
+
+    static int64_t reportIDs[Count];
+    for(int round = 0; round < Rounds; round++)
+    {
+        initializeStore(directory, CrasheeUserReportStorageFiles);
+        resetBatches();
+        int writtenCount = 0;
+        for(int i = 0; i < Count; i++)
+        {
+            char path[CrasheeCRS_MAX_PATH_LENGTH];
+            reportIDs[i] = crasheecrs_getNextCrashReport(path);
+            FILE* file = fopen(path, "w");
+            if(file != NULL)
+            {
+                writtenCount += fwrite(report, 1, (size_t)reportLength, file) == (size_t)reportLength;
+                fclose(file);
+            }
+            crasheecrs_notifyReportWritten(reportIDs[i]);
+        }
+        CrasheeTEST_CHECK(writtenCount == Count);
+
+        Fixer fixer = {reportIDs, Count};
+        pthread_t thread;
+        const bool isFixing = pthread_create(&thread, NULL, fixUpReports, &fixer) == 0;
+        // Oldest first, one batch at a time, so that the deletes run into
+        // the fix ups coming the other way.
+        int batchCount = 0;
+        for(int i = 0; i < Count; i += BatchLength)
+        {
+            batchCount += crasheecrs_deleteReportsAsync(reportIDs + i, BatchLength, onBatchCompleted, &g_batches);
+            waitForBatches(&g_batches, batchCount);
+        }
+        CrasheeTEST_CHECK(batchCount == Count / BatchLength);
+        CrasheeTEST_CHECK(g_batches.batchCount == batchCount);
+        if(isFixing)
+        {
+            pthread_join(thread, NULL);
+        }
+        CrasheeTEST_CHECK(crasheecrs_getReportCount() == 0);
+        WAIT_FOR(countFiles(directory, "-report-") == 0);
+        CrasheeTEST_CHECK(countFiles(directory, "-report-") == 0);
+        crasheecrs_initialize("CrasheeCTests", directory);
+        CrasheeTEST_CHECK(crasheecrs_getReportCount() == 0);
+    }
+    crasheecrs_deleteAllReports();
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runAsyncStoreTests(void)
+{
+    testBatches(CrasheeUserReportStorageFiles, "async-files");
+    testBatches(CrasheeUserReportStorageSegments, "async-segments");
+    testDeleteWhileTranscoding();
+}
+
+static void countReport(__unused const int64_t reportID,
+                        __unused const CrasheeFileView* const report,
+                        __unused const bool isFixedUp,
+                        void* const userData)
+{
+    Batches* const batches = userData;
+    batches->readCount++;
+}
+
+/** Time listing, reading and deleting reports one at a time, then in batches. */
+static void benchmarkStorage(const CrasheeUserReportStorage storage, const int count)
+{
+    enum { ReportLength = 2048, BatchLength = 100 };
+    const char* const storageName = storage == CrasheeUserReportStorageSegments ? "segments" : "files";
+    char directory[400];
+    char name[100];
+    snprintf(name, sizeof(name), "async-benchmark-%s", storageName);
+    if(!crasheetest_makeTemporaryDirectory(name, directory, sizeof(directory)))
+    {
+        return;
+    }
+    initializeStore(directory, storage);
+    static int64_t reportIDs[MaxReports];
+    static char report[ReportLength + 1];
+
+    for(int isBatched = 0; isBatched < 2; isBatched++)
+    {
+        const char* const mode = isBatched ? "batched" : "one at a time";
+        resetBatches();
+        double start = crasheetest_now();
+        if(isBatched)
+        {
+            waitForBatches(&g_batches, addReports(count, BatchLength, ReportLength));
+            memcpy(reportIDs, g_batches.reportIDs, sizeof(*reportIDs) * (size_t)count);
+        }
+        else
+        {
+            for(int i = 0; i < count; i++)
+            {
+                reportIDs[i] = crasheecrs_addUserReport(report, makeReport(report, i, ReportLength));
+            }
+        }
+        snprintf(name, sizeof(name), "%s, %d reports, %s: add", storageName, count, mode);
+        crasheetest_reportBenchmark(name, count / (crasheetest_now() - start), "reports/s");
+
+        if(!isBatched)
+        {
+            static int64_t listedIDs[MaxReports];
+            start = crasheetest_now();
+            const int listedCount = crasheecrs_getReportIDs(listedIDs, MaxReports);
+            snprintf(name, sizeof(name), "%s, %d reports: list", storageName, listedCount);
+            crasheetest_reportBenchmark(name, (crasheetest_now() - start) * 1000, "ms");
+        }
+
+        resetBatches();
+        start = crasheetest_now();
+        if(isBatched)
+        {
+            crasheecrs_readReportsAsync(reportIDs, count, countReport, onBatchCompleted, &g_batches);
+            waitForBatches(&g_batches, 1);
+        }
+        else
+        {
+            for(int i = 0; i < count; i++)
+            {
+                free(crasheecrs_readReport(reportIDs[i]));
+            }
+        }
+        snprintf(name, sizeof(name), "%s, %d reports, %s: read", storageName, count, mode);
+        crasheetest_reportBenchmark(name, count / (crasheetest_now() - start), "reports/s");
+
+        resetBatches();
+        start = crasheetest_now();
+        if(isBatched)
+        {
+            int batchCount = 0;
+            for(int i = 0; i < count; i += BatchLength)
+            {
+                batchCount += crasheecrs_deleteReportsAsync(reportIDs + i, BatchLength, onBatchCompleted, &g_batches);
+            }
+            waitForBatches(&g_batches, batchCount);
+        }
+        else
+        {
+            for(int i = 0; i < count; i++)
+            {
+                crasheecrs_deleteReportWithID(reportIDs[i]);
+            }
+        }
+        snprintf(name, sizeof(name), "%s, %d reports, %s: delete", storageName, count, mode);
+        crasheetest_reportBenchmark(name, count / (crasheetest_now() - start), "reports/s");
+    }
+    crasheecrs_deleteAllReports();
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageFiles);
+}
+
+void crasheetest_runAsyncStoreBenchmarks(void)
+{
+    benchmarkStorage(CrasheeUserReportStorageFiles, 1000);
+    benchmarkStorage(CrasheeUserReportStorageFiles, 4000);
+    benchmarkStorage(CrasheeUserReportStorageSegments, 1000);
+    benchmarkStorage(CrasheeUserReportStorageSegments, 4000);
+}
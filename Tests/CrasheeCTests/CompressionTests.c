@@ -0,0 +1,386 @@
+//
+//  CompressionTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeCrashReportDictionary.h"
+#include "CrasheeCrashReportFixer.h"
+#include "CrasheeCrashReportStore.h"
+#include "CrasheeFileUtils.h"
+#include "CrasheeLZ.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// ============================================================================
+#pragma mark - Helpers -
+// ============================================================================
+
+/** Wait up to 10 seconds for the store's background work to get somewhere. */
+#define WAIT_FOR(CONDITION) \
+    for(int waited = 0; waited < 1000 && !(CONDITION); waited++) usleep(10000)
+
+static CrasheeLZWorkspace g_workspace;
+
+/** The start of a minified crash report, with the field names real ones have. */
+static const char* const g_sampleReport =
+    "{\"report\":{\"version\":\"3.3.0\",\"id\":\"5B1C1F0E-6D0A-4E8B-9A33-0C4F2B7D9E61\","
+    "\"process_name\":\"Sample\",\"timestamp\":1718000000,\"type\":\"standard\"},"
+    "\"system\":{\"system_name\":\"iOS\",\"system_version\":\"17.4\",\"machine\":\"iPhone14,5\","
+    "\"os_version\":\"21E219\",\"jailbroken\":false,\"CFBundleExecutable\":\"Sample\","
+    "\"CFBundleIdentifier\":\"com.example.sample\",\"CFBundleVersion\":\"42\","
+    "\"CFBundleShortVersionString\":\"2.1.0\",\"cpu_arch\":\"arm64e\",\"cpu_type\":16777228,"
+    "\"cpu_subtype\":2,\"time_zone\":\"GMT+1\",\"build_type\":\"app store\","
+    "\"memory\":{\"size\":4294967296,\"usable\":3758096384,\"free\":183500800},"
+    "\"application_stats\":{\"application_active\":true,\"application_in_foreground\":true,"
+    "\"launches_since_last_crash\":3,\"sessions_since_last_crash\":3,\"active_time_since_last_crash\":61.5,"
+    "\"background_time_since_last_crash\":0,\"sessions_since_launch\":1,\"active_time_since_launch\":12.25,"
+    "\"background_time_since_launch\":0}},"
+    "\"crash\":{\"error\":{\"mach\":{\"exception\":1,\"exception_name\":\"EXC_BAD_ACCESS\",\"code\":1,"
+    "\"code_name\":\"KERN_INVALID_ADDRESS\",\"subcode\":0},\"signal\":{\"signal\":11,\"name\":\"SIGSEGV\","
+    "\"code\":0,\"code_name\":\"SEGV_MAPERR\"},\"address\":16,\"type\":\"mach\"}}}";
+
+static uint64_t g_randomState = 0x9e3779b97f4a7c15ull;
+
+static uint64_t nextRandom(void)
+{
+    g_randomState ^= g_randomState << 13;
+    g_randomState ^= g_randomState >> 7;
+    g_randomState ^= g_randomState << 17;
+    return g_randomState;
+}
+
+/** Encode the synthetic report, pretty printed or not. */
+static void makeReport(CrasheeTestBuffer* const report, const bool prettyPrint)
+{
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, prettyPrint, crasheetest_addToBuffer, report);
+    crasheetest_encodeSyntheticReport(&context, NULL, NULL);
+}
+
+/** Compress data into a stream the way the report writer does, one frame per block. */
+static int compressStream(const char* const data, const int length, CrasheeTestBuffer* const stream)
+{
+    crasheetest_clearBuffer(stream);
+    char magic[CrasheeLZ_MAGIC_LENGTH];
+    crasheelz_writeMagic(magic);
+    crasheetest_addToBuffer(magic, sizeof(magic), stream);
+    for(int offset = 0; offset < length; offset += CrasheeLZ_BLOCK_SIZE)
+    {
+        const int remaining = length - offset;
+        const int frameLength = crasheelz_encodeFrame(&g_workspace,
+                                                      data + offset,
+                                                      remaining < CrasheeLZ_BLOCK_SIZE ? remaining : CrasheeLZ_BLOCK_SIZE);
+        crasheetest_addToBuffer(g_workspace.outputBuffer, frameLength, stream);
+    }
+    return stream->length;
+}
+
+static bool isBlockRoundTrip(const char* const data, const int length)
+{
+    static char compressed[CrasheeLZ_BLOCK_SIZE * 2];
+    static char decompressed[CrasheeLZ_BLOCK_SIZE];
+    const int compressedLength = crasheelz_compressBlock(data, length, compressed, sizeof(compressed), g_workspace.hashTable);
+    if(compressedLength <= 0 && length > 0)
+    {
+        return false;
+    }
+    const int decompressedLength = crasheelz_decompressBlock(compressed, compressedLength, decompressed, sizeof(decompressed));
+    return decompressedLength == length && memcmp(decompressed, data, (size_t)length) == 0;
+}
+
+static bool isDictionaryRoundTrip(const char* const data, const int length, const CrasheeLZDictionary* const dictionary)
+{
+    int compressedLength = -1;
+    int decompressedLength = -1;
+    char* compressed = crasheelz_compressWithDictionary(data, length, dictionary, &compressedLength);
+    char* decompressed = NULL;
+    if(compressed != NULL &&
+       crasheelz_isDictionaryCompressed(compressed, compressedLength) &&
+       crasheelz_getDictionaryID(compressed, compressedLength) == dictionary->id)
+    {
+        decompressed = crasheelz_decompressWithDictionary(compressed, compressedLength, dictionary, &decompressedLength);
+    }
+    const bool matches = decompressed != NULL && decompressedLength == length && memcmp(decompressed, data, (size_t)length) == 0;
+    free(compressed);
+    free(decompressed);
+    return matches;
+}
+
+
+// ============================================================================
+#pragma mark - Tests -
+// ============================================================================
+
+static void testBlocks(void)
+{
+    static char random[CrasheeLZ_BLOCK_SIZE];
+    for(int i = 0; i < CrasheeLZ_BLOCK_SIZE; i++)
+    {
+        random[i] = (char)nextRandom();
+    }
+    CrasheeTestBuffer report = {0};
+    makeReport(&report, true);
+    CrasheeTEST_CHECK(report.length > CrasheeLZ_BLOCK_SIZE);
+
+    static const int lengths[] = {0, 1, 4, 5, 12, 13, 100, 4095, 4096, CrasheeLZ_BLOCK_SIZE - 1, CrasheeLZ_BLOCK_SIZE};
+    int mismatches = 0;
+    for(int i = 0; i < (int)(sizeof(lengths) / sizeof(*lengths)); i++)
+    {
+        mismatches += !isBlockRoundTrip(random, lengths[i]);
+        mismatches += !isBlockRoundTrip(report.data, lengths[i]);
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+
+    // Damaged blocks are rejected or decode to something, but never overrun.
+    static char compressed[CrasheeLZ_BLOCK_SIZE * 2];
+    static char decompressed[CrasheeLZ_BLOCK_SIZE];
+    const int compressedLength = crasheelz_compressBlock(report.data, CrasheeLZ_BLOCK_SIZE, compressed, sizeof(compressed), g_workspace.hashTable);
+    CrasheeTEST_CHECK(compressedLength > 0 && compressedLength < CrasheeLZ_BLOCK_SIZE / 2);
+    for(int i = 0; i < 2000 && compressedLength > 0; i++)
+    {
+        const int offset = (int)(nextRandom() % (uint64_t)compressedLength);
+        const char original = compressed[offset];
+        compressed[offset] ^= (char)(1 + nextRandom() % 255);
+        crasheelz_decompressBlock(compressed, compressedLength, decompressed, sizeof(decompressed));
+        compressed[offset] = original;
+    }
+    crasheetest_freeBuffer(&report);
+}
+
+static void testStreams(void)
+{
+    CrasheeTestBuffer report = {0};
+    CrasheeTestBuffer stream = {0};
+    makeReport(&report, true);
+    compressStream(report.data, report.length, &stream);
+    CrasheeTEST_CHECK(crasheelz_isCompressed(stream.data, stream.length));
+    CrasheeTEST_CHECK(stream.length < report.length / 2);
+
+    int length = -1;
+    char* decompressed = crasheelz_decompressStream(stream.data, stream.length, &length);
+    CrasheeTEST_CHECK(decompressed != NULL && length == report.length && memcmp(decompressed, report.data, (size_t)length) == 0);
+    free(decompressed);
+
+    // A stream cut off while being written still gives back its whole frames.
+    decompressed = crasheelz_decompressStream(stream.data, stream.length - 10, &length);
+    CrasheeTEST_CHECK(decompressed != NULL && length < report.length && length % CrasheeLZ_BLOCK_SIZE == 0 &&
+                      memcmp(decompressed, report.data, (size_t)length) == 0);
+    free(decompressed);
+
+    crasheetest_freeBuffer(&report);
+    crasheetest_freeBuffer(&stream);
+}
+
+static void testDictionary(void)
+{
+    const CrasheeLZDictionary* const dictionary = crasheecrd_getCurrentDictionary();
+    CrasheeTEST_CHECK(dictionary != NULL && dictionary->id != 0);
+    CrasheeTEST_CHECK(dictionary->length > 0 && dictionary->length <= CrasheeLZ_MAX_DICTIONARY_LENGTH);
+    CrasheeTEST_CHECK(crasheecrd_getDictionary(dictionary->id) == dictionary);
+    CrasheeTEST_CHECK(crasheecrd_getDictionary(dictionary->id + 1) == NULL);
+
+    CrasheeTestBuffer report = {0};
+    makeReport(&report, false);
+    char* random = malloc((size_t)report.length);
+    for(int i = 0; random != NULL && i < report.length; i++)
+    {
+        random[i] = (char)nextRandom();
+    }
+    CrasheeTEST_CHECK(random != NULL);
+
+    // Frame sizes around the block space left over by the dictionary.
+    const int frameLength = CrasheeLZ_BLOCK_SIZE - dictionary->length;
+    const int lengths[] = {0, 1, 5, 13, 100, frameLength - 1, frameLength, frameLength + 1, frameLength * 3 + 7, report.length};
+    int mismatches = 0;
+    for(int i = 0; random != NULL && i < (int)(sizeof(lengths) / sizeof(*lengths)); i++)
+    {
+        mismatches += !isDictionaryRoundTrip(report.data, lengths[i], dictionary);
+        mismatches += !isDictionaryRoundTrip(random, lengths[i], dictionary);
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+
+    // The dictionary pays for itself on a report that uses the real field names.
+    CrasheeLZDictionary empty = {.id = dictionary->id + 1, .data = "", .length = 0};
+    const int sampleLength = (int)strlen(g_sampleReport);
+    int withLength = 0;
+    int withoutLength = 0;
+    char* with = crasheelz_compressWithDictionary(g_sampleReport, sampleLength, dictionary, &withLength);
+    char* without = crasheelz_compressWithDictionary(g_sampleReport, sampleLength, &empty, &withoutLength);
+    CrasheeTEST_CHECK(with != NULL && without != NULL && withLength < withoutLength * 2 / 3);
+    free(with);
+    free(without);
+    with = crasheelz_compressWithDictionary(report.data, report.length, dictionary, &withLength);
+    CrasheeTEST_CHECK(with != NULL);
+
+    // Streams are only decompressed with the dictionary they name, and a
+    // truncated one gives back what it can.
+    CrasheeTEST_CHECK(crasheelz_decompressWithDictionary(with, withLength, &empty, NULL) == NULL);
+    CrasheeTEST_CHECK(crasheelz_decompressStream(with, withLength, NULL) == NULL);
+    int length = -1;
+    char* decompressed = crasheelz_decompressWithDictionary(with, withLength - 10, dictionary, &length);
+    CrasheeTEST_CHECK(decompressed != NULL && length < report.length && memcmp(decompressed, report.data, (size_t)length) == 0);
+    free(decompressed);
+
+    for(int i = 0; i < 500 && with != NULL; i++)
+    {
+        const int offset = CrasheeLZ_DICTIONARY_HEADER_LENGTH + (int)(nextRandom() % (uint64_t)(withLength - CrasheeLZ_DICTIONARY_HEADER_LENGTH));
+        const char original = with[offset];
+        with[offset] ^= (char)(1 + nextRandom() % 255);
+        free(crasheelz_decompressWithDictionary(with, withLength, dictionary, NULL));
+        with[offset] = original;
+    }
+
+    free(with);
+    free(random);
+    crasheetest_freeBuffer(&report);
+}
+
+static bool writeReport(const int fd, void* const userData)
+{
+    const CrasheeTestBuffer* const report = userData;
+    return write(fd, report->data, (size_t)report->length) == report->length;
+}
+
+static bool isCompressedAtRest(const char* const path)
+{
+    CrasheeFileView view;
+    if(!crasheefu_mapFile(path, &view, 0))
+    {
+        return false;
+    }
+    const bool isCompressed = crasheelz_isDictionaryCompressed(view.data, view.length);
+    crasheefu_unmapFile(&view);
+    return isCompressed;
+}
+
+/** A fixed up report is minified and compressed in the background, and reads back minified. */
+static void testReportsAtRest(void)
+{
+    char directory[400];
+    CrasheeTEST_CHECK(crasheetest_makeTemporaryDirectory("compression", directory, sizeof(directory)));
+    crasheecrs_initialize("CrasheeCTests", directory);
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageFiles);
+
+    CrasheeTestBuffer report = {0};
+    makeReport(&report, true);
+    int minifiedLength = 0;
+    char* minified = crasheecrf_minifyCrashReport(report.data, report.length, &minifiedLength);
+    CrasheeTEST_CHECK(minified != NULL);
+
+    const int64_t reportID = crasheecrs_addUserReport("{}", 2);
+    CrasheeTEST_CHECK(crasheecrs_replaceWithFixedUpReport(reportID, writeReport, &report));
+    char path[CrasheeCRS_MAX_PATH_LENGTH];
+    crasheecrs_getCrashReportPath(reportID, path);
+    WAIT_FOR(isCompressedAtRest(path));
+    CrasheeTEST_CHECK(isCompressedAtRest(path));
+
+    char* readBack = crasheecrs_readReport(reportID);
+    CrasheeTEST_CHECK(readBack != NULL && minified != NULL && strcmp(readBack, minified) == 0);
+    free(readBack);
+    free(minified);
+    crasheecrs_deleteAllReports();
+    crasheetest_freeBuffer(&report);
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runCompressionTests(void)
+{
+    testBlocks();
+    testStreams();
+    testDictionary();
+    testReportsAtRest();
+}
+
+void crasheetest_runCompressionBenchmarks(void)
+{
+    enum { Repetitions = 20 };
+    const CrasheeLZDictionary* const dictionary = crasheecrd_getCurrentDictionary();
+    CrasheeLZDictionary empty = {.id = dictionary->id + 1, .data = "", .length = 0};
+    CrasheeTestBuffer pretty = {0};
+    CrasheeTestBuffer minified = {0};
+    CrasheeTestBuffer stream = {0};
+    makeReport(&pretty, true);
+    makeReport(&minified, false);
+    const double megabytes = (double)pretty.length * Repetitions / (1024 * 1024);
+
+    double start = crasheetest_now();
+    for(int i = 0; i < Repetitions; i++)
+    {
+        compressStream(pretty.data, pretty.length, &stream);
+    }
+    crasheetest_reportBenchmark("stream, pretty report: compress", megabytes / (crasheetest_now() - start), "MB/s");
+    start = crasheetest_now();
+    for(int i = 0; i < Repetitions; i++)
+    {
+        free(crasheelz_decompressStream(stream.data, stream.length, NULL));
+    }
+    crasheetest_reportBenchmark("stream, pretty report: decompress", megabytes / (crasheetest_now() - start), "MB/s");
+    crasheetest_reportBenchmark("stream, pretty report: ratio", (double)pretty.length / stream.length, "x");
+
+    const CrasheeLZDictionary* const dictionaries[] = {&empty, dictionary};
+    const char* const names[] = {"no dictionary", "dictionary"};
+    char name[100];
+    for(int d = 0; d < 2; d++)
+    {
+        const double minifiedMegabytes = (double)minified.length * Repetitions / (1024 * 1024);
+        int compressedLength = 0;
+        char* compressed = NULL;
+        start = crasheetest_now();
+        for(int i = 0; i < Repetitions; i++)
+        {
+            free(compressed);
+            compressed = crasheelz_compressWithDictionary(minified.data, minified.length, dictionaries[d], &compressedLength);
+        }
+        snprintf(name, sizeof(name), "%s, minified report: compress", names[d]);
+        crasheetest_reportBenchmark(name, minifiedMegabytes / (crasheetest_now() - start), "MB/s");
+        start = crasheetest_now();
+        for(int i = 0; i < Repetitions && compressed != NULL; i++)
+        {
+            free(crasheelz_decompressWithDictionary(compressed, compressedLength, dictionaries[d], NULL));
+        }
+        snprintf(name, sizeof(name), "%s, minified report: decompress", names[d]);
+        crasheetest_reportBenchmark(name, minifiedMegabytes / (crasheetest_now() - start), "MB/s");
+        snprintf(name, sizeof(name), "%s, report at rest: ratio", names[d]);
+        crasheetest_reportBenchmark(name, compressedLength > 0 ? (double)pretty.length / compressedLength : 0, "x");
+        free(compressed);
+
+        const int sampleLength = (int)strlen(g_sampleReport);
+        compressed = crasheelz_compressWithDictionary(g_sampleReport, sampleLength, dictionaries[d], &compressedLength);
+        snprintf(name, sizeof(name), "%s, %d byte sample report: ratio", names[d], sampleLength);
+        crasheetest_reportBenchmark(name, compressedLength > 0 ? (double)sampleLength / compressedLength : 0, "x");
+        free(compressed);
+    }
+
+    crasheetest_freeBuffer(&pretty);
+    crasheetest_freeBuffer(&minified);
+    crasheetest_freeBuffer(&stream);
+}
@@ -0,0 +1,259 @@
+//
+//  ConcurrentStoreTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeCrashReportStore.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// ============================================================================
+#pragma mark - Helpers -
+// ============================================================================
+
+enum { MaxThreads = 8 };
+
+typedef struct
+{
+    int threadIndex;
+    int reportCount;
+    /** Delete every other report right after adding it. */
+    bool shouldDeleteOdd;
+    int64_t* reportIDs;
+} Submitter;
+
+static int makeReport(char* const buffer, const int threadIndex, const int index)
+{
+    return snprintf(buffer, 200, "{\"thread\":%d,\"index\":%d,\"padding\":\"%0*d\"}",
+                    threadIndex, index, 20 + index % 50, index);
+}
+
+static void* submitReports(void* const userData)
+{
+    Submitter* const submitter = userData;
+    char report[200];
+    for(int i = 0; i < submitter->reportCount; i++)
+    {
+        const int length = makeReport(report, submitter->threadIndex, i);
+        submitter->reportIDs[i] = crasheecrs_addUserReport(report, length);
+        if(submitter->shouldDeleteOdd && i % 2 == 1)
+        {
+            crasheecrs_deleteReportWithID(submitter->reportIDs[i]);
+        }
+    }
+    return NULL;
+}
+
+/** Add reports from several threads at once.
+ *
+ * @return The time taken in seconds, or a negative value if a thread couldn't be started.
+ */
+static double runSubmitters(Submitter* const submitters, const int threadCount)
+{
+    pthread_t threads[MaxThreads];
+    int startedCount = 0;
+    const double start = crasheetest_now();
+    for(; startedCount < threadCount; startedCount++)
+    {
+        if(pthread_create(&threads[startedCount], NULL, submitReports, &submitters[startedCount]) != 0)
+        {
+            break;
+        }
+    }
+    for(int i = 0; i < startedCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    const double seconds = crasheetest_now() - start;
+    return startedCount == threadCount ? seconds : -1;
+}
+
+static int compareIDs(const void* const a, const void* const b)
+{
+    const int64_t left = *(const int64_t*)a;
+    const int64_t right = *(const int64_t*)b;
+    return left < right ? -1 : left > right;
+}
+
+static bool areUnique(const int64_t* const reportIDs, const int count)
+{
+    int64_t* sorted = malloc(sizeof(*sorted) * (size_t)count);
+    if(sorted == NULL)
+    {
+        return false;
+    }
+    memcpy(sorted, reportIDs, sizeof(*sorted) * (size_t)count);
+    qsort(sorted, (size_t)count, sizeof(*sorted), compareIDs);
+    bool unique = true;
+    for(int i = 0; i < count && unique; i++)
+    {
+        unique = sorted[i] > 0 && (i == 0 || sorted[i] != sorted[i - 1]);
+    }
+    free(sorted);
+    return unique;
+}
+
+static void initializeStore(const char* const directory,
+                            const CrasheeUserReportStorage storage,
+                            const CrasheeReportDurability durability)
+{
+    crasheecrs_initialize("CrasheeCTests", directory);
+    crasheecrs_setMaxReportCount(100000);
+    crasheecrs_setMaxReportCountOfKind(CrasheeReportKindUser, 0);
+    crasheecrs_setMaxReportBytes(0);
+    crasheecrs_setMaxReportAge(0);
+    crasheecrs_setUserReportStorage(storage);
+    crasheecrs_setReportDurability(durability);
+    crasheecrs_deleteAllReports();
+}
+
+static void resetStore(void)
+{
+    crasheecrs_deleteAllReports();
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageFiles);
+    crasheecrs_setReportDurability(CrasheeReportDurabilityNone);
+}
+
+
+// ============================================================================
+#pragma mark - Tests -
+// ============================================================================
+
+static void testConcurrentSubmission(const CrasheeUserReportStorage storage, const char* const name)
+{
+    enum { ReportsPerThread = 150 };
+    char directory[400];
+    CrasheeTEST_CHECK(crasheetest_makeTemporaryDirectory(name, directory, sizeof(directory)));
+    initializeStore(directory, storage, CrasheeReportDurabilityGroupCommit);
+
+    static int64_t reportIDs[MaxThreads * ReportsPerThread];
+    Submitter submitters[MaxThreads];
+    for(int i = 0; i < MaxThreads; i++)
+    {
+        submitters[i] = (Submitter)
+        {
+            .threadIndex = i,
+            .reportCount = ReportsPerThread,
+            .shouldDeleteOdd = true,
+            .reportIDs = reportIDs + i * ReportsPerThread,
+        };
+    }
+    CrasheeTEST_CHECK(runSubmitters(submitters, MaxThreads) >= 0);
+    CrasheeTEST_CHECK(areUnique(reportIDs, MaxThreads * ReportsPerThread));
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == MaxThreads * ReportsPerThread / 2);
+
+    // The kept reports are exactly the ones listed, and read back as they
+    // were added, after a reload too.
+    static int64_t keptIDs[MaxThreads * ReportsPerThread / 2];
+    static int64_t listedIDs[MaxThreads * ReportsPerThread / 2 + 1];
+    const int keptCount = MaxThreads * ReportsPerThread / 2;
+    for(int i = 0; i < keptCount; i++)
+    {
+        keptIDs[i] = reportIDs[i * 2];
+    }
+    qsort(keptIDs, (size_t)keptCount, sizeof(*keptIDs), compareIDs);
+    for(int pass = 0; pass < 2; pass++)
+    {
+        const int listedCount = crasheecrs_getReportIDs(listedIDs, keptCount + 1);
+        qsort(listedIDs, (size_t)listedCount, sizeof(*listedIDs), compareIDs);
+        CrasheeTEST_CHECK(listedCount == keptCount && memcmp(listedIDs, keptIDs, sizeof(keptIDs)) == 0);
+
+        int mismatches = 0;
+        char expected[200];
+        for(int thread = 0; thread < MaxThreads; thread++)
+        {
+            for(int i = 0; i < ReportsPerThread; i += 2)
+            {
+                char* report = crasheecrs_readReport(reportIDs[thread * ReportsPerThread + i]);
+                makeReport(expected, thread, i);
+                mismatches += report == NULL || strcmp(report, expected) != 0;
+                free(report);
+            }
+        }
+        CrasheeTEST_CHECK(mismatches == 0);
+        crasheecrs_initialize("CrasheeCTests", directory);
+    }
+    resetStore();
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runConcurrentStoreTests(void)
+{
+    testConcurrentSubmission(CrasheeUserReportStorageFiles, "concurrent-files");
+    testConcurrentSubmission(CrasheeUserReportStorageSegments, "concurrent-segments");
+}
+
+static void benchmarkSubmission(const CrasheeUserReportStorage storage, const CrasheeReportDurability durability)
+{
+    enum { ReportsPerThread = 500 };
+    const char* const storageName = storage == CrasheeUserReportStorageSegments ? "segments" : "files";
+    const char* const durabilityName = durability == CrasheeReportDurabilitySync ? "sync" : "none";
+    char directory[400];
+    char name[100];
+    snprintf(name, sizeof(name), "concurrent-benchmark-%s-%s", storageName, durabilityName);
+    if(!crasheetest_makeTemporaryDirectory(name, directory, sizeof(directory)))
+    {
+        return;
+    }
+    initializeStore(directory, storage, durability);
+
+    static int64_t reportIDs[MaxThreads * ReportsPerThread];
+    Submitter submitters[MaxThreads];
+    for(int threadCount = 1; threadCount <= MaxThreads; threadCount *= 2)
+    {
+        for(int i = 0; i < threadCount; i++)
+        {
+            submitters[i] = (Submitter)
+            {
+                .threadIndex = i,
+                .reportCount = ReportsPerThread,
+                .reportIDs = reportIDs + i * ReportsPerThread,
+            };
+        }
+        const double seconds = runSubmitters(submitters, threadCount);
+        if(seconds > 0)
+        {
+            snprintf(name, sizeof(name), "%s, durability %s, %d threads: add", storageName, durabilityName, threadCount);
+            crasheetest_reportBenchmark(name, threadCount * ReportsPerThread / seconds, "reports/s");
+        }
+        crasheecrs_deleteAllReports();
+    }
+    resetStore();
+}
+
+void crasheetest_runConcurrentStoreBenchmarks(void)
+{
+    benchmarkSubmission(CrasheeUserReportStorageFiles, CrasheeReportDurabilityNone);
+    benchmarkSubmission(CrasheeUserReportStorageFiles, CrasheeReportDurabilitySync);
+    benchmarkSubmission(CrasheeUserReportStorageSegments, CrasheeReportDurabilityNone);
+    benchmarkSubmission(CrasheeUserReportStorageSegments, CrasheeReportDurabilitySync);
+}
@@ -0,0 +1,308 @@
+//
+//  CrasheeCTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeCrashReportFields.h"
+#include "CrasheeFileUtils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+// ============================================================================
+#pragma mark - Globals -
+// ============================================================================
+
+static int g_checkCount;
+static int g_failureCount;
+
+
+// ============================================================================
+#pragma mark - Checks -
+// ============================================================================
+
+void crasheetest_check(const bool passed, const char* const expression, const char* const file, const int line)
+{
+    g_checkCount++;
+    if(!passed)
+    {
+        g_failureCount++;
+        printf("FAILED %s:%d: %s\n", file, line, expression);
+    }
+}
+
+int crasheetest_getCheckCount(void)
+{
+    return g_checkCount;
+}
+
+int crasheetest_getFailureCount(void)
+{
+    return g_failureCount;
+}
+
+
+// ============================================================================
+#pragma mark - Benchmarks -
+// ============================================================================
+
+double crasheetest_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+void crasheetest_reportBenchmark(const char* const name, const double value, const char* const unit)
+{
+    printf("    %-56s %12.2f %s\n", name, value, unit);
+}
+
+
+// ============================================================================
+#pragma mark - Files -
+// ============================================================================
+
+bool crasheetest_makeTemporaryDirectory(const char* const name, char* const path, const int maxLength)
+{
+    const char* base = getenv("TMPDIR");
+    if(base == NULL || *base == '\0')
+    {
+        base = "/tmp";
+    }
+    if(snprintf(path, (size_t)maxLength, "%s/CrasheeCTests/%s", base, name) >= maxLength)
+    {
+        return false;
+    }
+    return crasheefu_makePath(path) && crasheefu_deleteContentsOfPath(path);
+}
+
+
+// ============================================================================
+#pragma mark - JSON -
+// ============================================================================
+
+int crasheetest_addToBuffer(const char* const data, const int length, void* const userData)
+{
+    CrasheeTestBuffer* buffer = (CrasheeTestBuffer*)userData;
+    if(buffer->length + length >= buffer->capacity)
+    {
+        int capacity = buffer->capacity < 4096 ? 4096 : buffer->capacity;
+        while(buffer->length + length >= capacity)
+        {
+            capacity *= 2;
+        }
+        char* data = realloc(buffer->data, (size_t)capacity);
+        if(data == NULL)
+        {
+            return CrasheeJSON_ERROR_CANNOT_ADD_DATA;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, data, (size_t)length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+    return CrasheeJSON_OK;
+}
+
+void crasheetest_clearBuffer(CrasheeTestBuffer* const buffer)
+{
+    buffer->length = 0;
+    if(buffer->data != NULL)
+    {
+        buffer->data[0] = '\0';
+    }
+}
+
+void crasheetest_freeBuffer(CrasheeTestBuffer* const buffer)
+{
+    free(buffer->data);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+static int echo_onBooleanElement(const char* const name, const bool value, void* const userData)
+{
+    return crasheejson_addBooleanElement(userData, name, value);
+}
+
+static int echo_onFloatingPointElement(const char* const name, const double value, void* const userData)
+{
+    return crasheejson_addFloatingPointElement(userData, name, value);
+}
+
+static int echo_onIntegerElement(const char* const name, const int64_t value, void* const userData)
+{
+    return crasheejson_addIntegerElement(userData, name, value);
+}
+
+static int echo_onUnsignedIntegerElement(const char* const name, const uint64_t value, void* const userData)
+{
+    return crasheejson_addUIntegerElement(userData, name, value);
+}
+
+static int echo_onNullElement(const char* const name, void* const userData)
+{
+    return crasheejson_addNullElement(userData, name);
+}
+
+static int echo_onStringElement(const char* const name, const char* const value, void* const userData)
+{
+    return crasheejson_addStringElement(userData, name, value, (int)strlen(value));
+}
+
+static int echo_onBeginObject(const char* const name, void* const userData)
+{
+    return crasheejson_beginObject(userData, name);
+}
+
+static int echo_onBeginArray(const char* const name, void* const userData)
+{
+    return crasheejson_beginArray(userData, name);
+}
+
+static int echo_onEndContainer(void* const userData)
+{
+    return crasheejson_endContainer(userData);
+}
+
+static int echo_onEndData(void* const userData)
+{
+    return crasheejson_endEncode(userData);
+}
+
+void crasheetest_getEchoCallbaccrashee(CrasheeJSONDecodeCallbaccrashee* const callbaccrashee)
+{
+    memset(callbaccrashee, 0, sizeof(*callbaccrashee));
+    callbaccrashee->onBooleanElement = echo_onBooleanElement;
+    callbaccrashee->onFloatingPointElement = echo_onFloatingPointElement;
+    callbaccrashee->onIntegerElement = echo_onIntegerElement;
+    callbaccrashee->onUnsignedIntegerElement = echo_onUnsignedIntegerElement;
+    callbaccrashee->onNullElement = echo_onNullElement;
+    callbaccrashee->onStringElement = echo_onStringElement;
+    callbaccrashee->onBeginObject = echo_onBeginObject;
+    callbaccrashee->onBeginArray = echo_onBeginArray;
+    callbaccrashee->onEndContainer = echo_onEndContainer;
+    callbaccrashee->onEndData = echo_onEndData;
+}
+
+static void endSection(void (*const onSectionEnd)(void*), void* const userData)
+{
+    if(onSectionEnd != NULL)
+    {
+        onSectionEnd(userData);
+    }
+}
+
+void crasheetest_encodeSyntheticReport(CrasheeJSONEncodeContext* const context,
+                                       void (*const onSectionEnd)(void* userData),
+                                       void* const userData)
+{
+    crasheejson_setInternedNames(context, g_crasheeCrashFieldNames, CrasheeCrashFieldCount);
+    crasheejson_beginObject(context, NULL);
+
+    crasheejson_beginObject(context, CrasheeCrashField_Report);
+    crasheejson_addStringElement(context, CrasheeCrashField_ID, "6C1E1A3B-0E5B-4E1F-9D38-7A1B5C0D4E2F", CrasheeJSON_SIZE_AUTOMATIC);
+    crasheejson_addIntegerElement(context, CrasheeCrashField_Timestamp, 1700000000);
+    crasheejson_endContainer(context);
+    endSection(onSectionEnd, userData);
+
+    char name[128];
+    crasheejson_beginArray(context, CrasheeCrashField_BinaryImages);
+    for(int i = 0; i < 400; i++)
+    {
+        crasheejson_beginObject(context, NULL);
+        crasheejson_addUIntegerElement(context, CrasheeCrashField_ImageAddress, 0x100000000ull + (uint64_t)i * 0x10000);
+        crasheejson_addUIntegerElement(context, CrasheeCrashField_ImageSize, 0x4000);
+        snprintf(name, sizeof(name), "/System/Library/Frameworks/Framework%d.framework/Framework%d", i, i);
+        crasheejson_addStringElement(context, CrasheeCrashField_Name, name, CrasheeJSON_SIZE_AUTOMATIC);
+        crasheejson_addStringElement(context, CrasheeCrashField_UUID, "6C1E1A3B-0E5B-4E1F-9D38-7A1B5C0D4E2F", CrasheeJSON_SIZE_AUTOMATIC);
+        crasheejson_addIntegerElement(context, CrasheeCrashField_CPUType, 16777228);
+        crasheejson_endContainer(context);
+    }
+    crasheejson_endContainer(context);
+    endSection(onSectionEnd, userData);
+
+    unsigned char stack[240];
+    for(int i = 0; i < (int)sizeof(stack); i++)
+    {
+        stack[i] = (unsigned char)(i * 7);
+    }
+    uint64_t registerValue = 0x9e3779b97f4a7c15ull;
+    crasheejson_beginArray(context, CrasheeCrashField_Threads);
+    for(int thread = 0; thread < 30; thread++)
+    {
+        crasheejson_beginObject(context, NULL);
+        crasheejson_beginObject(context, CrasheeCrashField_Backtrace);
+        crasheejson_beginArray(context, CrasheeCrashField_Contents);
+        for(int frame = 0; frame < 40; frame++)
+        {
+            crasheejson_beginObject(context, NULL);
+            crasheejson_addStringElement(context, CrasheeCrashField_ObjectName, "Framework12", CrasheeJSON_SIZE_AUTOMATIC);
+            crasheejson_addUIntegerElement(context, CrasheeCrashField_ObjectAddr, 0x100120000ull);
+            crasheejson_addStringElement(context, CrasheeCrashField_SymbolName,
+                                         "-[SomeViewController someMethodWithArgument:]", CrasheeJSON_SIZE_AUTOMATIC);
+            crasheejson_addUIntegerElement(context, CrasheeCrashField_InstructionAddr, 0x100123470ull + (uint64_t)frame);
+            crasheejson_endContainer(context);
+        }
+        crasheejson_endContainer(context);
+        crasheejson_endContainer(context);
+        crasheejson_beginObject(context, CrasheeCrashField_Registers);
+        crasheejson_beginObject(context, CrasheeCrashField_Basic);
+        for(int i = 0; i < 33; i++)
+        {
+            // Register values span the whole unsigned range.
+            registerValue ^= registerValue << 13;
+            registerValue ^= registerValue >> 7;
+            registerValue ^= registerValue << 17;
+            snprintf(name, sizeof(name), "x%d", i);
+            crasheejson_addUIntegerElement(context, name, registerValue >> (i % 4 * 16));
+        }
+        crasheejson_endContainer(context);
+        crasheejson_endContainer(context);
+        crasheejson_beginObject(context, CrasheeCrashField_Stack);
+        crasheejson_addDataElement(context, CrasheeCrashField_Contents, (const char*)stack, sizeof(stack));
+        crasheejson_endContainer(context);
+        crasheejson_endContainer(context);
+    }
+    crasheejson_endContainer(context);
+    endSection(onSectionEnd, userData);
+
+    crasheejson_beginObject(context, CrasheeCrashField_User);
+    crasheejson_addFloatingPointElement(context, "load", 0.7512);
+    crasheejson_addFloatingPointElement(context, "uptime", 86399.125);
+    crasheejson_addIntegerElement(context, "offset", -3600);
+    char log[4096];
+    for(int i = 0; i < (int)sizeof(log) - 1; i++)
+    {
+        log[i] = i % 80 == 79 ? '\n' : (char)('a' + i % 26);
+    }
+    log[sizeof(log) - 1] = '\0';
+    crasheejson_addStringElement(context, "log", log, CrasheeJSON_SIZE_AUTOMATIC);
+    crasheejson_endContainer(context);
+    crasheejson_endEncode(context);
+}
@@ -0,0 +1,195 @@
+//
+//  CrasheeCTests.h
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/* Harness for the C tests and benchmarks of the recording core.
+ *
+ * Each suite has a test function, and optionally a benchmark function that
+ * only runs when the executable is started with --bench. Failed checks are
+ * counted rather than aborting, so a single run reports every failure.
+ */
+
+
+#ifndef HDR_CrasheeCTests_h
+#define HDR_CrasheeCTests_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "CrasheeJSONCodec.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/** Record the result of a check, printing it if it failed. */
+#define CrasheeTEST_CHECK(EXPRESSION) \
+    crasheetest_check((EXPRESSION), #EXPRESSION, __FILE__, __LINE__)
+
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+/** Record the result of a check. Use CrasheeTEST_CHECK() instead.
+ *
+ * @param passed Whether the check passed.
+ *
+ * @param expression The expression that was checked.
+ *
+ * @param file The file the check is in.
+ *
+ * @param line The line the check is on.
+ */
+void crasheetest_check(bool passed, const char* expression, const char* file, int line);
+
+/** Get the number of checks made so far.
+ */
+int crasheetest_getCheckCount(void);
+
+/** Get the number of checks that have failed so far.
+ */
+int crasheetest_getFailureCount(void);
+
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+/** Get a monotonic time in seconds, for timing benchmarks.
+ */
+double crasheetest_now(void);
+
+/** Print a benchmark result.
+ *
+ * @param name What was measured.
+ *
+ * @param value The measurement.
+ *
+ * @param unit The measurement's unit.
+ */
+void crasheetest_reportBenchmark(const char* name, double value, const char* unit);
+
+
+// ============================================================================
+// Files
+// ============================================================================
+
+/** Create an empty directory for a test to work in. Anything left over from
+ * an earlier run is deleted first.
+ *
+ * @param name The directory's name, unique to the test.
+ *
+ * @param path Buffer to hold the directory's path.
+ *
+ * @param maxLength The length of the buffer.
+ *
+ * @return true if the directory was created.
+ */
+bool crasheetest_makeTemporaryDirectory(const char* name, char* path, int maxLength);
+
+
+// ============================================================================
+// JSON
+// ============================================================================
+
+/** A growable buffer that collects encoded data. */
+typedef struct
+{
+    char* data;
+    int length;
+    int capacity;
+} CrasheeTestBuffer;
+
+/** Append data to a CrasheeTestBuffer, keeping it NUL terminated.
+ * Matches CrasheeJSONAddDataFunc, with the buffer as userData.
+ */
+int crasheetest_addToBuffer(const char* data, int length, void* userData);
+
+/** Empty a buffer, keeping its memory. */
+void crasheetest_clearBuffer(CrasheeTestBuffer* buffer);
+
+/** Release a buffer's memory. */
+void crasheetest_freeBuffer(CrasheeTestBuffer* buffer);
+
+/** Get decode callbaccrashee that re-encode every element into the
+ * CrasheeJSONEncodeContext passed as userData, so that a document can be
+ * compared against what the decoder made of it.
+ *
+ * @param callbaccrashee The callbaccrashee to fill in.
+ */
+void crasheetest_getEchoCallbaccrashee(CrasheeJSONDecodeCallbaccrashee* callbaccrashee);
+
+/** Encode something shaped like a crash report: binary images, backtraces,
+ * register values across the whole 64-bit range, stack dumps and user data.
+ * Ends the encoding when done.
+ *
+ * @param context A context that crasheejson_beginEncode() has been called on.
+ *
+ * @param onSectionEnd If not NULL, called after each top level section, where
+ *                     the report writer flushes.
+ *
+ * @param userData Data to pass to onSectionEnd.
+ */
+void crasheetest_encodeSyntheticReport(CrasheeJSONEncodeContext* context,
+                                       void (*onSectionEnd)(void* userData),
+                                       void* userData);
+
+
+// ============================================================================
+// Suites
+// ============================================================================
+
+void crasheetest_runJSONCodecTests(void);
+void crasheetest_runJSONCodecBenchmarks(void);
+
+void crasheetest_runJSONDecodeTests(void);
+void crasheetest_runJSONDecodeBenchmarks(void);
+
+void crasheetest_runFormatTests(void);
+void crasheetest_runFormatBenchmarks(void);
+
+void crasheetest_runWriterTests(void);
+void crasheetest_runWriterBenchmarks(void);
+
+void crasheetest_runCompressionTests(void);
+void crasheetest_runCompressionBenchmarks(void);
+
+void crasheetest_runSegmentStoreTests(void);
+void crasheetest_runSegmentStoreBenchmarks(void);
+
+void crasheetest_runConcurrentStoreTests(void);
+void crasheetest_runConcurrentStoreBenchmarks(void);
+
+void crasheetest_runAsyncStoreTests(void);
+void crasheetest_runAsyncStoreBenchmarks(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_CrasheeCTests_h
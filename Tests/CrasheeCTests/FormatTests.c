@@ -0,0 +1,291 @@
+//
+//  FormatTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeFormat.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// ============================================================================
+#pragma mark - Helpers -
+// ============================================================================
+
+static uint64_t g_randomState = 88172645463325252ull;
+
+/** Xorshift, so that runs are repeatable on every platform. */
+static uint64_t nextRandom(void)
+{
+    g_randomState ^= g_randomState << 13;
+    g_randomState ^= g_randomState >> 7;
+    g_randomState ^= g_randomState << 17;
+    return g_randomState;
+}
+
+/** The fewest significant digits that strtod() reads back as the same value. */
+static int getShortestDigitCount(const double value)
+{
+    char buffer[40];
+    for(int digits = 1; digits <= 17; digits++)
+    {
+        snprintf(buffer, sizeof(buffer), "%.*e", digits - 1, value);
+        if(strtod(buffer, NULL) == value)
+        {
+            return digits;
+        }
+    }
+    return 17;
+}
+
+/** Count the significant digits in a formatted double, ignoring the
+ * trailing zeroes of a plain integer.
+ */
+static int getSignificantDigitCount(const char* const string)
+{
+    const char* end = strchr(string, 'e');
+    if(end == NULL)
+    {
+        end = string + strlen(string);
+        if(strchr(string, '.') == NULL)
+        {
+            while(end > string + 1 && end[-1] == '0')
+            {
+                end--;
+            }
+        }
+    }
+    int count = 0;
+    bool isSignificant = false;
+    for(const char* ch = string; ch < end; ch++)
+    {
+        if(*ch >= '1' && *ch <= '9')
+        {
+            isSignificant = true;
+        }
+        if(isSignificant && *ch >= '0' && *ch <= '9')
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+
+// ============================================================================
+#pragma mark - Tests -
+// ============================================================================
+
+static void testIntegersMatchSnprintf(void)
+{
+    char actual[40];
+    char expected[40];
+    int mismatches = 0;
+    for(int i = 0; i < 200000; i++)
+    {
+        const uint64_t unsignedValue = nextRandom() >> (nextRandom() % 64);
+        const int64_t signedValue = (int64_t)nextRandom() >> (nextRandom() % 64);
+        const int minDigits = i % 17;
+        const bool uppercase = i & 1;
+
+        crasheefmt_uint64(actual, unsignedValue);
+        snprintf(expected, sizeof(expected), "%llu", (unsigned long long)unsignedValue);
+        mismatches += strcmp(actual, expected) != 0;
+
+        crasheefmt_int64(actual, signedValue);
+        snprintf(expected, sizeof(expected), "%lld", (long long)signedValue);
+        mismatches += strcmp(actual, expected) != 0;
+
+        const int length = crasheefmt_hex64(actual, unsignedValue, minDigits, uppercase);
+        snprintf(expected, sizeof(expected), uppercase ? "%0*llX" : "%0*llx", minDigits, (unsigned long long)unsignedValue);
+        mismatches += strcmp(actual, expected) != 0 && !(minDigits == 0 && unsignedValue == 0);
+        mismatches += length != (int)strlen(actual);
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+
+    crasheefmt_int64(actual, INT64_MIN);
+    CrasheeTEST_CHECK(strcmp(actual, "-9223372036854775808") == 0);
+    crasheefmt_uint64(actual, UINT64_MAX);
+    CrasheeTEST_CHECK(strcmp(actual, "18446744073709551615") == 0);
+    crasheefmt_uint64(actual, 0);
+    CrasheeTEST_CHECK(strcmp(actual, "0") == 0);
+}
+
+static void testDoublesAreShortestRoundTrip(void)
+{
+    char buffer[CrasheeFMT_DOUBLE_BUFFER_LENGTH + 8];
+    int badLengths = 0;
+    int badRoundTrips = 0;
+    int notShortest = 0;
+    for(int i = 0; i < 100000; i++)
+    {
+        double value;
+        if(i % 3 == 0)
+        {
+            // Values a report really holds: whole numbers and milliseconds.
+            value = (double)(int64_t)(nextRandom() % 2000001) - 1000000;
+            value /= i % 2 ? 1000 : 1;
+        }
+        else
+        {
+            const uint64_t bits = nextRandom();
+            memcpy(&value, &bits, sizeof(value));
+        }
+        if(isnan(value) || isinf(value))
+        {
+            continue;
+        }
+        const int length = crasheefmt_double(buffer, value);
+        badLengths += length != (int)strlen(buffer) || length >= CrasheeFMT_DOUBLE_BUFFER_LENGTH;
+        badRoundTrips += strtod(buffer, NULL) != value;
+        notShortest += value != 0 && getSignificantDigitCount(buffer) != getShortestDigitCount(value);
+    }
+    CrasheeTEST_CHECK(badLengths == 0);
+    CrasheeTEST_CHECK(badRoundTrips == 0);
+    CrasheeTEST_CHECK(notShortest == 0);
+
+    static const struct
+    {
+        double value;
+        const char* expected;
+    } cases[] =
+    {
+        {0.1, "0.1"},
+        {100, "100"},
+        {1.5, "1.5"},
+        {1e-5, "0.00001"},
+        {1e16, "10000000000000000"},
+        {1e17, "1e+17"},
+        {5e-324, "5e-324"},
+        {1.7976931348623157e308, "1.7976931348623157e+308"},
+    };
+    for(int i = 0; i < (int)(sizeof(cases) / sizeof(*cases)); i++)
+    {
+        crasheefmt_double(buffer, cases[i].value);
+        CrasheeTEST_CHECK(strcmp(buffer, cases[i].expected) == 0);
+    }
+    crasheefmt_double(buffer, NAN);
+    CrasheeTEST_CHECK(strcmp(buffer, "nan") == 0);
+    crasheefmt_double(buffer, -INFINITY);
+    CrasheeTEST_CHECK(strcmp(buffer, "-inf") == 0);
+}
+
+static void testUUID(void)
+{
+    static const unsigned char bytes[16] =
+    {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+    };
+    char buffer[CrasheeFMT_UUID_BUFFER_LENGTH];
+    crasheefmt_uuid(buffer, bytes);
+    CrasheeTEST_CHECK(strcmp(buffer, "00112233-4455-6677-8899-AABBCCDDEEFF") == 0);
+}
+
+#define CHECK_FORMAT(...) \
+    do \
+    { \
+        char actual[256]; \
+        char expected[256]; \
+        crasheefmt_format(actual, sizeof(actual), __VA_ARGS__); \
+        snprintf(expected, sizeof(expected), __VA_ARGS__); \
+        CrasheeTEST_CHECK(strcmp(actual, expected) == 0); \
+    } while(0)
+
+static void testFormatMatchesSnprintf(void)
+{
+    CHECK_FORMAT("%s/%s-report-%016llx.json", "/var/reports", "App", 0x1234abcdull);
+    CHECK_FORMAT("stack@%p", (void*)0x7ffee1234560);
+    CHECK_FORMAT("r%d %i %u %x %X %08x %c %% %ld %lu %zu", -12, 7, 4000000000u, 0xbeef, 0xbeef, 0x12, 'q', -5L, 6UL, (size_t)99);
+    CHECK_FORMAT("%-5d|%5s|%-6s|%.3s|%hhd|%hd|%o", 3, "ab", "cd", "abcdef", (char)44, (short)-7, 8);
+    CHECK_FORMAT("%f %.2f %.0f %10.3f %-10.1f|", 3.14159, 2.675, 2.5, 12.3456, 1.25);
+    CHECK_FORMAT("%*d|%-*d|%.*s", 6, 42, 4, 7, 2, "xyz");
+    CHECK_FORMAT("%s: %s (%u): %s: ", "INFO", "CrasheeFormat.c", 12u, "testFormat");
+
+    char buffer[8];
+    crasheefmt_format(buffer, sizeof(buffer), "%s", "0123456789");
+    CrasheeTEST_CHECK(strcmp(buffer, "0123456") == 0);
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runFormatTests(void)
+{
+    testIntegersMatchSnprintf();
+    testDoublesAreShortestRoundTrip();
+    testUUID();
+    testFormatMatchesSnprintf();
+}
+
+static volatile int g_benchmarkSink;
+
+void crasheetest_runFormatBenchmarks(void)
+{
+    enum { Count = 1000000 };
+    int64_t* integers = malloc(Count * sizeof(*integers));
+    double* doubles = malloc(Count * sizeof(*doubles));
+    if(integers == NULL || doubles == NULL)
+    {
+        free(integers);
+        free(doubles);
+        return;
+    }
+    for(int i = 0; i < Count; i++)
+    {
+        integers[i] = (int64_t)nextRandom() >> (nextRandom() % 60);
+        doubles[i] = (double)(nextRandom() % 100000000) / (double)(nextRandom() % 1000 + 1);
+    }
+
+    char buffer[64];
+    int sink = 0;
+    double start;
+#define BENCHMARK(NAME, EXPRESSION) \
+    start = crasheetest_now(); \
+    for(int i = 0; i < Count; i++) \
+    { \
+        sink += EXPRESSION; \
+    } \
+    crasheetest_reportBenchmark(NAME, (crasheetest_now() - start) / Count * 1e9, "ns")
+
+    BENCHMARK("int64: snprintf %lld", snprintf(buffer, sizeof(buffer), "%lld", (long long)integers[i]));
+    BENCHMARK("int64: crasheefmt_int64", crasheefmt_int64(buffer, integers[i]));
+    BENCHMARK("double: snprintf %.17g", snprintf(buffer, sizeof(buffer), "%.17g", doubles[i]));
+    BENCHMARK("double: crasheefmt_double", crasheefmt_double(buffer, doubles[i]));
+    BENCHMARK("pointer name: snprintf stack@%p", snprintf(buffer, sizeof(buffer), "stack@%p", (void*)(uintptr_t)integers[i]));
+    BENCHMARK("pointer name: crasheefmt_format stack@%p", crasheefmt_format(buffer, sizeof(buffer), "stack@%p", (void*)(uintptr_t)integers[i]));
+    BENCHMARK("report path: snprintf",
+              snprintf(buffer, sizeof(buffer), "%s/%s-report-%016llx.json", "/var/x", "App", (long long)integers[i]));
+    BENCHMARK("report path: crasheefmt_format",
+              crasheefmt_format(buffer, sizeof(buffer), "%s/%s-report-%016llx.json", "/var/x", "App", (long long)integers[i]));
+#undef BENCHMARK
+
+    g_benchmarkSink = sink;
+    free(integers);
+    free(doubles);
+}
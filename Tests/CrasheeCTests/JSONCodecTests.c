@@ -0,0 +1,538 @@
+//
+//  JSONCodecTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeCBORCodec.h"
+#include "CrasheeJSONCodec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// ============================================================================
+#pragma mark - Sample Document -
+// ============================================================================
+
+typedef enum
+{
+    SampleObject,
+    SampleArray,
+    SampleEnd,
+    SampleBoolean,
+    SampleInteger,
+    SampleUInteger,
+    SampleFloat,
+    SampleNull,
+    SampleString,
+    SampleData,
+} SampleType;
+
+typedef struct
+{
+    SampleType type;
+    const char* name;
+    int64_t integer;
+    double floatingPoint;
+    const char* string;
+} SampleElement;
+
+/** Every kind of element, with values at the edges of their ranges. */
+static const SampleElement g_sampleDocument[] =
+{
+    {SampleObject, NULL},
+        {SampleBoolean, "crashed", 1},
+        {SampleInteger, "min", INT64_MIN},
+        {SampleInteger, "negative", -42},
+        {SampleUInteger, "address", (int64_t)0xfffffffffffffff0ull},
+        {SampleFloat, "tenth", 0, 0.1},
+        {SampleFloat, "huge", 0, 1.7976931348623157e308},
+        {SampleFloat, "tiny", 0, -2.5e-8},
+        {SampleNull, "nothing"},
+        {SampleString, "reason", 0, 0, "Tab\tquote\" and \"backslash\\ \xe2\x9c\x93 \xf0\x9f\x92\xa5 \x1b[31mred\x1b[0m"},
+        {SampleData, "bytes", 0, 0, "\x00\x01\xfe\xff"},
+        {SampleArray, "threads"},
+            {SampleObject, NULL},
+                {SampleInteger, "index", 0},
+                {SampleArray, "registers"},
+                    {SampleUInteger, NULL, 0x7fff5fbff8c0ll},
+                    {SampleUInteger, NULL, 0},
+                {SampleEnd},
+            {SampleEnd},
+            {SampleArray, NULL},
+            {SampleEnd},
+            {SampleObject, NULL},
+            {SampleEnd},
+        {SampleEnd},
+        {SampleString, "a name long enough that it is not interned by the encoder", 0, 0, ""},
+    {SampleEnd},
+};
+static const int g_sampleDocumentCount = sizeof(g_sampleDocument) / sizeof(*g_sampleDocument);
+
+static void encodeSampleAsJSON(CrasheeTestBuffer* const buffer)
+{
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, buffer);
+    for(int i = 0; i < g_sampleDocumentCount; i++)
+    {
+        const SampleElement* element = &g_sampleDocument[i];
+        switch(element->type)
+        {
+            case SampleObject: crasheejson_beginObject(&context, element->name); break;
+            case SampleArray: crasheejson_beginArray(&context, element->name); break;
+            case SampleEnd: crasheejson_endContainer(&context); break;
+            case SampleBoolean: crasheejson_addBooleanElement(&context, element->name, element->integer != 0); break;
+            case SampleInteger: crasheejson_addIntegerElement(&context, element->name, element->integer); break;
+            case SampleUInteger: crasheejson_addUIntegerElement(&context, element->name, (uint64_t)element->integer); break;
+            case SampleFloat: crasheejson_addFloatingPointElement(&context, element->name, element->floatingPoint); break;
+            case SampleNull: crasheejson_addNullElement(&context, element->name); break;
+            case SampleString:
+                crasheejson_addStringElement(&context, element->name, element->string, CrasheeJSON_SIZE_AUTOMATIC);
+                break;
+            case SampleData: crasheejson_addDataElement(&context, element->name, element->string, 4); break;
+        }
+    }
+    crasheejson_endEncode(&context);
+}
+
+static void encodeSampleAsCBOR(CrasheeTestBuffer* const buffer)
+{
+    CrasheeCBOREncodeContext context;
+    crasheecbor_beginEncode(&context, crasheetest_addToBuffer, buffer);
+    for(int i = 0; i < g_sampleDocumentCount; i++)
+    {
+        const SampleElement* element = &g_sampleDocument[i];
+        switch(element->type)
+        {
+            case SampleObject: crasheecbor_beginObject(&context, element->name); break;
+            case SampleArray: crasheecbor_beginArray(&context, element->name); break;
+            case SampleEnd: crasheecbor_endContainer(&context); break;
+            case SampleBoolean: crasheecbor_addBooleanElement(&context, element->name, element->integer != 0); break;
+            case SampleInteger: crasheecbor_addIntegerElement(&context, element->name, element->integer); break;
+            case SampleUInteger: crasheecbor_addUIntegerElement(&context, element->name, (uint64_t)element->integer); break;
+            case SampleFloat: crasheecbor_addFloatingPointElement(&context, element->name, element->floatingPoint); break;
+            case SampleNull: crasheecbor_addNullElement(&context, element->name); break;
+            case SampleString:
+                crasheecbor_addStringElement(&context, element->name, element->string, CrasheeCBOR_SIZE_AUTOMATIC);
+                break;
+            case SampleData: crasheecbor_addDataElement(&context, element->name, element->string, 4); break;
+        }
+    }
+    crasheecbor_endEncode(&context);
+}
+
+/** Convert CBOR to JSON, returning the conversion's result. */
+static int convertCBOR(const char* const data, const int length, CrasheeTestBuffer* const json)
+{
+    crasheetest_clearBuffer(json);
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, json);
+    const int result = crasheecbor_convertToJSON(data, length, &context, NULL);
+    crasheejson_endEncode(&context);
+    return result;
+}
+
+/** Decode a document and re-encode everything the decoder reported. */
+static int echoJSON(const char* const data, const int length, CrasheeTestBuffer* const echo)
+{
+    crasheetest_clearBuffer(echo);
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, echo);
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee;
+    crasheetest_getEchoCallbaccrashee(&callbaccrashee);
+    char stringBuffer[1024];
+    return crasheejson_decode(data, length, stringBuffer, sizeof(stringBuffer), &callbaccrashee, &context, NULL);
+}
+
+
+// ============================================================================
+#pragma mark - Strings -
+// ============================================================================
+
+/** Escape the way the encoder did before its scan was vectorized: one byte at a time. */
+static int escapeOneByteAtATime(const char* const string, const int length, char* dst)
+{
+    char* const dstStart = dst;
+    for(int i = 0; i < length; i++)
+    {
+        const unsigned char ch = (unsigned char)string[i];
+        switch(ch)
+        {
+            case '\\': *dst++ = '\\'; *dst++ = '\\'; break;
+            case '\"': *dst++ = '\\'; *dst++ = '\"'; break;
+            case '\b': *dst++ = '\\'; *dst++ = 'b'; break;
+            case '\f': *dst++ = '\\'; *dst++ = 'f'; break;
+            case '\n': *dst++ = '\\'; *dst++ = 'n'; break;
+            case '\r': *dst++ = '\\'; *dst++ = 'r'; break;
+            case '\t': *dst++ = '\\'; *dst++ = 't'; break;
+            default:
+                if(ch < ' ')
+                {
+                    dst += sprintf(dst, "\\u%04X", ch);
+                }
+                else
+                {
+                    *dst++ = (char)ch;
+                }
+        }
+    }
+    return (int)(dst - dstStart);
+}
+
+/** Fill a string with well-formed UTF-8, mostly plain text, with every
+ * character that needs escaping mixed in. Returns the length.
+ */
+static int makeRandomString(char* const string, const int maxLength)
+{
+    static const char* const pieces[] =
+    {
+        "\"", "\\", "\n", "\t", "\x01", "\x1f", "\x7f", "/", "\xc3\xa9", "\xe2\x9c\x93", "\xf0\x9f\x92\xa5",
+    };
+    const int length = rand() % maxLength;
+    int i = 0;
+    while(i < length)
+    {
+        if(rand() % 8 != 0)
+        {
+            string[i++] = (char)('a' + rand() % 26);
+            continue;
+        }
+        const char* piece = pieces[rand() % (int)(sizeof(pieces) / sizeof(*pieces))];
+        const int pieceLength = (int)strlen(piece);
+        if(i + pieceLength > length)
+        {
+            break;
+        }
+        memcpy(string + i, piece, (size_t)pieceLength);
+        i += pieceLength;
+    }
+    string[i] = '\0';
+    return i;
+}
+
+static int captureString(__unused const char* const name, const char* const value, void* const userData)
+{
+    return crasheetest_addToBuffer(value, (int)strlen(value), userData);
+}
+
+static int ignoreName(__unused const char* const name, __unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static int ignore(__unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static void testEscapingMatchesReference(void)
+{
+    // Long enough to cross every SIMD block size and the encoder's work buffer.
+    static char string[2000];
+    static char expected[2000 * 6 + 2];
+    CrasheeTestBuffer encoded = {0};
+    CrasheeTestBuffer decoded = {0};
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee;
+    crasheetest_getEchoCallbaccrashee(&callbaccrashee);
+    callbaccrashee.onStringElement = captureString;
+    callbaccrashee.onBeginArray = ignoreName;
+    callbaccrashee.onEndContainer = ignore;
+    callbaccrashee.onEndData = ignore;
+    char stringBuffer[sizeof(string) * 2];
+    int mismatches = 0;
+    int roundTripFailures = 0;
+
+    srand(1);
+    for(int i = 0; i < 3000; i++)
+    {
+        const int length = makeRandomString(string, i < 100 ? 64 : (int)sizeof(string));
+        expected[0] = '[';
+        expected[1] = '"';
+        int expectedLength = 2 + escapeOneByteAtATime(string, length, expected + 2);
+        memcpy(expected + expectedLength, "\"]", 3);
+        expectedLength += 2;
+
+        crasheetest_clearBuffer(&encoded);
+        CrasheeJSONEncodeContext context;
+        crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, &encoded);
+        crasheejson_beginArray(&context, NULL);
+        crasheejson_addStringElement(&context, NULL, string, length);
+        crasheejson_endEncode(&context);
+        if(encoded.length != expectedLength || memcmp(encoded.data, expected, (size_t)expectedLength) != 0)
+        {
+            mismatches++;
+            continue;
+        }
+
+        crasheetest_clearBuffer(&decoded);
+        const int result = crasheejson_decode(encoded.data, encoded.length, stringBuffer, sizeof(stringBuffer),
+                                              &callbaccrashee, &decoded, NULL);
+        if(result != CrasheeJSON_OK || decoded.length != length || memcmp(decoded.data, string, (size_t)length) != 0)
+        {
+            roundTripFailures++;
+        }
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+    CrasheeTEST_CHECK(roundTripFailures == 0);
+    crasheetest_freeBuffer(&encoded);
+    crasheetest_freeBuffer(&decoded);
+}
+
+static void testIncrementalStringMatchesWholeString(void)
+{
+    const char* const pieces[] = {"first \"", "", "\\second\n", "\xe2\x9c\x93 third"};
+    CrasheeTestBuffer whole = {0};
+    CrasheeTestBuffer incremental = {0};
+    CrasheeJSONEncodeContext context;
+
+    crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, &whole);
+    crasheejson_addStringElement(&context, NULL, "first \"\\second\n\xe2\x9c\x93 third", CrasheeJSON_SIZE_AUTOMATIC);
+    crasheejson_endEncode(&context);
+
+    crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, &incremental);
+    crasheejson_beginStringElement(&context, NULL);
+    for(int i = 0; i < 4; i++)
+    {
+        crasheejson_appendStringElement(&context, pieces[i], (int)strlen(pieces[i]));
+    }
+    crasheejson_endStringElement(&context);
+    crasheejson_endEncode(&context);
+
+    CrasheeTEST_CHECK(whole.length > 0 && strcmp(whole.data, incremental.data) == 0);
+    crasheetest_freeBuffer(&whole);
+    crasheetest_freeBuffer(&incremental);
+}
+
+
+// ============================================================================
+#pragma mark - Documents -
+// ============================================================================
+
+static void testDocumentRoundTrip(void)
+{
+    CrasheeTestBuffer json = {0};
+    CrasheeTestBuffer echo = {0};
+    encodeSampleAsJSON(&json);
+    CrasheeTEST_CHECK(echoJSON(json.data, json.length, &echo) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(echo.length == json.length && strcmp(echo.data, json.data) == 0);
+    CrasheeTEST_CHECK(strstr(json.data, "\"address\":18446744073709551600") != NULL);
+    CrasheeTEST_CHECK(strstr(json.data, "\"min\":-9223372036854775808") != NULL);
+    crasheetest_freeBuffer(&json);
+    crasheetest_freeBuffer(&echo);
+}
+
+static void testCBORConvertsToSameJSON(void)
+{
+    CrasheeTestBuffer json = {0};
+    CrasheeTestBuffer cbor = {0};
+    CrasheeTestBuffer converted = {0};
+    encodeSampleAsJSON(&json);
+    encodeSampleAsCBOR(&cbor);
+    CrasheeTEST_CHECK(crasheecbor_isCBOR(cbor.data, cbor.length));
+    CrasheeTEST_CHECK(!crasheecbor_isCBOR(json.data, json.length));
+    CrasheeTEST_CHECK(convertCBOR(cbor.data, cbor.length, &converted) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(converted.length == json.length && strcmp(converted.data, json.data) == 0);
+    CrasheeTEST_CHECK(cbor.length < json.length);
+    crasheetest_freeBuffer(&json);
+    crasheetest_freeBuffer(&cbor);
+    crasheetest_freeBuffer(&converted);
+}
+
+static void testTruncatedCBORConvertsToWellFormedJSON(void)
+{
+    CrasheeTestBuffer cbor = {0};
+    CrasheeTestBuffer converted = {0};
+    CrasheeTestBuffer echo = {0};
+    encodeSampleAsCBOR(&cbor);
+    int badResults = 0;
+    int malformed = 0;
+    for(int length = CrasheeCBOR_MAGIC_LENGTH + 1; length < cbor.length; length++)
+    {
+        const int result = convertCBOR(cbor.data, length, &converted);
+        if(result != CrasheeJSON_OK && result != CrasheeJSON_ERROR_INCOMPLETE)
+        {
+            badResults++;
+        }
+        if(echoJSON(converted.data, converted.length, &echo) != CrasheeJSON_OK)
+        {
+            malformed++;
+        }
+    }
+    CrasheeTEST_CHECK(badResults == 0);
+    CrasheeTEST_CHECK(malformed == 0);
+    crasheetest_freeBuffer(&cbor);
+    crasheetest_freeBuffer(&converted);
+    crasheetest_freeBuffer(&echo);
+}
+
+static void testCBORBadElementsAreReplaced(void)
+{
+    CrasheeTestBuffer cbor = {0};
+    CrasheeTestBuffer converted = {0};
+    encodeSampleAsCBOR(&cbor);
+    unsigned char data[512];
+    memcpy(data, cbor.data, CrasheeCBOR_MAGIC_LENGTH);
+    int length;
+
+    // {1: "x", "a": [reserved head, stray break, 5], "b": 2}
+    static const unsigned char badKeyAndHeads[] =
+    {
+        0xa3, 0x01, 0x61, 'x', 0x61, 'a', 0x83, 0xfc, 0xff, 0x05, 0x61, 'b', 0x02,
+    };
+    length = CrasheeCBOR_MAGIC_LENGTH;
+    memcpy(data + length, badKeyAndHeads, sizeof(badKeyAndHeads));
+    length += (int)sizeof(badKeyAndHeads);
+    CrasheeTEST_CHECK(convertCBOR((char*)data, length, &converted) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(strcmp(converted.data, "{\"a\":[null,null,5],\"b\":2}") == 0);
+
+    // {"a": (_ "ab", 1, "cd")}
+    static const unsigned char badChunk[] =
+    {
+        0xa1, 0x61, 'a', 0x7f, 0x62, 'a', 'b', 0x01, 0x62, 'c', 'd', 0xff,
+    };
+    length = CrasheeCBOR_MAGIC_LENGTH;
+    memcpy(data + length, badChunk, sizeof(badChunk));
+    length += (int)sizeof(badChunk);
+    CrasheeTEST_CHECK(convertCBOR((char*)data, length, &converted) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(strcmp(converted.data, "{\"a\":\"abcd\"}") == 0);
+
+    // [[[...150 deep...[0]...]]], 9]
+    length = CrasheeCBOR_MAGIC_LENGTH;
+    data[length++] = 0x82;
+    for(int i = 0; i < 150; i++)
+    {
+        data[length++] = 0x81;
+    }
+    data[length++] = 0x00;
+    data[length++] = 0x09;
+    CrasheeTEST_CHECK(convertCBOR((char*)data, length, &converted) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(converted.length > 3 && strcmp(converted.data + converted.length - 3, ",9]") == 0);
+
+    // {"reason": "\x1b[31mboom\x01", <300 byte key>: 1}
+    CrasheeCBOREncodeContext context;
+    char longKey[301];
+    memset(longKey, 'k', 300);
+    longKey[300] = '\0';
+    crasheetest_clearBuffer(&cbor);
+    crasheecbor_beginEncode(&context, crasheetest_addToBuffer, &cbor);
+    crasheecbor_beginObject(&context, NULL);
+    crasheecbor_addStringElement(&context, "reason", "\x1b[31mboom\x01", CrasheeCBOR_SIZE_AUTOMATIC);
+    crasheecbor_addIntegerElement(&context, longKey, 1);
+    crasheecbor_endEncode(&context);
+    CrasheeTEST_CHECK(convertCBOR(cbor.data, cbor.length, &converted) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(strstr(converted.data, "\"reason\":\"\\u001B[31mboom\\u0001\"") != NULL);
+    CrasheeTEST_CHECK(strstr(converted.data, longKey) != NULL);
+
+    crasheetest_freeBuffer(&cbor);
+    crasheetest_freeBuffer(&converted);
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runJSONCodecTests(void)
+{
+    testEscapingMatchesReference();
+    testIncrementalStringMatchesWholeString();
+    testDocumentRoundTrip();
+    testCBORConvertsToSameJSON();
+    testTruncatedCBORConvertsToWellFormedJSON();
+    testCBORBadElementsAreReplaced();
+}
+
+static int discardData(__unused const char* const data, __unused const int length, __unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+/** Encode 256 byte pieces of a string, then escape the same pieces one byte at a time. */
+static void benchmarkEscaping(const char* const name, const char* const string, const int length)
+{
+    enum { PieceLength = 256, Rounds = 50 };
+    char escaped[PieceLength * 6];
+    char label[100];
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, false, discardData, NULL);
+
+    double start = crasheetest_now();
+    for(int round = 0; round < Rounds; round++)
+    {
+        for(int offset = 0; offset + PieceLength <= length; offset += PieceLength)
+        {
+            crasheejson_addStringElement(&context, NULL, string + offset, PieceLength);
+        }
+    }
+    const double encoderSeconds = crasheetest_now() - start;
+
+    start = crasheetest_now();
+    int escapedLength = 0;
+    for(int round = 0; round < Rounds; round++)
+    {
+        for(int offset = 0; offset + PieceLength <= length; offset += PieceLength)
+        {
+            escapedLength += escapeOneByteAtATime(string + offset, PieceLength, escaped);
+        }
+    }
+    const double referenceSeconds = crasheetest_now() - start;
+
+    const double megabytes = (double)length * Rounds / 1e6;
+    snprintf(label, sizeof(label), "escape %s: encoder", name);
+    crasheetest_reportBenchmark(label, megabytes / encoderSeconds, "MB/s");
+    snprintf(label, sizeof(label), "escape %s: one byte at a time", name);
+    crasheetest_reportBenchmark(label, megabytes / referenceSeconds, escapedLength > 0 ? "MB/s" : "");
+}
+
+void crasheetest_runJSONCodecBenchmarks(void)
+{
+    enum { Length = 1 << 20 };
+    static const char symbols[] = "_ZN7Crashee12CrashReporter6reportEv -[CrasheeInstallation sendAllReports] ";
+    char* string = malloc(Length);
+    if(string == NULL)
+    {
+        return;
+    }
+
+    for(int i = 0; i < Length; i++)
+    {
+        string[i] = symbols[i % (sizeof(symbols) - 1)];
+    }
+    benchmarkEscaping("symbols", string, Length);
+
+    for(int i = 0; i < Length; i++)
+    {
+        string[i] = i % 97 == 0 ? '"' : symbols[i % (sizeof(symbols) - 1)];
+    }
+    benchmarkEscaping("symbols, 1% quotes", string, Length);
+
+    for(int i = 0; i < Length; i++)
+    {
+        string[i] = i % 8 == 0 ? '\n' : symbols[i % (sizeof(symbols) - 1)];
+    }
+    benchmarkEscaping("console lines", string, Length);
+
+    free(string);
+}
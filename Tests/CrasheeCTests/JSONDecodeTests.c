@@ -0,0 +1,489 @@
+//
+//  JSONDecodeTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeFormat.h"
+#include "CrasheeJSONCodec.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// ============================================================================
+#pragma mark - Number Capture -
+// ============================================================================
+
+typedef enum
+{
+    NumberSigned,
+    NumberUnsigned,
+    NumberFloat,
+} NumberKind;
+
+typedef struct
+{
+    NumberKind kind;
+    int64_t signedValue;
+    uint64_t unsignedValue;
+    double floatValue;
+} Number;
+
+typedef struct
+{
+    Number* numbers;
+    int count;
+    int capacity;
+} NumberCapture;
+
+static Number* nextNumber(NumberCapture* const capture)
+{
+    if(capture->count >= capture->capacity)
+    {
+        return NULL;
+    }
+    return &capture->numbers[capture->count++];
+}
+
+static int captureSigned(__unused const char* const name, const int64_t value, void* const userData)
+{
+    Number* number = nextNumber(userData);
+    if(number == NULL)
+    {
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    number->kind = NumberSigned;
+    number->signedValue = value;
+    return CrasheeJSON_OK;
+}
+
+static int captureUnsigned(__unused const char* const name, const uint64_t value, void* const userData)
+{
+    Number* number = nextNumber(userData);
+    if(number == NULL)
+    {
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    number->kind = NumberUnsigned;
+    number->unsignedValue = value;
+    return CrasheeJSON_OK;
+}
+
+static int captureFloat(__unused const char* const name, const double value, void* const userData)
+{
+    Number* number = nextNumber(userData);
+    if(number == NULL)
+    {
+        return CrasheeJSON_ERROR_DATA_TOO_LONG;
+    }
+    number->kind = NumberFloat;
+    number->floatValue = value;
+    return CrasheeJSON_OK;
+}
+
+static int ignoreName(__unused const char* const name, __unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static int ignoreString(__unused const char* const name, __unused const char* const value, __unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static int ignoreBoolean(__unused const char* const name, __unused const bool value, __unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static int ignore(__unused void* const userData)
+{
+    return CrasheeJSON_OK;
+}
+
+static void getNumberCallbaccrashee(CrasheeJSONDecodeCallbaccrashee* const callbaccrashee, const bool wantsUnsigned)
+{
+    callbaccrashee->onBooleanElement = ignoreBoolean;
+    callbaccrashee->onFloatingPointElement = captureFloat;
+    callbaccrashee->onIntegerElement = captureSigned;
+    callbaccrashee->onUnsignedIntegerElement = wantsUnsigned ? captureUnsigned : NULL;
+    callbaccrashee->onNullElement = ignoreName;
+    callbaccrashee->onStringElement = ignoreString;
+    callbaccrashee->onBeginObject = ignoreName;
+    callbaccrashee->onBeginArray = ignoreName;
+    callbaccrashee->onEndContainer = ignore;
+    callbaccrashee->onEndData = ignore;
+}
+
+/** Get a number's value, whichever callback reported it. Doubles written
+ * without a fraction or exponent decode as integers.
+ */
+static double getValue(const Number* const number)
+{
+    switch(number->kind)
+    {
+        case NumberSigned: return (double)number->signedValue;
+        case NumberUnsigned: return (double)number->unsignedValue;
+        default: return number->floatValue;
+    }
+}
+
+/** Decode a JSON array of numbers. */
+static int decodeNumbers(const char* const json, NumberCapture* const capture, const bool wantsUnsigned)
+{
+    capture->count = 0;
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee;
+    getNumberCallbaccrashee(&callbaccrashee, wantsUnsigned);
+    char stringBuffer[256];
+    return crasheejson_decode(json, (int)strlen(json), stringBuffer, sizeof(stringBuffer), &callbaccrashee, capture, NULL);
+}
+
+static uint64_t g_randomState = 0x2545f4914f6cdd1dull;
+
+static uint64_t nextRandom(void)
+{
+    g_randomState ^= g_randomState << 13;
+    g_randomState ^= g_randomState >> 7;
+    g_randomState ^= g_randomState << 17;
+    return g_randomState;
+}
+
+
+// ============================================================================
+#pragma mark - Numbers -
+// ============================================================================
+
+static void testIntegers(void)
+{
+    enum { Count = 20000 };
+    static Number numbers[Count + 1];
+    NumberCapture capture = {numbers, 0, Count + 1};
+    CrasheeTestBuffer json = {0};
+    uint64_t* expected = malloc(Count * sizeof(*expected));
+
+    crasheetest_addToBuffer("[", 1, &json);
+    for(int i = 0; i < Count; i++)
+    {
+        // Every digit count, on both sides of INT64_MAX.
+        expected[i] = nextRandom() >> (nextRandom() % 64);
+        char text[CrasheeFMT_INT64_BUFFER_LENGTH + 1];
+        int length = i % 3 == 0
+            ? crasheefmt_int64(text, -(int64_t)(expected[i] >> 1))
+            : crasheefmt_uint64(text, expected[i]);
+        text[length++] = i < Count - 1 ? ',' : ']';
+        crasheetest_addToBuffer(text, length, &json);
+    }
+    CrasheeTEST_CHECK(decodeNumbers(json.data, &capture, true) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(capture.count == Count);
+    int mismatches = 0;
+    for(int i = 0; i < capture.count; i++)
+    {
+        const Number* number = &numbers[i];
+        if(i % 3 == 0)
+        {
+            mismatches += number->kind != NumberSigned || number->signedValue != -(int64_t)(expected[i] >> 1);
+        }
+        else if(expected[i] > INT64_MAX)
+        {
+            mismatches += number->kind != NumberUnsigned || number->unsignedValue != expected[i];
+        }
+        else
+        {
+            mismatches += number->kind != NumberSigned || number->signedValue != (int64_t)expected[i];
+        }
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+
+    CrasheeTEST_CHECK(decodeNumbers("[9223372036854775807,-9223372036854775808,9223372036854775808,"
+                                    "18446744073709551615,18446744073709551616,-0,12345678,1234567812345678]",
+                                    &capture, true) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(capture.count == 8);
+    CrasheeTEST_CHECK(numbers[0].kind == NumberSigned && numbers[0].signedValue == INT64_MAX);
+    CrasheeTEST_CHECK(numbers[1].kind == NumberSigned && numbers[1].signedValue == INT64_MIN);
+    CrasheeTEST_CHECK(numbers[2].kind == NumberUnsigned && numbers[2].unsignedValue == (uint64_t)INT64_MAX + 1);
+    CrasheeTEST_CHECK(numbers[3].kind == NumberUnsigned && numbers[3].unsignedValue == UINT64_MAX);
+    CrasheeTEST_CHECK(numbers[4].kind == NumberFloat && numbers[4].floatValue == 18446744073709551616.0);
+    CrasheeTEST_CHECK(numbers[5].kind == NumberSigned && numbers[5].signedValue == 0);
+    CrasheeTEST_CHECK(numbers[6].kind == NumberSigned && numbers[6].signedValue == 12345678);
+    CrasheeTEST_CHECK(numbers[7].kind == NumberSigned && numbers[7].signedValue == 1234567812345678);
+
+    // Without an unsigned callback, values past INT64_MAX arrive as doubles.
+    CrasheeTEST_CHECK(decodeNumbers("[18446744073709551615]", &capture, false) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(capture.count == 1 && numbers[0].kind == NumberFloat && numbers[0].floatValue == 18446744073709551615.0);
+
+    CrasheeTEST_CHECK(decodeNumbers("[12a]", &capture, true) != CrasheeJSON_OK);
+    CrasheeTEST_CHECK(decodeNumbers("[-]", &capture, true) != CrasheeJSON_OK);
+
+    free(expected);
+    crasheetest_freeBuffer(&json);
+}
+
+static void testFloatsMatchStrtod(void)
+{
+    enum { Count = 20000 };
+    static Number numbers[Count];
+    static char texts[Count][32];
+    NumberCapture capture = {numbers, 0, Count};
+    CrasheeTestBuffer json = {0};
+
+    crasheetest_addToBuffer("[", 1, &json);
+    for(int i = 0; i < Count; i++)
+    {
+        double value;
+        do
+        {
+            const uint64_t bits = nextRandom();
+            memcpy(&value, &bits, sizeof(value));
+        } while(isnan(value) || isinf(value));
+        switch(i % 4)
+        {
+            case 0: crasheefmt_double(texts[i], value); break;
+            case 1: snprintf(texts[i], sizeof(texts[i]), "%.17g", value); break;
+            case 2: snprintf(texts[i], sizeof(texts[i]), "%.6e", value); break;
+            default: snprintf(texts[i], sizeof(texts[i]), "%.3f", (double)(nextRandom() % 100000000) / 7); break;
+        }
+        crasheetest_addToBuffer(texts[i], (int)strlen(texts[i]), &json);
+        crasheetest_addToBuffer(i < Count - 1 ? "," : "]", 1, &json);
+    }
+    CrasheeTEST_CHECK(decodeNumbers(json.data, &capture, true) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(capture.count == Count);
+    int mismatches = 0;
+    for(int i = 0; i < capture.count; i++)
+    {
+        mismatches += getValue(&numbers[i]) != strtod(texts[i], NULL);
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+
+    // Halfway cases, subnormals, and mantissas too long for the fast path.
+    static const char* const hardCases[] =
+    {
+        "2.2250738585072011e-308", "2.2250738585072014e-308", "4.9406564584124654e-324", "1e23",
+        "9007199254740993.0", "0.1", "3.14159265358979323846264338327950288", "1.00000000000000011102230246251565404236316680908203125",
+        "7.2057594037927933e16", "1e-400", "123456789012345678901234567890e-20", "0.000000000000000000000000000001e30",
+    };
+    const int hardCaseCount = (int)(sizeof(hardCases) / sizeof(*hardCases));
+    crasheetest_clearBuffer(&json);
+    crasheetest_addToBuffer("[", 1, &json);
+    for(int i = 0; i < hardCaseCount; i++)
+    {
+        crasheetest_addToBuffer(hardCases[i], (int)strlen(hardCases[i]), &json);
+        crasheetest_addToBuffer(i < hardCaseCount - 1 ? "," : "]", 1, &json);
+    }
+    CrasheeTEST_CHECK(decodeNumbers(json.data, &capture, true) == CrasheeJSON_OK);
+    CrasheeTEST_CHECK(capture.count == hardCaseCount);
+    mismatches = 0;
+    for(int i = 0; i < capture.count; i++)
+    {
+        mismatches += numbers[i].kind != NumberFloat || numbers[i].floatValue != strtod(hardCases[i], NULL);
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+
+    crasheetest_freeBuffer(&json);
+}
+
+
+// ============================================================================
+#pragma mark - Push Decoder -
+// ============================================================================
+
+/** Push decode in fixed size chunks, re-encoding what was decoded. */
+static int pushDecode(const char* const data, const int length, const int chunkLength, CrasheeTestBuffer* const echo)
+{
+    crasheetest_clearBuffer(echo);
+    static char stringBuffer[16384];
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, echo);
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee;
+    crasheetest_getEchoCallbaccrashee(&callbaccrashee);
+    CrasheeJSONPushDecoder decoder;
+    crasheejson_beginPushDecode(&decoder, stringBuffer, sizeof(stringBuffer), &callbaccrashee, &context);
+    int result = CrasheeJSON_OK;
+    for(int offset = 0; offset < length && result == CrasheeJSON_OK; offset += chunkLength)
+    {
+        const int remaining = length - offset;
+        result = crasheejson_feedPushDecoder(&decoder, data + offset, remaining < chunkLength ? remaining : chunkLength);
+    }
+    return result == CrasheeJSON_OK ? crasheejson_endPushDecode(&decoder) : result;
+}
+
+/** Check that every chunk size gives the push decoder the same result as decoding whole. */
+static void checkChunkIndependence(const char* const data, const int length, const int maxChunkLength)
+{
+    CrasheeTestBuffer expected = {0};
+    CrasheeTestBuffer actual = {0};
+    static char stringBuffer[16384];
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, false, crasheetest_addToBuffer, &expected);
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee;
+    crasheetest_getEchoCallbaccrashee(&callbaccrashee);
+    const int expectedResult = crasheejson_decode(data, length, stringBuffer, sizeof(stringBuffer), &callbaccrashee, &context, NULL);
+
+    int mismatches = 0;
+    for(int chunkLength = 1; chunkLength <= maxChunkLength; chunkLength++)
+    {
+        const int result = pushDecode(data, length, chunkLength, &actual);
+        if((result == CrasheeJSON_OK) != (expectedResult == CrasheeJSON_OK))
+        {
+            mismatches++;
+        }
+        else if(result == CrasheeJSON_OK && (actual.length != expected.length || memcmp(actual.data, expected.data, (size_t)actual.length) != 0))
+        {
+            mismatches++;
+        }
+    }
+    CrasheeTEST_CHECK(mismatches == 0);
+    crasheetest_freeBuffer(&expected);
+    crasheetest_freeBuffer(&actual);
+}
+
+static void testPushDecoderChunkIndependence(void)
+{
+    static const char* const documents[] =
+    {
+        "{\"a\":[1,-2,3.5e-3,18446744073709551615,true,false,null],\"b\":{\"c\":\"d\",\"e\":[],\"f\":{}}}",
+        "{\"escapes\":\"q\\\"b\\\\s\\/n\\nt\\tu\\u00e9\\ud83d\\ude00\",\"lone\":\"\\ud800x\"}",
+        "[\"\xe2\x9c\x93 split \xf0\x9f\x92\xa5\",\"ab\xff\xfe" "cd\",\"trunc\xf0\x9f\"]",
+        "  [ 1 , [ [ [ ] ] ] , { \"k\" : \"v\" } ]  ",
+        "{\"unterminated\":[1,2",
+        "[1,2]]",
+        "[\"\\u\xc3\xa9\xc3\xa9\"]",
+        "[\"\\ud800\\u\xc3\xa9\xc3\xa9\"]",
+    };
+    for(int i = 0; i < (int)(sizeof(documents) / sizeof(*documents)); i++)
+    {
+        const int length = (int)strlen(documents[i]);
+        checkChunkIndependence(documents[i], length, length);
+    }
+
+    // Non-ASCII bytes are not hex digits, even when char is signed.
+    for(int i = 6; i < 8; i++)
+    {
+        CrasheeTestBuffer echo = {0};
+        CrasheeTEST_CHECK(pushDecode(documents[i], (int)strlen(documents[i]), 1, &echo) == CrasheeJSON_ERROR_INVALID_CHARACTER);
+        crasheetest_freeBuffer(&echo);
+    }
+
+    CrasheeTestBuffer report = {0};
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, true, crasheetest_addToBuffer, &report);
+    crasheetest_encodeSyntheticReport(&context, NULL, NULL);
+    checkChunkIndependence(report.data, report.length, 64);
+    crasheetest_freeBuffer(&report);
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runJSONDecodeTests(void)
+{
+    testIntegers();
+    testFloatsMatchStrtod();
+    testPushDecoderChunkIndependence();
+}
+
+static volatile double g_benchmarkSink;
+
+void crasheetest_runJSONDecodeBenchmarks(void)
+{
+    enum { Runs = 20 };
+    CrasheeTestBuffer report = {0};
+    CrasheeJSONEncodeContext context;
+    crasheejson_beginEncode(&context, true, crasheetest_addToBuffer, &report);
+    crasheetest_encodeSyntheticReport(&context, NULL, NULL);
+
+    enum { NumberCount = 100000 };
+    static Number numbers[NumberCount];
+    NumberCapture capture = {numbers, 0, NumberCount};
+    CrasheeJSONDecodeCallbaccrashee callbaccrashee;
+    getNumberCallbaccrashee(&callbaccrashee, true);
+    static char stringBuffer[16384];
+
+    double start = crasheetest_now();
+    for(int run = 0; run < Runs; run++)
+    {
+        capture.count = 0;
+        crasheejson_decode(report.data, report.length, stringBuffer, sizeof(stringBuffer), &callbaccrashee, &capture, NULL);
+    }
+    double seconds = crasheetest_now() - start;
+    crasheetest_reportBenchmark("decode synthetic report", (double)report.length * Runs / 1e6 / seconds, "MB/s");
+
+    start = crasheetest_now();
+    for(int run = 0; run < Runs; run++)
+    {
+        capture.count = 0;
+        CrasheeJSONPushDecoder decoder;
+        crasheejson_beginPushDecode(&decoder, stringBuffer, sizeof(stringBuffer), &callbaccrashee, &capture);
+        for(int offset = 0; offset < report.length; offset += 4096)
+        {
+            const int remaining = report.length - offset;
+            crasheejson_feedPushDecoder(&decoder, report.data + offset, remaining < 4096 ? remaining : 4096);
+        }
+        crasheejson_endPushDecode(&decoder);
+    }
+    seconds = crasheetest_now() - start;
+    crasheetest_reportBenchmark("push decode synthetic report, 4 KB chunks", (double)report.length * Runs / 1e6 / seconds, "MB/s");
+
+    // Numbers alone, against the C library.
+    CrasheeTestBuffer json = {0};
+    crasheetest_addToBuffer("[", 1, &json);
+    for(int i = 0; i < NumberCount; i++)
+    {
+        char text[CrasheeFMT_DOUBLE_BUFFER_LENGTH + 1];
+        int length = i % 2 == 0
+            ? crasheefmt_uint64(text, nextRandom() >> (nextRandom() % 16))
+            : crasheefmt_double(text, (double)(nextRandom() % 100000000) / 1024);
+        text[length++] = i < NumberCount - 1 ? ',' : ']';
+        crasheetest_addToBuffer(text, length, &json);
+    }
+    start = crasheetest_now();
+    for(int run = 0; run < Runs; run++)
+    {
+        decodeNumbers(json.data, &capture, true);
+    }
+    seconds = crasheetest_now() - start;
+    crasheetest_reportBenchmark("decode numbers", seconds / Runs / NumberCount * 1e9, "ns/number");
+
+    double sum = 0;
+    start = crasheetest_now();
+    for(int run = 0; run < Runs; run++)
+    {
+        const char* ptr = json.data + 1;
+        for(int i = 0; i < NumberCount; i++)
+        {
+            char* end;
+            sum += i % 2 == 0 ? (double)strtoull(ptr, &end, 10) : strtod(ptr, &end);
+            ptr = end + 1;
+        }
+    }
+    seconds = crasheetest_now() - start;
+    g_benchmarkSink = sum;
+    crasheetest_reportBenchmark("strtoull/strtod on the same numbers", seconds / Runs / NumberCount * 1e9, "ns/number");
+
+    crasheetest_freeBuffer(&report);
+    crasheetest_freeBuffer(&json);
+}
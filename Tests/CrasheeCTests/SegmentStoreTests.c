@@ -0,0 +1,323 @@
+//
+//  SegmentStoreTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeCrashReportStore.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// ============================================================================
+#pragma mark - Helpers -
+// ============================================================================
+
+enum { ReportCount = 1000 };
+
+static int64_t g_reportIDs[ReportCount];
+
+/** Wait up to 10 seconds for the store's background work to get somewhere. */
+#define WAIT_FOR(CONDITION) \
+    for(int waited = 0; waited < 1000 && !(CONDITION); waited++) usleep(10000)
+
+/** Make the body of report i: a few KB, so that 1000 of them fill several segments. */
+static int makeReport(char* const buffer, const int index)
+{
+    const int padding = 6000 + index % 13 * 100;
+    int length = snprintf(buffer, 64, "{\"index\":%d,\"padding\":\"", index);
+    memset(buffer + length, 'a' + index % 26, (size_t)padding);
+    length += padding;
+    memcpy(buffer + length, "\"}", 3);
+    return length + 2;
+}
+
+static bool isReadable(const int index)
+{
+    static char expected[8192];
+    const int length = makeReport(expected, index);
+    char* report = crasheecrs_readReport(g_reportIDs[index]);
+    const bool matches = report != NULL && (int)strlen(report) == length && memcmp(report, expected, (size_t)length) == 0;
+    free(report);
+    return matches;
+}
+
+static bool areReadable(const int step)
+{
+    for(int i = 0; i < ReportCount; i += step)
+    {
+        if(!isReadable(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Count the files in a directory whose names contain a string. */
+static int countFiles(const char* const directory, const char* const nameContains)
+{
+    DIR* dir = opendir(directory);
+    if(dir == NULL)
+    {
+        return -1;
+    }
+    int count = 0;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        count += strstr(entry->d_name, nameContains) != NULL;
+    }
+    closedir(dir);
+    return count;
+}
+
+/** Add up the sizes of the files in a directory: as written, and as allocated on disk. */
+static void getDiskUsage(const char* const directory, int64_t* const apparentBytes, int64_t* const allocatedBytes)
+{
+    *apparentBytes = 0;
+    *allocatedBytes = 0;
+    DIR* dir = opendir(directory);
+    if(dir == NULL)
+    {
+        return;
+    }
+    struct dirent* entry;
+    char path[1000];
+    while((entry = readdir(dir)) != NULL)
+    {
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        if(entry->d_name[0] != '.' && stat(path, &st) == 0)
+        {
+            *apparentBytes += st.st_size;
+            *allocatedBytes += (int64_t)st.st_blocks * 512;
+        }
+    }
+    closedir(dir);
+}
+
+/** Reset the store's limits, which are shared by every suite. */
+static void initializeStore(const char* const directory)
+{
+    crasheecrs_initialize("CrasheeCTests", directory);
+    crasheecrs_setMaxReportCount(100000);
+    crasheecrs_setMaxReportCountOfKind(CrasheeReportKindUser, 0);
+    crasheecrs_setMaxReportBytes(0);
+    crasheecrs_setMaxReportAge(0);
+}
+
+static bool writeFixedUpReport(const int fd, __unused void* const userData)
+{
+    return write(fd, "{\"fixed\":1}", 11) == 11;
+}
+
+
+// ============================================================================
+#pragma mark - Tests -
+// ============================================================================
+
+static void testSegments(const char* const directory)
+{
+    static char report[8192];
+    initializeStore(directory);
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageSegments);
+    for(int i = 0; i < ReportCount; i++)
+    {
+        g_reportIDs[i] = crasheecrs_addUserReport(report, makeReport(report, i));
+    }
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == ReportCount);
+    CrasheeTEST_CHECK(areReadable(1));
+    CrasheeTEST_CHECK(countFiles(directory, "-report-") == 0);
+    const int segmentCount = countFiles(directory, "segment-");
+    CrasheeTEST_CHECK(segmentCount > 4);
+
+    // Leave every segment mostly empty, so that all of them get compacted.
+    for(int i = 0; i < ReportCount; i++)
+    {
+        if(i % 5 != 0)
+        {
+            crasheecrs_deleteReportWithID(g_reportIDs[i]);
+        }
+    }
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == ReportCount / 5);
+    WAIT_FOR(countFiles(directory, "segment-") <= segmentCount / 2);
+    CrasheeTEST_CHECK(countFiles(directory, "segment-") <= segmentCount / 2);
+    CrasheeTEST_CHECK(areReadable(5));
+
+    initializeStore(directory);
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == ReportCount / 5);
+    CrasheeTEST_CHECK(areReadable(5));
+
+    // A fixed up report replaces its frame, and outlives a rebuilt manifest.
+    CrasheeTEST_CHECK(crasheecrs_replaceWithFixedUpReport(g_reportIDs[5], writeFixedUpReport, NULL));
+    char* fixedUp = crasheecrs_readReport(g_reportIDs[5]);
+    CrasheeTEST_CHECK(fixedUp != NULL && strcmp(fixedUp, "{\"fixed\":1}") == 0);
+    free(fixedUp);
+    char path[600];
+    snprintf(path, sizeof(path), "%s/manifest.bin", directory);
+    unlink(path);
+    initializeStore(directory);
+    // Deleted reports in segments that weren't compacted yet come back.
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() >= ReportCount / 5);
+    fixedUp = crasheecrs_readReport(g_reportIDs[5]);
+    CrasheeTEST_CHECK(fixedUp != NULL && strcmp(fixedUp, "{\"fixed\":1}") == 0);
+    free(fixedUp);
+    CrasheeTEST_CHECK(isReadable(10) && isReadable(ReportCount - 5));
+
+    crasheecrs_setMaxReportCountOfKind(CrasheeReportKindUser, 50);
+    WAIT_FOR(crasheecrs_getReportCount() == 50);
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == 50);
+    CrasheeTEST_CHECK(isReadable(ReportCount - 5));
+    crasheecrs_setMaxReportCountOfKind(CrasheeReportKindUser, 0);
+
+    crasheecrs_deleteAllReports();
+    CrasheeTEST_CHECK(crasheecrs_getReportCount() == 0);
+    CrasheeTEST_CHECK(countFiles(directory, "segment-") == 0);
+}
+
+static void testDamagedFrameIsRejected(const char* const directory)
+{
+    initializeStore(directory);
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageSegments);
+    crasheecrs_deleteAllReports();
+    const int64_t reportID = crasheecrs_addUserReport("{\"damaged\":false}", 17);
+    char* report = crasheecrs_readReport(reportID);
+    CrasheeTEST_CHECK(report != NULL);
+    free(report);
+
+    DIR* dir = opendir(directory);
+    struct dirent* entry;
+    char path[1000] = "";
+    while(dir != NULL && (entry = readdir(dir)) != NULL)
+    {
+        if(strstr(entry->d_name, "segment-") != NULL)
+        {
+            snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        }
+    }
+    if(dir != NULL)
+    {
+        closedir(dir);
+    }
+    const int fd = open(path, O_RDWR);
+    struct stat st;
+    CrasheeTEST_CHECK(fd >= 0 && fstat(fd, &st) == 0);
+    if(fd >= 0)
+    {
+        // Inside the report body, at the end of the only frame.
+        CrasheeTEST_CHECK(pwrite(fd, "t", 1, st.st_size - 7) == 1);
+        close(fd);
+    }
+    report = crasheecrs_readReport(reportID);
+    CrasheeTEST_CHECK(report == NULL);
+    free(report);
+    crasheecrs_deleteAllReports();
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageFiles);
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runSegmentStoreTests(void)
+{
+    char directory[400];
+    CrasheeTEST_CHECK(crasheetest_makeTemporaryDirectory("segments", directory, sizeof(directory)));
+    testSegments(directory);
+    testDamagedFrameIsRejected(directory);
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageFiles);
+}
+
+static void benchmarkStorage(const CrasheeUserReportStorage storage, const int reportLength)
+{
+    enum { Count = 2000 };
+    const char* const storageName = storage == CrasheeUserReportStorageSegments ? "segments" : "files";
+    char directory[400];
+    char name[100];
+    snprintf(name, sizeof(name), "segments-benchmark-%s-%d", storageName, reportLength);
+    if(!crasheetest_makeTemporaryDirectory(name, directory, sizeof(directory)))
+    {
+        return;
+    }
+    initializeStore(directory);
+    crasheecrs_setUserReportStorage(storage);
+    char* report = malloc((size_t)reportLength);
+    int64_t* reportIDs = malloc(Count * sizeof(*reportIDs));
+    if(report == NULL || reportIDs == NULL)
+    {
+        free(report);
+        free(reportIDs);
+        return;
+    }
+    memset(report, 'x', (size_t)reportLength);
+    report[0] = '"';
+    report[reportLength - 1] = '"';
+
+    double start = crasheetest_now();
+    for(int i = 0; i < Count; i++)
+    {
+        reportIDs[i] = crasheecrs_addUserReport(report, reportLength);
+    }
+    const double addSeconds = crasheetest_now() - start;
+
+    start = crasheetest_now();
+    for(int i = 0; i < Count; i++)
+    {
+        free(crasheecrs_readReport(reportIDs[i]));
+    }
+    const double readSeconds = crasheetest_now() - start;
+
+    int64_t apparentBytes;
+    int64_t allocatedBytes;
+    getDiskUsage(directory, &apparentBytes, &allocatedBytes);
+
+    snprintf(name, sizeof(name), "%s, %d byte reports: add", storageName, reportLength);
+    crasheetest_reportBenchmark(name, Count / addSeconds, "reports/s");
+    snprintf(name, sizeof(name), "%s, %d byte reports: read", storageName, reportLength);
+    crasheetest_reportBenchmark(name, Count / readSeconds, "reports/s");
+    snprintf(name, sizeof(name), "%s, %d byte reports: disk written", storageName, reportLength);
+    crasheetest_reportBenchmark(name, (double)apparentBytes / 1024, "KB");
+    snprintf(name, sizeof(name), "%s, %d byte reports: disk allocated", storageName, reportLength);
+    crasheetest_reportBenchmark(name, (double)allocatedBytes / 1024, "KB");
+
+    crasheecrs_deleteAllReports();
+    free(report);
+    free(reportIDs);
+}
+
+void crasheetest_runSegmentStoreBenchmarks(void)
+{
+    benchmarkStorage(CrasheeUserReportStorageFiles, 500);
+    benchmarkStorage(CrasheeUserReportStorageSegments, 500);
+    benchmarkStorage(CrasheeUserReportStorageFiles, 4000);
+    benchmarkStorage(CrasheeUserReportStorageSegments, 4000);
+    crasheecrs_setUserReportStorage(CrasheeUserReportStorageFiles);
+}
@@ -0,0 +1,233 @@
+//
+//  WriterTests.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "CrasheeCTests.h"
+#include "CrasheeFileUtils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// ============================================================================
+#pragma mark - Helpers -
+// ============================================================================
+
+/** Check that a file holds exactly the expected bytes. */
+static bool fileContains(const char* const path, const char* const expected, const int expectedLength)
+{
+    char* data = NULL;
+    int length = 0;
+    if(!crasheefu_readEntireFile(path, &data, &length, 0))
+    {
+        return false;
+    }
+    const bool matches = length == expectedLength && memcmp(data, expected, (size_t)length) == 0;
+    free(data);
+    return matches;
+}
+
+/** Write the same random mix of small and large writes and flushes to a
+ * writer and to an in-memory copy.
+ */
+static bool writeRandomly(CrasheeBufferedWriter* const writer, const char* const source, CrasheeTestBuffer* const expected)
+{
+    static const int lengths[] =
+    {
+        0, 1, 7, 64, CrasheeFU_VECTORED_DIRECT_WRITE_LENGTH - 1, CrasheeFU_VECTORED_DIRECT_WRITE_LENGTH, 1000, 5000,
+    };
+    srand(6);
+    for(int i = 0; i < 400; i++)
+    {
+        const int length = lengths[rand() % (int)(sizeof(lengths) / sizeof(*lengths))];
+        const char* data = source + rand() % 1000;
+        if(!crasheefu_writeBufferedWriter(writer, data, length))
+        {
+            return false;
+        }
+        crasheetest_addToBuffer(data, length, expected);
+        if(rand() % 10 == 0 && !crasheefu_flushBufferedWriter(writer))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// ============================================================================
+#pragma mark - Tests -
+// ============================================================================
+
+static void testWritersProduceSameBytes(const char* const directory)
+{
+    char source[6000];
+    for(int i = 0; i < (int)sizeof(source); i++)
+    {
+        source[i] = (char)('a' + i % 26);
+    }
+    char path[500];
+    snprintf(path, sizeof(path), "%s/writer.json", directory);
+    static char buffer[16384];
+    static const int bufferLengths[] = {64, 1024, sizeof(buffer)};
+    CrasheeTestBuffer expected = {0};
+
+    for(int vectored = 0; vectored <= 1; vectored++)
+    {
+        for(int i = 0; i < (int)(sizeof(bufferLengths) / sizeof(*bufferLengths)); i++)
+        {
+            unlink(path);
+            crasheetest_clearBuffer(&expected);
+            CrasheeBufferedWriter writer;
+            const bool opened = vectored
+                ? crasheefu_openVectoredBufferedWriter(&writer, path, buffer, bufferLengths[i], false)
+                : crasheefu_openBufferedWriter(&writer, path, buffer, bufferLengths[i]);
+            CrasheeTEST_CHECK(opened);
+            if(!opened)
+            {
+                continue;
+            }
+            CrasheeTEST_CHECK(writeRandomly(&writer, source, &expected));
+            crasheefu_closeBufferedWriter(&writer);
+            CrasheeTEST_CHECK(fileContains(path, expected.data, expected.length));
+        }
+    }
+    crasheetest_freeBuffer(&expected);
+}
+
+static void testOpenModes(const char* const directory)
+{
+    char path[500];
+    snprintf(path, sizeof(path), "%s/slot.json", directory);
+    char buffer[1024];
+    CrasheeBufferedWriter writer;
+
+    unlink(path);
+    CrasheeTEST_CHECK(crasheefu_openVectoredBufferedWriter(&writer, path, buffer, sizeof(buffer), false));
+    crasheefu_writeBufferedWriter(&writer, "a longer first report", 21);
+    crasheefu_closeBufferedWriter(&writer);
+
+    // An existing file is only written over if it is a report slot.
+    CrasheeTEST_CHECK(!crasheefu_openVectoredBufferedWriter(&writer, path, buffer, sizeof(buffer), false));
+    CrasheeTEST_CHECK(!crasheefu_openBufferedWriter(&writer, path, buffer, sizeof(buffer)));
+    CrasheeTEST_CHECK(crasheefu_openVectoredBufferedWriter(&writer, path, buffer, sizeof(buffer), true));
+    crasheefu_writeBufferedWriter(&writer, "{}", 2);
+    crasheefu_closeBufferedWriter(&writer);
+    CrasheeTEST_CHECK(fileContains(path, "{}", 2));
+}
+
+
+// ============================================================================
+#pragma mark - Suite -
+// ============================================================================
+
+void crasheetest_runWriterTests(void)
+{
+    char directory[400];
+    CrasheeTEST_CHECK(crasheetest_makeTemporaryDirectory("writer", directory, sizeof(directory)));
+    testWritersProduceSameBytes(directory);
+    testOpenModes(directory);
+}
+
+/** Get how many write system calls this process has made, or -1 if the
+ * platform doesn't say (only Linux does, through /proc).
+ */
+static long getWriteSyscallCount(void)
+{
+    FILE* file = fopen("/proc/self/io", "r");
+    if(file == NULL)
+    {
+        return -1;
+    }
+    long count = -1;
+    char line[100];
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        if(sscanf(line, "syscw: %ld", &count) == 1)
+        {
+            break;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static int addToWriter(const char* const data, const int length, void* const userData)
+{
+    return crasheefu_writeBufferedWriter(userData, data, length) ? CrasheeJSON_OK : CrasheeJSON_ERROR_CANNOT_ADD_DATA;
+}
+
+static void flushWriter(void* const userData)
+{
+    crasheefu_flushBufferedWriter(userData);
+}
+
+void crasheetest_runWriterBenchmarks(void)
+{
+    enum { Runs = 50 };
+    static char smallBuffer[1024];
+    static char largeBuffer[16384];
+    char directory[400];
+    char path[500];
+    if(!crasheetest_makeTemporaryDirectory("writer-benchmark", directory, sizeof(directory)))
+    {
+        return;
+    }
+    snprintf(path, sizeof(path), "%s/report.json", directory);
+
+    for(int vectored = 0; vectored <= 1; vectored++)
+    {
+        double best = 1e9;
+        long syscalls = 0;
+        for(int run = 0; run < Runs; run++)
+        {
+            unlink(path);
+            CrasheeBufferedWriter writer;
+            const long syscallsBefore = getWriteSyscallCount();
+            const double start = crasheetest_now();
+            const bool opened = vectored
+                ? crasheefu_openVectoredBufferedWriter(&writer, path, largeBuffer, sizeof(largeBuffer), false)
+                : crasheefu_openBufferedWriter(&writer, path, smallBuffer, sizeof(smallBuffer));
+            if(!opened)
+            {
+                return;
+            }
+            CrasheeJSONEncodeContext context;
+            crasheejson_beginEncode(&context, true, addToWriter, &writer);
+            crasheetest_encodeSyntheticReport(&context, flushWriter, &writer);
+            crasheefu_closeBufferedWriter(&writer);
+            const double seconds = crasheetest_now() - start;
+            syscalls = syscallsBefore < 0 ? -1 : getWriteSyscallCount() - syscallsBefore;
+            best = seconds < best ? seconds : best;
+        }
+        const char* mode = vectored ? "vectored 16 KB" : "copying 1 KB";
+        char label[100];
+        snprintf(label, sizeof(label), "report write, %s: best time", mode);
+        crasheetest_reportBenchmark(label, best * 1e6, "us");
+        snprintf(label, sizeof(label), "report write, %s: write syscalls", mode);
+        crasheetest_reportBenchmark(label, (double)syscalls, syscalls < 0 ? "calls (unavailable)" : "calls");
+    }
+}
@@ -0,0 +1,109 @@
+//
+//  main.c
+//
+//  Copyright (c) 2016 Karl Stenerud. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/* Runs the C tests, and with --bench the benchmarks, of the recording core.
+ *
+ * Usage: CrasheeCTests [--bench] [suite ...]
+ *
+ * With no suites named, all of them run. Benchmarks are meant for release
+ * builds (swift run -c release CrasheeCTests --bench).
+ */
+
+
+#include "CrasheeCTests.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+typedef struct
+{
+    const char* name;
+    void (*runTests)(void);
+    void (*runBenchmarks)(void);
+} Suite;
+
+static const Suite g_suites[] =
+{
+    {"json", crasheetest_runJSONCodecTests, crasheetest_runJSONCodecBenchmarks},
+    {"decode", crasheetest_runJSONDecodeTests, crasheetest_runJSONDecodeBenchmarks},
+    {"format", crasheetest_runFormatTests, crasheetest_runFormatBenchmarks},
+    {"writer", crasheetest_runWriterTests, crasheetest_runWriterBenchmarks},
+    {"lz", crasheetest_runCompressionTests, crasheetest_runCompressionBenchmarks},
+    {"segments", crasheetest_runSegmentStoreTests, crasheetest_runSegmentStoreBenchmarks},
+    {"concurrent", crasheetest_runConcurrentStoreTests, crasheetest_runConcurrentStoreBenchmarks},
+    {"async", crasheetest_runAsyncStoreTests, crasheetest_runAsyncStoreBenchmarks},
+};
+static const int g_suitesCount = sizeof(g_suites) / sizeof(*g_suites);
+
+
+static bool isSelected(const Suite* const suite, const int argc, const char** const argv)
+{
+    bool anyNamed = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--bench") == 0)
+        {
+            continue;
+        }
+        anyNamed = true;
+        if(strcmp(argv[i], suite->name) == 0)
+        {
+            return true;
+        }
+    }
+    return !anyNamed;
+}
+
+int main(const int argc, const char** const argv)
+{
+    bool shouldBenchmark = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--bench") == 0)
+        {
+            shouldBenchmark = true;
+        }
+    }
+
+    for(int i = 0; i < g_suitesCount; i++)
+    {
+        const Suite* suite = &g_suites[i];
+        if(!isSelected(suite, argc, argv))
+        {
+            continue;
+        }
+        const int failuresBefore = crasheetest_getFailureCount();
+        suite->runTests();
+        printf("%-10s %s\n", suite->name, crasheetest_getFailureCount() == failuresBefore ? "passed" : "FAILED");
+        if(shouldBenchmark && suite->runBenchmarks != NULL)
+        {
+            suite->runBenchmarks();
+        }
+    }
+
+    printf("%d checks, %d failed\n", crasheetest_getCheckCount(), crasheetest_getFailureCount());
+    return crasheetest_getFailureCount() == 0 ? 0 : 1;
+}